@@ -0,0 +1,367 @@
+/*
+ * File: GraphBenchmark.c
+ * ----------------------
+ * This program measures the graph algorithms in graphalgo.h on a large
+ * random graph.  By default, the graph has 100,000 nodes and 1,000,000
+ * arcs; the optional command-line arguments change those numbers.  For
+ * comparison, the program also times a breadth-first search written
+ * with getNeighbors and a Set of visited nodes, which is how clients
+ * searched a Graph before the algorithms were available, and the same
+ * search written with mapNeighbors and an array indexed by node.
+ * Finally, it measures how the parallel search and shortest-path
+ * algorithms scale with the number of threads, doubling the count up to
+ * the number of processors, or up to the third command-line argument if
+ * there is one.
+ * The last section writes the graph as an edge list and times the
+ * loaders in graphio.h, both from the text file and from a saved
+ * snapshot.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "cslib.h"
+#include "filelib.h"
+#include "foreach.h"
+#include "graph.h"
+#include "graphalgo.h"
+#include "graphio.h"
+#include "queue.h"
+#include "random.h"
+#include "set.h"
+#include "strlib.h"
+#include "vector.h"
+
+/* Constants */
+
+#define DEFAULT_NODES 100000
+#define DEFAULT_ARCS 1000000
+#define EDGE_LIST_FILE "GraphBenchmark-edges.txt"
+#define SNAPSHOT_FILE "GraphBenchmark-graph.dat"
+
+/*
+ * Type: SearchState
+ * -----------------
+ * This type holds the queue and the visited flags for the search that
+ * uses mapNeighbors.
+ */
+
+typedef struct {
+   Node *queue;
+   int tail;
+   bool *visited;
+} SearchState;
+
+/* Private function prototypes */
+
+static Graph createRandomGraph(int nNodes, int nArcs);
+static void measureScaling(FrozenGraph fg, int maxThreads);
+static void measureLoading(FrozenGraph fg);
+static int searchWithNeighborSets(Graph g, Node start);
+static int searchWithMapNeighbors(Graph g, Node start);
+static void visitNeighbor(Node neighbor, Arc arc, void *data);
+static double elapsedSeconds(struct timespec *start);
+static void startTimer(struct timespec *start);
+
+/* Main program */
+
+int main(int argc, string argv[]) {
+   struct timespec timer;
+   Graph g;
+   FrozenGraph fg;
+   Vector nodes;
+   int *ids;
+   double *dist;
+   int nNodes, nArcs, maxThreads, n;
+
+   nNodes = (argc > 1) ? stringToInteger(argv[1]) : DEFAULT_NODES;
+   nArcs = (argc > 2) ? stringToInteger(argv[2]) : DEFAULT_ARCS;
+   if (argc > 3) {
+      maxThreads = stringToInteger(argv[3]);
+   } else {
+      maxThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+      if (maxThreads < 1) maxThreads = 1;
+   }
+   setRandomSeed(1);
+   printf("Graph with %d nodes and %d arcs\n", nNodes, nArcs);
+   startTimer(&timer);
+   g = createRandomGraph(nNodes, nArcs);
+   printf("%-32s %8.3fs\n", "Build Graph", elapsedSeconds(&timer));
+   startTimer(&timer);
+   fg = freezeGraph(g);
+   printf("%-32s %8.3fs\n", "freezeGraph", elapsedSeconds(&timer));
+   ids = newArray(nNodes, int);
+   dist = newArray(nNodes, double);
+   startTimer(&timer);
+   n = searchWithNeighborSets(g, getFrozenNode(fg, 0));
+   printf("%-32s %8.3fs  (%d reached)\n", "BFS with getNeighbors",
+          elapsedSeconds(&timer), n);
+   startTimer(&timer);
+   n = searchWithMapNeighbors(g, getFrozenNode(fg, 0));
+   printf("%-32s %8.3fs  (%d reached)\n", "BFS with mapNeighbors",
+          elapsedSeconds(&timer), n);
+   startTimer(&timer);
+   n = breadthFirstFrozenGraph(fg, 0, ids);
+   printf("%-32s %8.3fs  (%d reached)\n", "breadthFirstFrozenGraph",
+          elapsedSeconds(&timer), n);
+   startTimer(&timer);
+   n = depthFirstFrozenGraph(fg, 0, ids);
+   printf("%-32s %8.3fs  (%d reached)\n", "depthFirstFrozenGraph",
+          elapsedSeconds(&timer), n);
+   startTimer(&timer);
+   shortestDistancesFrozenGraph(fg, 0, dist, NULL);
+   printf("%-32s %8.3fs\n", "shortestDistancesFrozenGraph",
+          elapsedSeconds(&timer));
+   startTimer(&timer);
+   n = strongComponentsFrozenGraph(fg, ids);
+   printf("%-32s %8.3fs  (%d components)\n", "strongComponentsFrozenGraph",
+          elapsedSeconds(&timer), n);
+   startTimer(&timer);
+   n = connectedComponentsFrozenGraph(fg, ids);
+   printf("%-32s %8.3fs  (%d components)\n",
+          "connectedComponentsFrozenGraph", elapsedSeconds(&timer), n);
+   startTimer(&timer);
+   topologicalSortFrozenGraph(fg, ids);
+   printf("%-32s %8.3fs\n", "topologicalSortFrozenGraph",
+          elapsedSeconds(&timer));
+   startTimer(&timer);
+   nodes = breadthFirstSearch(g, getFrozenNode(fg, 0));
+   printf("%-32s %8.3fs  (%d reached)\n", "breadthFirstSearch",
+          elapsedSeconds(&timer), sizeVector(nodes));
+   freeVector(nodes);
+   measureScaling(fg, maxThreads);
+   measureLoading(fg);
+   freeBlock(ids);
+   freeBlock(dist);
+   freeFrozenGraph(fg);
+   freeGraph(g);
+   return 0;
+}
+
+/*
+ * Function: createRandomGraph
+ * Usage: g = createRandomGraph(nNodes, nArcs);
+ * --------------------------------------------
+ * Creates a graph with arcs between randomly chosen nodes, each of which
+ * has a random cost between 1 and 100.
+ */
+
+static Graph createRandomGraph(int nNodes, int nArcs) {
+   Graph g;
+   Node *nodes;
+   Arc arc;
+   int i;
+
+   g = newGraph();
+   nodes = newArray(nNodes, Node);
+   for (i = 0; i < nNodes; i++) {
+      nodes[i] = addNode(g, concat("n", integerToString(i)));
+   }
+   for (i = 0; i < nArcs; i++) {
+      arc = addArc(g, nodes[randomInteger(0, nNodes - 1)],
+                      nodes[randomInteger(0, nNodes - 1)]);
+      setCost(arc, randomInteger(1, 100));
+   }
+   freeBlock(nodes);
+   return g;
+}
+
+/*
+ * Function: measureScaling
+ * Usage: measureScaling(fg, maxThreads);
+ * --------------------------------------
+ * Times the parallel algorithms from node 0 with increasing numbers of
+ * threads and reports each time along with its speedup over one thread.
+ * The incoming rows of the snapshot are built first, so that the time
+ * to build them is not charged to the first search.
+ */
+
+static void measureScaling(FrozenGraph fg, int maxThreads) {
+   struct timespec timer;
+   double *dist, bfsBase, deltaBase, t;
+   int *depth;
+   int start, nThreads, n;
+
+   start = 0;
+   depth = newArray(getFrozenNodeCount(fg), int);
+   dist = newArray(getFrozenNodeCount(fg), double);
+   startTimer(&timer);
+   getFrozenInOffsets(fg);
+   printf("%-32s %8.3fs\n", "getFrozenInOffsets", elapsedSeconds(&timer));
+   printf("\n%8s %24s %24s\n", "Threads", "parallelBreadthFirst",
+          "deltaStepping");
+   bfsBase = deltaBase = 0;
+   nThreads = 1;
+   while (true) {
+      startTimer(&timer);
+      n = parallelBreadthFirstFrozenGraph(fg, &start, 1, depth, nThreads);
+      t = elapsedSeconds(&timer);
+      if (nThreads == 1) bfsBase = t;
+      printf("%8d %8.3fs (%5.2fx, %d)", nThreads, t, bfsBase / t, n);
+      startTimer(&timer);
+      deltaSteppingFrozenGraph(fg, &start, 1, dist, 0, nThreads);
+      t = elapsedSeconds(&timer);
+      if (nThreads == 1) deltaBase = t;
+      printf(" %14.3fs (%5.2fx)\n", t, deltaBase / t);
+      if (nThreads == maxThreads) break;
+      nThreads = (2 * nThreads < maxThreads) ? 2 * nThreads : maxThreads;
+   }
+   freeBlock(depth);
+   freeBlock(dist);
+}
+
+/*
+ * Function: measureLoading
+ * Usage: measureLoading(fg);
+ * --------------------------
+ * Writes the arcs of the snapshot to a text file, using node IDs as
+ * labels, and times reading it back as a Graph and as a snapshot.  It
+ * then saves the snapshot in binary form and times loading it again.
+ */
+
+static void measureLoading(FrozenGraph fg) {
+   struct timespec timer;
+   FILE *outfile;
+   FrozenGraph copy;
+   Graph g;
+   const int *offsets, *targets;
+   const double *costs;
+   int u, i;
+
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   costs = getFrozenCosts(fg);
+   outfile = fopen(EDGE_LIST_FILE, "w");
+   if (outfile == NULL) error("Can't create %s", EDGE_LIST_FILE);
+   for (u = 0; u < getFrozenNodeCount(fg); u++) {
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         fprintf(outfile, "%d %d %g\n", u, targets[i], costs[i]);
+      }
+   }
+   fclose(outfile);
+   printf("\n");
+   startTimer(&timer);
+   g = loadGraphFromEdgeList(EDGE_LIST_FILE, 0);
+   printf("%-32s %8.3fs\n", "loadGraphFromEdgeList", elapsedSeconds(&timer));
+   freeGraph(g);
+   startTimer(&timer);
+   copy = loadFrozenGraphFromEdgeList(EDGE_LIST_FILE, 0);
+   printf("%-32s %8.3fs\n", "loadFrozenGraphFromEdgeList",
+          elapsedSeconds(&timer));
+   startTimer(&timer);
+   saveFrozenGraph(copy, SNAPSHOT_FILE);
+   printf("%-32s %8.3fs\n", "saveFrozenGraph", elapsedSeconds(&timer));
+   freeFrozenGraph(copy);
+   startTimer(&timer);
+   copy = loadFrozenGraph(SNAPSHOT_FILE);
+   printf("%-32s %8.3fs\n", "loadFrozenGraph", elapsedSeconds(&timer));
+   freeFrozenGraph(copy);
+   deleteFile(EDGE_LIST_FILE);
+   deleteFile(SNAPSHOT_FILE);
+}
+
+/*
+ * Function: searchWithNeighborSets
+ * Usage: n = searchWithNeighborSets(g, start);
+ * --------------------------------------------
+ * Performs a breadth-first search using only the operations in graph.h
+ * and returns the number of nodes reached.
+ */
+
+static int searchWithNeighborSets(Graph g, Node start) {
+   Queue queue;
+   Set visited, neighbors;
+   Node node, neighbor;
+   int count;
+
+   queue = newQueue();
+   visited = newSet(Node);
+   enqueueQueue(queue, start);
+   addSet(visited, start);
+   count = 0;
+   while (!isEmptyQueue(queue)) {
+      node = dequeueQueue(queue);
+      count++;
+      neighbors = getNeighbors(node);
+      foreach (neighbor in neighbors) {
+         if (!containsSet(visited, neighbor)) {
+            addSet(visited, neighbor);
+            enqueueQueue(queue, neighbor);
+         }
+      }
+      freeSet(neighbors);
+   }
+   freeSet(visited);
+   freeQueue(queue);
+   return count;
+}
+
+/*
+ * Function: searchWithMapNeighbors
+ * Usage: n = searchWithMapNeighbors(g, start);
+ * --------------------------------------------
+ * Performs the same search as searchWithNeighborSets but visits the
+ * neighbors with mapNeighbors and marks nodes in an array indexed by
+ * node index, so that the loop allocates nothing.
+ */
+
+static int searchWithMapNeighbors(Graph g, Node start) {
+   SearchState state;
+   int head, i;
+
+   state.queue = newArray(getNodeIndexLimit(g), Node);
+   state.visited = newArray(getNodeIndexLimit(g), bool);
+   for (i = 0; i < getNodeIndexLimit(g); i++) {
+      state.visited[i] = false;
+   }
+   state.queue[0] = start;
+   state.visited[getNodeIndex(start)] = true;
+   state.tail = 1;
+   for (head = 0; head < state.tail; head++) {
+      mapNeighbors(state.queue[head], visitNeighbor, &state);
+   }
+   freeBlock(state.queue);
+   freeBlock(state.visited);
+   return state.tail;
+}
+
+static void visitNeighbor(Node neighbor, Arc arc, void *data) {
+   SearchState *state;
+
+   state = (SearchState *) data;
+   if (!state->visited[getNodeIndex(neighbor)]) {
+      state->visited[getNodeIndex(neighbor)] = true;
+      state->queue[state->tail++] = neighbor;
+   }
+}
+
+static void startTimer(struct timespec *start) {
+   clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+static double elapsedSeconds(struct timespec *start) {
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
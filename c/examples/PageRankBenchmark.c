@@ -0,0 +1,273 @@
+/*
+ * File: PageRankBenchmark.c
+ * -------------------------
+ * This program measures pageRankFrozenGraph on a synthetic graph whose
+ * in-degrees follow a power law, which is the shape of the web and
+ * social graphs for which PageRank is usually computed.  A few nodes
+ * receive a large share of the arcs, so dividing the nodes evenly among
+ * threads would give the first thread far more than its share of the
+ * work; the vertex program instead divides them by partitionFrozenGraph.
+ * By default, the graph has 200,000 nodes and 2,000,000 arcs; the
+ * optional command-line arguments change those numbers.  The program
+ * writes the graph as an edge list, loads it with
+ * loadFrozenGraphFromEdgeList, and times the computation with the number
+ * of threads doubling up to the number of processors, or up to the third
+ * command-line argument if there is one.  For comparison, it also times
+ * one iteration written with the sets that graph.h returns for each
+ * node.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "cslib.h"
+#include "filelib.h"
+#include "foreach.h"
+#include "graph.h"
+#include "graphalgo.h"
+#include "graphio.h"
+#include "random.h"
+#include "strlib.h"
+
+/* Constants */
+
+#define DEFAULT_NODES 200000
+#define DEFAULT_ARCS 2000000
+#define DAMPING 0.85
+#define TOLERANCE 1e-8
+#define SKEW 3
+#define N_TOP_NODES 5
+#define EDGE_LIST_FILE "PageRankBenchmark-edges.txt"
+
+/* Private function prototypes */
+
+static void writePowerLawGraph(string path, int nNodes, int nArcs);
+static void measureScaling(FrozenGraph fg, int maxThreads);
+static double imbalance(FrozenGraph fg, int bounds[], int nThreads);
+static void measureGraphIteration(int nNodes);
+static void listTopNodes(FrozenGraph fg, double rank[]);
+static double elapsedSeconds(struct timespec *start);
+static void startTimer(struct timespec *start);
+
+/* Main program */
+
+int main(int argc, string argv[]) {
+   struct timespec timer;
+   FrozenGraph fg;
+   int nNodes, nArcs, maxThreads;
+
+   nNodes = (argc > 1) ? stringToInteger(argv[1]) : DEFAULT_NODES;
+   nArcs = (argc > 2) ? stringToInteger(argv[2]) : DEFAULT_ARCS;
+   if (argc > 3) {
+      maxThreads = stringToInteger(argv[3]);
+   } else {
+      maxThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+      if (maxThreads < 1) maxThreads = 1;
+   }
+   setRandomSeed(1);
+   printf("Power-law graph with %d nodes and %d arcs\n", nNodes, nArcs);
+   writePowerLawGraph(EDGE_LIST_FILE, nNodes, nArcs);
+   startTimer(&timer);
+   fg = loadFrozenGraphFromEdgeList(EDGE_LIST_FILE, 0);
+   printf("%-32s %8.3fs\n", "loadFrozenGraphFromEdgeList",
+          elapsedSeconds(&timer));
+   startTimer(&timer);
+   getFrozenInOffsets(fg);
+   printf("%-32s %8.3fs\n", "getFrozenInOffsets", elapsedSeconds(&timer));
+   measureGraphIteration(nNodes);
+   deleteFile(EDGE_LIST_FILE);
+   measureScaling(fg, maxThreads);
+   freeFrozenGraph(fg);
+   return 0;
+}
+
+/*
+ * Function: writePowerLawGraph
+ * Usage: writePowerLawGraph(path, nNodes, nArcs);
+ * -----------------------------------------------
+ * Writes an edge list in which the start of each arc is chosen at
+ * random and the end is chosen by raising a random number in [0, 1) to
+ * the power SKEW, which makes the low-numbered nodes far more popular
+ * than the rest.  The last line names the highest node, so that every
+ * node appears in the graph.
+ */
+
+static void writePowerLawGraph(string path, int nNodes, int nArcs) {
+   FILE *outfile;
+   int i;
+
+   outfile = fopen(path, "w");
+   if (outfile == NULL) error("Can't create %s", path);
+   for (i = 0; i < nArcs - 1; i++) {
+      fprintf(outfile, "%d %d\n", randomInteger(0, nNodes - 1),
+              (int) (nNodes * pow(randomReal(0, 1), SKEW)));
+   }
+   fprintf(outfile, "%d %d\n", nNodes - 1, 0);
+   fclose(outfile);
+}
+
+/*
+ * Function: measureScaling
+ * Usage: measureScaling(fg, maxThreads);
+ * --------------------------------------
+ * Times pageRankFrozenGraph with increasing numbers of threads and
+ * reports each time along with its speedup over one thread.  For each
+ * number of threads, it also reports the imbalance of the ranges from
+ * partitionFrozenGraph and of ranges with equal numbers of nodes.
+ */
+
+static void measureScaling(FrozenGraph fg, int maxThreads) {
+   struct timespec timer;
+   double *rank;
+   double base, t, balanced;
+   int *bounds;
+   int nThreads, n, i;
+
+   rank = newArray(getFrozenNodeCount(fg), double);
+   printf("\n%8s %11s %10s %9s %11s %11s\n", "Threads", "Iterations",
+          "Time", "Speedup", "Imbalance", "Even split");
+   base = 0;
+   for (nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+      bounds = newArray(nThreads + 1, int);
+      partitionFrozenGraph(fg, nThreads, bounds);
+      balanced = imbalance(fg, bounds, nThreads);
+      for (i = 0; i <= nThreads; i++) {
+         bounds[i] = (int) ((long) getFrozenNodeCount(fg) * i / nThreads);
+      }
+      startTimer(&timer);
+      n = pageRankFrozenGraph(fg, rank, DAMPING, TOLERANCE, nThreads);
+      t = elapsedSeconds(&timer);
+      if (nThreads == 1) base = t;
+      printf("%8d %11d %9.3fs %8.2fx %11.2f %11.2f\n", nThreads, n, t,
+             base / t, balanced, imbalance(fg, bounds, nThreads));
+      freeBlock(bounds);
+   }
+   listTopNodes(fg, rank);
+   freeBlock(rank);
+}
+
+/*
+ * Function: imbalance
+ * Usage: ratio = imbalance(fg, bounds, nThreads);
+ * -----------------------------------------------
+ * Returns the ratio of the work in the largest range to the average
+ * work per thread, counting one unit for each node and for each arc that
+ * enters or leaves it.
+ */
+
+static double imbalance(FrozenGraph fg, int bounds[], int nThreads) {
+   const int *offsets, *inOffsets;
+   long work, most;
+   int i;
+
+   offsets = getFrozenOffsets(fg);
+   inOffsets = getFrozenInOffsets(fg);
+   most = 0;
+   for (i = 0; i < nThreads; i++) {
+      work = bounds[i + 1] - bounds[i]
+           + offsets[bounds[i + 1]] - offsets[bounds[i]]
+           + inOffsets[bounds[i + 1]] - inOffsets[bounds[i]];
+      if (work > most) most = work;
+   }
+   return (double) most * nThreads
+        / (getFrozenNodeCount(fg) + 2.0 * getFrozenArcCount(fg));
+}
+
+/*
+ * Function: measureGraphIteration
+ * Usage: measureGraphIteration(nNodes);
+ * -------------------------------------
+ * Loads the edge list as a Graph and times one PageRank iteration that
+ * visits the incoming arcs of each node with foreach, which is how a
+ * client would compute ranks with only the operations in graph.h.
+ */
+
+static void measureGraphIteration(int nNodes) {
+   struct timespec timer;
+   Graph g;
+   Node node;
+   Arc arc;
+   double *rank, *next;
+   double sum;
+   int i, degree;
+
+   g = loadGraphFromEdgeList(EDGE_LIST_FILE, 0);
+   rank = newArray(getNodeIndexLimit(g), double);
+   next = newArray(getNodeIndexLimit(g), double);
+   for (i = 0; i < getNodeIndexLimit(g); i++) {
+      rank[i] = 1.0 / nNodes;
+   }
+   startTimer(&timer);
+   foreach (node in getNodeSet(g)) {
+      sum = 0;
+      foreach (arc in getIncomingArcs(node)) {
+         degree = sizeSet(getArcSet(startOfArc(arc)));
+         sum += rank[getNodeIndex(startOfArc(arc))] / degree;
+      }
+      next[getNodeIndex(node)] = (1 - DAMPING) / nNodes + DAMPING * sum;
+   }
+   printf("%-32s %8.3fs\n", "One iteration with foreach",
+          elapsedSeconds(&timer));
+   freeBlock(rank);
+   freeBlock(next);
+   freeGraph(g);
+}
+
+/*
+ * Function: listTopNodes
+ * Usage: listTopNodes(fg, rank);
+ * ------------------------------
+ * Lists the nodes with the highest ranks.
+ */
+
+static void listTopNodes(FrozenGraph fg, double rank[]) {
+   bool *listed;
+   int i, k, best;
+
+   listed = newArray(getFrozenNodeCount(fg), bool);
+   for (i = 0; i < getFrozenNodeCount(fg); i++) {
+      listed[i] = false;
+   }
+   printf("\n%-12s %12s\n", "Node", "Rank");
+   for (k = 0; k < N_TOP_NODES && k < getFrozenNodeCount(fg); k++) {
+      best = -1;
+      for (i = 0; i < getFrozenNodeCount(fg); i++) {
+         if (!listed[i] && (best == -1 || rank[i] > rank[best])) best = i;
+      }
+      listed[best] = true;
+      printf("%-12s %12.6f\n", getFrozenNodeName(fg, best), rank[best]);
+   }
+   freeBlock(listed);
+}
+
+static void startTimer(struct timespec *start) {
+   clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+static double elapsedSeconds(struct timespec *start) {
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
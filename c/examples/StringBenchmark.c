@@ -0,0 +1,316 @@
+/*
+ * File: StringBenchmark.c
+ * -----------------------
+ * This program measures the search and case functions in strlib.h on
+ * strings from 1 KB up to 100 MB; the optional command-line argument
+ * changes the largest size.  For each function and size, it reports the
+ * time of one call and the rate at which the call reads the string,
+ * alongside the same operation written as a loop over the characters,
+ * which is how strlib implemented the functions that have no
+ * counterpart in the C library.  Each input is arranged so that the
+ * function must read the whole string: the character or pattern being
+ * sought appears only at the far end, and the strings being compared
+ * differ only in case.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "cslib.h"
+#include "random.h"
+#include "strlib.h"
+
+/* Constants */
+
+#define MIN_SIZE 1024
+#define DEFAULT_MAX_SIZE (100 * 1024 * 1024)
+#define SIZE_STEP 10
+#define BYTES_PER_TEST (256 * 1024 * 1024)
+#define PATTERN "needle"
+
+/*
+ * Type: Operation
+ * ---------------
+ * This type identifies the operation that a measurement performs.
+ */
+
+typedef enum {
+   FIND_CHAR,
+   FIND_STRING,
+   FIND_LAST_CHAR,
+   FIND_LAST_STRING,
+   EQUAL_IGNORE_CASE,
+   TO_LOWER_CASE,
+   TO_UPPER_CASE
+} Operation;
+
+/*
+ * Type: Inputs
+ * ------------
+ * This type holds the strings on which the operations run.  The text
+ * has the pattern at its end, the reversed text has it at its start,
+ * and the upper-case text matches the text except for case.
+ */
+
+typedef struct {
+   string text;
+   string reversed;
+   string upper;
+} Inputs;
+
+/* Private function prototypes */
+
+static void createInputs(Inputs *inputs, int size);
+static void freeInputs(Inputs *inputs);
+static void measure(string name, Operation op, Inputs *inputs, int size);
+static int run(Operation op, Inputs *inputs, bool library);
+static int findCharLoop(char ch, string text);
+static int findStringLoop(string str, string text);
+static int findLastCharLoop(char ch, string text);
+static int findLastStringLoop(string str, string text);
+static bool equalIgnoreCaseLoop(string s1, string s2);
+static string convertCaseLoop(string s, bool upper);
+static double elapsedSeconds(struct timespec *start);
+static void startTimer(struct timespec *start);
+
+/* Main program */
+
+int main(int argc, string argv[]) {
+   Inputs inputs;
+   long size, maxSize;
+
+   maxSize = (argc > 1) ? stringToInteger(argv[1]) : DEFAULT_MAX_SIZE;
+   setRandomSeed(1);
+   for (size = MIN_SIZE; size <= maxSize; size *= SIZE_STEP) {
+      if (size * SIZE_STEP > maxSize) size = maxSize;
+      createInputs(&inputs, (int) size);
+      printf("\nStrings of %ld bytes\n", size);
+      printf("%-24s %12s %10s %12s %10s %8s\n", "Function", "Loop",
+             "MB/s", "strlib", "MB/s", "Speedup");
+      measure("findChar", FIND_CHAR, &inputs, (int) size);
+      measure("findString", FIND_STRING, &inputs, (int) size);
+      measure("findLastChar", FIND_LAST_CHAR, &inputs, (int) size);
+      measure("findLastString", FIND_LAST_STRING, &inputs, (int) size);
+      measure("stringEqualIgnoreCase", EQUAL_IGNORE_CASE, &inputs,
+              (int) size);
+      measure("toLowerCase", TO_LOWER_CASE, &inputs, (int) size);
+      measure("toUpperCase", TO_UPPER_CASE, &inputs, (int) size);
+      freeInputs(&inputs);
+      if (size == maxSize) break;
+   }
+   return 0;
+}
+
+/*
+ * Function: createInputs
+ * Usage: createInputs(&inputs, size);
+ * -----------------------------------
+ * Fills the text with random lower-case letters and spaces, which
+ * contain many partial matches for the pattern, and then writes the
+ * pattern and the character '!' at the end.  The reversed text begins
+ * with '!' followed by the pattern.
+ */
+
+static void createInputs(Inputs *inputs, int size) {
+   int i, n;
+
+   inputs->text = newArray(size + 1, char);
+   for (i = 0; i < size; i++) {
+      n = randomInteger(0, 26);
+      inputs->text[i] = (n == 26) ? ' ' : 'a' + n;
+   }
+   inputs->text[size] = '\0';
+   n = strlen(PATTERN);
+   memcpy(inputs->text + size - n - 1, PATTERN, n);
+   inputs->text[size - 1] = '!';
+   inputs->reversed = newArray(size + 1, char);
+   for (i = 0; i < size; i++) {
+      inputs->reversed[i] = inputs->text[size - 1 - i];
+   }
+   inputs->reversed[size] = '\0';
+   memcpy(inputs->reversed + 1, PATTERN, n);
+   inputs->upper = toUpperCase(inputs->text);
+}
+
+static void freeInputs(Inputs *inputs) {
+   freeBlock(inputs->text);
+   freeBlock(inputs->reversed);
+   freeBlock(inputs->upper);
+}
+
+/*
+ * Function: measure
+ * Usage: measure(name, op, &inputs, size);
+ * ----------------------------------------
+ * Times the operation written as a loop and as a call to strlib,
+ * repeating each enough times to read about BYTES_PER_TEST bytes, and
+ * prints one line of the table.  The function checks that both versions
+ * produce the same result.
+ */
+
+static void measure(string name, Operation op, Inputs *inputs, int size) {
+   struct timespec timer;
+   double loopTime, libraryTime;
+   int reps, i, loopResult, libraryResult;
+
+   reps = BYTES_PER_TEST / size;
+   if (reps < 1) reps = 1;
+   startTimer(&timer);
+   for (i = 0; i < reps; i++) {
+      loopResult = run(op, inputs, false);
+   }
+   loopTime = elapsedSeconds(&timer) / reps;
+   startTimer(&timer);
+   for (i = 0; i < reps; i++) {
+      libraryResult = run(op, inputs, true);
+   }
+   libraryTime = elapsedSeconds(&timer) / reps;
+   if (loopResult != libraryResult) error("%s: Results differ", name);
+   printf("%-24s %10.3fms %10.0f %10.3fms %10.0f %7.1fx\n", name,
+          1000 * loopTime, size / loopTime / 1e6, 1000 * libraryTime,
+          size / libraryTime / 1e6, loopTime / libraryTime);
+}
+
+/*
+ * Function: run
+ * Usage: result = run(op, &inputs, library);
+ * ------------------------------------------
+ * Performs the operation once, using strlib if library is true and the
+ * loop otherwise, and returns an integer summarizing the result.
+ */
+
+static int run(Operation op, Inputs *inputs, bool library) {
+   string result;
+   int n;
+
+   switch (op) {
+    case FIND_CHAR:
+      if (library) return findChar('!', inputs->text, 0);
+      return findCharLoop('!', inputs->text);
+    case FIND_STRING:
+      if (library) return findString(PATTERN, inputs->text, 0);
+      return findStringLoop(PATTERN, inputs->text);
+    case FIND_LAST_CHAR:
+      if (library) return findLastChar('!', inputs->reversed);
+      return findLastCharLoop('!', inputs->reversed);
+    case FIND_LAST_STRING:
+      if (library) return findLastString(PATTERN, inputs->reversed);
+      return findLastStringLoop(PATTERN, inputs->reversed);
+    case EQUAL_IGNORE_CASE:
+      if (library) return stringEqualIgnoreCase(inputs->text, inputs->upper);
+      return equalIgnoreCaseLoop(inputs->text, inputs->upper);
+    case TO_LOWER_CASE: case TO_UPPER_CASE:
+      if (library) {
+         result = (op == TO_LOWER_CASE) ? toLowerCase(inputs->upper)
+                                        : toUpperCase(inputs->text);
+      } else {
+         result = convertCaseLoop((op == TO_LOWER_CASE) ? inputs->upper
+                                                        : inputs->text,
+                                  op == TO_UPPER_CASE);
+      }
+      n = result[0];
+      freeBlock(result);
+      return n;
+   }
+   return -1;
+}
+
+/*
+ * Functions: findCharLoop, findStringLoop, findLastCharLoop,
+ *            findLastStringLoop, equalIgnoreCaseLoop, convertCaseLoop
+ * -------------------------------------------------------------------
+ * These functions perform the operations one character at a time.
+ */
+
+static int findCharLoop(char ch, string text) {
+   int i;
+
+   for (i = 0; text[i] != '\0'; i++) {
+      if (text[i] == ch) return i;
+   }
+   return -1;
+}
+
+static int findStringLoop(string str, string text) {
+   int i, j;
+
+   for (i = 0; text[i] != '\0'; i++) {
+      for (j = 0; str[j] != '\0' && text[i + j] == str[j]; j++) {
+         /* Empty */
+      }
+      if (str[j] == '\0') return i;
+   }
+   return -1;
+}
+
+static int findLastCharLoop(char ch, string text) {
+   int i;
+
+   for (i = strlen(text) - 1; i >= 0; i--) {
+      if (text[i] == ch) return i;
+   }
+   return -1;
+}
+
+static int findLastStringLoop(string str, string text) {
+   int i, nc;
+
+   nc = strlen(str);
+   for (i = strlen(text) - nc; i >= 0; i--) {
+      if (strncmp(str, text + i, nc) == 0) return i;
+   }
+   return -1;
+}
+
+static bool equalIgnoreCaseLoop(string s1, string s2) {
+   int i;
+
+   for (i = 0; s1[i] != '\0'; i++) {
+      if (tolower(s1[i]) != tolower(s2[i])) return false;
+   }
+   return s2[i] == '\0';
+}
+
+static string convertCaseLoop(string s, bool upper) {
+   string result;
+   int i;
+
+   result = newArray(strlen(s) + 1, char);
+   for (i = 0; s[i] != '\0'; i++) {
+      result[i] = upper ? toupper(s[i]) : tolower(s[i]);
+   }
+   result[i] = '\0';
+   return result;
+}
+
+static void startTimer(struct timespec *start) {
+   clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+static double elapsedSeconds(struct timespec *start) {
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
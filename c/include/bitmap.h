@@ -0,0 +1,215 @@
+/*
+ * File: bitmap.h
+ * --------------
+ * This interface exports a compressed bitmap, which represents a set of
+ * 32-bit unsigned integers.  The values are divided into chunks of 65536
+ * according to their upper 16 bits, and each chunk is stored in the
+ * most compact of three forms: a sorted array of the lower 16 bits when
+ * the chunk holds few values, an array of 65536 bits when it holds many,
+ * or a list of runs of consecutive values when those are more compact
+ * than either.  This design, which is known as a
+ * <b><i>roaring bitmap</i></b>, uses far less memory than a tree and
+ * computes unions and intersections a whole chunk at a time.
+ *
+ * <p>Most applications will use the <code>Set</code> type instead,
+ * which can be asked to use a bitmap for sets of <code>int</code> or
+ * <code>unsigned</code> values.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _bitmap_h
+#define _bitmap_h
+
+#include "cslib.h"
+#include "iterator.h"
+
+/**
+ * Type: Bitmap
+ * ------------
+ * The abstract type for a compressed bitmap.
+ */
+
+typedef struct BitmapCDT *Bitmap;
+
+/**
+ * Function: newBitmap
+ * Usage: bm = newBitmap();
+ * ------------------------
+ * Creates a new bitmap that contains no values.
+ */
+
+Bitmap newBitmap(void);
+
+/**
+ * Function: freeBitmap
+ * Usage: freeBitmap(bm);
+ * ----------------------
+ * Frees the storage associated with a bitmap.
+ */
+
+void freeBitmap(Bitmap bm);
+
+/**
+ * Function: size
+ * Usage: n = size(bm);
+ * --------------------
+ * Returns the number of values in the bitmap.
+ */
+
+int sizeBitmap(Bitmap bm);
+
+/**
+ * Function: isEmpty
+ * Usage: if (isEmpty(bm)) . . .
+ * -----------------------------
+ * Returns <code>true</code> if the bitmap contains no values.
+ */
+
+bool isEmptyBitmap(Bitmap bm);
+
+/**
+ * Function: clear
+ * Usage: clear(bm);
+ * -----------------
+ * Removes all values from the bitmap.
+ */
+
+void clearBitmap(Bitmap bm);
+
+/**
+ * Function: clone
+ * Usage: newbm = clone(bm);
+ * -------------------------
+ * Creates a copy of the bitmap.
+ */
+
+Bitmap cloneBitmap(Bitmap bm);
+
+/**
+ * Function: containsBitmap
+ * Usage: if (containsBitmap(bm, value)) . . .
+ * -------------------------------------------
+ * Returns <code>true</code> if the bitmap contains <code>value</code>.
+ */
+
+bool containsBitmap(Bitmap bm, unsigned value);
+
+/**
+ * Function: addBitmap
+ * Usage: addBitmap(bm, value);
+ * ----------------------------
+ * Adds <code>value</code> to the bitmap.  Adding values in ascending
+ * order is particularly efficient.
+ */
+
+void addBitmap(Bitmap bm, unsigned value);
+
+/**
+ * Function: removeBitmap
+ * Usage: removeBitmap(bm, value);
+ * -------------------------------
+ * Removes <code>value</code> from the bitmap, if it is there.
+ */
+
+void removeBitmap(Bitmap bm, unsigned value);
+
+/**
+ * Function: rankBitmap
+ * Usage: rank = rankBitmap(bm, value);
+ * ------------------------------------
+ * Returns the number of values in the bitmap that are less than
+ * <code>value</code>, which need not itself be in the bitmap.
+ */
+
+int rankBitmap(Bitmap bm, unsigned value);
+
+/**
+ * Function: equalsBitmap
+ * Usage: if (equalsBitmap(b1, b2)) . . .
+ * --------------------------------------
+ * Returns <code>true</code> if the two bitmaps contain the same values.
+ */
+
+bool equalsBitmap(Bitmap b1, Bitmap b2);
+
+/**
+ * Function: isSubsetBitmap
+ * Usage: if (isSubsetBitmap(b1, b2)) . . .
+ * ----------------------------------------
+ * Returns <code>true</code> if every value in <code>b1</code> is also
+ * in <code>b2</code>.
+ */
+
+bool isSubsetBitmap(Bitmap b1, Bitmap b2);
+
+/**
+ * Function: unionBitmap
+ * Usage: bm = unionBitmap(b1, b2);
+ * --------------------------------
+ * Returns a new bitmap containing the values in either argument.
+ */
+
+Bitmap unionBitmap(Bitmap b1, Bitmap b2);
+
+/**
+ * Function: intersectionBitmap
+ * Usage: bm = intersectionBitmap(b1, b2);
+ * ---------------------------------------
+ * Returns a new bitmap containing the values in both arguments.
+ */
+
+Bitmap intersectionBitmap(Bitmap b1, Bitmap b2);
+
+/**
+ * Function: differenceBitmap
+ * Usage: bm = differenceBitmap(b1, b2);
+ * -------------------------------------
+ * Returns a new bitmap containing the values in <code>b1</code> that
+ * are not in <code>b2</code>.
+ */
+
+Bitmap differenceBitmap(Bitmap b1, Bitmap b2);
+
+/**
+ * Function: optimizeBitmap
+ * Usage: optimizeBitmap(bm);
+ * --------------------------
+ * Converts each chunk that consists mostly of runs of consecutive values
+ * into the run representation, if that saves space.  The bitmap
+ * continues to work correctly without this call, which is worth making
+ * after a large number of values have been added.
+ */
+
+void optimizeBitmap(Bitmap bm);
+
+/**
+ * Function: newBitmapRangeIterator
+ * Usage: foreach (value in newBitmapRangeIterator(bm, lo, hi)) . . .
+ * ------------------------------------------------------------------
+ * Returns an iterator that produces, in ascending order, the values in
+ * the bitmap that lie between <code>lo</code> and <code>hi</code>,
+ * inclusive.  Using the bitmap itself in a <code>foreach</code> loop
+ * produces all of its values in the same order.  In either case, the
+ * bitmap must not be modified while the iteration is in progress.
+ */
+
+Iterator newBitmapRangeIterator(Bitmap bm, unsigned lo, unsigned hi);
+
+#endif
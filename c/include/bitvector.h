@@ -0,0 +1,243 @@
+/*
+ * File: bitvector.h
+ * -----------------
+ * This interface exports a fixed-length vector of bits, which is the
+ * most compact way to represent a set of small nonnegative integers,
+ * such as the indices of the nodes visited in a graph.  The generic
+ * collection functions treat a <code>BitVector</code> as the set of
+ * indices whose bits are on, so that, for example, <code>size</code>
+ * returns the number of such bits and <code>foreach</code> produces
+ * their indices in ascending order.  Since the vector is a set rather
+ * than a sequence, <code>get</code> and <code>set</code> report errors;
+ * the bits are tested with <code>contains</code> and changed with
+ * <code>add</code> and <code>remove</code>.  The bulk operations combine
+ * whole words, and several words at a time where the processor allows.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _bitvector_h
+#define _bitvector_h
+
+#include "cslib.h"
+#include "generic.h"
+
+/**
+ * Type: BitVector
+ * ---------------
+ * The abstract type for a vector of bits.
+ */
+
+typedef struct BitVectorCDT *BitVector;
+
+/* Exported entries */
+
+/**
+ * Function: newBitVector
+ * Usage: bv = newBitVector(nBits);
+ * --------------------------------
+ * Creates a vector of <code>nBits</code> bits, all of which are off.
+ */
+
+BitVector newBitVector(int nBits);
+
+/**
+ * Function: freeBitVector
+ * Usage: freeBitVector(bv);
+ * -------------------------
+ * Frees the storage associated with the bit vector.
+ */
+
+void freeBitVector(BitVector bv);
+
+/**
+ * Function: lengthBitVector
+ * Usage: n = lengthBitVector(bv);
+ * -------------------------------
+ * Returns the number of bits in the vector, whether on or off.
+ */
+
+int lengthBitVector(BitVector bv);
+
+/**
+ * Function: size
+ * Usage: n = size(bv);
+ * --------------------
+ * Returns the number of bits that are on.
+ */
+
+int sizeBitVector(BitVector bv);
+
+/**
+ * Function: isEmpty
+ * Usage: if (isEmpty(bv)) . . .
+ * -----------------------------
+ * Returns <code>true</code> if no bits are on.
+ */
+
+bool isEmptyBitVector(BitVector bv);
+
+/**
+ * Function: clear
+ * Usage: clear(bv);
+ * -----------------
+ * Turns off every bit without changing the length of the vector.
+ */
+
+void clearBitVector(BitVector bv);
+
+/**
+ * Function: clone
+ * Usage: newbv = clone(bv);
+ * -------------------------
+ * Creates a copy of the bit vector.
+ */
+
+BitVector cloneBitVector(BitVector bv);
+
+/**
+ * Function: contains
+ * Usage: if (contains(bv, k)) . . .
+ * ---------------------------------
+ * Returns <code>true</code> if bit <code>k</code> is on.
+ */
+
+bool containsBitVector(BitVector bv, int k);
+
+/**
+ * Function: add
+ * Usage: add(bv, k);
+ * ------------------
+ * Turns on bit <code>k</code>.
+ */
+
+void addBitVector(BitVector bv, int k);
+
+/**
+ * Function: remove
+ * Usage: remove(bv, k);
+ * ---------------------
+ * Turns off bit <code>k</code>.
+ */
+
+void removeBitVector(BitVector bv, int k);
+
+/**
+ * Function: nextSetBit
+ * Usage: k = nextSetBit(bv, start);
+ * ---------------------------------
+ * Returns the index of the first bit at or after <code>start</code> that
+ * is on, or -1 if there is no such bit.  The search skips a full word of
+ * bits that are off in a single step, which makes the following idiom
+ * efficient for sparse vectors:
+ *
+ *<pre>
+ *    for (k = nextSetBit(bv, 0); k >= 0; k = nextSetBit(bv, k + 1)) . . .
+ *</pre>
+ */
+
+int nextSetBit(BitVector bv, int start);
+
+/**
+ * Function: andBitVector
+ * Usage: andBitVector(dst, src);
+ * ------------------------------
+ * Turns off each bit in <code>dst</code> that is off in <code>src</code>.
+ * This function and the three that follow update <code>dst</code> in
+ * place and require both vectors to have the same length.
+ */
+
+void andBitVector(BitVector dst, BitVector src);
+
+/**
+ * Function: orBitVector
+ * Usage: orBitVector(dst, src);
+ * -----------------------------
+ * Turns on each bit in <code>dst</code> that is on in <code>src</code>.
+ */
+
+void orBitVector(BitVector dst, BitVector src);
+
+/**
+ * Function: xorBitVector
+ * Usage: xorBitVector(dst, src);
+ * ------------------------------
+ * Inverts each bit in <code>dst</code> that is on in <code>src</code>.
+ */
+
+void xorBitVector(BitVector dst, BitVector src);
+
+/**
+ * Function: andNotBitVector
+ * Usage: andNotBitVector(dst, src);
+ * ---------------------------------
+ * Turns off each bit in <code>dst</code> that is on in <code>src</code>.
+ */
+
+void andNotBitVector(BitVector dst, BitVector src);
+
+/**
+ * Function: equals
+ * Usage: if (equals(b1, b2)) . . .
+ * --------------------------------
+ * Returns <code>true</code> if <code>b1</code> and <code>b2</code> have
+ * the same length and the same bits on.
+ */
+
+bool equalsBitVector(BitVector b1, BitVector b2);
+
+/**
+ * Function: isSubset
+ * Usage: if (isSubset(b1, b2)) . . .
+ * ----------------------------------
+ * Returns <code>true</code> if every bit that is on in <code>b1</code>
+ * is also on in <code>b2</code>.
+ */
+
+bool isSubsetBitVector(BitVector b1, BitVector b2);
+
+/**
+ * Function: union
+ * Usage: bv = union(b1, b2);
+ * --------------------------
+ * Returns a new vector with the bits that are on in either argument.
+ */
+
+BitVector unionBitVector(BitVector b1, BitVector b2);
+
+/**
+ * Function: intersection
+ * Usage: bv = intersection(b1, b2);
+ * ---------------------------------
+ * Returns a new vector with the bits that are on in both arguments.
+ */
+
+BitVector intersectionBitVector(BitVector b1, BitVector b2);
+
+/**
+ * Function: setDifference
+ * Usage: bv = setDifference(b1, b2);
+ * ----------------------------------
+ * Returns a new vector with the bits that are on in <code>b1</code>
+ * and off in <code>b2</code>.
+ */
+
+BitVector setDifferenceBitVector(BitVector b1, BitVector b2);
+
+#endif
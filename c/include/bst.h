@@ -137,6 +137,21 @@ void clearBST(BST bst);
 
 BST cloneBST(BST bst);
 
+/**
+ * Function: shareBST
+ * Usage: newbst = shareBST(bst);
+ * ------------------------------
+ * Creates a copy of the BST in constant time by sharing its nodes with
+ * the original.  When either tree is later changed, only the nodes on the
+ * path to the change are copied, so the other tree is unaffected.  The
+ * node returned by <code>insertBSTNode</code> always belongs to a single
+ * tree, which makes it safe to call <code>setNodeValue</code> on it, but
+ * nodes obtained in any other way may be shared and must not be changed.
+ * Each node is freed when the last tree that refers to it is freed.
+ */
+
+BST shareBST(BST bst);
+
 /**
  * Function: findBSTNode
  * Usage: node = findBSTNode(bst, key);
@@ -200,13 +215,76 @@ void removeBSTNode(BST bst, ...);
 
 void removeBSTNodeFromArg(BST bst, GenericType any);
 
+/**
+ * Friend function: rankBSTFromArg
+ * Usage: rank = rankBSTFromArg(bst, any);
+ * ---------------------------------------
+ * Returns the number of keys in the tree that are less than the key
+ * taken from the generic argument, which need not be in the tree.
+ */
+
+int rankBSTFromArg(BST bst, GenericType any);
+
+/**
+ * Function: selectBSTNode
+ * Usage: node = selectBSTNode(bst, k);
+ * ------------------------------------
+ * Returns the node whose key is the <code>k</code>th smallest in the
+ * tree, counting from 0, or <code>NULL</code> if <code>k</code> is not
+ * between 0 and one less than the size of the tree.  Because every node
+ * records the size of its subtree, this function runs in logarithmic
+ * time.
+ */
+
+BSTNode selectBSTNode(BST bst, int k);
+
+/**
+ * Friend function: floorBSTNodeFromArg
+ * Usage: node = floorBSTNodeFromArg(bst, any);
+ * --------------------------------------------
+ * Returns the node with the largest key that is less than or equal to
+ * the key taken from the generic argument, or <code>NULL</code> if there
+ * is no such node.
+ */
+
+BSTNode floorBSTNodeFromArg(BST bst, GenericType any);
+
+/**
+ * Friend function: ceilingBSTNodeFromArg
+ * Usage: node = ceilingBSTNodeFromArg(bst, any);
+ * ----------------------------------------------
+ * Returns the node with the smallest key that is greater than or equal
+ * to the key taken from the generic argument, or <code>NULL</code> if
+ * there is no such node.
+ */
+
+BSTNode ceilingBSTNodeFromArg(BST bst, GenericType any);
+
+/**
+ * Function: buildBSTFromSorted
+ * Usage: buildBSTFromSorted(bst, keys, values, n);
+ * ------------------------------------------------
+ * Replaces the contents of the BST with a perfectly balanced tree that
+ * holds the <code>n</code> keys in the array <code>keys</code>, which
+ * must be in ascending order.  If <code>values</code> is not
+ * <code>NULL</code>, each node takes its value from the corresponding
+ * element of that array.  If a key appears more than once, the tree
+ * keeps its last occurrence.  The tree is built in linear time, which
+ * is much faster than inserting the keys one at a time.  Calling
+ * <code>buildBSTFromSorted</code> with unsorted keys is an error.
+ */
+
+void buildBSTFromSorted(BST bst, GenericType keys[], void *values[], int n);
+
 /**
  * Function: mapBST
  * Usage: mapBST(bst, fn, order, data);
  * ------------------------------------
  * Calls a function on every node in the binary search tree using the
  * specified iteration order.  The arguments to the callback function
- * are a pointer to the node and the <code>data</code> pointer.
+ * are a pointer to the node and the <code>data</code> pointer.  The
+ * traversal uses neither recursion nor dynamic allocation, but the
+ * callback function must not add nodes to or remove nodes from the tree.
  */
 
 void mapBST(BST bst, proc fn, TraversalOrder order, void *data);
@@ -217,11 +295,29 @@ void mapBST(BST bst, proc fn, TraversalOrder order, void *data);
  * ----------------------------------------------
  * Returns an iterator for traversing the nodes in a binary search tree
  * in the specified order.  The <code>foreach</code> statement
- * automatically uses an <code>INORDER</code> traversal.
+ * automatically uses an <code>INORDER</code> traversal.  The iterator
+ * produces the nodes one at a time as the traversal proceeds, so that
+ * starting an iteration takes constant time and space proportional to
+ * the height of the tree.  The tree must therefore not be modified while
+ * the iteration is in progress.
  */
 
 Iterator newNodeIterator(BST bst, TraversalOrder order);
 
+/**
+ * Friend function: newRangeNodeIterator
+ * Usage: iterator = newRangeNodeIterator(bst, lo, hi);
+ * ----------------------------------------------------
+ * Returns an iterator that produces, in ascending order, the nodes whose
+ * keys lie between the keys addressed by <code>lo</code> and
+ * <code>hi</code>, inclusive.  Either pointer may be <code>NULL</code>,
+ * in which case the range is unbounded at that end.  The iterator visits
+ * only the nodes on the way to the range and those within it, so the
+ * tree must not be modified while the iteration is in progress.
+ */
+
+Iterator newRangeNodeIterator(BST bst, GenericType *lo, GenericType *hi);
+
 /**
  * Function: getRootBST
  * Usage: root = getRootBST(bst);
@@ -0,0 +1,320 @@
+/*
+ * File: btree.h
+ * -------------
+ * This interface supports a general abstraction for B-trees.  A
+ * <b><i>B-tree</i></b> is a balanced search tree in which each node
+ * holds many keys in sorted order, along with one more child pointer
+ * than it has keys.  Because the keys in a node are stored contiguously,
+ * a lookup touches only a handful of nodes, which makes B-trees much
+ * friendlier to the memory cache than binary search trees when the
+ * collection is large.
+ *
+ * <p>As with the <code>bst.h</code> interface, most applications will
+ * use the <code>Map</code> and <code>Set</code> types instead, which
+ * can be asked to use a B-tree in their implementation.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _btree_h
+#define _btree_h
+
+#include <stdarg.h>
+#include "cmpfn.h"
+#include "cslib.h"
+#include "generic.h"
+#include "iterator.h"
+
+/**
+ * Type: BTree
+ * -----------
+ * The abstract type for a B-tree.
+ */
+
+typedef struct BTreeCDT *BTree;
+
+/**
+ * Type: BTreeEntry
+ * ----------------
+ * This type holds a copy of a key and its associated value.  Entries of
+ * this type are produced by the iterator returned from
+ * <code>newEntryIterator</code>.
+ */
+
+typedef struct {
+   GenericType key;
+   void *value;
+} BTreeEntry;
+
+/**
+ * Function: newBTree
+ * Usage: bt = newBTree(type);
+ * ---------------------------
+ * Creates a new empty B-tree for keys with the specified base type.  The
+ * <code>type</code> parameter must be an explicit type name like
+ * <code>int</code> or <code>string</code>.
+ */
+
+#define newBTree(type) newBTreeFromType(#type)
+
+/**
+ * Function: newBTreeFromType
+ * Usage: bt = newBTreeFromType(baseType);
+ * ---------------------------------------
+ * Creates a new empty B-tree for keys with the specified base type
+ * expressed as a string.
+ */
+
+BTree newBTreeFromType(string baseType);
+
+/**
+ * Function: freeBTree
+ * Usage: freeBTree(bt);
+ * ---------------------
+ * Frees the storage for a B-tree.  If the values contain allocated
+ * storage, the client must free this storage before calling
+ * <code>freeBTree</code>.
+ */
+
+void freeBTree(BTree bt);
+
+/**
+ * Function: size
+ * Usage: n = size(bt);
+ * --------------------
+ * Returns the number of keys in the B-tree.
+ */
+
+int sizeBTree(BTree bt);
+
+/**
+ * Function: isEmpty
+ * Usage: if (isEmpty(bt)) . . .
+ * -----------------------------
+ * Returns <code>true</code> if the B-tree has no keys.
+ */
+
+bool isEmptyBTree(BTree bt);
+
+/**
+ * Function: clear
+ * Usage: clear(bt);
+ * -----------------
+ * Removes all keys from the B-tree.
+ */
+
+void clearBTree(BTree bt);
+
+/**
+ * Function: clone
+ * Usage: newbt = clone(bt);
+ * -------------------------
+ * Creates a copy of the B-tree.  The keys and values are copied by
+ * assignment, so any storage they refer to is shared.
+ */
+
+BTree cloneBTree(BTree bt);
+
+/**
+ * Function: findBTreeEntry
+ * Usage: vp = findBTreeEntry(bt, key);
+ * ------------------------------------
+ * Looks up the key in the B-tree.  If the key exists,
+ * <code>findBTreeEntry</code> returns a pointer to the value field
+ * associated with that key; if not, it returns <code>NULL</code>.
+ * The pointer remains valid only until the B-tree is next modified.
+ */
+
+void **findBTreeEntry(BTree bt, ...);
+
+/**
+ * Friend function: findBTreeEntryFromArg
+ * Usage: vp = findBTreeEntryFromArg(bt, any);
+ * -------------------------------------------
+ * Looks up the key stored in the generic argument.
+ */
+
+void **findBTreeEntryFromArg(BTree bt, GenericType any);
+
+/**
+ * Function: insertBTreeEntry
+ * Usage: vp = insertBTreeEntry(bt, key);
+ * --------------------------------------
+ * Inserts the key into the B-tree, unless it is already there.  In either
+ * case, <code>insertBTreeEntry</code> returns a pointer to the value
+ * field associated with the key.  The value field of a new key is
+ * initialized to <code>NULL</code>.  The pointer remains valid only until
+ * the B-tree is next modified.
+ */
+
+void **insertBTreeEntry(BTree bt, ...);
+
+/**
+ * Friend function: insertBTreeEntryFromArg
+ * Usage: vp = insertBTreeEntryFromArg(bt, any);
+ * ---------------------------------------------
+ * Inserts the key stored in the generic argument.
+ */
+
+void **insertBTreeEntryFromArg(BTree bt, GenericType any);
+
+/**
+ * Function: removeBTreeEntry
+ * Usage: removeBTreeEntry(bt, key);
+ * ---------------------------------
+ * Removes the key from the B-tree.  If the key does not exist, the
+ * B-tree is unchanged.
+ */
+
+void removeBTreeEntry(BTree bt, ...);
+
+/**
+ * Friend function: removeBTreeEntryFromArg
+ * Usage: removeBTreeEntryFromArg(bt, any);
+ * ----------------------------------------
+ * Removes the key stored in the generic argument.
+ */
+
+void removeBTreeEntryFromArg(BTree bt, GenericType any);
+
+/**
+ * Friend function: rankBTreeFromArg
+ * Usage: rank = rankBTreeFromArg(bt, any);
+ * ----------------------------------------
+ * Returns the number of keys in the B-tree that are less than the key
+ * stored in the generic argument, which need not be in the tree.
+ */
+
+int rankBTreeFromArg(BTree bt, GenericType any);
+
+/**
+ * Function: selectBTreeEntry
+ * Usage: if (selectBTreeEntry(bt, k, &entry)) . . .
+ * -------------------------------------------------
+ * Copies the entry whose key is the <code>k</code>th smallest in the
+ * B-tree, counting from 0, into <code>entry</code> and returns
+ * <code>true</code>.  If <code>k</code> is out of range, the function
+ * returns <code>false</code>.  Because every node records the number of
+ * keys in its subtree, this function runs in logarithmic time.
+ */
+
+bool selectBTreeEntry(BTree bt, int k, BTreeEntry *dst);
+
+/**
+ * Friend function: floorBTreeEntryFromArg
+ * Usage: if (floorBTreeEntryFromArg(bt, any, &entry)) . . .
+ * ---------------------------------------------------------
+ * Copies the entry with the largest key that is less than or equal to
+ * the key stored in the generic argument into <code>entry</code>.  The
+ * function returns <code>false</code> if there is no such entry.
+ */
+
+bool floorBTreeEntryFromArg(BTree bt, GenericType any, BTreeEntry *dst);
+
+/**
+ * Friend function: ceilingBTreeEntryFromArg
+ * Usage: if (ceilingBTreeEntryFromArg(bt, any, &entry)) . . .
+ * -----------------------------------------------------------
+ * Copies the entry with the smallest key that is greater than or equal
+ * to the key stored in the generic argument into <code>entry</code>.
+ * The function returns <code>false</code> if there is no such entry.
+ */
+
+bool ceilingBTreeEntryFromArg(BTree bt, GenericType any, BTreeEntry *dst);
+
+/**
+ * Function: buildBTreeFromSorted
+ * Usage: buildBTreeFromSorted(bt, keys, values, n);
+ * -------------------------------------------------
+ * Replaces the contents of the B-tree with the <code>n</code> keys in
+ * the array <code>keys</code>, which must be in ascending order.  If
+ * <code>values</code> is not <code>NULL</code>, each key takes its value
+ * from the corresponding element of that array.  If a key appears more
+ * than once, the tree keeps its last occurrence.  The tree is built in
+ * linear time and has the smallest possible height.  Calling
+ * <code>buildBTreeFromSorted</code> with unsorted keys is an error.
+ */
+
+void buildBTreeFromSorted(BTree bt, GenericType keys[], void *values[], int n);
+
+/**
+ * Function: newEntryIterator
+ * Usage: iterator = newEntryIterator(bt);
+ * ---------------------------------------
+ * Creates an iterator that steps through the entries of the B-tree in
+ * ascending key order.  Each element produced by the iterator is a
+ * <code>BTreeEntry</code>.  Using the B-tree itself in a
+ * <code>foreach</code> loop iterates over its keys in the same order.
+ * In either case, the iterator does not copy the tree, so the B-tree
+ * must not be modified while the iteration is in progress.
+ */
+
+Iterator newEntryIterator(BTree bt);
+
+/**
+ * Friend function: newRangeEntryIterator
+ * Usage: iterator = newRangeEntryIterator(bt, lo, hi);
+ * ----------------------------------------------------
+ * Creates an iterator that steps through the entries whose keys lie
+ * between the keys addressed by <code>lo</code> and <code>hi</code>,
+ * inclusive.  Either pointer may be <code>NULL</code>, in which case the
+ * range is unbounded at that end.  The iterator starts at the first key
+ * in the range without visiting the keys that precede it.
+ */
+
+Iterator newRangeEntryIterator(BTree bt, GenericType *lo, GenericType *hi);
+
+/**
+ * Friend function: getBaseTypeBTree
+ * Usage: baseType = getBaseTypeBTree(bt);
+ * ---------------------------------------
+ * Returns the base type of the B-tree.
+ */
+
+string getBaseTypeBTree(BTree bt);
+
+/**
+ * Friend function: getBaseTypeSizeBTree
+ * Usage: size = getBaseTypeSizeBTree(bt);
+ * ---------------------------------------
+ * Returns the size of the base type of the B-tree.
+ */
+
+int getBaseTypeSizeBTree(BTree bt);
+
+/**
+ * Function: setCompareFnBTree
+ * Usage: setCompareFnBTree(bt, cmpFn);
+ * ------------------------------------
+ * Sets the comparison function for keys in the B-tree.  This function
+ * must be called before any keys are inserted.
+ */
+
+void setCompareFnBTree(BTree bt, CompareFn cmpFn);
+
+/**
+ * Function: getCompareFnBTree
+ * Usage: cmpFn = getCompareFnBTree(bt);
+ * -------------------------------------
+ * Returns the comparison function for keys in the B-tree.
+ */
+
+CompareFn getCompareFnBTree(BTree bt);
+
+#endif
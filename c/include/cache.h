@@ -0,0 +1,345 @@
+/*
+ * File: cache.h
+ * -------------
+ * This interface exports a bounded cache that maps string keys to
+ * values.  A cache has a capacity, and adding an entry that would exceed
+ * it first evicts entries chosen by the cache's eviction policy.  Each
+ * entry has a cost, which is 1 unless the client specifies otherwise, so
+ * the capacity can limit either the number of entries or the total of a
+ * measure such as their size in bytes.  A client-supplied eviction
+ * function is called for every value that the cache discards, which
+ * gives the client a single place to release the storage for values.
+ *
+ * <p>The <code>Cache</code> type is not safe for use by several threads
+ * at once.  The <code>SharedCache</code> type provides the same
+ * operations for multithreaded programs by dividing the entries among
+ * several independently locked caches.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _cache_h
+#define _cache_h
+
+#include "cslib.h"
+
+/**
+ * Type: Cache
+ * -----------
+ * The abstract type for a cache.
+ */
+
+typedef struct CacheCDT *Cache;
+
+/**
+ * Type: SharedCache
+ * -----------------
+ * The abstract type for a cache that several threads can use at once.
+ */
+
+typedef struct SharedCacheCDT *SharedCache;
+
+/**
+ * Type: EvictionPolicy
+ * --------------------
+ * This enumerated type identifies the strategy that a cache uses to
+ * choose the entry to evict.  <code>LRU_EVICTION</code> evicts the entry
+ * that was used least recently.  <code>CLOCK_EVICTION</code> approximates
+ * that choice by giving each recently used entry a second chance before
+ * evicting it, which makes a successful lookup cheaper because it does
+ * not need to reorder the entries.  Both policies perform every
+ * operation in constant time.
+ */
+
+typedef enum {
+   LRU_EVICTION,
+   CLOCK_EVICTION
+} EvictionPolicy;
+
+/**
+ * Type: EvictionFn
+ * ----------------
+ * This type represents the function that the cache calls when it
+ * discards a value.  The arguments are the key, the value, and the data
+ * pointer supplied to <code>setEvictionFn</code>.  The key is valid only
+ * until the function returns, and the function must not use the cache.
+ */
+
+typedef void (*EvictionFn)(string key, void *value, void *data);
+
+/* Exported entries */
+
+/**
+ * Function: newCache
+ * Usage: cache = newCache(capacity, policy);
+ * ------------------------------------------
+ * Creates an empty cache that holds entries with a total cost of at most
+ * <code>capacity</code> and evicts them according to
+ * <code>policy</code>.
+ */
+
+Cache newCache(int capacity, EvictionPolicy policy);
+
+/**
+ * Function: freeCache
+ * Usage: freeCache(cache);
+ * ------------------------
+ * Frees the storage associated with the cache, after calling the
+ * eviction function on each of its values.
+ */
+
+void freeCache(Cache cache);
+
+/**
+ * Function: setEvictionFn
+ * Usage: setEvictionFn(cache, fn, data);
+ * --------------------------------------
+ * Sets the function that the cache calls on every value that it
+ * discards, whether it is evicted, replaced by <code>putCache</code>,
+ * removed, or cleared.  The <code>data</code> pointer is passed to the
+ * function on each call.
+ */
+
+void setEvictionFn(Cache cache, EvictionFn fn, void *data);
+
+/**
+ * Function: putCache
+ * Usage: putCache(cache, key, value);
+ * -----------------------------------
+ * Associates <code>key</code> with <code>value</code> in the cache,
+ * with a cost of 1.  The new entry counts as the most recently used.
+ */
+
+void putCache(Cache cache, string key, void *value);
+
+/**
+ * Function: putCacheWithCost
+ * Usage: putCacheWithCost(cache, key, value, cost);
+ * -------------------------------------------------
+ * Associates <code>key</code> with <code>value</code> in the cache,
+ * with the specified cost, which must be positive.  A value whose cost
+ * exceeds the capacity of the cache is discarded immediately, along with
+ * any earlier value for <code>key</code>, and the other entries remain
+ * in the cache.
+ */
+
+void putCacheWithCost(Cache cache, string key, void *value, int cost);
+
+/**
+ * Function: getCache
+ * Usage: value = getCache(cache, key);
+ * ------------------------------------
+ * Returns the value associated with <code>key</code> and marks the entry
+ * as recently used, or returns <code>NULL</code> if the key is not in
+ * the cache.  Each call counts as a hit or a miss.
+ */
+
+void *getCache(Cache cache, string key);
+
+/**
+ * Function: containsKeyCache
+ * Usage: if (containsKeyCache(cache, key)) . . .
+ * ----------------------------------------------
+ * Returns <code>true</code> if <code>key</code> is in the cache, without
+ * marking it as used or counting a hit or a miss.
+ */
+
+bool containsKeyCache(Cache cache, string key);
+
+/**
+ * Function: removeCache
+ * Usage: removeCache(cache, key);
+ * -------------------------------
+ * Removes the entry for <code>key</code>, if any, from the cache.
+ */
+
+void removeCache(Cache cache, string key);
+
+/**
+ * Function: clearCache
+ * Usage: clearCache(cache);
+ * -------------------------
+ * Removes every entry from the cache.  The counters are unchanged.
+ */
+
+void clearCache(Cache cache);
+
+/**
+ * Function: sizeCache
+ * Usage: n = sizeCache(cache);
+ * ----------------------------
+ * Returns the number of entries in the cache.
+ */
+
+int sizeCache(Cache cache);
+
+/**
+ * Function: getCacheCost
+ * Usage: cost = getCacheCost(cache);
+ * ----------------------------------
+ * Returns the total cost of the entries in the cache.
+ */
+
+int getCacheCost(Cache cache);
+
+/**
+ * Function: getCacheHits
+ * Usage: n = getCacheHits(cache);
+ * -------------------------------
+ * Returns the number of calls to <code>getCache</code> that found their
+ * key.
+ */
+
+long getCacheHits(Cache cache);
+
+/**
+ * Function: getCacheMisses
+ * Usage: n = getCacheMisses(cache);
+ * ---------------------------------
+ * Returns the number of calls to <code>getCache</code> that did not find
+ * their key.
+ */
+
+long getCacheMisses(Cache cache);
+
+/**
+ * Function: getCacheEvictions
+ * Usage: n = getCacheEvictions(cache);
+ * ------------------------------------
+ * Returns the number of entries that the cache has evicted to stay
+ * within its capacity.
+ */
+
+long getCacheEvictions(Cache cache);
+
+/**
+ * Function: newSharedCache
+ * Usage: cache = newSharedCache(capacity, policy, nShards);
+ * ---------------------------------------------------------
+ * Creates an empty cache that several threads can use at once.  The
+ * entries are divided by key among <code>nShards</code> caches, each of
+ * which has an equal share of the capacity and its own lock, so that
+ * threads using different shards do not wait for one another.  Because
+ * each shard evicts on its own, the entry evicted is the one chosen by
+ * the policy within its shard rather than across the whole cache.
+ */
+
+SharedCache newSharedCache(int capacity, EvictionPolicy policy, int nShards);
+
+/**
+ * Function: freeSharedCache
+ * Usage: freeSharedCache(cache);
+ * ------------------------------
+ * Frees the storage associated with the cache.  No other thread may be
+ * using the cache.
+ */
+
+void freeSharedCache(SharedCache cache);
+
+/**
+ * Function: setSharedEvictionFn
+ * Usage: setSharedEvictionFn(cache, fn, data);
+ * --------------------------------------------
+ * Sets the eviction function for the shared cache, which is called with
+ * the lock for the entry's shard held.  This function should be called
+ * before other threads start using the cache.
+ */
+
+void setSharedEvictionFn(SharedCache cache, EvictionFn fn, void *data);
+
+/**
+ * Function: putSharedCache
+ * Usage: putSharedCache(cache, key, value);
+ * -----------------------------------------
+ * Associates <code>key</code> with <code>value</code>, with a cost of 1.
+ */
+
+void putSharedCache(SharedCache cache, string key, void *value);
+
+/**
+ * Function: putSharedCacheWithCost
+ * Usage: putSharedCacheWithCost(cache, key, value, cost);
+ * -------------------------------------------------------
+ * Associates <code>key</code> with <code>value</code>, with the
+ * specified cost.
+ */
+
+void putSharedCacheWithCost(SharedCache cache, string key, void *value,
+                            int cost);
+
+/**
+ * Function: getSharedCache
+ * Usage: value = getSharedCache(cache, key);
+ * ------------------------------------------
+ * Returns the value associated with <code>key</code>, or
+ * <code>NULL</code> if there is none.  Another thread may evict the
+ * entry as soon as this function returns, so an eviction function that
+ * frees values can free a value that a thread is still using.  Clients
+ * that free values on eviction must therefore protect them, for example
+ * with a reference count.
+ */
+
+void *getSharedCache(SharedCache cache, string key);
+
+/**
+ * Function: removeSharedCache
+ * Usage: removeSharedCache(cache, key);
+ * -------------------------------------
+ * Removes the entry for <code>key</code>, if any.
+ */
+
+void removeSharedCache(SharedCache cache, string key);
+
+/**
+ * Function: sizeSharedCache
+ * Usage: n = sizeSharedCache(cache);
+ * ----------------------------------
+ * Returns the number of entries in the cache.
+ */
+
+int sizeSharedCache(SharedCache cache);
+
+/**
+ * Function: getSharedCacheHits
+ * Usage: n = getSharedCacheHits(cache);
+ * -------------------------------------
+ * Returns the total number of hits in all shards.
+ */
+
+long getSharedCacheHits(SharedCache cache);
+
+/**
+ * Function: getSharedCacheMisses
+ * Usage: n = getSharedCacheMisses(cache);
+ * ---------------------------------------
+ * Returns the total number of misses in all shards.
+ */
+
+long getSharedCacheMisses(SharedCache cache);
+
+/**
+ * Function: getSharedCacheEvictions
+ * Usage: n = getSharedCacheEvictions(cache);
+ * ------------------------------------------
+ * Returns the total number of evictions in all shards.
+ */
+
+long getSharedCacheEvictions(SharedCache cache);
+
+#endif
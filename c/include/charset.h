@@ -2,6 +2,8 @@
  * File: charset.h
  * ---------------
  * This interface exports an abstract type that represents sets of characters.
+ * A character set is stored as a vector of 256 bits, which makes it
+ * possible to classify many characters of a string at once.
  */
 
 /*************************************************************************/
@@ -181,4 +183,39 @@ CharSet intersectionCharSet(CharSet s1, CharSet s2);
 
 CharSet setDifferenceCharSet(CharSet s1, CharSet s2);
 
+/**
+ * Function: spanCharSet
+ * Usage: n = spanCharSet(str, set);
+ * ---------------------------------
+ * Returns the length of the longest prefix of <code>str</code> that
+ * consists entirely of characters in <code>set</code>.
+ */
+
+int spanCharSet(string str, CharSet set);
+
+/**
+ * Function: findFirstInCharSet
+ * Usage: index = findFirstInCharSet(str, set);
+ * --------------------------------------------
+ * Returns the index of the first character in <code>str</code> that is
+ * a member of <code>set</code>, or -1 if there is no such character.
+ */
+
+int findFirstInCharSet(string str, CharSet set);
+
+/**
+ * Function: splitByCharSet
+ * Usage: array = splitByCharSet(str, set);
+ * ----------------------------------------
+ * Divides <code>str</code> into fields separated by the characters in
+ * <code>set</code> and returns the fields as a newly allocated,
+ * <code>NULL</code>-terminated array of newly allocated strings.
+ * Adjacent separators do not produce empty fields, so that, for example,
+ * splitting <code>"&nbsp;to&nbsp;&nbsp;be&nbsp;"</code> by the set
+ * containing the space character produces the array
+ * <code>{&nbsp;"to",&nbsp;"be",&nbsp;NULL&nbsp;}</code>.
+ */
+
+string *splitByCharSet(string str, CharSet set);
+
 #endif
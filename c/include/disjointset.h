@@ -0,0 +1,283 @@
+/*
+ * File: disjointset.h
+ * -------------------
+ * This interface exports a disjoint-set forest, also called a union-find
+ * structure, which partitions a fixed collection of elements into
+ * disjoint sets.  The elements are the integers from 0 up to the number
+ * of elements, or the nodes of a graph.  The basic operations are
+ * finding the set that contains an element and merging two sets, each
+ * of which takes nearly constant time, so that computing the connected
+ * components of a graph takes little more than one pass over its arcs.
+ *
+ * <p>The <code>ConcurrentDisjointSet</code> type provides the same
+ * operations on integer elements for programs in which several threads
+ * merge sets at once.  It uses atomic operations rather than locks.
+ *
+ * <p>For both types, the generic <code>size</code> and
+ * <code>isEmpty</code> functions count the elements.  The other generic
+ * set operations do not apply to a forest and report an error.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _disjointset_h
+#define _disjointset_h
+
+#include "cslib.h"
+#include "graph.h"
+
+/**
+ * Type: DisjointSet
+ * -----------------
+ * The abstract type for a disjoint-set forest.
+ */
+
+typedef struct DisjointSetCDT *DisjointSet;
+
+/**
+ * Type: ConcurrentDisjointSet
+ * ---------------------------
+ * The abstract type for a disjoint-set forest that several threads can
+ * update at once.
+ */
+
+typedef struct ConcurrentDisjointSetCDT *ConcurrentDisjointSet;
+
+/* Exported entries */
+
+/**
+ * Function: newDisjointSet
+ * Usage: ds = newDisjointSet(n);
+ * ------------------------------
+ * Creates a disjoint-set forest with the elements 0 through
+ * <code>n</code>&nbsp;-&nbsp;1, each of which is initially in a set by
+ * itself.
+ */
+
+DisjointSet newDisjointSet(int n);
+
+/**
+ * Function: newDisjointSetFromGraph
+ * Usage: ds = newDisjointSetFromGraph(g);
+ * ---------------------------------------
+ * Creates a disjoint-set forest with one element for each node in the
+ * graph, each of which is initially in a set by itself.  The nodes are
+ * numbered in the order of <code>getNodeSet</code>, and the node
+ * versions of the functions below translate each node to its number.
+ * Nodes added to the graph later are not part of the forest.
+ */
+
+DisjointSet newDisjointSetFromGraph(Graph g);
+
+/**
+ * Function: freeDisjointSet
+ * Usage: freeDisjointSet(ds);
+ * ---------------------------
+ * Frees the storage associated with the forest.
+ */
+
+void freeDisjointSet(DisjointSet ds);
+
+/**
+ * Function: sizeDisjointSet
+ * Usage: n = sizeDisjointSet(ds);
+ * -------------------------------
+ * Returns the number of elements in the forest.
+ */
+
+int sizeDisjointSet(DisjointSet ds);
+
+/**
+ * Function: countDisjointSets
+ * Usage: n = countDisjointSets(ds);
+ * ---------------------------------
+ * Returns the number of distinct sets in the forest.
+ */
+
+int countDisjointSets(DisjointSet ds);
+
+/**
+ * Function: findDisjointSet
+ * Usage: root = findDisjointSet(ds, k);
+ * -------------------------------------
+ * Returns the representative element of the set containing
+ * <code>k</code>.  Two elements are in the same set exactly when their
+ * representatives are equal, but the representative of a set can change
+ * when it is merged with another set.
+ */
+
+int findDisjointSet(DisjointSet ds, int k);
+
+/**
+ * Function: unionDisjointSet
+ * Usage: if (unionDisjointSet(ds, k1, k2)) . . .
+ * ----------------------------------------------
+ * Merges the sets containing <code>k1</code> and <code>k2</code>.  The
+ * function returns <code>true</code> if the elements were in different
+ * sets and <code>false</code> if they were already in the same one.
+ */
+
+bool unionDisjointSet(DisjointSet ds, int k1, int k2);
+
+/**
+ * Function: sameSetDisjointSet
+ * Usage: if (sameSetDisjointSet(ds, k1, k2)) . . .
+ * ------------------------------------------------
+ * Returns <code>true</code> if <code>k1</code> and <code>k2</code> are in
+ * the same set.
+ */
+
+bool sameSetDisjointSet(DisjointSet ds, int k1, int k2);
+
+/**
+ * Function: unionPairsDisjointSet
+ * Usage: merged = unionPairsDisjointSet(ds, starts, ends, n);
+ * -----------------------------------------------------------
+ * Merges the sets containing <code>starts[i]</code> and
+ * <code>ends[i]</code> for each <code>i</code> less than <code>n</code>
+ * and returns the number of merges that joined two different sets.
+ */
+
+int unionPairsDisjointSet(DisjointSet ds, int starts[], int ends[], int n);
+
+/**
+ * Function: findNodeDisjointSet
+ * Usage: root = findNodeDisjointSet(ds, node);
+ * --------------------------------------------
+ * Returns the representative element of the set containing
+ * <code>node</code> in a forest created by
+ * <code>newDisjointSetFromGraph</code>.
+ */
+
+int findNodeDisjointSet(DisjointSet ds, Node node);
+
+/**
+ * Function: unionNodesDisjointSet
+ * Usage: if (unionNodesDisjointSet(ds, n1, n2)) . . .
+ * ---------------------------------------------------
+ * Merges the sets containing the nodes <code>n1</code> and
+ * <code>n2</code>, returning <code>true</code> if they were in different
+ * sets.
+ */
+
+bool unionNodesDisjointSet(DisjointSet ds, Node n1, Node n2);
+
+/**
+ * Function: unionArcsDisjointSet
+ * Usage: merged = unionArcsDisjointSet(ds, arcs, n);
+ * --------------------------------------------------
+ * Merges the sets containing the two ends of each of the <code>n</code>
+ * arcs in the array and returns the number of merges that joined two
+ * different sets.  Calling this function on every arc of a graph leaves
+ * one set for each of its weakly connected components.
+ */
+
+int unionArcsDisjointSet(DisjointSet ds, Arc arcs[], int n);
+
+/**
+ * Function: newConcurrentDisjointSet
+ * Usage: cds = newConcurrentDisjointSet(n);
+ * -----------------------------------------
+ * Creates a concurrent disjoint-set forest with the elements 0 through
+ * <code>n</code>&nbsp;-&nbsp;1.  Any number of threads may call
+ * <code>findConcurrentDisjointSet</code>,
+ * <code>unionConcurrentDisjointSet</code>, and
+ * <code>sameSetConcurrentDisjointSet</code> at the same time.
+ */
+
+ConcurrentDisjointSet newConcurrentDisjointSet(int n);
+
+/**
+ * Function: freeConcurrentDisjointSet
+ * Usage: freeConcurrentDisjointSet(cds);
+ * --------------------------------------
+ * Frees the storage associated with the forest.  No other thread may be
+ * using it.
+ */
+
+void freeConcurrentDisjointSet(ConcurrentDisjointSet cds);
+
+/**
+ * Function: sizeConcurrentDisjointSet
+ * Usage: n = sizeConcurrentDisjointSet(cds);
+ * ------------------------------------------
+ * Returns the number of elements in the forest.
+ */
+
+int sizeConcurrentDisjointSet(ConcurrentDisjointSet cds);
+
+/**
+ * Function: countConcurrentDisjointSets
+ * Usage: n = countConcurrentDisjointSets(cds);
+ * --------------------------------------------
+ * Returns the number of distinct sets in the forest.  While other
+ * threads are merging sets, the result may already be out of date.
+ */
+
+int countConcurrentDisjointSets(ConcurrentDisjointSet cds);
+
+/**
+ * Function: findConcurrentDisjointSet
+ * Usage: root = findConcurrentDisjointSet(cds, k);
+ * ------------------------------------------------
+ * Returns the representative element of the set containing
+ * <code>k</code>.  If other threads are merging sets, the result is the
+ * representative at some moment during the call.
+ */
+
+int findConcurrentDisjointSet(ConcurrentDisjointSet cds, int k);
+
+/**
+ * Function: unionConcurrentDisjointSet
+ * Usage: if (unionConcurrentDisjointSet(cds, k1, k2)) . . .
+ * ---------------------------------------------------------
+ * Merges the sets containing <code>k1</code> and <code>k2</code>,
+ * returning <code>true</code> if this call joined two different sets.
+ * When several threads merge the same sets at once, exactly one of them
+ * sees <code>true</code>.
+ */
+
+bool unionConcurrentDisjointSet(ConcurrentDisjointSet cds, int k1, int k2);
+
+/**
+ * Function: sameSetConcurrentDisjointSet
+ * Usage: if (sameSetConcurrentDisjointSet(cds, k1, k2)) . . .
+ * -----------------------------------------------------------
+ * Returns <code>true</code> if <code>k1</code> and <code>k2</code> are in
+ * the same set.  A <code>false</code> result may be out of date if other
+ * threads are merging sets, but a <code>true</code> result never is.
+ */
+
+bool sameSetConcurrentDisjointSet(ConcurrentDisjointSet cds, int k1, int k2);
+
+/**
+ * Function: unionPairsConcurrentDisjointSet
+ * Usage: m = unionPairsConcurrentDisjointSet(cds, starts, ends, n, nThreads);
+ * ---------------------------------------------------------------------------
+ * Merges the sets containing <code>starts[i]</code> and
+ * <code>ends[i]</code> for each <code>i</code> less than <code>n</code>,
+ * dividing the pairs among <code>nThreads</code> threads, and returns
+ * the number of merges that joined two different sets.
+ */
+
+int unionPairsConcurrentDisjointSet(ConcurrentDisjointSet cds,
+                                    int starts[], int ends[], int n,
+                                    int nThreads);
+
+#endif
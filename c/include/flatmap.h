@@ -0,0 +1,260 @@
+/*
+ * File: flatmap.h
+ * ---------------
+ * This interface defines a map from strings to values that keeps its
+ * entries in sorted arrays rather than in a tree.  A lookup searches a
+ * compact array of key prefixes and touches only a few cache lines, so a
+ * <code>FlatMap</code> is considerably faster to read than a
+ * <code>Map</code> when it holds no more than a few hundred entries.
+ * Adding or removing an entry, however, moves the entries that follow
+ * it, which takes linear time.  A <code>FlatMap</code> is therefore best
+ * suited to small maps that are built once, ideally with
+ * <code>putAllFlatMap</code>, and then read many times.
+ *
+ * <p>The functions in this interface correspond one for one to those in
+ * <code>map.h</code>, with <code>FlatMap</code> in place of
+ * <code>Map</code> in their names, and the generic functions such as
+ * <code>get</code> and <code>put</code> work with either type.  Iteration
+ * produces the keys in ascending order.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _flatmap_h
+#define _flatmap_h
+
+#include "cslib.h"
+#include "generic.h"
+#include "iterator.h"
+
+/**
+ * Type: FlatMap
+ * -------------
+ * This type is the ADT used to represent the map.
+ */
+
+typedef struct FlatMapCDT *FlatMap;
+
+/* Exported entries */
+
+/**
+ * Function: newFlatMap
+ * Usage: map = newFlatMap();
+ * --------------------------
+ * Allocates a new map with no entries.
+ */
+
+FlatMap newFlatMap(void);
+
+/**
+ * Function: freeFlatMap
+ * Usage: freeFlatMap(map);
+ * ------------------------
+ * Frees the storage associated with the map.
+ */
+
+void freeFlatMap(FlatMap map);
+
+/**
+ * Function: size
+ * Usage: n = size(map);
+ * ---------------------
+ * Returns the number of entries in the map.
+ */
+
+int sizeFlatMap(FlatMap map);
+
+/**
+ * Function: isEmpty
+ * Usage: if (isEmpty(map)) . . .
+ * ------------------------------
+ * Returns <code>true</code> if the map has no entries.
+ */
+
+bool isEmptyFlatMap(FlatMap map);
+
+/**
+ * Function: clear
+ * Usage: clear(map);
+ * ------------------
+ * Removes all entries from the map.
+ */
+
+void clearFlatMap(FlatMap map);
+
+/**
+ * Function: clone
+ * Usage: newmap = clone(map);
+ * ---------------------------
+ * Creates a copy of the map.  The <code>clone</code> function copies
+ * only the first level of the structure and does not copy the individual
+ * values.
+ */
+
+FlatMap cloneFlatMap(FlatMap map);
+
+/**
+ * Function: put
+ * Usage: put(map, key, value);
+ * ----------------------------
+ * Associates <code>key</code> with <code>value</code> in the map.
+ * Each call to <code>put</code> supersedes any previous definition
+ * for <code>key</code>.
+ */
+
+void putFlatMap(FlatMap map, string key, void *value);
+
+/**
+ * Function: putAllFlatMap
+ * Usage: putAllFlatMap(map, keys, values, n);
+ * -------------------------------------------
+ * Associates each of the first <code>n</code> elements of the array
+ * <code>keys</code> with the corresponding element of <code>values</code>.
+ * The effect is the same as calling <code>put</code> for each pair in
+ * order, so that a key appearing more than once takes the last of its
+ * values.  This function sorts the new entries and merges them with the
+ * existing ones in a single pass, which is much faster than calling
+ * <code>put</code> for each pair.
+ */
+
+void putAllFlatMap(FlatMap map, string keys[], void *values[], int n);
+
+/**
+ * Function: get
+ * Usage: void *value = get(map, key);
+ * -----------------------------------
+ * Returns the value associated with <code>key</code> in the map,
+ * or <code>NULL</code>, if no such value exists.
+ */
+
+void *getFlatMap(FlatMap map, string key);
+
+/**
+ * Function: containsKey
+ * Usage: if (containsKey(map, key)) . . .
+ * ---------------------------------------
+ * Checks to see if the map contains the specified key.
+ */
+
+bool containsKeyFlatMap(FlatMap map, string key);
+
+/**
+ * Function: remove
+ * Usage: remove(map, key);
+ * ------------------------
+ * Removes the key and its value from the map.
+ */
+
+void removeFlatMap(FlatMap map, string key);
+
+/**
+ * Function: rankFlatMap
+ * Usage: rank = rankFlatMap(map, key);
+ * ------------------------------------
+ * Returns the number of keys in the map that are less than
+ * <code>key</code>, which need not itself be in the map.
+ */
+
+int rankFlatMap(FlatMap map, string key);
+
+/**
+ * Function: selectFlatMap
+ * Usage: key = selectFlatMap(map, k);
+ * -----------------------------------
+ * Returns the <code>k</code>th smallest key in the map, counting from 0.
+ * It is an error to call <code>selectFlatMap</code> if <code>k</code> is
+ * not between 0 and one less than the size of the map.
+ */
+
+string selectFlatMap(FlatMap map, int k);
+
+/**
+ * Function: floorKeyFlatMap
+ * Usage: key = floorKeyFlatMap(map, key);
+ * ---------------------------------------
+ * Returns the largest key in the map that is less than or equal to
+ * <code>key</code>, or <code>NULL</code> if there is no such key.
+ */
+
+string floorKeyFlatMap(FlatMap map, string key);
+
+/**
+ * Function: ceilingKeyFlatMap
+ * Usage: key = ceilingKeyFlatMap(map, key);
+ * -----------------------------------------
+ * Returns the smallest key in the map that is greater than or equal to
+ * <code>key</code>, or <code>NULL</code> if there is no such key.
+ */
+
+string ceilingKeyFlatMap(FlatMap map, string key);
+
+/**
+ * Function: firstKeyFlatMap
+ * Usage: key = firstKeyFlatMap(map);
+ * ----------------------------------
+ * Returns the smallest key in the map, or <code>NULL</code> if the map
+ * is empty.
+ */
+
+string firstKeyFlatMap(FlatMap map);
+
+/**
+ * Function: lastKeyFlatMap
+ * Usage: key = lastKeyFlatMap(map);
+ * ---------------------------------
+ * Returns the largest key in the map, or <code>NULL</code> if the map
+ * is empty.
+ */
+
+string lastKeyFlatMap(FlatMap map);
+
+/**
+ * Function: newFlatMapRangeIterator
+ * Usage: foreach (key in newFlatMapRangeIterator(map, lo, hi)) . . .
+ * ------------------------------------------------------------------
+ * Returns an iterator that produces, in ascending order, the keys in the
+ * map that lie between <code>lo</code> and <code>hi</code>, inclusive.
+ * Either bound may be <code>NULL</code>, in which case the range is
+ * unbounded at that end.
+ */
+
+Iterator newFlatMapRangeIterator(FlatMap map, string lo, string hi);
+
+/**
+ * Function: map
+ * Usage: map(map, fn, data);
+ * --------------------------
+ * Iterates through the map in ascending order of the keys and calls the
+ * function <code>fn</code> on each entry.  The callback function takes
+ * the following arguments:
+ *
+ *<ul>
+ *  <li>The key
+ *  <li>The associated value
+ *  <li>The <code>data</code> pointer
+ *</ul>
+ *
+ * The <code>data</code> pointer allows the client to pass state
+ * information to the function <code>fn</code>, if necessary.  If no such
+ * information is required, this argument should be <code>NULL</code>.
+ */
+
+void mapFlatMap(FlatMap map, proc fn, void *data);
+
+#endif
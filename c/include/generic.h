@@ -68,6 +68,34 @@ typedef union {
     void *pointerRep;
 } GenericType;
 
+/**
+ * Type: StorageType
+ * -----------------
+ * Selects the data structure used to store the entries of an ordered
+ * collection such as a <code>Map</code> or a <code>Set</code>.  The
+ * <code>AVL_TREE</code> option uses the balanced binary tree from the
+ * <code>bst.h</code> interface, which is the default.  The
+ * <code>B_TREE</code> option uses the <code>btree.h</code> interface,
+ * which stores many keys contiguously in each node and therefore makes
+ * far fewer cache misses on large collections.  The
+ * <code>PERSISTENT_TREE</code> option uses the same balanced tree as
+ * <code>AVL_TREE</code> but shares nodes between a collection and its
+ * clones, so that <code>clone</code> runs in constant time and each later
+ * change copies only a logarithmic number of nodes.  The
+ * <code>COMPRESSED_BITMAP</code> option, which is available only for
+ * sets of <code>int</code> or <code>unsigned</code> values, uses the
+ * <code>bitmap.h</code> interface, which needs only a few bits for each
+ * element of a dense set and combines sets a word at a time.  All options
+ * iterate over their keys in the same order.
+ */
+
+typedef enum {
+   AVL_TREE,
+   B_TREE,
+   PERSISTENT_TREE,
+   COMPRESSED_BITMAP
+} StorageType;
+
 /**
  * Friend type: FetchFn
  * --------------------
@@ -414,4 +442,31 @@ StoreFn getStoreFnForType(string type);
 
 ToStringFn getToStringFn(string type);
 
+/**
+ * Friend function: sortGenericArray
+ * Usage: sortGenericArray(keys, values, n, cmpFn);
+ * ------------------------------------------------
+ * Sorts the first <code>n</code> elements of <code>keys</code> into
+ * ascending order using <code>cmpFn</code>.  If <code>values</code> is
+ * not <code>NULL</code>, its elements are rearranged along with the
+ * keys.  The sort is stable, so equal keys keep their relative order,
+ * and it returns immediately if the keys are already sorted.
+ */
+
+void sortGenericArray(GenericType keys[], void *values[], int n,
+                      CompareFn cmpFn);
+
+/**
+ * Friend function: uniqueGenericArray
+ * Usage: n = uniqueGenericArray(keys, values, n, cmpFn);
+ * ------------------------------------------------------
+ * Removes adjacent duplicates from a sorted array of keys, keeping the
+ * last key (and value, if <code>values</code> is not <code>NULL</code>)
+ * in each run of equal keys.  The function returns the number of keys
+ * that remain.
+ */
+
+int uniqueGenericArray(GenericType keys[], void *values[], int n,
+                       CompareFn cmpFn);
+
 #endif
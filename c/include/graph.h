@@ -65,6 +65,30 @@ typedef struct NodeCDT *Node;
 
 typedef struct ArcCDT *Arc;
 
+/**
+ * Type: FrozenGraph
+ * -----------------
+ * This type is the abstract type for a read-only snapshot of a graph,
+ * which stores the arcs in compressed sparse row form.  In a snapshot,
+ * the nodes are identified by consecutive integers starting at 0, and
+ * the arcs leaving each node occupy a contiguous range of the target
+ * and cost arrays.  Algorithms that traverse a snapshot therefore read
+ * memory sequentially and allocate nothing, which makes them much faster
+ * than the same algorithms applied to the <code>Graph</code> itself.
+ */
+
+typedef struct FrozenGraphCDT *FrozenGraph;
+
+/**
+ * Type: NeighborFn
+ * ----------------
+ * This type represents a function that <code>mapNeighbors</code> calls
+ * for each arc leaving a node.  The arguments are the node at the end of
+ * the arc, the arc itself, and the client data pointer.
+ */
+
+typedef void (*NeighborFn)(Node neighbor, Arc arc, void *data);
+
 /**
  * Function: newGraph
  * Usage: g = newGraph();
@@ -138,7 +162,9 @@ void removeArc(Graph g, Arc arc);
  * Usage: if (isConnected(n1, n2)) . . .
  * -------------------------------------
  * Returns <code>true</code> if there is an arc from <code>n1</code>
- * to <code>n2</code>.
+ * to <code>n2</code>.  Once a node has more than a few arcs, the graph
+ * keeps a hash table of their ends, so this test takes constant time on
+ * average regardless of the number of arcs.
  */
 
 bool isConnected(Node n1, Node n2);
@@ -194,6 +220,52 @@ Set getArcSet(void *arg);
 
 Set getNeighbors(Node node);
 
+/**
+ * Function: mapNeighbors
+ * Usage: mapNeighbors(node, fn, data);
+ * ------------------------------------
+ * Calls <code>fn</code> for each arc leaving the node, passing the node
+ * at the end of the arc, the arc, and <code>data</code>.  Unlike
+ * <code>getNeighbors</code>, this function allocates no memory, which
+ * makes it the better choice in the inner loop of a graph algorithm.
+ * The arcs are visited in no particular order, and a node that is the
+ * end of several arcs is passed once for each of them.  The callback
+ * function must not add arcs to or remove arcs from the graph.
+ */
+
+void mapNeighbors(Node node, NeighborFn fn, void *data);
+
+/**
+ * Function: getOutDegree
+ * Usage: n = getOutDegree(node);
+ * ------------------------------
+ * Returns the number of arcs leaving the node.
+ */
+
+int getOutDegree(Node node);
+
+/**
+ * Function: getIncomingArcs
+ * Usage: arcSet = getIncomingArcs(node);
+ * --------------------------------------
+ * Returns the set of arcs that end at the specified node.  As with
+ * <code>getArcSet</code>, the set belongs to the graph, and the client
+ * must not change it or keep it after changing the graph.
+ */
+
+Set getIncomingArcs(Node node);
+
+/**
+ * Function: getPredecessors
+ * Usage: nodeSet = getPredecessors(node);
+ * ---------------------------------------
+ * Returns a set consisting of the nodes that have an arc to the given
+ * node.  This function is the counterpart of <code>getNeighbors</code>
+ * for incoming arcs.
+ */
+
+Set getPredecessors(Node node);
+
 /**
  * Function: getName
  * Usage: str = getName(node);
@@ -262,4 +334,295 @@ void setNodeOrdering(Graph graph, CompareFn cmpFn);
 
 void setArcOrdering(Graph graph, CompareFn cmpFn);
 
+/**
+ * Function: getNodeIndex
+ * Usage: index = getNodeIndex(node);
+ * ----------------------------------
+ * Returns the index of the node, which is a small integer that no other
+ * node in the graph shares.  Indices start at 0, and a new node reuses
+ * the index of a node that has been removed, so the indices of the nodes
+ * in a graph always lie below <code>getNodeIndexLimit(g)</code>.  An
+ * algorithm can therefore keep information about each node in an array
+ * indexed by node index instead of a map.
+ */
+
+int getNodeIndex(Node node);
+
+/**
+ * Function: getArcIndex
+ * Usage: index = getArcIndex(arc);
+ * --------------------------------
+ * Returns the index of the arc, which follows the same rules as the
+ * index of a node.
+ */
+
+int getArcIndex(Arc arc);
+
+/**
+ * Function: getNodeIndexLimit
+ * Usage: limit = getNodeIndexLimit(g);
+ * ------------------------------------
+ * Returns one more than the highest node index that the graph has
+ * assigned, which is the size an array indexed by node index must have.
+ */
+
+int getNodeIndexLimit(Graph g);
+
+/**
+ * Function: getArcIndexLimit
+ * Usage: limit = getArcIndexLimit(g);
+ * -----------------------------------
+ * Returns one more than the highest arc index that the graph has
+ * assigned.
+ */
+
+int getArcIndexLimit(Graph g);
+
+/**
+ * Function: getNodeByIndex
+ * Usage: node = getNodeByIndex(g, index);
+ * ---------------------------------------
+ * Returns the node with the specified index, or <code>NULL</code> if no
+ * node currently has that index.
+ */
+
+Node getNodeByIndex(Graph g, int index);
+
+/**
+ * Function: getArcByIndex
+ * Usage: arc = getArcByIndex(g, index);
+ * -------------------------------------
+ * Returns the arc with the specified index, or <code>NULL</code> if no
+ * arc currently has that index.
+ */
+
+Arc getArcByIndex(Graph g, int index);
+
+/**
+ * Function: setNodeAttribute
+ * Usage: setNodeAttribute(g, name, node, value);
+ * ----------------------------------------------
+ * Sets the value of the named attribute for the node.  An attribute is a
+ * number attached to every node in the graph, such as the distance that
+ * a search has found to each node.  The graph creates the attribute the
+ * first time a client uses its name, with the value 0 for every node.
+ */
+
+void setNodeAttribute(Graph g, string name, Node node, double value);
+
+/**
+ * Function: getNodeAttribute
+ * Usage: value = getNodeAttribute(g, name, node);
+ * -----------------------------------------------
+ * Returns the value of the named attribute for the node, which is 0 if
+ * the value has never been set.
+ */
+
+double getNodeAttribute(Graph g, string name, Node node);
+
+/**
+ * Function: getNodeAttributeArray
+ * Usage: values = getNodeAttributeArray(g, name);
+ * -----------------------------------------------
+ * Returns the array that holds the values of the named attribute, which
+ * is indexed by node index.  Reading and writing the array directly
+ * avoids looking up the name of the attribute for each node, as in the
+ * following loop:
+ *
+ *<pre>
+ *    dist = getNodeAttributeArray(g, "dist");
+ *    foreach (node in getNodeSet(g)) {
+ *       dist[getNodeIndex(node)] = HUGE_VAL;
+ *    }
+ *</pre>
+ *
+ * The array remains valid until the next call to <code>addNode</code>
+ * or <code>removeNodeAttribute</code>.
+ */
+
+double *getNodeAttributeArray(Graph g, string name);
+
+/**
+ * Function: removeNodeAttribute
+ * Usage: removeNodeAttribute(g, name);
+ * ------------------------------------
+ * Removes the named attribute and frees its storage.
+ */
+
+void removeNodeAttribute(Graph g, string name);
+
+/**
+ * Function: freezeGraph
+ * Usage: fg = freezeGraph(g);
+ * ---------------------------
+ * Returns a snapshot of the graph in its current state.  The node IDs
+ * follow the order of <code>getNodeSet</code>, and the arcs leaving each
+ * node follow the order of <code>getArcSet</code>.  Later changes to the
+ * graph do not affect the snapshot.
+ */
+
+FrozenGraph freezeGraph(Graph g);
+
+/**
+ * Function: freeFrozenGraph
+ * Usage: freeFrozenGraph(fg);
+ * ---------------------------
+ * Frees the storage for the snapshot.
+ */
+
+void freeFrozenGraph(FrozenGraph fg);
+
+/**
+ * Function: getFrozenNodeCount
+ * Usage: n = getFrozenNodeCount(fg);
+ * ----------------------------------
+ * Returns the number of nodes in the snapshot.
+ */
+
+int getFrozenNodeCount(FrozenGraph fg);
+
+/**
+ * Function: getFrozenArcCount
+ * Usage: n = getFrozenArcCount(fg);
+ * ---------------------------------
+ * Returns the number of arcs in the snapshot.
+ */
+
+int getFrozenArcCount(FrozenGraph fg);
+
+/**
+ * Function: getFrozenNodeId
+ * Usage: id = getFrozenNodeId(fg, name);
+ * --------------------------------------
+ * Returns the ID of the node with the specified name, or -1 if the
+ * snapshot has no such node.
+ */
+
+int getFrozenNodeId(FrozenGraph fg, string name);
+
+/**
+ * Function: getFrozenIdForNode
+ * Usage: id = getFrozenIdForNode(fg, node);
+ * -----------------------------------------
+ * Returns the ID of the specified node from the original graph, or -1
+ * if the node was not in the graph when the snapshot was taken.  The
+ * lookup takes constant time and, unlike <code>getFrozenNodeId</code>,
+ * does not build a table of the names.
+ */
+
+int getFrozenIdForNode(FrozenGraph fg, Node node);
+
+/**
+ * Function: getFrozenNodeName
+ * Usage: name = getFrozenNodeName(fg, id);
+ * ----------------------------------------
+ * Returns the name of the node with the specified ID.
+ */
+
+string getFrozenNodeName(FrozenGraph fg, int id);
+
+/**
+ * Function: getFrozenNode
+ * Usage: node = getFrozenNode(fg, id);
+ * ------------------------------------
+ * Returns the node in the original graph that has the specified ID.  The
+ * result is valid only as long as that node remains in the graph.  For
+ * a snapshot that was not taken from a graph, such as one read from a
+ * file by the functions in <code>graphio.h</code>, the result is
+ * <code>NULL</code>.
+ */
+
+Node getFrozenNode(FrozenGraph fg, int id);
+
+/**
+ * Function: getFrozenOffsets
+ * Usage: offsets = getFrozenOffsets(fg);
+ * --------------------------------------
+ * Returns the array of row offsets, which has one more element than the
+ * snapshot has nodes.  The arcs leaving node <code>id</code> are those
+ * whose indices run from <code>offsets[id]</code> up to but not
+ * including <code>offsets[id + 1]</code>, so that a client can visit
+ * the neighbors of a node with the following loop:
+ *
+ *<pre>
+ *    for (i = offsets[id]; i < offsets[id + 1]; i++) {
+ *       . . . targets[i] is a neighbor, costs[i] the cost of the arc . . .
+ *    }
+ *</pre>
+ *
+ * The array belongs to the snapshot and must not be changed.
+ */
+
+const int *getFrozenOffsets(FrozenGraph fg);
+
+/**
+ * Function: getFrozenTargets
+ * Usage: targets = getFrozenTargets(fg);
+ * --------------------------------------
+ * Returns the array that holds the ID of the node at the end of each arc.
+ */
+
+const int *getFrozenTargets(FrozenGraph fg);
+
+/**
+ * Function: getFrozenCosts
+ * Usage: costs = getFrozenCosts(fg);
+ * ----------------------------------
+ * Returns the array that holds the cost of each arc.
+ */
+
+const double *getFrozenCosts(FrozenGraph fg);
+
+/**
+ * Function: getFrozenInOffsets
+ * Usage: inOffsets = getFrozenInOffsets(fg);
+ * ------------------------------------------
+ * Returns the row offsets for the arcs entering each node, which work in
+ * the same way as those from <code>getFrozenOffsets</code> but index the
+ * array from <code>getFrozenSources</code>.  The snapshot builds these
+ * rows the first time a client asks for them, so the first call must not
+ * run concurrently with any other call on the same snapshot.
+ */
+
+const int *getFrozenInOffsets(FrozenGraph fg);
+
+/**
+ * Function: getFrozenSources
+ * Usage: sources = getFrozenSources(fg);
+ * --------------------------------------
+ * Returns the array that holds the ID of the node at the start of each
+ * arc in the rows from <code>getFrozenInOffsets</code>.
+ */
+
+const int *getFrozenSources(FrozenGraph fg);
+
+/**
+ * Friend function: freezeGraphStructure
+ * Usage: fg = freezeGraphStructure(g);
+ * ------------------------------------
+ * Returns a snapshot like the one from <code>freezeGraph</code> except
+ * that it does not copy the node names, for algorithms that identify the
+ * nodes by ID or by <code>Node</code> value and free the snapshot before
+ * the graph changes.  Calling <code>getFrozenNodeId</code> or
+ * <code>getFrozenNodeName</code> on such a snapshot is an error.
+ */
+
+FrozenGraph freezeGraphStructure(Graph g);
+
+/**
+ * Friend function: assembleFrozenGraph
+ * Usage: fg = assembleFrozenGraph(n, m, offsets, targets, costs, names, buf);
+ * ---------------------------------------------------------------------------
+ * Creates a snapshot of <code>n</code> nodes and <code>m</code> arcs
+ * directly from its compressed sparse row arrays, which must have been
+ * allocated with <code>newArray</code> and become the property of the
+ * snapshot.  If <code>buf</code> is not <code>NULL</code>, the names
+ * are stored in that single block, which the snapshot frees in place of
+ * the individual names.  The snapshot has no original graph, so
+ * <code>getFrozenNode</code> returns <code>NULL</code>.
+ */
+
+FrozenGraph assembleFrozenGraph(int n, int m, int *offsets, int *targets,
+                                double *costs, string *names, char *buf);
+
 #endif
@@ -0,0 +1,373 @@
+/*
+ * File: graphalgo.h
+ * -----------------
+ * This interface exports standard algorithms on graphs: breadth-first
+ * and depth-first search, shortest paths by Dijkstra's algorithm and by
+ * A* search, topological sorting, and strongly and weakly connected
+ * components.  Each algorithm comes in two forms.  The first takes a
+ * <code>Graph</code> and returns its results as vectors of nodes.  The
+ * second takes a <code>FrozenGraph</code> snapshot and works with the
+ * integer IDs of its nodes, storing its results in arrays supplied by
+ * the client.  The first form takes a snapshot of the graph and then
+ * calls the second, so a program that runs several algorithms on a
+ * graph that does not change should freeze the graph once and use the
+ * second form directly.
+ *
+ * <p>All of these algorithms keep their working state in arrays indexed
+ * by node ID and run in time proportional to the size of the graph, or
+ * within a logarithmic factor of it for the shortest-path algorithms.
+ * For very large graphs, the interface also exports versions of
+ * breadth-first search and of the shortest-path computation that divide
+ * the work among several threads.  These exist only in the second form,
+ * because a graph large enough to benefit from them should be frozen
+ * once and searched many times.  The same holds for the engine that
+ * runs vertex programs, such as PageRank, in which every node repeatedly
+ * computes a new value from the values of its neighbors.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _graphalgo_h
+#define _graphalgo_h
+
+#include "cslib.h"
+#include "graph.h"
+#include "vector.h"
+
+/**
+ * Type: HeuristicFn
+ * -----------------
+ * This type represents the estimate that A* search uses for the cost of
+ * the cheapest path from <code>node</code> to <code>goal</code>.  The
+ * path that the search finds is the shortest one as long as the estimate
+ * never exceeds the true cost.  The <code>data</code> argument is the
+ * pointer supplied by the client.
+ */
+
+typedef double (*HeuristicFn)(Node node, Node goal, void *data);
+
+/**
+ * Type: FrozenHeuristicFn
+ * -----------------------
+ * This type represents an A* estimate for the nodes of a snapshot, which
+ * are identified by their IDs.
+ */
+
+typedef double (*FrozenHeuristicFn)(int id, int goal, void *data);
+
+/**
+ * Type: VertexUpdateFn
+ * --------------------
+ * This type represents the rule by which a vertex program computes the
+ * new value of the node <code>id</code> from the array <code>old</code>,
+ * which holds the values of every node after the previous iteration.
+ * Several threads call the function at once for different nodes, so it
+ * must not change any state that it shares with other calls.
+ */
+
+typedef double (*VertexUpdateFn)(FrozenGraph fg, int id, const double old[],
+                                 void *data);
+
+/**
+ * Type: VertexPrepareFn
+ * ---------------------
+ * This type represents a function that a vertex program calls on a
+ * single thread before each iteration, which lets it compute quantities
+ * that every update needs, such as a sum over all nodes.  The array
+ * <code>old</code> holds the values that the iteration will read.
+ */
+
+typedef void (*VertexPrepareFn)(FrozenGraph fg, const double old[],
+                                void *data);
+
+/* Exported entries */
+
+/**
+ * Function: breadthFirstSearch
+ * Usage: nodes = breadthFirstSearch(g, start);
+ * --------------------------------------------
+ * Returns a vector of the nodes reachable from <code>start</code>, in
+ * the order in which a breadth-first search visits them.
+ */
+
+Vector breadthFirstSearch(Graph g, Node start);
+
+/**
+ * Function: depthFirstSearch
+ * Usage: nodes = depthFirstSearch(g, start);
+ * ------------------------------------------
+ * Returns a vector of the nodes reachable from <code>start</code>, in
+ * the order in which a depth-first search first visits them.
+ */
+
+Vector depthFirstSearch(Graph g, Node start);
+
+/**
+ * Function: findShortestPath
+ * Usage: path = findShortestPath(g, start, finish);
+ * -------------------------------------------------
+ * Uses Dijkstra's algorithm to find the path from <code>start</code> to
+ * <code>finish</code> whose arcs have the smallest total cost, and
+ * returns a vector of the nodes on that path, beginning with
+ * <code>start</code> and ending with <code>finish</code>.  If there is no
+ * such path, the vector is empty.  The function calls <code>error</code>
+ * if the graph has an arc with a negative cost.
+ */
+
+Vector findShortestPath(Graph g, Node start, Node finish);
+
+/**
+ * Function: findPathAStar
+ * Usage: path = findPathAStar(g, start, finish, heuristic, data);
+ * ---------------------------------------------------------------
+ * Finds a path from <code>start</code> to <code>finish</code> using A*
+ * search, which explores the nodes in order of their distance from
+ * <code>start</code> plus the estimate that <code>heuristic</code>
+ * returns for their distance to <code>finish</code>.  A good estimate
+ * lets the search ignore most of a large graph.  The result has the same
+ * form as the result of <code>findShortestPath</code>.
+ */
+
+Vector findPathAStar(Graph g, Node start, Node finish,
+                     HeuristicFn heuristic, void *data);
+
+/**
+ * Function: topologicalSort
+ * Usage: nodes = topologicalSort(g);
+ * ----------------------------------
+ * Returns a vector of all the nodes in the graph, arranged so that every
+ * arc leads from a node to one that appears later.  If the graph has a
+ * cycle, no such order exists, and the function returns
+ * <code>NULL</code>.
+ */
+
+Vector topologicalSort(Graph g);
+
+/**
+ * Function: findStronglyConnectedComponents
+ * Usage: components = findStronglyConnectedComponents(g);
+ * -------------------------------------------------------
+ * Divides the nodes into strongly connected components, in which there
+ * is a path from each node to every other, and returns a vector of those
+ * components, each of which is a vector of nodes.  A component appears
+ * before every component from which it can be reached.
+ */
+
+Vector findStronglyConnectedComponents(Graph g);
+
+/**
+ * Function: findConnectedComponents
+ * Usage: components = findConnectedComponents(g);
+ * -----------------------------------------------
+ * Divides the nodes into the components that are connected when the
+ * direction of the arcs is ignored and returns a vector of those
+ * components, each of which is a vector of nodes.
+ */
+
+Vector findConnectedComponents(Graph g);
+
+/**
+ * Function: breadthFirstFrozenGraph
+ * Usage: n = breadthFirstFrozenGraph(fg, start, order);
+ * -----------------------------------------------------
+ * Stores the IDs of the nodes reachable from <code>start</code> in the
+ * array <code>order</code>, in breadth-first order, and returns their
+ * number.  The array must have room for every node in the snapshot.
+ */
+
+int breadthFirstFrozenGraph(FrozenGraph fg, int start, int order[]);
+
+/**
+ * Function: depthFirstFrozenGraph
+ * Usage: n = depthFirstFrozenGraph(fg, start, order);
+ * ---------------------------------------------------
+ * Stores the IDs of the nodes reachable from <code>start</code> in the
+ * array <code>order</code>, in depth-first order, and returns their
+ * number.
+ */
+
+int depthFirstFrozenGraph(FrozenGraph fg, int start, int order[]);
+
+/**
+ * Function: shortestDistancesFrozenGraph
+ * Usage: shortestDistancesFrozenGraph(fg, start, dist, parent);
+ * -------------------------------------------------------------
+ * Uses Dijkstra's algorithm to compute the cost of the cheapest path from
+ * <code>start</code> to every node.  On return, <code>dist[id]</code>
+ * holds that cost, which is <code>HUGE_VAL</code> if the node cannot be
+ * reached, and <code>parent[id]</code> holds the ID of the node before
+ * <code>id</code> on the path, or -1 if there is none.  Either array may
+ * be <code>NULL</code> if the client does not need it.
+ */
+
+void shortestDistancesFrozenGraph(FrozenGraph fg, int start, double dist[],
+                                  int parent[]);
+
+/**
+ * Function: aStarFrozenGraph
+ * Usage: n = aStarFrozenGraph(fg, start, goal, heuristic, data, path);
+ * --------------------------------------------------------------------
+ * Uses A* search to find a path from <code>start</code> to
+ * <code>goal</code>, stores the IDs of the nodes on the path in the
+ * array <code>path</code>, and returns their number, which is 0 if
+ * there is no path.
+ */
+
+int aStarFrozenGraph(FrozenGraph fg, int start, int goal,
+                     FrozenHeuristicFn heuristic, void *data, int path[]);
+
+/**
+ * Function: topologicalSortFrozenGraph
+ * Usage: if (topologicalSortFrozenGraph(fg, order)) . . .
+ * -------------------------------------------------------
+ * Stores the IDs of all the nodes in the array <code>order</code> in
+ * topological order and returns <code>true</code>, or returns
+ * <code>false</code> if the graph has a cycle.
+ */
+
+bool topologicalSortFrozenGraph(FrozenGraph fg, int order[]);
+
+/**
+ * Function: strongComponentsFrozenGraph
+ * Usage: n = strongComponentsFrozenGraph(fg, component);
+ * ------------------------------------------------------
+ * Computes the strongly connected components of the snapshot using
+ * Tarjan's algorithm, stores the number of the component that contains
+ * each node in the array <code>component</code>, and returns the number
+ * of components.  The components are numbered so that no arc leads from
+ * a component to one with a higher number.
+ */
+
+int strongComponentsFrozenGraph(FrozenGraph fg, int component[]);
+
+/**
+ * Function: connectedComponentsFrozenGraph
+ * Usage: n = connectedComponentsFrozenGraph(fg, component);
+ * ---------------------------------------------------------
+ * Computes the components of the snapshot that are connected when the
+ * direction of the arcs is ignored, stores the number of the component
+ * that contains each node in the array <code>component</code>, and
+ * returns the number of components.  The components are numbered in
+ * order of their lowest node IDs.
+ */
+
+int connectedComponentsFrozenGraph(FrozenGraph fg, int component[]);
+
+/**
+ * Function: parallelBreadthFirstFrozenGraph
+ * Usage: k = parallelBreadthFirstFrozenGraph(fg, starts, n, depth, nThreads);
+ * ---------------------------------------------------------------------------
+ * Performs a breadth-first search from the <code>n</code> nodes in the
+ * array <code>starts</code> using <code>nThreads</code> threads and
+ * returns the number of nodes reached.  On return, <code>depth[id]</code>
+ * holds the number of arcs on the shortest path to <code>id</code> from
+ * any of the starting nodes, or -1 if there is no such path.
+ *
+ * <p>The search processes one level at a time.  While the frontier is
+ * small, each thread takes part of the frontier and follows the arcs
+ * leaving those nodes.  Once the frontier holds a large share of the
+ * arcs, the search switches to checking each unreached node for an
+ * incoming arc from the frontier, which can stop at the first such arc
+ * it finds.  The first of these bottom-up steps asks the snapshot for
+ * its incoming rows, which it builds if no client has done so.
+ */
+
+int parallelBreadthFirstFrozenGraph(FrozenGraph fg, int starts[], int n,
+                                    int depth[], int nThreads);
+
+/**
+ * Function: deltaSteppingFrozenGraph
+ * Usage: deltaSteppingFrozenGraph(fg, starts, n, dist, delta, nThreads);
+ * ----------------------------------------------------------------------
+ * Computes the cost of the cheapest path to every node from any of the
+ * <code>n</code> nodes in the array <code>starts</code>, using
+ * <code>nThreads</code> threads, and stores it in <code>dist</code>,
+ * where the cost is <code>HUGE_VAL</code> if there is no such path.
+ * The function uses the delta-stepping algorithm, which groups nodes
+ * into buckets by their tentative distance, so that bucket <i>k</i>
+ * holds the nodes whose distance is at least <i>k</i> times
+ * <code>delta</code> but less than <i>k</i> + 1 times
+ * <code>delta</code>.  The threads settle all the nodes in a bucket at
+ * once, which may relax some arcs more than once.  Smaller values of
+ * <code>delta</code> waste less work, and larger values give the threads
+ * more to do at once.  If <code>delta</code> is 0, the function chooses
+ * the largest arc cost divided by the average number of arcs leaving a
+ * node.  The function calls <code>error</code> if the graph has an arc
+ * with a negative cost.
+ */
+
+void deltaSteppingFrozenGraph(FrozenGraph fg, int starts[], int n,
+                              double dist[], double delta, int nThreads);
+
+/**
+ * Function: partitionFrozenGraph
+ * Usage: partitionFrozenGraph(fg, nParts, bounds);
+ * ------------------------------------------------
+ * Divides the node IDs into <code>nParts</code> consecutive ranges and
+ * stores their limits in <code>bounds</code>, which must have room for
+ * <code>nParts</code> + 1 elements, so that part <i>k</i> runs from
+ * <code>bounds[k]</code> up to but not including
+ * <code>bounds[k + 1]</code>.  The ranges are chosen so that each holds
+ * about the same number of nodes plus incoming and outgoing arcs, which
+ * balances the work of a vertex program even when a few nodes have most
+ * of the arcs.
+ */
+
+void partitionFrozenGraph(FrozenGraph fg, int nParts, int bounds[]);
+
+/**
+ * Function: runVertexProgram
+ * Usage: n = runVertexProgram(fg, update, prepare, data, values,
+ *                             maxIterations, tolerance, nThreads);
+ * ----------------------------------------------------------------
+ * Runs a vertex program on the snapshot.  The array <code>values</code>
+ * holds the initial value of each node.  In each iteration, the function
+ * calls <code>prepare</code>, unless it is <code>NULL</code>, and then
+ * calls <code>update</code> for every node, storing the results in a
+ * second array, so that every update reads the values from the previous
+ * iteration.  The nodes are divided among <code>nThreads</code> threads
+ * by <code>partitionFrozenGraph</code>.  The program stops once the sum
+ * of the changes in the values is no more than <code>tolerance</code> or
+ * after <code>maxIterations</code> iterations.  On return,
+ * <code>values</code> holds the final values, and the result is the
+ * number of iterations.
+ */
+
+int runVertexProgram(FrozenGraph fg, VertexUpdateFn update,
+                     VertexPrepareFn prepare, void *data, double values[],
+                     int maxIterations, double tolerance, int nThreads);
+
+/**
+ * Function: pageRankFrozenGraph
+ * Usage: n = pageRankFrozenGraph(fg, rank, damping, tolerance, nThreads);
+ * -----------------------------------------------------------------------
+ * Computes the PageRank of every node as a vertex program and stores it
+ * in the array <code>rank</code>.  A random walker follows a random arc
+ * leaving its node with probability <code>damping</code>, typically
+ * 0.85, and otherwise jumps to a random node, as it also does from a node
+ * with no arcs.  The rank of a node is the fraction of time the walker
+ * spends there, so the ranks add up to 1.  The iteration stops once the
+ * ranks change by no more than <code>tolerance</code> in total, or after
+ * 1000 iterations, and the function returns the number of iterations.
+ */
+
+int pageRankFrozenGraph(FrozenGraph fg, double rank[], double damping,
+                        double tolerance, int nThreads);
+
+#endif
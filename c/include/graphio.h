@@ -0,0 +1,126 @@
+/*
+ * File: graphio.h
+ * ---------------
+ * This interface exports functions that read large graphs from files.
+ * The text formats are the ones in which most published graph data
+ * sets are distributed.  An edge list has one arc on each line, written
+ * as the labels of its start and end nodes followed by an optional
+ * cost, as in
+ *
+ *<pre>
+ *    17 42 2.5
+ *</pre>
+ *
+ * An adjacency list instead has one line for each node, written as the
+ * label of the node followed by the labels of its neighbors.  In either
+ * format, node labels are nonnegative integers, blank lines and lines
+ * that begin with <code>#</code> or <code>%</code> are ignored, and the
+ * name of each node is its label written in decimal.
+ *
+ * <p>Building a graph one <code>addArc</code> call at a time from lines
+ * read with <code>readLine</code> spends most of its time allocating
+ * strings and tokens.  These functions instead map the whole file into
+ * memory, parse the numbers in place, and size every array from a first
+ * count of the input.  For the largest graphs, a program can skip the
+ * <code>Graph</code> entirely, load a <code>FrozenGraph</code> directly,
+ * and save it in a binary format that loads almost instantly.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _graphio_h
+#define _graphio_h
+
+#include "cslib.h"
+#include "graph.h"
+
+/**
+ * Constant: EDGE_LIST_UNDIRECTED
+ * ------------------------------
+ * An option for the loading functions that adds an arc in each
+ * direction for every pair of nodes in the file.  The options argument
+ * combines any of these flags with the <code>|</code> operator and is 0
+ * for a directed edge list.
+ */
+
+#define EDGE_LIST_UNDIRECTED 1
+
+/**
+ * Constant: EDGE_LIST_ADJACENCY
+ * -----------------------------
+ * An option for the loading functions that reads the file as an
+ * adjacency list, in which each line lists a node and its neighbors.
+ */
+
+#define EDGE_LIST_ADJACENCY 2
+
+/* Exported entries */
+
+/**
+ * Function: loadGraphFromEdgeList
+ * Usage: g = loadGraphFromEdgeList(path, options);
+ * ------------------------------------------------
+ * Reads the graph in the named file and returns it as a new
+ * <code>Graph</code>.  The nodes are added in order of their labels,
+ * and the arcs in the order in which they appear in the file.  Arcs
+ * without a cost have cost 1.  The function calls <code>error</code> if
+ * the file cannot be read or contains a line that does not fit the
+ * format.
+ */
+
+Graph loadGraphFromEdgeList(string path, int options);
+
+/**
+ * Function: loadFrozenGraphFromEdgeList
+ * Usage: fg = loadFrozenGraphFromEdgeList(path, options);
+ * -------------------------------------------------------
+ * Reads the graph in the named file and returns it as a snapshot without
+ * building a <code>Graph</code>.  The node IDs follow the order of the
+ * labels, and the arcs leaving each node keep the order in which they
+ * appear in the file.  Because the snapshot has no original graph,
+ * <code>getFrozenNode</code> returns <code>NULL</code> for its nodes.
+ */
+
+FrozenGraph loadFrozenGraphFromEdgeList(string path, int options);
+
+/**
+ * Function: saveFrozenGraph
+ * Usage: saveFrozenGraph(fg, path);
+ * ---------------------------------
+ * Writes the snapshot to the named file in a binary format that
+ * <code>loadFrozenGraph</code> can read.  The format stores the numbers
+ * in the byte order of the machine that writes it.
+ */
+
+void saveFrozenGraph(FrozenGraph fg, string path);
+
+/**
+ * Function: loadFrozenGraph
+ * Usage: fg = loadFrozenGraph(path);
+ * ----------------------------------
+ * Reads a snapshot written by <code>saveFrozenGraph</code>.  Loading
+ * requires no parsing, so it takes little more time than copying the
+ * file into memory.  The function calls <code>error</code> if the file
+ * is not a saved snapshot or was written on a machine with a different
+ * byte order.
+ */
+
+FrozenGraph loadFrozenGraph(string path);
+
+#endif
@@ -31,6 +31,7 @@
 #include "cslib.h"
 #include "generic.h"
 #include "iterator.h"
+#include "strlib.h"
 
 /**
  * Function: HashMap
@@ -128,6 +129,28 @@ void *getHashMap(HashMap map, string key);
 
 bool containsKeyHashMap(HashMap map, string key);
 
+/**
+ * Function: getHashMapView
+ * Usage: void *value = getHashMapView(map, view);
+ * -----------------------------------------------
+ * Returns the value associated with the key whose characters are those
+ * in <code>view</code>, or <code>NULL</code>, if no such value exists.
+ * This function makes it possible to look up a key found in a larger
+ * string without first copying it into a string of its own.
+ */
+
+void *getHashMapView(HashMap map, StringView view);
+
+/**
+ * Function: containsKeyHashMapView
+ * Usage: if (containsKeyHashMapView(map, view)) . . .
+ * ---------------------------------------------------
+ * Checks to see if the map contains the key whose characters are those
+ * in <code>view</code>.
+ */
+
+bool containsKeyHashMapView(HashMap map, StringView view);
+
 /**
  * Function: remove
  * Usage: remove(map, key);
@@ -157,4 +180,25 @@ void removeHashMap(HashMap map, string key);
 
 void mapHashMap(HashMap map, proc fn, void *data);
 
+/**
+ * Function: hashString
+ * Usage: code = hashString(str);
+ * ------------------------------
+ * Returns the nonnegative hash code that the <code>HashMap</code> type
+ * uses for the string <code>str</code>.  Other structures that hash
+ * string keys use the same function.
+ */
+
+int hashString(string str);
+
+/**
+ * Function: hashView
+ * Usage: code = hashView(view);
+ * -----------------------------
+ * Returns the same hash code as <code>hashString</code> for a string
+ * containing the characters in <code>view</code>.
+ */
+
+int hashView(StringView view);
+
 #endif
@@ -0,0 +1,314 @@
+/*
+ * File: intervalmap.h
+ * -------------------
+ * This interface exports two collections that associate values with
+ * closed intervals and find the intervals that overlap a query.  An
+ * <code>IntervalMap</code> is a balanced tree that supports insertion
+ * and removal at any time.  A <code>SegmentTree</code> is built once
+ * from arrays of intervals and cannot change afterward, which lets it
+ * store its data in flat arrays that are faster to search.  Both
+ * collections take the type of their endpoints when they are created,
+ * in the same way as a <code>Set</code>, so that endpoints can be
+ * <code>int</code>, <code>double</code>, or any other type for which
+ * <code>cmpfn.h</code> has a comparison function.  The endpoints are
+ * passed to the functions in this interface as additional arguments of
+ * that type.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _intervalmap_h
+#define _intervalmap_h
+
+#include <stdarg.h>
+#include "cslib.h"
+#include "cmpfn.h"
+#include "generic.h"
+
+/**
+ * Type: IntervalMap
+ * -----------------
+ * The abstract type for a map from intervals to values.
+ */
+
+typedef struct IntervalMapCDT *IntervalMap;
+
+/**
+ * Type: SegmentTree
+ * -----------------
+ * The abstract type for a static collection of intervals and values.
+ */
+
+typedef struct SegmentTreeCDT *SegmentTree;
+
+/**
+ * Type: IntervalFn
+ * ----------------
+ * This type represents a function that the query functions call on each
+ * interval they find.  The arguments are the endpoints, the value, and
+ * the client data pointer.  The endpoints are stored in the field of the
+ * <code>GenericType</code> union that matches the endpoint type, such
+ * as <code>lo.doubleRep</code> for <code>double</code> endpoints.
+ */
+
+typedef void (*IntervalFn)(GenericType lo, GenericType hi, void *value,
+                           void *data);
+
+/* Exported entries */
+
+/**
+ * Function: newIntervalMap
+ * Usage: map = newIntervalMap(type);
+ * ----------------------------------
+ * Creates an empty map whose intervals have endpoints of the specified
+ * type.
+ */
+
+#define newIntervalMap(type) newIntervalMapFromType(#type)
+
+/**
+ * Function: newIntervalMapFromType
+ * Usage: map = newIntervalMapFromType(baseType);
+ * ----------------------------------------------
+ * Creates an empty map whose endpoint type is expressed as a string.
+ */
+
+IntervalMap newIntervalMapFromType(string baseType);
+
+/**
+ * Function: freeIntervalMap
+ * Usage: freeIntervalMap(map);
+ * ----------------------------
+ * Frees the storage associated with the map.
+ */
+
+void freeIntervalMap(IntervalMap map);
+
+/**
+ * Function: sizeIntervalMap
+ * Usage: n = sizeIntervalMap(map);
+ * --------------------------------
+ * Returns the number of intervals in the map.
+ */
+
+int sizeIntervalMap(IntervalMap map);
+
+/**
+ * Function: isEmptyIntervalMap
+ * Usage: if (isEmptyIntervalMap(map)) . . .
+ * -----------------------------------------
+ * Returns <code>true</code> if the map contains no intervals.
+ */
+
+bool isEmptyIntervalMap(IntervalMap map);
+
+/**
+ * Function: clearIntervalMap
+ * Usage: clearIntervalMap(map);
+ * -----------------------------
+ * Removes all intervals from the map.
+ */
+
+void clearIntervalMap(IntervalMap map);
+
+/**
+ * Function: cloneIntervalMap
+ * Usage: newmap = cloneIntervalMap(map);
+ * --------------------------------------
+ * Creates a copy of the map.  The values are shared with the original.
+ */
+
+IntervalMap cloneIntervalMap(IntervalMap map);
+
+/**
+ * Function: putIntervalMap
+ * Usage: putIntervalMap(map, lo, hi, value);
+ * ------------------------------------------
+ * Associates <code>value</code> with the closed interval from
+ * <code>lo</code> to <code>hi</code>, replacing any value previously
+ * associated with exactly that interval.  The function calls
+ * <code>error</code> if <code>lo</code> is greater than <code>hi</code>.
+ */
+
+void putIntervalMap(IntervalMap map, ...);
+
+/**
+ * Friend function: putIntervalMapFromArgs
+ * Usage: putIntervalMapFromArgs(map, args);
+ * -----------------------------------------
+ * Identical to <code>putIntervalMap</code> except that the arguments
+ * come from the <code>args</code> list.
+ */
+
+void putIntervalMapFromArgs(IntervalMap map, va_list args);
+
+/**
+ * Function: getIntervalMap
+ * Usage: value = getIntervalMap(map, lo, hi);
+ * -------------------------------------------
+ * Returns the value associated with exactly the interval from
+ * <code>lo</code> to <code>hi</code>, or <code>NULL</code> if there is
+ * none.
+ */
+
+void *getIntervalMap(IntervalMap map, ...);
+
+/**
+ * Friend function: getIntervalMapFromArgs
+ * Usage: value = getIntervalMapFromArgs(map, args);
+ * -------------------------------------------------
+ * Identical to <code>getIntervalMap</code> except that the arguments
+ * come from the <code>args</code> list.
+ */
+
+void *getIntervalMapFromArgs(IntervalMap map, va_list args);
+
+/**
+ * Function: removeIntervalMap
+ * Usage: removeIntervalMap(map, lo, hi);
+ * --------------------------------------
+ * Removes the interval from <code>lo</code> to <code>hi</code>, if it is
+ * in the map.
+ */
+
+void removeIntervalMap(IntervalMap map, ...);
+
+/**
+ * Friend function: removeIntervalMapFromArgs
+ * Usage: removeIntervalMapFromArgs(map, args);
+ * --------------------------------------------
+ * Identical to <code>removeIntervalMap</code> except that the arguments
+ * come from the <code>args</code> list.
+ */
+
+void removeIntervalMapFromArgs(IntervalMap map, va_list args);
+
+/**
+ * Function: overlapsIntervalMap
+ * Usage: if (overlapsIntervalMap(map, lo, hi)) . . .
+ * --------------------------------------------------
+ * Returns <code>true</code> if some interval in the map shares at least
+ * one point with the interval from <code>lo</code> to <code>hi</code>.
+ * This test takes logarithmic time.
+ */
+
+bool overlapsIntervalMap(IntervalMap map, ...);
+
+/**
+ * Function: mapOverlapsIntervalMap
+ * Usage: n = mapOverlapsIntervalMap(map, fn, data, lo, hi);
+ * ---------------------------------------------------------
+ * Calls <code>fn</code> on every interval in the map that overlaps the
+ * interval from <code>lo</code> to <code>hi</code>, in order of their
+ * lower endpoints, and returns the number of such intervals.  If
+ * <code>fn</code> is <code>NULL</code>, the function only counts them.
+ * The time required is logarithmic in the size of the map plus linear
+ * in the number of intervals found.
+ */
+
+int mapOverlapsIntervalMap(IntervalMap map, IntervalFn fn, void *data, ...);
+
+/**
+ * Function: mapStabbingIntervalMap
+ * Usage: n = mapStabbingIntervalMap(map, fn, data, x);
+ * ----------------------------------------------------
+ * Calls <code>fn</code> on every interval in the map that contains the
+ * point <code>x</code> and returns the number of such intervals.  If
+ * <code>fn</code> is <code>NULL</code>, the function only counts them.
+ */
+
+int mapStabbingIntervalMap(IntervalMap map, IntervalFn fn, void *data, ...);
+
+/**
+ * Function: mapIntervalMap
+ * Usage: mapIntervalMap(map, fn, data);
+ * -------------------------------------
+ * Calls <code>fn</code> on every interval in the map, in order of their
+ * lower endpoints and then of their upper endpoints.
+ */
+
+void mapIntervalMap(IntervalMap map, IntervalFn fn, void *data);
+
+/**
+ * Function: newSegmentTree
+ * Usage: st = newSegmentTree(type, los, his, values, n);
+ * ------------------------------------------------------
+ * Creates a segment tree containing the <code>n</code> intervals whose
+ * endpoints are in the arrays <code>los</code> and <code>his</code>,
+ * which have elements of the specified type, and whose values are in the
+ * array <code>values</code>.  Unlike an <code>IntervalMap</code>, a
+ * segment tree may contain the same interval more than once.  The tree
+ * copies the arrays, so the client may reuse them.
+ */
+
+#define newSegmentTree(type, los, his, values, n) \
+   newSegmentTreeFromType(#type, los, his, values, n)
+
+/**
+ * Function: newSegmentTreeFromType
+ * Usage: st = newSegmentTreeFromType(baseType, los, his, values, n);
+ * ------------------------------------------------------------------
+ * Creates a segment tree whose endpoint type is expressed as a string.
+ */
+
+SegmentTree newSegmentTreeFromType(string baseType, void *los, void *his,
+                                   void *values[], int n);
+
+/**
+ * Function: freeSegmentTree
+ * Usage: freeSegmentTree(st);
+ * ---------------------------
+ * Frees the storage associated with the segment tree.
+ */
+
+void freeSegmentTree(SegmentTree st);
+
+/**
+ * Function: sizeSegmentTree
+ * Usage: n = sizeSegmentTree(st);
+ * -------------------------------
+ * Returns the number of intervals in the segment tree.
+ */
+
+int sizeSegmentTree(SegmentTree st);
+
+/**
+ * Function: mapOverlapsSegmentTree
+ * Usage: n = mapOverlapsSegmentTree(st, fn, data, lo, hi);
+ * --------------------------------------------------------
+ * Calls <code>fn</code> on every interval in the tree that overlaps the
+ * interval from <code>lo</code> to <code>hi</code>, in order of their
+ * lower endpoints, and returns the number of such intervals.  If
+ * <code>fn</code> is <code>NULL</code>, the function only counts them.
+ */
+
+int mapOverlapsSegmentTree(SegmentTree st, IntervalFn fn, void *data, ...);
+
+/**
+ * Function: mapStabbingSegmentTree
+ * Usage: n = mapStabbingSegmentTree(st, fn, data, x);
+ * ---------------------------------------------------
+ * Calls <code>fn</code> on every interval in the tree that contains the
+ * point <code>x</code> and returns the number of such intervals.  If
+ * <code>fn</code> is <code>NULL</code>, the function only counts them.
+ */
+
+int mapStabbingSegmentTree(SegmentTree st, IntervalFn fn, void *data, ...);
+
+#endif
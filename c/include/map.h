@@ -57,6 +57,19 @@ typedef struct MapCDT *Map;
 
 Map newMap();
 
+/**
+ * Function: newMapWithStorage
+ * Usage: map = newMapWithStorage(storage);
+ * ----------------------------------------
+ * Allocates a new map with no entries, using the data structure selected
+ * by <code>storage</code>, which must be one of the constants defined by
+ * the <code>StorageType</code> enumeration in <code>generic.h</code>.
+ * Maps with many entries are usually faster when created with the
+ * <code>B_TREE</code> option.
+ */
+
+Map newMapWithStorage(StorageType storage);
+
 /**
  * Function: freeMap
  * Usage: freeMap(map);
@@ -99,7 +112,9 @@ void clearMap(Map map);
  * ---------------------------
  * Creates a copy of the map.  The <code>clone</code> function copies
  * only the first level of the structure and does not copy the individual
- * elements.
+ * elements.  If the map was created with the <code>PERSISTENT_TREE</code>
+ * storage option, the copy shares its internal structure with the
+ * original and takes constant time to create.
  */
 
 Map cloneMap(Map map);
@@ -115,6 +130,21 @@ Map cloneMap(Map map);
 
 void putMap(Map map, string key, void *value);
 
+/**
+ * Function: putAllMap
+ * Usage: putAllMap(map, keys, values, n);
+ * ---------------------------------------
+ * Associates each of the first <code>n</code> elements of the array
+ * <code>keys</code> with the corresponding element of <code>values</code>.
+ * The effect is the same as calling <code>put</code> for each pair in
+ * order, so that a key appearing more than once takes the last of its
+ * values.  This function sorts the new entries and then rebuilds the map
+ * in a single pass, which is much faster than calling <code>put</code>
+ * for each pair when <code>n</code> is large.
+ */
+
+void putAllMap(Map map, string keys[], void *values[], int n);
+
 /**
  * Function: get
  * Usage: void *value = get(map, key);
@@ -143,6 +173,80 @@ bool containsKeyMap(Map map, string key);
 
 void removeMap(Map map, string key);
 
+/**
+ * Function: rankMap
+ * Usage: rank = rankMap(map, key);
+ * --------------------------------
+ * Returns the number of keys in the map that are less than
+ * <code>key</code>, which need not itself be in the map.
+ */
+
+int rankMap(Map map, string key);
+
+/**
+ * Function: selectMap
+ * Usage: key = selectMap(map, k);
+ * -------------------------------
+ * Returns the <code>k</code>th smallest key in the map, counting from 0.
+ * It is an error to call <code>selectMap</code> if <code>k</code> is
+ * not between 0 and one less than the size of the map.
+ */
+
+string selectMap(Map map, int k);
+
+/**
+ * Function: floorKeyMap
+ * Usage: key = floorKeyMap(map, key);
+ * -----------------------------------
+ * Returns the largest key in the map that is less than or equal to
+ * <code>key</code>, or <code>NULL</code> if there is no such key.
+ */
+
+string floorKeyMap(Map map, string key);
+
+/**
+ * Function: ceilingKeyMap
+ * Usage: key = ceilingKeyMap(map, key);
+ * -------------------------------------
+ * Returns the smallest key in the map that is greater than or equal to
+ * <code>key</code>, or <code>NULL</code> if there is no such key.
+ */
+
+string ceilingKeyMap(Map map, string key);
+
+/**
+ * Function: firstKeyMap
+ * Usage: key = firstKeyMap(map);
+ * ------------------------------
+ * Returns the smallest key in the map, or <code>NULL</code> if the map
+ * is empty.
+ */
+
+string firstKeyMap(Map map);
+
+/**
+ * Function: lastKeyMap
+ * Usage: key = lastKeyMap(map);
+ * -----------------------------
+ * Returns the largest key in the map, or <code>NULL</code> if the map
+ * is empty.
+ */
+
+string lastKeyMap(Map map);
+
+/**
+ * Function: newRangeIterator
+ * Usage: foreach (key in newRangeIterator(map, lo, hi)) . . .
+ * -----------------------------------------------------------
+ * Returns an iterator that produces, in ascending order, the keys in the
+ * map that lie between <code>lo</code> and <code>hi</code>, inclusive.
+ * Either bound may be <code>NULL</code>, in which case the range is
+ * unbounded at that end.  The iterator starts at the first key in the
+ * range without stepping through the keys that precede it.
+ */
+
+Iterator newRangeIterator(Map map, string lo, string hi);
+
 /**
  * Function: map
  * Usage: map(map, fn, data);
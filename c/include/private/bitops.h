@@ -0,0 +1,62 @@
+/*
+ * File: private/bitops.h
+ * ----------------------
+ * This file defines the operations on 64-bit words that the bitmap,
+ * bitvector, charset, and graphalgo modules share.  The functions are
+ * static and inline so that each module gets its own copy, which the
+ * compiler reduces to a single instruction on most processors.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _bitops_h
+#define _bitops_h
+
+#include <stdint.h>
+
+/*
+ * Implementation notes: countBits, lowestBit
+ * ------------------------------------------
+ * When the compiler provides them, these functions use the builtins that
+ * map onto the population count and count trailing zeros instructions.
+ * Otherwise, countBits adds the bits in parallel within the word and
+ * lowestBit isolates the lowest 1 bit and finds its position.  The
+ * result of lowestBit is undefined if word is 0.
+ */
+
+static inline int countBits(uint64_t word) {
+#ifdef __GNUC__
+   return __builtin_popcountll(word);
+#else
+   word = word - ((word >> 1) & 0x5555555555555555ULL);
+   word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+   word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+   return (int) ((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline int lowestBit(uint64_t word) {
+#ifdef __GNUC__
+   return __builtin_ctzll(word);
+#else
+   return countBits((word & -word) - 1);
+#endif
+}
+
+#endif
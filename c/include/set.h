@@ -28,6 +28,8 @@
 #include <stdarg.h>
 #include "cslib.h"
 #include "cmpfn.h"
+#include "generic.h"
+#include "iterator.h"
 
 /**
  * Type: Set
@@ -60,6 +62,43 @@ typedef struct SetCDT *Set;
 
 Set newSetFromType(string baseType);
 
+/**
+ * Function: newSetWithStorage
+ * Usage: set = newSetWithStorage(type, storage);
+ * ----------------------------------------------
+ * Creates an empty set of values of the specified base type, using the
+ * data structure selected by <code>storage</code>, which must be one of
+ * the constants defined by the <code>StorageType</code> enumeration in
+ * <code>generic.h</code>.  Sets with many elements are usually faster
+ * when created with the <code>B_TREE</code> option.
+ */
+
+#define newSetWithStorage(type, storage) \
+   newSetFromTypeWithStorage(#type, storage)
+
+/**
+ * Function: newSetFromTypeWithStorage
+ * Usage: set = newSetFromTypeWithStorage(baseType, storage);
+ * ----------------------------------------------------------
+ * Creates a new set of values with the specified base type expressed as
+ * a string, using the data structure selected by <code>storage</code>.
+ */
+
+Set newSetFromTypeWithStorage(string baseType, StorageType storage);
+
+/**
+ * Function: newSetFromArray
+ * Usage: set = newSetFromArray(baseType, array, n);
+ * -------------------------------------------------
+ * Creates a new set of values with the specified base type that contains
+ * the first <code>n</code> elements of <code>array</code>, which must be
+ * an array of that type.  The array need not be sorted and may contain
+ * duplicates.  Creating a large set in this way is much faster than
+ * adding the elements one at a time.
+ */
+
+Set newSetFromArray(string baseType, void *array, int n);
+
 /**
  * Function: freeSet
  * Usage: freeSet(set);
@@ -102,7 +141,9 @@ void clearSet(Set set);
  * ---------------------------
  * Creates a copy of the set.  The <code>clone</code> function copies
  * only the first level of the structure and does not copy the individual
- * elements.
+ * elements.  If the set was created with the <code>PERSISTENT_TREE</code>
+ * storage option, the copy shares its internal structure with the
+ * original and takes constant time to create.
  */
 
 Set cloneSet(Set set);
@@ -145,6 +186,19 @@ void addSet(Set set, ...);
 
 void addSetFromArgs(Set set, va_list args);
 
+/**
+ * Function: addAllSet
+ * Usage: addAllSet(set, array, n);
+ * --------------------------------
+ * Adds the first <code>n</code> elements of <code>array</code> to the
+ * set.  The array must contain values of the base type of the set, but
+ * need not be sorted.  This function sorts the array elements and then
+ * rebuilds the set in a single pass, which is much faster than calling
+ * <code>add</code> for each element when <code>n</code> is large.
+ */
+
+void addAllSet(Set set, void *array, int n);
+
 /**
  * Function: remove
  * Usage: remove(set, value);
@@ -164,6 +218,40 @@ void removeSet(Set set, ...);
 
 void removeSetFromArgs(Set set, va_list args);
 
+/**
+ * Function: rankSet
+ * Usage: rank = rankSet(set, value);
+ * ----------------------------------
+ * Returns the number of elements of the set that are less than the
+ * specified value, which need not itself be in the set.
+ */
+
+int rankSet(Set set, ...);
+
+/**
+ * Function: newSetRangeIterator
+ * Usage: foreach (value in newSetRangeIterator(set, lo, hi)) . . .
+ * ----------------------------------------------------------------
+ * Returns an iterator that produces, in ascending order, the elements of
+ * the set that lie between the values <code>lo</code> and
+ * <code>hi</code>, inclusive.  The iterator starts at the first element
+ * in the range without stepping through the elements that precede it.
+ */
+
+Iterator newSetRangeIterator(Set set, ...);
+
+/**
+ * Function: mapSet
+ * Usage: mapSet(set, fn, data);
+ * -----------------------------
+ * Calls <code>fn</code> on each element of the set in ascending order.
+ * The arguments to the callback function are the address of a variable
+ * holding the element and the <code>data</code> pointer.  The callback
+ * function must not add elements to or remove elements from the set.
+ */
+
+void mapSet(Set set, proc fn, void *data);
+
 /**
  * Function: equals
  * Usage: if (equals(s1, s2)) . . .
@@ -0,0 +1,205 @@
+/*
+ * File: sketch.h
+ * --------------
+ * This interface exports two probabilistic structures that summarize a
+ * stream of string keys in a fixed amount of memory.  A
+ * <code>BloomFilter</code> answers whether a key might have been added,
+ * with no false negatives and a false-positive rate chosen when the
+ * filter is created, which makes it a cheap test to apply before looking
+ * a key up in a large table.  A <code>CountMinSketch</code> estimates how
+ * many times each key has been added, never underestimating the count.
+ * Neither structure stores the keys themselves.  Both can be written to
+ * a file and read back, so that they can be built ahead of time and
+ * loaded when a program starts.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _sketch_h
+#define _sketch_h
+
+#include <stdio.h>
+#include "cslib.h"
+
+/**
+ * Type: BloomFilter
+ * -----------------
+ * The abstract type for a Bloom filter.
+ */
+
+typedef struct BloomFilterCDT *BloomFilter;
+
+/**
+ * Type: CountMinSketch
+ * --------------------
+ * The abstract type for a count-min sketch.
+ */
+
+typedef struct CountMinSketchCDT *CountMinSketch;
+
+/* Exported entries */
+
+/**
+ * Function: newBloomFilter
+ * Usage: bf = newBloomFilter(capacity, rate);
+ * -------------------------------------------
+ * Creates an empty Bloom filter sized so that, once
+ * <code>capacity</code> keys have been added, the probability that
+ * <code>mightContainBloomFilter</code> returns <code>true</code> for
+ * some other key is at most <code>rate</code>, apart from chance
+ * variation.  The filter is divided into blocks the size of a cache
+ * line, and each key affects only a single block, so that adding or
+ * testing a key touches memory only once.  The size accounts for this
+ * layout, which needs more bits per key than a classical Bloom filter
+ * to reach the same rate.
+ */
+
+BloomFilter newBloomFilter(int capacity, double rate);
+
+/**
+ * Function: freeBloomFilter
+ * Usage: freeBloomFilter(bf);
+ * ---------------------------
+ * Frees the storage associated with the filter.
+ */
+
+void freeBloomFilter(BloomFilter bf);
+
+/**
+ * Function: clearBloomFilter
+ * Usage: clearBloomFilter(bf);
+ * ----------------------------
+ * Returns the filter to its empty state.
+ */
+
+void clearBloomFilter(BloomFilter bf);
+
+/**
+ * Function: addBloomFilter
+ * Usage: addBloomFilter(bf, key);
+ * -------------------------------
+ * Adds <code>key</code> to the filter.
+ */
+
+void addBloomFilter(BloomFilter bf, string key);
+
+/**
+ * Function: mightContainBloomFilter
+ * Usage: if (mightContainBloomFilter(bf, key)) . . .
+ * --------------------------------------------------
+ * Returns <code>false</code> if <code>key</code> has definitely not been
+ * added to the filter and <code>true</code> if it probably has.
+ */
+
+bool mightContainBloomFilter(BloomFilter bf, string key);
+
+/**
+ * Function: writeBloomFilter
+ * Usage: writeBloomFilter(outfile, bf);
+ * -------------------------------------
+ * Writes the filter to <code>outfile</code>, which must have been opened
+ * in binary mode.  The format is the same on every platform.
+ */
+
+void writeBloomFilter(FILE *outfile, BloomFilter bf);
+
+/**
+ * Function: readBloomFilter
+ * Usage: bf = readBloomFilter(infile);
+ * ------------------------------------
+ * Reads a filter written by <code>writeBloomFilter</code>.  This
+ * function calls <code>error</code> if the file does not contain a
+ * filter.
+ */
+
+BloomFilter readBloomFilter(FILE *infile);
+
+/**
+ * Function: newCountMinSketch
+ * Usage: cms = newCountMinSketch(epsilon, delta);
+ * -----------------------------------------------
+ * Creates an empty count-min sketch.  With probability at least
+ * <code>1&nbsp;-&nbsp;delta</code>, the estimate for any key exceeds the
+ * true count by at most <code>epsilon</code> times the total of all
+ * counts added to the sketch.
+ */
+
+CountMinSketch newCountMinSketch(double epsilon, double delta);
+
+/**
+ * Function: freeCountMinSketch
+ * Usage: freeCountMinSketch(cms);
+ * -------------------------------
+ * Frees the storage associated with the sketch.
+ */
+
+void freeCountMinSketch(CountMinSketch cms);
+
+/**
+ * Function: clearCountMinSketch
+ * Usage: clearCountMinSketch(cms);
+ * --------------------------------
+ * Resets every count in the sketch to zero.
+ */
+
+void clearCountMinSketch(CountMinSketch cms);
+
+/**
+ * Function: addCountMinSketch
+ * Usage: addCountMinSketch(cms, key, count);
+ * ------------------------------------------
+ * Adds <code>count</code>, which must not be negative, to the count for
+ * <code>key</code>.  Counts that would overflow stop at the largest
+ * value an <code>int</code> can hold.
+ */
+
+void addCountMinSketch(CountMinSketch cms, string key, int count);
+
+/**
+ * Function: estimateCountMinSketch
+ * Usage: n = estimateCountMinSketch(cms, key);
+ * --------------------------------------------
+ * Returns an estimate of the total count added for <code>key</code>,
+ * which is never less than the true count.
+ */
+
+int estimateCountMinSketch(CountMinSketch cms, string key);
+
+/**
+ * Function: writeCountMinSketch
+ * Usage: writeCountMinSketch(outfile, cms);
+ * -----------------------------------------
+ * Writes the sketch to <code>outfile</code>, which must have been opened
+ * in binary mode.  The format is the same on every platform.
+ */
+
+void writeCountMinSketch(FILE *outfile, CountMinSketch cms);
+
+/**
+ * Function: readCountMinSketch
+ * Usage: cms = readCountMinSketch(infile);
+ * ----------------------------------------
+ * Reads a sketch written by <code>writeCountMinSketch</code>.  This
+ * function calls <code>error</code> if the file does not contain a
+ * sketch.
+ */
+
+CountMinSketch readCountMinSketch(FILE *infile);
+
+#endif
@@ -362,4 +362,101 @@ int stringArrayLength(string array[]);
 
 int searchStringArray(string str, string array[]);
 
+/* Section 6 -- String views */
+
+/**
+ * Type: StringView
+ * ----------------
+ * This type describes a sequence of characters inside some other string
+ * without copying them.  The field <code>p</code> points to the first
+ * character, and <code>len</code> is the number of characters, which
+ * need not be followed by a null character.  A view is valid only as
+ * long as the string into which it points, so a client that needs to
+ * keep the characters must copy them with <code>viewToString</code>.
+ * The functions in this section take and return views by value and
+ * never allocate memory, except for <code>viewToString</code>, which
+ * makes it possible to parse text without allocating a string for each
+ * piece until one of them needs to be kept.
+ */
+
+typedef struct {
+   const char *p;
+   int len;
+} StringView;
+
+/**
+ * Function: viewString
+ * Usage: view = viewString(s);
+ * ----------------------------
+ * Returns a view of the entire string <code>s</code>.
+ */
+
+StringView viewString(string s);
+
+/**
+ * Function: sliceString
+ * Usage: view = sliceString(s, p1, p2);
+ * -------------------------------------
+ * Returns a view of the characters of <code>s</code> between index
+ * positions <code>p1</code> and <code>p2</code>, inclusive, following
+ * the same rules as <code>substring</code>.  Unlike
+ * <code>substring</code>, this function reads only the characters up to
+ * position <code>p2</code> and does not copy them.
+ */
+
+StringView sliceString(string s, int p1, int p2);
+
+/**
+ * Function: sliceView
+ * Usage: part = sliceView(view, p1, p2);
+ * --------------------------------------
+ * Returns a view of the characters of <code>view</code> between index
+ * positions <code>p1</code> and <code>p2</code>, inclusive, following
+ * the same rules as <code>substring</code>.
+ */
+
+StringView sliceView(StringView view, int p1, int p2);
+
+/**
+ * Function: trimView
+ * Usage: trimmed = trimView(view);
+ * --------------------------------
+ * Returns a view of the same characters as <code>view</code> without
+ * any whitespace characters at the beginning and end.
+ */
+
+StringView trimView(StringView view);
+
+/**
+ * Function: findInView
+ * Usage: p = findInView(str, view, start);
+ * ----------------------------------------
+ * Searches for the string <code>str</code> in <code>view</code>, in the
+ * same way as <code>findString</code>, and returns the first index at
+ * or after <code>start</code> at which it begins, or -1 if there is no
+ * match.
+ */
+
+int findInView(string str, StringView view, int start);
+
+/**
+ * Function: viewEquals
+ * Usage: if (viewEquals(view, str)) . . .
+ * ---------------------------------------
+ * Returns <code>true</code> if the characters in <code>view</code> are
+ * the same as those in the string <code>str</code>.
+ */
+
+bool viewEquals(StringView view, string str);
+
+/**
+ * Function: viewToString
+ * Usage: s = viewToString(view);
+ * ------------------------------
+ * Returns a newly allocated string containing the characters in
+ * <code>view</code>.
+ */
+
+string viewToString(StringView view);
+
 #endif
@@ -27,6 +27,7 @@
 #define _tokenscanner_h
 
 #include "cslib.h"
+#include "strlib.h"
 #include "private/tokenpatch.h"
 
 /**
@@ -96,6 +97,18 @@ void freeTokenScanner();
 
 void setInputString(TokenScanner scanner, string str);
 
+/**
+ * Function: setInputView
+ * Usage: setInputView(scanner, view);
+ * -----------------------------------
+ * Sets the token stream for this scanner to the characters in the
+ * specified view, so that a client can scan part of a larger string
+ * without copying it.  The string into which the view points must
+ * remain unchanged while the scanner reads from it.
+ */
+
+void setInputView(TokenScanner scanner, StringView view);
+
 /**
  * Function: setInputFile
  * Usage: setInputFile(scanner, infile);
@@ -126,6 +139,19 @@ bool hasMoreTokens(TokenScanner scanner);
 
 string nextToken(TokenScanner scanner);
 
+/**
+ * Function: nextTokenView
+ * Usage: view = nextTokenView(scanner);
+ * -------------------------------------
+ * Returns the next token as a view rather than a new string.  The view
+ * points into storage that belongs to the scanner, so it remains valid
+ * only until the next call that reads from the scanner.  A client that
+ * needs to keep the token must copy it with <code>viewToString</code>.
+ * At the end of the input, the view is empty.
+ */
+
+StringView nextTokenView(TokenScanner scanner);
+
 /**
  * Function: saveToken
  * Usage: saveToken(scanner, token);
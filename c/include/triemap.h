@@ -0,0 +1,195 @@
+/*
+ * File: triemap.h
+ * ---------------
+ * This interface defines a map abstraction that associates string keys
+ * with values using a <b><i>radix tree</i></b>, which is a trie in which
+ * each chain of nodes with a single child is compressed into one node.
+ * Keys that share a prefix share the nodes that represent it, so the
+ * prefix is stored only once.  In addition to the usual map operations,
+ * a <code>TrieMap</code> can efficiently step through the keys that
+ * begin with a given prefix and find the longest key that is a prefix
+ * of a given string.  As with the <code>Map</code> type, iteration
+ * produces the keys in lexicographic order.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#ifndef _triemap_h
+#define _triemap_h
+
+#include "cslib.h"
+#include "iterator.h"
+
+/**
+ * Type: TrieMap
+ * -------------
+ * This type is the ADT used to represent the map.
+ */
+
+typedef struct TrieMapCDT *TrieMap;
+
+/* Exported entries */
+
+/**
+ * Function: newTrieMap
+ * Usage: map = newTrieMap();
+ * --------------------------
+ * Allocates a new map with no entries.
+ */
+
+TrieMap newTrieMap(void);
+
+/**
+ * Function: freeTrieMap
+ * Usage: freeTrieMap(map);
+ * ------------------------
+ * Frees the storage associated with the map.
+ */
+
+void freeTrieMap(TrieMap map);
+
+/**
+ * Function: size
+ * Usage: n = size(map);
+ * ---------------------
+ * Returns the number of entries in the map.
+ */
+
+int sizeTrieMap(TrieMap map);
+
+/**
+ * Function: isEmpty
+ * Usage: if (isEmpty(map)) . . .
+ * ------------------------------
+ * Returns <code>true</code> if the map has no entries.
+ */
+
+bool isEmptyTrieMap(TrieMap map);
+
+/**
+ * Function: clear
+ * Usage: clear(map);
+ * ------------------
+ * Removes all entries from the map.
+ */
+
+void clearTrieMap(TrieMap map);
+
+/**
+ * Function: clone
+ * Usage: newmap = clone(map);
+ * ---------------------------
+ * Creates a copy of the map.  The <code>clone</code> function copies
+ * only the first level of the structure and does not copy the individual
+ * values.
+ */
+
+TrieMap cloneTrieMap(TrieMap map);
+
+/**
+ * Function: put
+ * Usage: put(map, key, value);
+ * ----------------------------
+ * Associates <code>key</code> with <code>value</code> in the map.
+ * Each call to <code>put</code> supersedes any previous definition
+ * for <code>key</code>.
+ */
+
+void putTrieMap(TrieMap map, string key, void *value);
+
+/**
+ * Function: get
+ * Usage: void *value = get(map, key);
+ * -----------------------------------
+ * Returns the value associated with <code>key</code> in the map,
+ * or <code>NULL</code>, if no such value exists.
+ */
+
+void *getTrieMap(TrieMap map, string key);
+
+/**
+ * Function: containsKey
+ * Usage: if (containsKey(map, key)) . . .
+ * ---------------------------------------
+ * Checks to see if the map contains the specified key.
+ */
+
+bool containsKeyTrieMap(TrieMap map, string key);
+
+/**
+ * Function: remove
+ * Usage: remove(map, key);
+ * ------------------------
+ * Removes the key and its value from the map.
+ */
+
+void removeTrieMap(TrieMap map, string key);
+
+/**
+ * Function: longestPrefixTrieMap
+ * Usage: key = longestPrefixTrieMap(map, str);
+ * --------------------------------------------
+ * Returns the longest key in the map that is a prefix of
+ * <code>str</code>, or <code>NULL</code> if there is no such key.  The
+ * result is a newly allocated string.  The search examines each
+ * character of <code>str</code> at most once.
+ */
+
+string longestPrefixTrieMap(TrieMap map, string str);
+
+/**
+ * Function: newPrefixIterator
+ * Usage: foreach (key in newPrefixIterator(map, prefix)) . . .
+ * ------------------------------------------------------------
+ * Returns an iterator that produces, in lexicographic order, the keys in
+ * the map that begin with <code>prefix</code>.  The iteration starts at
+ * the node for the prefix and never visits the other keys.  Because the
+ * map does not store its keys as separate strings, each key is assembled
+ * in a buffer that belongs to the iterator and is overwritten by the next
+ * step; clients that need to keep a key must copy it.  Using the map
+ * itself in a <code>foreach</code> loop iterates over all of its keys in
+ * the same way.  The map must not be modified while the iteration is in
+ * progress.
+ */
+
+Iterator newPrefixIterator(TrieMap map, string prefix);
+
+/**
+ * Function: map
+ * Usage: map(map, fn, data);
+ * --------------------------
+ * Iterates through the map in lexicographic order of the keys and calls
+ * the function <code>fn</code> on each entry.  The callback function
+ * takes the following arguments:
+ *
+ *<ul>
+ *  <li>The key string
+ *  <li>The associated value
+ *  <li>The <code>data</code> pointer
+ *</ul>
+ *
+ * The <code>data</code> pointer allows the client to pass state
+ * information to the function <code>fn</code>, if necessary.  If no such
+ * information is required, this argument should be <code>NULL</code>.
+ * The key string is valid only until the callback function returns.
+ */
+
+void mapTrieMap(TrieMap map, proc fn, void *data);
+
+#endif
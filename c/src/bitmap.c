@@ -0,0 +1,1390 @@
+/*
+ * File: bitmap.c
+ * --------------
+ * This file implements the bitmap.h interface, which provides a
+ * compressed representation for sets of unsigned integers.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bitmap.h"
+#include "cslib.h"
+#include "foreach.h"
+#include "iterator.h"
+#include "itertype.h"
+#include "unittest.h"
+#include "private/bitops.h"
+
+/*
+ * Constants
+ * ---------
+ * CHUNK_SIZE       -- Number of values covered by each container
+ * ARRAY_LIMIT      -- Largest number of values stored in an array
+ * BITMAP_WORDS     -- Number of 64-bit words in a bitmap container
+ * INITIAL_CAPACITY -- Initial number of entries allocated for an array
+ */
+
+#define CHUNK_SIZE 65536
+#define ARRAY_LIMIT 4096
+#define BITMAP_WORDS (CHUNK_SIZE / 64)
+#define INITIAL_CAPACITY 4
+
+/*
+ * Type: ContainerType
+ * -------------------
+ * This type identifies the representation used for a chunk.
+ */
+
+typedef enum {
+   ARRAY_CONTAINER,
+   BITMAP_CONTAINER,
+   RUN_CONTAINER
+} ContainerType;
+
+/*
+ * Type: Container
+ * ---------------
+ * This type holds the values in a bitmap whose upper 16 bits are equal
+ * to the key.  An array container stores the lower 16 bits of each value
+ * in ascending order.  A run container uses the same array to store a
+ * pair for each run, consisting of the first value and the length of the
+ * run minus one.  A bitmap container stores one bit for every possible
+ * value in the words array.
+ */
+
+typedef struct {
+   unsigned short key;         /* Upper 16 bits of the values           */
+   ContainerType type;         /* Representation used for this chunk    */
+   int cardinality;            /* Number of values in the chunk         */
+   int length;                 /* Number of values or runs in array     */
+   int capacity;               /* Number of values or runs allocated    */
+   unsigned short *array;      /* Values or runs for those types        */
+   uint64_t *words;            /* Bits for a bitmap container           */
+} Container;
+
+/*
+ * Type: BitmapCDT
+ * ---------------
+ * This type is the concrete type used to represent the bitmap.  The
+ * containers are stored in ascending order of their keys, and only
+ * chunks that hold at least one value have a container.
+ */
+
+struct BitmapCDT {
+   IteratorHeader header;      /* Header to enable iteration            */
+   Container *containers;      /* Array of nonempty containers          */
+   int count;                  /* Number of containers                  */
+   int capacity;               /* Number of containers allocated        */
+   int size;                   /* Number of values in the bitmap        */
+};
+
+/*
+ * Type: BitmapOperation
+ * ---------------------
+ * This type identifies the operations that combine two bitmaps.
+ */
+
+typedef enum { UNION_OP, INTERSECTION_OP, DIFFERENCE_OP } BitmapOperation;
+
+/*
+ * Type: CursorState
+ * -----------------
+ * This type holds the state of an iteration over a bitmap.  The pos
+ * field is the index of the next value in an array container, the index
+ * of the current run in a run container, or the next bit to examine in
+ * a bitmap container.  For a run container, the offset field is the
+ * position of the next value within the current run.
+ */
+
+typedef struct {
+   Bitmap bm;
+   int index;
+   int pos;
+   int offset;
+   unsigned hi;
+} CursorState;
+
+/* Private function prototypes */
+
+static int findContainer(Bitmap bm, int key, bool *found);
+static Container *insertContainer(Bitmap bm, int index, int key);
+static void removeContainer(Bitmap bm, int index);
+static Container *appendContainer(Bitmap bm);
+static void initContainer(Container *c, int key);
+static void copyContainer(Container *dst, Container *src);
+static void freeContainer(Container *c);
+static void ensureCapacity(Container *c, int n);
+static bool containerContains(Container *c, int low);
+static bool containerAdd(Container *c, int low);
+static bool containerRemove(Container *c, int low);
+static int containerRank(Container *c, int low);
+static int lowerBound(unsigned short array[], int n, int low);
+static int findRun(Container *c, int low);
+static void convertToBitmap(Container *c);
+static void convertToArray(Container *c);
+static void expandRuns(Container *c);
+static void convertToRuns(Container *c);
+static int extendRuns(unsigned short runs[], int n, int v);
+static int countRuns(Container *c);
+static void shrinkIfSparse(Container *c);
+static Container *expandedView(Container *c, Container *tmp);
+static Bitmap combineBitmaps(Bitmap b1, Bitmap b2, BitmapOperation op);
+static void unionContainers(Container *dst, Container *a, Container *b);
+static void intersectContainers(Container *dst, Container *a,
+                                Container *b);
+static void subtractContainers(Container *dst, Container *a, Container *b);
+static int intersectionCardinality(Container *a, Container *b);
+static void loadWords(Container *dst, Container *src);
+static int countWords(uint64_t words[]);
+static void initCursor(CursorState *cs, Bitmap bm, unsigned lo, unsigned hi);
+static bool advanceCursor(CursorState *cs, unsigned *dst);
+static bool stepBitmapIterator(Iterator iterator, void *dst);
+static Iterator newForeachIterator(void *collection);
+
+/* Exported entries */
+
+Bitmap newBitmap(void) {
+   Bitmap bm;
+
+   bm = newBlock(Bitmap);
+   enableIteration(bm, newForeachIterator);
+   bm->containers = NULL;
+   bm->count = 0;
+   bm->capacity = 0;
+   bm->size = 0;
+   return bm;
+}
+
+void freeBitmap(Bitmap bm) {
+   clearBitmap(bm);
+   freeBlock(bm);
+}
+
+int sizeBitmap(Bitmap bm) {
+   return bm->size;
+}
+
+bool isEmptyBitmap(Bitmap bm) {
+   return bm->size == 0;
+}
+
+void clearBitmap(Bitmap bm) {
+   int i;
+
+   for (i = 0; i < bm->count; i++) {
+      freeContainer(&bm->containers[i]);
+   }
+   if (bm->containers != NULL) freeBlock(bm->containers);
+   bm->containers = NULL;
+   bm->count = 0;
+   bm->capacity = 0;
+   bm->size = 0;
+}
+
+Bitmap cloneBitmap(Bitmap bm) {
+   Bitmap newbm;
+   int i;
+
+   newbm = newBitmap();
+   for (i = 0; i < bm->count; i++) {
+      copyContainer(appendContainer(newbm), &bm->containers[i]);
+   }
+   newbm->size = bm->size;
+   return newbm;
+}
+
+bool containsBitmap(Bitmap bm, unsigned value) {
+   bool found;
+   int index;
+
+   index = findContainer(bm, value >> 16, &found);
+   return found && containerContains(&bm->containers[index], value & 0xFFFF);
+}
+
+/*
+ * Implementation notes: addBitmap
+ * -------------------------------
+ * Values that arrive in ascending order usually belong to the last
+ * container, which is checked before searching the others.
+ */
+
+void addBitmap(Bitmap bm, unsigned value) {
+   Container *c;
+   bool found;
+   int key, index;
+
+   key = value >> 16;
+   if (bm->count > 0 && bm->containers[bm->count - 1].key == key) {
+      c = &bm->containers[bm->count - 1];
+   } else {
+      index = findContainer(bm, key, &found);
+      if (found) {
+         c = &bm->containers[index];
+      } else {
+         c = insertContainer(bm, index, key);
+      }
+   }
+   if (containerAdd(c, value & 0xFFFF)) bm->size++;
+}
+
+void removeBitmap(Bitmap bm, unsigned value) {
+   Container *c;
+   bool found;
+   int index;
+
+   index = findContainer(bm, value >> 16, &found);
+   if (!found) return;
+   c = &bm->containers[index];
+   if (containerRemove(c, value & 0xFFFF)) {
+      bm->size--;
+      if (c->cardinality == 0) removeContainer(bm, index);
+   }
+}
+
+int rankBitmap(Bitmap bm, unsigned value) {
+   int i, key, rank;
+
+   key = value >> 16;
+   rank = 0;
+   for (i = 0; i < bm->count && bm->containers[i].key < key; i++) {
+      rank += bm->containers[i].cardinality;
+   }
+   if (i < bm->count && bm->containers[i].key == key) {
+      rank += containerRank(&bm->containers[i], value & 0xFFFF);
+   }
+   return rank;
+}
+
+bool equalsBitmap(Bitmap b1, Bitmap b2) {
+   return b1->size == b2->size && isSubsetBitmap(b1, b2);
+}
+
+/*
+ * Implementation notes: isSubsetBitmap
+ * ------------------------------------
+ * The bitmap b1 is a subset of b2 if each container in b1 has a partner
+ * in b2 with which it shares all of its values.  The number of shared
+ * values is counted without building the intersection.
+ */
+
+bool isSubsetBitmap(Bitmap b1, Bitmap b2) {
+   Container *c1, *c2;
+   int i, j;
+
+   if (b1->size > b2->size) return false;
+   j = 0;
+   for (i = 0; i < b1->count; i++) {
+      c1 = &b1->containers[i];
+      while (j < b2->count && b2->containers[j].key < c1->key) {
+         j++;
+      }
+      if (j == b2->count || b2->containers[j].key != c1->key) return false;
+      c2 = &b2->containers[j];
+      if (c1->cardinality > c2->cardinality) return false;
+      if (intersectionCardinality(c1, c2) != c1->cardinality) return false;
+   }
+   return true;
+}
+
+Bitmap unionBitmap(Bitmap b1, Bitmap b2) {
+   return combineBitmaps(b1, b2, UNION_OP);
+}
+
+Bitmap intersectionBitmap(Bitmap b1, Bitmap b2) {
+   return combineBitmaps(b1, b2, INTERSECTION_OP);
+}
+
+Bitmap differenceBitmap(Bitmap b1, Bitmap b2) {
+   return combineBitmaps(b1, b2, DIFFERENCE_OP);
+}
+
+/*
+ * Implementation notes: optimizeBitmap
+ * ------------------------------------
+ * A run container takes four bytes per run, an array container takes
+ * two bytes per value, and a bitmap container always takes 8192 bytes.
+ * Each container is converted to runs if that is the smallest of the
+ * three.
+ */
+
+void optimizeBitmap(Bitmap bm) {
+   Container *c;
+   int i, runBytes, currentBytes;
+
+   for (i = 0; i < bm->count; i++) {
+      c = &bm->containers[i];
+      if (c->type == RUN_CONTAINER) continue;
+      runBytes = 4 * countRuns(c);
+      if (c->type == ARRAY_CONTAINER) {
+         currentBytes = 2 * c->cardinality;
+      } else {
+         currentBytes = BITMAP_WORDS * sizeof(uint64_t);
+      }
+      if (runBytes < currentBytes) convertToRuns(c);
+   }
+}
+
+Iterator newBitmapRangeIterator(Bitmap bm, unsigned lo, unsigned hi) {
+   Iterator iterator;
+   CursorState *cs;
+
+   cs = newBlock(CursorState *);
+   initCursor(cs, bm, lo, hi);
+   iterator = newStepIterator(sizeof(unsigned), stepBitmapIterator);
+   setCollection(iterator, bm);
+   setIteratorData(iterator, cs);
+   return iterator;
+}
+
+/* Private functions */
+
+/*
+ * Implementation notes: findContainer
+ * -----------------------------------
+ * Uses binary search to find the container with the specified key.  If
+ * there is no such container, the function sets found to false and
+ * returns the index at which that container would be inserted.
+ */
+
+static int findContainer(Bitmap bm, int key, bool *found) {
+   int lh, rh, mid;
+
+   lh = 0;
+   rh = bm->count - 1;
+   while (lh <= rh) {
+      mid = (lh + rh) / 2;
+      if (bm->containers[mid].key == key) {
+         *found = true;
+         return mid;
+      }
+      if (bm->containers[mid].key < key) {
+         lh = mid + 1;
+      } else {
+         rh = mid - 1;
+      }
+   }
+   *found = false;
+   return lh;
+}
+
+/*
+ * Implementation notes: insertContainer, removeContainer, appendContainer
+ * -----------------------------------------------------------------------
+ * These functions maintain the array of containers, which doubles in
+ * size whenever it runs out of space.
+ */
+
+static Container *insertContainer(Bitmap bm, int index, int key) {
+   Container *c;
+
+   appendContainer(bm);
+   memmove(&bm->containers[index + 1], &bm->containers[index],
+           (bm->count - index - 1) * sizeof(Container));
+   c = &bm->containers[index];
+   initContainer(c, key);
+   return c;
+}
+
+static void removeContainer(Bitmap bm, int index) {
+   freeContainer(&bm->containers[index]);
+   memmove(&bm->containers[index], &bm->containers[index + 1],
+           (bm->count - index - 1) * sizeof(Container));
+   bm->count--;
+}
+
+static Container *appendContainer(Bitmap bm) {
+   Container *array;
+   int newCapacity;
+
+   if (bm->count == bm->capacity) {
+      newCapacity = (bm->capacity == 0) ? INITIAL_CAPACITY
+                                        : 2 * bm->capacity;
+      array = newArray(newCapacity, Container);
+      if (bm->containers != NULL) {
+         memcpy(array, bm->containers, bm->count * sizeof(Container));
+         freeBlock(bm->containers);
+      }
+      bm->containers = array;
+      bm->capacity = newCapacity;
+   }
+   return &bm->containers[bm->count++];
+}
+
+/*
+ * Implementation notes: initContainer, copyContainer, freeContainer
+ * -----------------------------------------------------------------
+ * A new container is an empty array container.  The copyContainer
+ * function allocates new storage for the copy.
+ */
+
+static void initContainer(Container *c, int key) {
+   c->key = key;
+   c->type = ARRAY_CONTAINER;
+   c->cardinality = 0;
+   c->length = 0;
+   c->capacity = 0;
+   c->array = NULL;
+   c->words = NULL;
+}
+
+static void copyContainer(Container *dst, Container *src) {
+   int nShorts;
+
+   *dst = *src;
+   if (src->array != NULL) {
+      nShorts = (src->type == RUN_CONTAINER) ? 2 * src->capacity
+                                             : src->capacity;
+      dst->array = newArray(nShorts, unsigned short);
+      memcpy(dst->array, src->array, nShorts * sizeof(unsigned short));
+   }
+   if (src->words != NULL) {
+      dst->words = newArray(BITMAP_WORDS, uint64_t);
+      memcpy(dst->words, src->words, BITMAP_WORDS * sizeof(uint64_t));
+   }
+}
+
+static void freeContainer(Container *c) {
+   if (c->array != NULL) freeBlock(c->array);
+   if (c->words != NULL) freeBlock(c->words);
+   c->array = NULL;
+   c->words = NULL;
+}
+
+/*
+ * Implementation notes: ensureCapacity
+ * ------------------------------------
+ * Makes sure that the array of an array or run container has room for
+ * at least n entries, where each entry of a run container occupies two
+ * elements of the array.
+ */
+
+static void ensureCapacity(Container *c, int n) {
+   unsigned short *array;
+   int newCapacity, perEntry;
+
+   if (n <= c->capacity) return;
+   perEntry = (c->type == RUN_CONTAINER) ? 2 : 1;
+   newCapacity = (c->capacity == 0) ? INITIAL_CAPACITY : c->capacity;
+   while (newCapacity < n) {
+      newCapacity *= 2;
+   }
+   array = newArray(perEntry * newCapacity, unsigned short);
+   if (c->array != NULL) {
+      memcpy(array, c->array, perEntry * c->length * sizeof(unsigned short));
+      freeBlock(c->array);
+   }
+   c->array = array;
+   c->capacity = newCapacity;
+}
+
+static bool containerContains(Container *c, int low) {
+   int i;
+
+   switch (c->type) {
+     case ARRAY_CONTAINER:
+      i = lowerBound(c->array, c->length, low);
+      return i < c->length && c->array[i] == low;
+     case BITMAP_CONTAINER:
+      return (c->words[low >> 6] >> (low & 63)) & 1;
+     case RUN_CONTAINER:
+      i = findRun(c, low);
+      return i >= 0 && low <= c->array[2 * i] + c->array[2 * i + 1];
+   }
+   return false;
+}
+
+/*
+ * Implementation notes: containerAdd, containerRemove
+ * ---------------------------------------------------
+ * These functions return true if the container changes.  A run container
+ * is expanded into one of the other forms before it is changed, and an
+ * array or bitmap container switches to the other form when its
+ * cardinality crosses ARRAY_LIMIT.
+ */
+
+static bool containerAdd(Container *c, int low) {
+   int i;
+
+   if (c->type == RUN_CONTAINER) {
+      if (containerContains(c, low)) return false;
+      expandRuns(c);
+   }
+   if (c->type == ARRAY_CONTAINER) {
+      i = lowerBound(c->array, c->length, low);
+      if (i < c->length && c->array[i] == low) return false;
+      if (c->cardinality < ARRAY_LIMIT) {
+         ensureCapacity(c, c->length + 1);
+         memmove(&c->array[i + 1], &c->array[i],
+                 (c->length - i) * sizeof(unsigned short));
+         c->array[i] = low;
+         c->length++;
+         c->cardinality++;
+         return true;
+      }
+      convertToBitmap(c);
+   }
+   if ((c->words[low >> 6] >> (low & 63)) & 1) return false;
+   c->words[low >> 6] |= (uint64_t) 1 << (low & 63);
+   c->cardinality++;
+   return true;
+}
+
+static bool containerRemove(Container *c, int low) {
+   int i;
+
+   if (!containerContains(c, low)) return false;
+   if (c->type == RUN_CONTAINER) expandRuns(c);
+   if (c->type == ARRAY_CONTAINER) {
+      i = lowerBound(c->array, c->length, low);
+      memmove(&c->array[i], &c->array[i + 1],
+              (c->length - i - 1) * sizeof(unsigned short));
+      c->length--;
+      c->cardinality--;
+   } else {
+      c->words[low >> 6] &= ~((uint64_t) 1 << (low & 63));
+      c->cardinality--;
+      shrinkIfSparse(c);
+   }
+   return true;
+}
+
+static int containerRank(Container *c, int low) {
+   int i, rank, start, end;
+
+   switch (c->type) {
+     case ARRAY_CONTAINER:
+      return lowerBound(c->array, c->length, low);
+     case BITMAP_CONTAINER:
+      rank = 0;
+      for (i = 0; i < (low >> 6); i++) {
+         rank += countBits(c->words[i]);
+      }
+      if ((low & 63) != 0) {
+         rank += countBits(c->words[i] & (((uint64_t) 1 << (low & 63)) - 1));
+      }
+      return rank;
+     case RUN_CONTAINER:
+      rank = 0;
+      for (i = 0; i < c->length; i++) {
+         start = c->array[2 * i];
+         end = start + c->array[2 * i + 1];
+         if (start >= low) break;
+         rank += ((end < low) ? end : low - 1) - start + 1;
+      }
+      return rank;
+   }
+   return 0;
+}
+
+/*
+ * Implementation notes: lowerBound, findRun
+ * -----------------------------------------
+ * The lowerBound function returns the index of the first element of the
+ * sorted array that is at least low.  The findRun function returns the
+ * index of the last run that starts at or before low, or -1 if there is
+ * no such run.
+ */
+
+static int lowerBound(unsigned short array[], int n, int low) {
+   int lh, rh, mid;
+
+   lh = 0;
+   rh = n;
+   while (lh < rh) {
+      mid = (lh + rh) / 2;
+      if (array[mid] < low) {
+         lh = mid + 1;
+      } else {
+         rh = mid;
+      }
+   }
+   return lh;
+}
+
+static int findRun(Container *c, int low) {
+   int lh, rh, mid;
+
+   lh = 0;
+   rh = c->length;
+   while (lh < rh) {
+      mid = (lh + rh) / 2;
+      if (c->array[2 * mid] <= low) {
+         lh = mid + 1;
+      } else {
+         rh = mid;
+      }
+   }
+   return lh - 1;
+}
+
+/*
+ * Implementation notes: Conversions
+ * ---------------------------------
+ * The functions convertToBitmap and convertToArray change a container of
+ * any type into the specified form.  The expandRuns function changes a
+ * run container into whichever of the other two forms is appropriate for
+ * its cardinality, and shrinkIfSparse changes a bitmap container that
+ * holds few values into an array.
+ */
+
+static void convertToBitmap(Container *c) {
+   uint64_t *words;
+   int i, v, start, end;
+
+   words = newArray(BITMAP_WORDS, uint64_t);
+   memset(words, 0, BITMAP_WORDS * sizeof(uint64_t));
+   if (c->type == ARRAY_CONTAINER) {
+      for (i = 0; i < c->length; i++) {
+         v = c->array[i];
+         words[v >> 6] |= (uint64_t) 1 << (v & 63);
+      }
+   } else if (c->type == RUN_CONTAINER) {
+      for (i = 0; i < c->length; i++) {
+         start = c->array[2 * i];
+         end = start + c->array[2 * i + 1];
+         for (v = start; v <= end; v++) {
+            words[v >> 6] |= (uint64_t) 1 << (v & 63);
+         }
+      }
+   } else {
+      freeBlock(words);
+      return;
+   }
+   freeContainer(c);
+   c->type = BITMAP_CONTAINER;
+   c->words = words;
+   c->length = 0;
+   c->capacity = 0;
+}
+
+static void convertToArray(Container *c) {
+   unsigned short *array;
+   uint64_t word;
+   int i, n, v, start, end;
+
+   if (c->type == ARRAY_CONTAINER) return;
+   array = newArray((c->cardinality == 0) ? 1 : c->cardinality,
+                    unsigned short);
+   n = 0;
+   if (c->type == BITMAP_CONTAINER) {
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         word = c->words[i];
+         while (word != 0) {
+            array[n++] = 64 * i + lowestBit(word);
+            word &= word - 1;
+         }
+      }
+   } else {
+      for (i = 0; i < c->length; i++) {
+         start = c->array[2 * i];
+         end = start + c->array[2 * i + 1];
+         for (v = start; v <= end; v++) {
+            array[n++] = v;
+         }
+      }
+   }
+   freeContainer(c);
+   c->type = ARRAY_CONTAINER;
+   c->array = array;
+   c->length = n;
+   c->capacity = (n == 0) ? 1 : n;
+}
+
+static void expandRuns(Container *c) {
+   if (c->type != RUN_CONTAINER) return;
+   if (c->cardinality <= ARRAY_LIMIT) {
+      convertToArray(c);
+   } else {
+      convertToBitmap(c);
+   }
+}
+
+static void shrinkIfSparse(Container *c) {
+   if (c->type == BITMAP_CONTAINER && c->cardinality <= ARRAY_LIMIT) {
+      convertToArray(c);
+   }
+}
+
+static void convertToRuns(Container *c) {
+   unsigned short *runs;
+   uint64_t word;
+   int i, n;
+
+   runs = newArray(2 * countRuns(c), unsigned short);
+   n = 0;
+   if (c->type == ARRAY_CONTAINER) {
+      for (i = 0; i < c->length; i++) {
+         n = extendRuns(runs, n, c->array[i]);
+      }
+   } else {
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         word = c->words[i];
+         while (word != 0) {
+            n = extendRuns(runs, n, 64 * i + lowestBit(word));
+            word &= word - 1;
+         }
+      }
+   }
+   freeContainer(c);
+   c->type = RUN_CONTAINER;
+   c->array = runs;
+   c->length = n;
+   c->capacity = n;
+}
+
+/*
+ * Implementation notes: extendRuns
+ * --------------------------------
+ * Adds the value v, which must be larger than any value already in the
+ * n runs, and returns the new number of runs.
+ */
+
+static int extendRuns(unsigned short runs[], int n, int v) {
+   if (n > 0 && v == runs[2 * n - 2] + runs[2 * n - 1] + 1) {
+      runs[2 * n - 1]++;
+      return n;
+   }
+   runs[2 * n] = v;
+   runs[2 * n + 1] = 0;
+   return n + 1;
+}
+
+/*
+ * Implementation notes: countRuns
+ * -------------------------------
+ * In a bitmap container, a run starts at each 1 bit whose predecessor
+ * is a 0 bit.  Shifting each word left by one, with the top bit of the
+ * previous word shifted in, lines up each bit with its predecessor, so
+ * the runs in a word can be counted with a single population count.
+ */
+
+static int countRuns(Container *c) {
+   uint64_t word, carry;
+   int i, n;
+
+   n = 0;
+   switch (c->type) {
+     case ARRAY_CONTAINER:
+      for (i = 0; i < c->length; i++) {
+         if (i == 0 || c->array[i] != c->array[i - 1] + 1) n++;
+      }
+      break;
+     case BITMAP_CONTAINER:
+      carry = 0;
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         word = c->words[i];
+         n += countBits(word & ~((word << 1) | carry));
+         carry = word >> 63;
+      }
+      break;
+     case RUN_CONTAINER:
+      n = c->length;
+      break;
+   }
+   return n;
+}
+
+/*
+ * Implementation notes: expandedView
+ * ----------------------------------
+ * The operations that combine containers handle only the array and
+ * bitmap forms.  This function returns its argument if it already has
+ * one of those forms and otherwise expands a copy of it into tmp, which
+ * the caller must then free.
+ */
+
+static Container *expandedView(Container *c, Container *tmp) {
+   if (c->type != RUN_CONTAINER) return c;
+   copyContainer(tmp, c);
+   expandRuns(tmp);
+   return tmp;
+}
+
+/*
+ * Implementation notes: combineBitmaps
+ * ------------------------------------
+ * Steps through the containers of the two bitmaps in order of their
+ * keys, in the manner of the merge phase of merge sort.  Containers with
+ * the same key are combined by the operation, while a container that
+ * has no partner is either copied or skipped.  Empty results are dropped.
+ */
+
+static Bitmap combineBitmaps(Bitmap b1, Bitmap b2, BitmapOperation op) {
+   Bitmap result;
+   Container *c1, *c2, *dst, tmp1, tmp2, *v1, *v2;
+   int i, j;
+
+   result = newBitmap();
+   i = j = 0;
+   while (i < b1->count || j < b2->count) {
+      c1 = (i < b1->count) ? &b1->containers[i] : NULL;
+      c2 = (j < b2->count) ? &b2->containers[j] : NULL;
+      if (c2 == NULL || (c1 != NULL && c1->key < c2->key)) {
+         if (op != INTERSECTION_OP) {
+            copyContainer(appendContainer(result), c1);
+            result->size += c1->cardinality;
+         } else if (c2 == NULL) {
+            break;
+         }
+         i++;
+      } else if (c1 == NULL || c2->key < c1->key) {
+         if (op == UNION_OP) {
+            copyContainer(appendContainer(result), c2);
+            result->size += c2->cardinality;
+         } else if (c1 == NULL) {
+            break;
+         }
+         j++;
+      } else {
+         v1 = expandedView(c1, &tmp1);
+         v2 = expandedView(c2, &tmp2);
+         dst = appendContainer(result);
+         initContainer(dst, c1->key);
+         switch (op) {
+           case UNION_OP: unionContainers(dst, v1, v2); break;
+           case INTERSECTION_OP: intersectContainers(dst, v1, v2); break;
+           case DIFFERENCE_OP: subtractContainers(dst, v1, v2); break;
+         }
+         if (v1 == &tmp1) freeContainer(&tmp1);
+         if (v2 == &tmp2) freeContainer(&tmp2);
+         if (dst->cardinality == 0) {
+            removeContainer(result, result->count - 1);
+         } else {
+            result->size += dst->cardinality;
+         }
+         i++;
+         j++;
+      }
+   }
+   return result;
+}
+
+/*
+ * Implementation notes: unionContainers, intersectContainers,
+ *                       subtractContainers
+ * -----------------------------------------------------------
+ * Each of these functions stores into dst the result of combining two
+ * containers in array or bitmap form.  When both operands are bitmaps,
+ * the result is computed one 64-bit word at a time in a simple loop
+ * with no dependencies between iterations, which an optimizing compiler
+ * turns into vector instructions where the machine has them.  Results
+ * that end up with few values are stored as arrays.
+ */
+
+static void unionContainers(Container *dst, Container *a, Container *b) {
+   Container *tmp;
+   int i, j, n, v;
+
+   if (a->type == ARRAY_CONTAINER && b->type == ARRAY_CONTAINER
+       && a->cardinality + b->cardinality <= ARRAY_LIMIT) {
+      ensureCapacity(dst, a->length + b->length);
+      i = j = n = 0;
+      while (i < a->length || j < b->length) {
+         if (j == b->length || (i < a->length && a->array[i] < b->array[j])) {
+            dst->array[n++] = a->array[i++];
+         } else if (i == a->length || b->array[j] < a->array[i]) {
+            dst->array[n++] = b->array[j++];
+         } else {
+            dst->array[n++] = a->array[i++];
+            j++;
+         }
+      }
+      dst->length = dst->cardinality = n;
+      return;
+   }
+   if (a->type != BITMAP_CONTAINER) {
+      tmp = a;
+      a = b;
+      b = tmp;
+   }
+   loadWords(dst, a);
+   if (b->type == BITMAP_CONTAINER) {
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         dst->words[i] |= b->words[i];
+      }
+   } else {
+      for (i = 0; i < b->length; i++) {
+         v = b->array[i];
+         dst->words[v >> 6] |= (uint64_t) 1 << (v & 63);
+      }
+   }
+   dst->cardinality = countWords(dst->words);
+   shrinkIfSparse(dst);
+}
+
+static void intersectContainers(Container *dst, Container *a,
+                                Container *b) {
+   Container *tmp;
+   int i, j, n;
+
+   if (a->type == BITMAP_CONTAINER && b->type == BITMAP_CONTAINER) {
+      loadWords(dst, a);
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         dst->words[i] &= b->words[i];
+      }
+      dst->cardinality = countWords(dst->words);
+      shrinkIfSparse(dst);
+      return;
+   }
+   if (a->type != ARRAY_CONTAINER) {
+      tmp = a;
+      a = b;
+      b = tmp;
+   }
+   ensureCapacity(dst, a->length);
+   n = 0;
+   if (b->type == BITMAP_CONTAINER) {
+      for (i = 0; i < a->length; i++) {
+         if (containerContains(b, a->array[i])) dst->array[n++] = a->array[i];
+      }
+   } else {
+      i = j = 0;
+      while (i < a->length && j < b->length) {
+         if (a->array[i] < b->array[j]) {
+            i++;
+         } else if (b->array[j] < a->array[i]) {
+            j++;
+         } else {
+            dst->array[n++] = a->array[i++];
+            j++;
+         }
+      }
+   }
+   dst->length = dst->cardinality = n;
+}
+
+static void subtractContainers(Container *dst, Container *a, Container *b) {
+   int i, n, v;
+
+   if (a->type == ARRAY_CONTAINER) {
+      ensureCapacity(dst, a->length);
+      n = 0;
+      for (i = 0; i < a->length; i++) {
+         if (!containerContains(b, a->array[i])) dst->array[n++] = a->array[i];
+      }
+      dst->length = dst->cardinality = n;
+      return;
+   }
+   loadWords(dst, a);
+   if (b->type == BITMAP_CONTAINER) {
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         dst->words[i] &= ~b->words[i];
+      }
+   } else {
+      for (i = 0; i < b->length; i++) {
+         v = b->array[i];
+         dst->words[v >> 6] &= ~((uint64_t) 1 << (v & 63));
+      }
+   }
+   dst->cardinality = countWords(dst->words);
+   shrinkIfSparse(dst);
+}
+
+/*
+ * Implementation notes: intersectionCardinality
+ * ---------------------------------------------
+ * Counts the values shared by two containers without building their
+ * intersection.
+ */
+
+static int intersectionCardinality(Container *a, Container *b) {
+   Container tmp1, tmp2, *v1, *v2, *tmp;
+   int i, j, n;
+
+   v1 = expandedView(a, &tmp1);
+   v2 = expandedView(b, &tmp2);
+   n = 0;
+   if (v1->type == BITMAP_CONTAINER && v2->type == BITMAP_CONTAINER) {
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         n += countBits(v1->words[i] & v2->words[i]);
+      }
+   } else {
+      if (v1->type != ARRAY_CONTAINER) {
+         tmp = v1;
+         v1 = v2;
+         v2 = tmp;
+      }
+      if (v2->type == BITMAP_CONTAINER) {
+         for (i = 0; i < v1->length; i++) {
+            if (containerContains(v2, v1->array[i])) n++;
+         }
+      } else {
+         i = j = 0;
+         while (i < v1->length && j < v2->length) {
+            if (v1->array[i] < v2->array[j]) {
+               i++;
+            } else if (v2->array[j] < v1->array[i]) {
+               j++;
+            } else {
+               n++;
+               i++;
+               j++;
+            }
+         }
+      }
+   }
+   if (a->type == RUN_CONTAINER) freeContainer(&tmp1);
+   if (b->type == RUN_CONTAINER) freeContainer(&tmp2);
+   return n;
+}
+
+/*
+ * Implementation notes: loadWords
+ * -------------------------------
+ * Turns dst into a bitmap container whose words hold the values in src,
+ * which must be in array or bitmap form.
+ */
+
+static void loadWords(Container *dst, Container *src) {
+   int i, v;
+
+   freeContainer(dst);
+   dst->type = BITMAP_CONTAINER;
+   dst->length = 0;
+   dst->capacity = 0;
+   dst->words = newArray(BITMAP_WORDS, uint64_t);
+   if (src->type == BITMAP_CONTAINER) {
+      memcpy(dst->words, src->words, BITMAP_WORDS * sizeof(uint64_t));
+   } else {
+      memset(dst->words, 0, BITMAP_WORDS * sizeof(uint64_t));
+      for (i = 0; i < src->length; i++) {
+         v = src->array[i];
+         dst->words[v >> 6] |= (uint64_t) 1 << (v & 63);
+      }
+   }
+}
+
+static int countWords(uint64_t words[]) {
+   int i, n;
+
+   n = 0;
+   for (i = 0; i < BITMAP_WORDS; i++) {
+      n += countBits(words[i]);
+   }
+   return n;
+}
+
+/*
+ * Implementation notes: initCursor, advanceCursor
+ * -----------------------------------------------
+ * The cursor starts in the container that holds lo, or the first one
+ * after it, at the position of the first value that is at least lo.
+ * Each call to advanceCursor then produces the next value, moving on to
+ * the next container whenever the current one is exhausted.  Once the
+ * cursor passes hi, its index is set beyond the last container.
+ */
+
+static void initCursor(CursorState *cs, Bitmap bm, unsigned lo, unsigned hi) {
+   Container *c;
+   bool found;
+   int low, i;
+
+   cs->bm = bm;
+   cs->hi = hi;
+   cs->pos = 0;
+   cs->offset = 0;
+   if (lo > hi) {
+      cs->index = bm->count;
+      return;
+   }
+   cs->index = findContainer(bm, lo >> 16, &found);
+   if (!found) return;
+   c = &bm->containers[cs->index];
+   low = lo & 0xFFFF;
+   switch (c->type) {
+     case ARRAY_CONTAINER:
+      cs->pos = lowerBound(c->array, c->length, low);
+      break;
+     case BITMAP_CONTAINER:
+      cs->pos = low;
+      break;
+     case RUN_CONTAINER:
+      i = findRun(c, low);
+      if (i >= 0 && low <= c->array[2 * i] + c->array[2 * i + 1]) {
+         cs->pos = i;
+         cs->offset = low - c->array[2 * i];
+      } else {
+         cs->pos = i + 1;
+      }
+      break;
+   }
+}
+
+static bool advanceCursor(CursorState *cs, unsigned *dst) {
+   Container *c;
+   uint64_t word;
+   int low, w;
+   unsigned value;
+
+   while (cs->index < cs->bm->count) {
+      c = &cs->bm->containers[cs->index];
+      low = -1;
+      switch (c->type) {
+        case ARRAY_CONTAINER:
+         if (cs->pos < c->length) low = c->array[cs->pos++];
+         break;
+        case RUN_CONTAINER:
+         if (cs->pos < c->length) {
+            low = c->array[2 * cs->pos] + cs->offset;
+            if (cs->offset == c->array[2 * cs->pos + 1]) {
+               cs->pos++;
+               cs->offset = 0;
+            } else {
+               cs->offset++;
+            }
+         }
+         break;
+        case BITMAP_CONTAINER:
+         if (cs->pos < CHUNK_SIZE) {
+            w = cs->pos >> 6;
+            word = c->words[w] & (~(uint64_t) 0 << (cs->pos & 63));
+            while (word == 0 && ++w < BITMAP_WORDS) {
+               word = c->words[w];
+            }
+            if (word != 0) {
+               low = 64 * w + lowestBit(word);
+               cs->pos = low + 1;
+            } else {
+               cs->pos = CHUNK_SIZE;
+            }
+         }
+         break;
+      }
+      if (low >= 0) {
+         value = ((unsigned) c->key << 16) | low;
+         if (value > cs->hi) break;
+         *dst = value;
+         return true;
+      }
+      cs->index++;
+      cs->pos = 0;
+      cs->offset = 0;
+   }
+   cs->index = cs->bm->count;
+   return false;
+}
+
+/*
+ * Implementation notes: stepBitmapIterator
+ * ----------------------------------------
+ * The cursor is kept in the data field of the iterator and is freed as
+ * soon as the iteration is complete.
+ */
+
+static bool stepBitmapIterator(Iterator iterator, void *dst) {
+   CursorState *cs;
+
+   cs = (CursorState *) getIteratorData(iterator);
+   if (cs == NULL) return false;
+   if (advanceCursor(cs, (unsigned *) dst)) return true;
+   freeBlock(cs);
+   setIteratorData(iterator, NULL);
+   return false;
+}
+
+static Iterator newForeachIterator(void *collection) {
+   return newBitmapRangeIterator((Bitmap) collection, 0, UINT_MAX);
+}
+
+/**********************************************************************/
+/* Unit test for the bitmap module                                    */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+/* Private function prototypes */
+
+static void testSmallBitmap(void);
+static void testContainerForms(void);
+static void testBitmapAlgebra(void);
+static Bitmap createMultiples(int k, int limit);
+static int sumRange(Bitmap bm, unsigned lo, unsigned hi);
+
+/* Unit test */
+
+void testBitmapModule(void) {
+   testSmallBitmap();
+   testContainerForms();
+   testBitmapAlgebra();
+}
+
+static void testSmallBitmap(void) {
+   Bitmap bm;
+   unsigned value, previous;
+   int n;
+
+   trace(bm = newBitmap());
+   test(isEmptyBitmap(bm), true);
+   trace(addBitmap(bm, 70000));
+   trace(addBitmap(bm, 3));
+   trace(addBitmap(bm, UINT_MAX));
+   trace(addBitmap(bm, 65535));
+   trace(addBitmap(bm, 65536));
+   trace(addBitmap(bm, 3));
+   test(sizeBitmap(bm), 5);
+   test(containsBitmap(bm, 3), true);
+   test(containsBitmap(bm, 4), false);
+   test(containsBitmap(bm, 65536), true);
+   test(containsBitmap(bm, UINT_MAX), true);
+   test(containsBitmap(bm, UINT_MAX - 1), false);
+   test(rankBitmap(bm, 0), 0);
+   test(rankBitmap(bm, 65536), 2);
+   test(rankBitmap(bm, 65537), 3);
+   test(rankBitmap(bm, UINT_MAX), 4);
+   n = 0;
+   previous = 0;
+   foreach (value in bm) {
+      if (n > 0 && value <= previous) reportError("Out of order at %u", value);
+      previous = value;
+      n++;
+   }
+   test(n, 5);
+   test(previous == UINT_MAX, true);
+   trace(removeBitmap(bm, 65535));
+   trace(removeBitmap(bm, 65535));
+   trace(removeBitmap(bm, 12345678));
+   test(sizeBitmap(bm), 4);
+   test(containsBitmap(bm, 65535), false);
+   test(sumRange(bm, 4, 70000), 135536);
+   test(sumRange(bm, 70000, 3), 0);
+   trace(freeBitmap(bm));
+}
+
+static void testContainerForms(void) {
+   Bitmap bm, copy;
+   int i;
+
+   trace(bm = createMultiples(2, 10000));
+   test(sizeBitmap(bm), 5000);
+   test(containsBitmap(bm, 5000), true);
+   test(containsBitmap(bm, 5001), false);
+   test(rankBitmap(bm, 5000), 2500);
+   test(rankBitmap(bm, 5001), 2501);
+   test(sumRange(bm, 100, 110), 630);
+   for (i = 0; i < 2000; i += 2) {
+      removeBitmap(bm, i);
+   }
+   test(sizeBitmap(bm), 4000);
+   test(containsBitmap(bm, 1998), false);
+   test(containsBitmap(bm, 2000), true);
+   test(rankBitmap(bm, 3000), 500);
+   trace(copy = cloneBitmap(bm));
+   for (i = 100000; i < 300000; i++) {
+      addBitmap(bm, i);
+   }
+   test(sizeBitmap(bm), 204000);
+   trace(optimizeBitmap(bm));
+   test(sizeBitmap(bm), 204000);
+   test(containsBitmap(bm, 99999), false);
+   test(containsBitmap(bm, 100000), true);
+   test(containsBitmap(bm, 299999), true);
+   test(containsBitmap(bm, 300000), false);
+   test(rankBitmap(bm, 200000), 104000);
+   test(sumRange(bm, 131070, 131073), 524286);
+   trace(removeBitmap(bm, 131072));
+   trace(addBitmap(bm, 300000));
+   test(sizeBitmap(bm), 204000);
+   test(containsBitmap(bm, 131072), false);
+   test(sumRange(bm, 131071, 131073), 262144);
+   test(isSubsetBitmap(copy, bm), true);
+   test(isSubsetBitmap(bm, copy), false);
+   trace(freeBitmap(bm));
+   trace(freeBitmap(copy));
+}
+
+/*
+ * Implementation notes: testBitmapAlgebra
+ * ---------------------------------------
+ * The multiples of 2 and 3 below 300000 produce bitmap containers, the
+ * multiples of 100 produce array containers, and the optimized copies
+ * add run containers to the mix.
+ */
+
+static void testBitmapAlgebra(void) {
+   Bitmap twos, threes, sixes, hundreds, set, range;
+
+   trace(twos = createMultiples(2, 300000));
+   trace(threes = createMultiples(3, 300000));
+   trace(sixes = createMultiples(6, 300000));
+   trace(hundreds = createMultiples(100, 300000));
+   trace(set = unionBitmap(twos, threes));
+   test(sizeBitmap(set), 200000);
+   test(containsBitmap(set, 299997), true);
+   test(containsBitmap(set, 299995), false);
+   test(equalsBitmap(intersectionBitmap(twos, threes), sixes), true);
+   test(equalsBitmap(intersectionBitmap(hundreds, threes),
+                     createMultiples(300, 300000)), true);
+   test(equalsBitmap(differenceBitmap(twos, threes),
+                     differenceBitmap(twos, sixes)), true);
+   test(sizeBitmap(differenceBitmap(hundreds, twos)), 0);
+   test(sizeBitmap(differenceBitmap(threes, hundreds)), 99000);
+   test(isSubsetBitmap(sixes, twos), true);
+   test(isSubsetBitmap(hundreds, set), true);
+   test(isSubsetBitmap(threes, twos), false);
+   test(equalsBitmap(twos, threes), false);
+   trace(range = newBitmap());
+   trace(addBitmap(range, 7));
+   trace(addBitmap(range, 250000));
+   trace(addBitmap(range, 1000000));
+   trace(optimizeBitmap(range));
+   trace(optimizeBitmap(set));
+   test(sizeBitmap(unionBitmap(set, range)), 200002);
+   test(sizeBitmap(intersectionBitmap(range, twos)), 1);
+   test(equalsBitmap(differenceBitmap(set, threes),
+                     differenceBitmap(twos, sixes)), true);
+   trace(freeBitmap(range));
+   trace(range = newBitmap());
+   trace(addBitmap(range, 5));
+   trace(addBitmap(range, 6));
+   trace(addBitmap(range, 7));
+   trace(addBitmap(range, 8));
+   trace(optimizeBitmap(range));
+   test(equalsBitmap(intersectionBitmap(range, threes),
+                     intersectionBitmap(threes, range)), true);
+   test(sizeBitmap(intersectionBitmap(range, threes)), 1);
+   test(sumRange(unionBitmap(range, sixes), 0, 12), 38);
+}
+
+static Bitmap createMultiples(int k, int limit) {
+   Bitmap bm;
+   int i;
+
+   bm = newBitmap();
+   for (i = 0; i < limit; i += k) {
+      addBitmap(bm, i);
+   }
+   return bm;
+}
+
+static int sumRange(Bitmap bm, unsigned lo, unsigned hi) {
+   unsigned value;
+   int sum;
+
+   sum = 0;
+   foreach (value in newBitmapRangeIterator(bm, lo, hi)) {
+      sum += value;
+   }
+   return sum;
+}
+
+#endif
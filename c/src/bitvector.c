@@ -0,0 +1,441 @@
+/*
+ * File: bitvector.c
+ * -----------------
+ * This file implements the bitvector.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bitvector.h"
+#include "cslib.h"
+#include "exception.h"
+#include "foreach.h"
+#include "iterator.h"
+#include "itertype.h"
+#include "strlib.h"
+#include "unittest.h"
+#include "private/bitops.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define BITVECTOR_SSE2
+#  include <emmintrin.h>
+#endif
+
+/*
+ * Type: BitVectorCDT
+ * ------------------
+ * This type defines the concrete structure of a bit vector.  Bit k is
+ * bit k % 64 of words[k / 64].  The bits in the last word beyond nBits
+ * are always off, so that counting and comparing can work a whole word
+ * at a time.
+ */
+
+struct BitVectorCDT {
+   IteratorHeader header;
+   uint64_t *words;
+   int nBits;
+   int nWords;
+};
+
+/*
+ * Type: BitOperation
+ * ------------------
+ * This type identifies the operation performed by combineWords.
+ */
+
+typedef enum { AND_OP, OR_OP, XOR_OP, AND_NOT_OP } BitOperation;
+
+/* Private function prototypes */
+
+static void checkIndex(BitVector bv, int k, string fn);
+static void combineWords(BitVector dst, BitVector src, BitOperation op,
+                                        string fn);
+static Iterator newForeachIterator(void *collection);
+static bool stepBitVectorIterator(Iterator it, void *dst);
+
+/* Exported entries */
+
+BitVector newBitVector(int nBits) {
+   BitVector bv;
+
+   if (nBits < 0) error("newBitVector: Negative length %d", nBits);
+   bv = newBlock(BitVector);
+   enableIteration(bv, newForeachIterator);
+   bv->nBits = nBits;
+   bv->nWords = (nBits + 63) / 64;
+   bv->words = newArray(bv->nWords + 1, uint64_t);
+   clearBitVector(bv);
+   return bv;
+}
+
+void freeBitVector(BitVector bv) {
+   freeBlock(bv->words);
+   freeBlock(bv);
+}
+
+int lengthBitVector(BitVector bv) {
+   return bv->nBits;
+}
+
+int sizeBitVector(BitVector bv) {
+   int i, n;
+
+   n = 0;
+   for (i = 0; i < bv->nWords; i++) {
+      n += countBits(bv->words[i]);
+   }
+   return n;
+}
+
+bool isEmptyBitVector(BitVector bv) {
+   int i;
+
+   for (i = 0; i < bv->nWords; i++) {
+      if (bv->words[i] != 0) return false;
+   }
+   return true;
+}
+
+void clearBitVector(BitVector bv) {
+   memset(bv->words, 0, bv->nWords * sizeof(uint64_t));
+}
+
+BitVector cloneBitVector(BitVector bv) {
+   BitVector newbv;
+
+   newbv = newBitVector(bv->nBits);
+   memcpy(newbv->words, bv->words, bv->nWords * sizeof(uint64_t));
+   return newbv;
+}
+
+bool containsBitVector(BitVector bv, int k) {
+   checkIndex(bv, k, "contains");
+   return ((bv->words[k >> 6] >> (k & 0x3F)) & 1) != 0;
+}
+
+void addBitVector(BitVector bv, int k) {
+   checkIndex(bv, k, "add");
+   bv->words[k >> 6] |= (uint64_t) 1 << (k & 0x3F);
+}
+
+void removeBitVector(BitVector bv, int k) {
+   checkIndex(bv, k, "remove");
+   bv->words[k >> 6] &= ~((uint64_t) 1 << (k & 0x3F));
+}
+
+int nextSetBit(BitVector bv, int start) {
+   int index;
+   uint64_t word;
+
+   if (start < 0) start = 0;
+   if (start >= bv->nBits) return -1;
+   index = start >> 6;
+   word = bv->words[index] & (~(uint64_t) 0 << (start & 0x3F));
+   while (word == 0) {
+      if (++index == bv->nWords) return -1;
+      word = bv->words[index];
+   }
+   return (index << 6) + lowestBit(word);
+}
+
+void andBitVector(BitVector dst, BitVector src) {
+   combineWords(dst, src, AND_OP, "andBitVector");
+}
+
+void orBitVector(BitVector dst, BitVector src) {
+   combineWords(dst, src, OR_OP, "orBitVector");
+}
+
+void xorBitVector(BitVector dst, BitVector src) {
+   combineWords(dst, src, XOR_OP, "xorBitVector");
+}
+
+void andNotBitVector(BitVector dst, BitVector src) {
+   combineWords(dst, src, AND_NOT_OP, "andNotBitVector");
+}
+
+bool equalsBitVector(BitVector b1, BitVector b2) {
+   if (b1->nBits != b2->nBits) return false;
+   return memcmp(b1->words, b2->words, b1->nWords * sizeof(uint64_t)) == 0;
+}
+
+bool isSubsetBitVector(BitVector b1, BitVector b2) {
+   int i;
+
+   if (b1->nBits != b2->nBits) {
+      error("isSubset: Bit vectors have different lengths");
+   }
+   for (i = 0; i < b1->nWords; i++) {
+      if ((b1->words[i] & ~b2->words[i]) != 0) return false;
+   }
+   return true;
+}
+
+BitVector unionBitVector(BitVector b1, BitVector b2) {
+   BitVector bv;
+
+   bv = cloneBitVector(b1);
+   combineWords(bv, b2, OR_OP, "union");
+   return bv;
+}
+
+BitVector intersectionBitVector(BitVector b1, BitVector b2) {
+   BitVector bv;
+
+   bv = cloneBitVector(b1);
+   combineWords(bv, b2, AND_OP, "intersection");
+   return bv;
+}
+
+BitVector setDifferenceBitVector(BitVector b1, BitVector b2) {
+   BitVector bv;
+
+   bv = cloneBitVector(b1);
+   combineWords(bv, b2, AND_NOT_OP, "setDifference");
+   return bv;
+}
+
+/* Private functions */
+
+static void checkIndex(BitVector bv, int k, string fn) {
+   if (k < 0 || k >= bv->nBits) error("%s: Index value out of range", fn);
+}
+
+/*
+ * Implementation notes: combineWords
+ * ----------------------------------
+ * With SSE2, the loop combines two words per instruction and leaves at
+ * most one word for the scalar loop.  None of the operations can turn on
+ * a bit past the end of the vector, since those bits are off in both
+ * arguments.
+ */
+
+static void combineWords(BitVector dst, BitVector src, BitOperation op,
+                                        string fn) {
+   int i;
+#ifdef BITVECTOR_SSE2
+   __m128i v1, v2;
+#endif
+
+   if (dst->nBits != src->nBits) {
+      error("%s: Bit vectors have different lengths", fn);
+   }
+   i = 0;
+#ifdef BITVECTOR_SSE2
+   for (; i + 2 <= dst->nWords; i += 2) {
+      v1 = _mm_loadu_si128((__m128i *) &dst->words[i]);
+      v2 = _mm_loadu_si128((__m128i *) &src->words[i]);
+      switch (op) {
+       case AND_OP: v1 = _mm_and_si128(v1, v2); break;
+       case OR_OP: v1 = _mm_or_si128(v1, v2); break;
+       case XOR_OP: v1 = _mm_xor_si128(v1, v2); break;
+       case AND_NOT_OP: v1 = _mm_andnot_si128(v2, v1); break;
+      }
+      _mm_storeu_si128((__m128i *) &dst->words[i], v1);
+   }
+#endif
+   for (; i < dst->nWords; i++) {
+      switch (op) {
+       case AND_OP: dst->words[i] &= src->words[i]; break;
+       case OR_OP: dst->words[i] |= src->words[i]; break;
+       case XOR_OP: dst->words[i] ^= src->words[i]; break;
+       case AND_NOT_OP: dst->words[i] &= ~src->words[i]; break;
+      }
+   }
+}
+
+/*
+ * Implementation notes: Iteration
+ * -------------------------------
+ * The iterator data holds the index at which to resume the search for
+ * the next bit that is on.
+ */
+
+static Iterator newForeachIterator(void *collection) {
+   Iterator it;
+   int *np;
+
+   it = newStepIterator(sizeof(int), stepBitVectorIterator);
+   setCollection(it, collection);
+   np = newBlock(int *);
+   *np = 0;
+   setIteratorData(it, np);
+   return it;
+}
+
+static bool stepBitVectorIterator(Iterator it, void *dst) {
+   int *np;
+   int k;
+
+   np = (int *) getIteratorData(it);
+   if (np == NULL) return false;
+   k = nextSetBit((BitVector) getCollection(it), *np);
+   if (k < 0) {
+      freeBlock(np);
+      setIteratorData(it, NULL);
+      return false;
+   }
+   *((int *) dst) = k;
+   *np = k + 1;
+   return true;
+}
+
+/**********************************************************************/
+/* Unit test for the bitvector module                                 */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+/* Private function prototypes */
+
+static void testSmallBitVector(void);
+static void testBulkOperations(void);
+static void testIndexedAccess(void);
+static string listBits(BitVector bv);
+
+/* Unit test */
+
+void testBitVectorModule(void) {
+   testSmallBitVector();
+   testBulkOperations();
+   testIndexedAccess();
+}
+
+static void testSmallBitVector(void) {
+   BitVector bv, copy;
+
+   trace(bv = newBitVector(130));
+   test(lengthBitVector(bv), 130);
+   test(isEmpty(bv), true);
+   trace(add(bv, 0));
+   trace(add(bv, 63));
+   trace(add(bv, 64));
+   trace(add(bv, 129));
+   test(size(bv), 4);
+   test(contains(bv, 63), true);
+   test(contains(bv, 62), false);
+   test(listBits(bv), "0 63 64 129");
+   test(nextSetBit(bv, 1), 63);
+   test(nextSetBit(bv, 65), 129);
+   test(nextSetBit(bv, 130), -1);
+   trace(copy = clone(bv));
+   trace(remove(bv, 63));
+   test(listBits(bv), "0 64 129");
+   test(equals(bv, copy), false);
+   test(isSubset(bv, copy), true);
+   test(isSubset(copy, bv), false);
+   trace(clear(bv));
+   test(isEmpty(bv), true);
+   test(nextSetBit(bv, 0), -1);
+   test(lengthBitVector(bv), 130);
+   trace(freeBitVector(bv));
+   trace(freeBitVector(copy));
+   trace(bv = newBitVector(0));
+   test(size(bv), 0);
+   test(listBits(bv), "");
+   trace(freeBitVector(bv));
+}
+
+/*
+ * Implementation notes: testBulkOperations
+ * ----------------------------------------
+ * Uses the multiples of 2 and 3 below 1000, whose combinations have
+ * easily computed sizes.
+ */
+
+static void testBulkOperations(void) {
+   BitVector twos, threes, bv;
+   int k;
+
+   twos = newBitVector(1000);
+   threes = newBitVector(1000);
+   for (k = 0; k < 1000; k++) {
+      if (k % 2 == 0) addBitVector(twos, k);
+      if (k % 3 == 0) addBitVector(threes, k);
+   }
+   test(sizeBitVector(twos), 500);
+   test(sizeBitVector(threes), 334);
+   trace(bv = union(twos, threes));
+   test(size(bv), 667);
+   trace(bv = intersection(twos, threes));
+   test(size(bv), 167);
+   test(contains(bv, 996), true);
+   trace(bv = setDifference(twos, threes));
+   test(size(bv), 333);
+   trace(bv = cloneBitVector(twos));
+   trace(xorBitVector(bv, threes));
+   test(size(bv), 500);
+   test(contains(bv, 3), true);
+   test(contains(bv, 6), false);
+   trace(andNotBitVector(bv, twos));
+   test(size(bv), 167);
+   trace(orBitVector(bv, twos));
+   trace(andBitVector(bv, threes));
+   test(size(bv), 334);
+   test(equals(bv, threes), true);
+}
+
+/*
+ * Implementation notes: testIndexedAccess
+ * ---------------------------------------
+ * Checks that the generic get and set functions, which apply to the
+ * Vector type, report errors for a BitVector instead of treating it as
+ * a Vector.
+ */
+
+static void testIndexedAccess(void) {
+   BitVector bv;
+   string msg;
+
+   trace(bv = newBitVector(10));
+   trace(add(bv, 3));
+   msg = "";
+   try {
+      get(bv, 3);
+   } catch (ErrorException) {
+      msg = (string) getExceptionValue();
+   } endtry
+   test(msg, "get: Use contains to test a bit in a BitVector");
+   msg = "";
+   try {
+      set(bv, 3, NULL);
+   } catch (ErrorException) {
+      msg = (string) getExceptionValue();
+   } endtry
+   test(msg, "set: Use add or remove to change a bit in a BitVector");
+   test(listBits(bv), "3");
+   trace(freeBitVector(bv));
+}
+
+static string listBits(BitVector bv) {
+   string result;
+   int k;
+
+   result = "";
+   foreach (k in bv) {
+      if (*result != '\0') result = concat(result, " ");
+      result = concat(result, integerToString(k));
+   }
+   return result;
+}
+
+#endif
@@ -69,12 +69,57 @@ struct BSTNodeCDT {
    struct BSTNodeCDT *left;    /* Left child                            */
    struct BSTNodeCDT *right;   /* Right child                           */
    int bf;                     /* Balance factor for node (-1, 0, +1)   */
-   BST bst;                    /* Back pointer to the bst               */
+   int size;                   /* Number of nodes in this subtree       */
+   int refCount;               /* Number of references to this node     */
+   ToStringFn toStringFn;      /* Function to convert key to a string   */
 };
 
+/*
+ * Constant: MAX_HEIGHT
+ * --------------------
+ * The maximum height of an AVL tree, which is far more than any tree
+ * that fits in memory can reach.  The lazy iterators use this constant
+ * as the capacity of their stacks.
+ */
+
+#define MAX_HEIGHT 64
+
+/*
+ * Type: WalkerState
+ * -----------------
+ * This type holds the state of a traversal in progress, which consists
+ * of the traversal order, an explicit stack of nodes, and the optional
+ * upper bound for a range.  The walker produces one node at a time, so
+ * neither the iterators nor mapBST need recursion or a list of nodes.
+ */
+
+typedef struct {
+   BST bst;
+   TraversalOrder order;
+   BSTNode stack[MAX_HEIGHT];
+   int depth;
+   bool hasUpperBound;
+   GenericType hi;
+} WalkerState;
+
 /* Private function prototypes */
 
 static BSTNode copyTree(BST newbst, BSTNode t);
+static BSTNode buildTree(BST bst, GenericType keys[], void *values[],
+                         int n);
+static int balancedHeight(int n);
+static void updateSize(BSTNode t);
+static int subtreeSize(BSTNode t);
+static void initWalker(WalkerState *ws, BST bst, TraversalOrder order,
+                       GenericType *lo, GenericType *hi);
+static BSTNode advanceWalker(WalkerState *ws);
+static void pushNode(WalkerState *ws, BSTNode t);
+static void pushLeftPath(WalkerState *ws, BSTNode t, GenericType *lo);
+static void pushPostorderPath(WalkerState *ws, BSTNode t);
+static Iterator newWalkerIterator(BST bst, TraversalOrder order,
+                                  GenericType *lo, GenericType *hi);
+static bool stepWalkerIterator(Iterator iterator, void *dst);
+static BSTNode ownNode(BSTNode *tp);
 static BSTNode findTreeNode(BST bst, BSTNode t, void *kp);
 static int insertTreeNode(BST bst, BSTNode *tp, void *kp, BSTNode *rp);
 static int removeTreeNode(BST bst, BSTNode *tp, void *kp);
@@ -86,8 +131,6 @@ static void fixLeftImbalance(BST bst, BSTNode *tp);
 static void fixRightImbalance(BST bst, BSTNode *tp);
 static void rotateLeft(BST bst, BSTNode *tp);
 static void rotateRight(BST bst, BSTNode *tp);
-static void mapTree(BSTNode t, proc fn, TraversalOrder order, void *data);
-static void addNodeToIterator(BSTNode node, void *data);
 static Iterator newForeachIterator(void *collection);
 
 /* Exported entries */
@@ -124,6 +167,7 @@ bool isEmptyBST(BST bst) {
 
 void clearBST(BST bst) {
    freeTree(bst->root);
+   bst->root = NULL;
    bst->count = 0;
 }
 
@@ -144,6 +188,33 @@ BST cloneBST(BST bst) {
    return newbst;
 }
 
+/*
+ * Implementation notes: shareBST
+ * ------------------------------
+ * The new tree points to the same root, whose reference count records
+ * that it now belongs to two trees.  The functions that change the tree
+ * call ownNode on each node before they modify it, which replaces a
+ * shared node with a private copy.
+ */
+
+BST shareBST(BST bst) {
+   BST newbst;
+
+   newbst = newBlock(BST);
+   enableIteration(newbst, newForeachIterator);
+   newbst->baseType = bst->baseType;
+   newbst->baseTypeSize = bst->baseTypeSize;
+   newbst->fetchFn = bst->fetchFn;
+   newbst->storeFn = bst->storeFn;
+   newbst->cmpFn = bst->cmpFn;
+   newbst->toStringFn = bst->toStringFn;
+   newbst->count = bst->count;
+   newbst->root = bst->root;
+   if (newbst->root != NULL) newbst->root->refCount++;
+   newbst->debugLog = NULL;
+   return newbst;
+}
+
 BSTNode findBSTNode(BST bst, ...) {
    va_list args;
    GenericType any;
@@ -189,8 +260,146 @@ void removeBSTNodeFromArg(BST bst, GenericType any) {
    removeTreeNode(bst, &bst->root, &any);
 }
 
+/*
+ * Implementation notes: buildBSTFromSorted
+ * ----------------------------------------
+ * The keys are checked in a single pass.  If they contain duplicates,
+ * the tree is built from a copy of the arrays from which the duplicates
+ * have been removed, which leaves the arguments unchanged.
+ */
+
+void buildBSTFromSorted(BST bst, GenericType keys[], void *values[], int n) {
+   GenericType *keyCopy;
+   void **valueCopy;
+   bool hasDuplicates;
+   int i, sign;
+
+   hasDuplicates = false;
+   for (i = 1; i < n; i++) {
+      sign = bst->cmpFn(&keys[i - 1], &keys[i]);
+      if (sign > 0) error("buildBSTFromSorted: Keys are not sorted");
+      if (sign == 0) hasDuplicates = true;
+   }
+   clearBST(bst);
+   if (hasDuplicates) {
+      keyCopy = newArray(n, GenericType);
+      memcpy(keyCopy, keys, n * sizeof(GenericType));
+      valueCopy = NULL;
+      if (values != NULL) {
+         valueCopy = newArray(n, void *);
+         memcpy(valueCopy, values, n * sizeof(void *));
+      }
+      n = uniqueGenericArray(keyCopy, valueCopy, n, bst->cmpFn);
+      bst->root = buildTree(bst, keyCopy, valueCopy, n);
+      freeBlock(keyCopy);
+      if (valueCopy != NULL) freeBlock(valueCopy);
+   } else {
+      bst->root = buildTree(bst, keys, values, n);
+   }
+   bst->count = n;
+}
+
+/*
+ * Implementation notes: rankBSTFromArg
+ * ------------------------------------
+ * Walks down from the root, adding the size of the left subtree plus
+ * one for the node itself whenever the search moves right.
+ */
+
+int rankBSTFromArg(BST bst, GenericType any) {
+   BSTNode t;
+   int rank, sign;
+
+   rank = 0;
+   t = bst->root;
+   while (t != NULL) {
+      sign = bst->cmpFn(&any, &t->key);
+      if (sign == 0) return rank + subtreeSize(t->left);
+      if (sign < 0) {
+         t = t->left;
+      } else {
+         rank += subtreeSize(t->left) + 1;
+         t = t->right;
+      }
+   }
+   return rank;
+}
+
+BSTNode selectBSTNode(BST bst, int k) {
+   BSTNode t;
+   int leftSize;
+
+   if (k < 0 || k >= bst->count) return NULL;
+   t = bst->root;
+   while (true) {
+      leftSize = subtreeSize(t->left);
+      if (k == leftSize) return t;
+      if (k < leftSize) {
+         t = t->left;
+      } else {
+         k -= leftSize + 1;
+         t = t->right;
+      }
+   }
+}
+
+BSTNode floorBSTNodeFromArg(BST bst, GenericType any) {
+   BSTNode t, result;
+   int sign;
+
+   result = NULL;
+   t = bst->root;
+   while (t != NULL) {
+      sign = bst->cmpFn(&any, &t->key);
+      if (sign == 0) return t;
+      if (sign < 0) {
+         t = t->left;
+      } else {
+         result = t;
+         t = t->right;
+      }
+   }
+   return result;
+}
+
+BSTNode ceilingBSTNodeFromArg(BST bst, GenericType any) {
+   BSTNode t, result;
+   int sign;
+
+   result = NULL;
+   t = bst->root;
+   while (t != NULL) {
+      sign = bst->cmpFn(&any, &t->key);
+      if (sign == 0) return t;
+      if (sign > 0) {
+         t = t->right;
+      } else {
+         result = t;
+         t = t->left;
+      }
+   }
+   return result;
+}
+
+Iterator newRangeNodeIterator(BST bst, GenericType *lo, GenericType *hi) {
+   return newWalkerIterator(bst, INORDER, lo, hi);
+}
+
+/*
+ * Implementation notes: mapBST
+ * ----------------------------
+ * The walker lives on the stack of this function, so mapping over the
+ * tree allocates no memory at all.
+ */
+
 void mapBST(BST bst, proc fn, TraversalOrder order, void *data) {
-   mapTree(bst->root, fn, order, data);
+   WalkerState ws;
+   BSTNode node;
+
+   initWalker(&ws, bst, order, NULL, NULL);
+   while ((node = advanceWalker(&ws)) != NULL) {
+      fn(node, data);
+   }
 }
 
 /*
@@ -204,11 +413,7 @@ void mapBST(BST bst, proc fn, TraversalOrder order, void *data) {
  */
 
 Iterator newNodeIterator(BST bst, TraversalOrder order) {
-   Iterator iterator;
-
-   iterator = newListIterator(sizeof(void *), NULL);
-   mapBST(bst, addNodeToIterator, order, iterator);
-   return iterator;
+   return newWalkerIterator(bst, order, NULL, NULL);
 }
 
 BSTNode getRootBST(BST bst) {
@@ -228,7 +433,7 @@ GenericType getKey(BSTNode node) {
 }
 
 string getKeyString(BSTNode node) {
-   return node->bst->toStringFn(node->key);
+   return node->toStringFn(node->key);
 }
 
 int getBF(BSTNode node) {
@@ -282,10 +487,98 @@ static BSTNode copyTree(BST newbst, BSTNode t) {
    node->left = copyTree(newbst, t->left);
    node->right = copyTree(newbst, t->right);
    node->bf = t->bf;
-   node->bst = newbst;
+   node->size = t->size;
+   node->refCount = 1;
+   node->toStringFn = newbst->toStringFn;
+   return node;
+}
+
+/*
+ * Implementation notes: buildTree, balancedHeight
+ * -----------------------------------------------
+ * The buildTree function makes the middle key the root and builds the
+ * two halves recursively, which gives every node a left subtree that is
+ * the same size as its right subtree or one node larger.  A tree built
+ * this way from n keys has a height equal to the number of bits in n,
+ * which lets buildTree compute each balance factor directly from the
+ * subtree sizes without walking the subtrees.
+ */
+
+static BSTNode buildTree(BST bst, GenericType keys[], void *values[],
+                         int n) {
+   BSTNode node;
+   int mid;
+
+   if (n == 0) return NULL;
+   mid = n / 2;
+   node = newBlock(BSTNode);
+   node->key = keys[mid];
+   node->value = (values == NULL) ? NULL : values[mid];
+   node->left = buildTree(bst, keys, values, mid);
+   node->right = buildTree(bst, keys + mid + 1,
+                           (values == NULL) ? NULL : values + mid + 1,
+                           n - mid - 1);
+   node->bf = balancedHeight(n - mid - 1) - balancedHeight(mid);
+   node->size = n;
+   node->refCount = 1;
+   node->toStringFn = bst->toStringFn;
    return node;
 }
 
+static int balancedHeight(int n) {
+   int height;
+
+   height = 0;
+   while (n > 0) {
+      height++;
+      n >>= 1;
+   }
+   return height;
+}
+
+/*
+ * Implementation notes: updateSize, subtreeSize
+ * ---------------------------------------------
+ * Every node records the number of nodes in its subtree, which makes it
+ * possible to find the rank of a key or the key with a given rank in
+ * logarithmic time.  Any operation that changes the children of a node
+ * calls updateSize to recompute that count from the children.
+ */
+
+static void updateSize(BSTNode t) {
+   t->size = subtreeSize(t->left) + subtreeSize(t->right) + 1;
+}
+
+static int subtreeSize(BSTNode t) {
+   return (t == NULL) ? 0 : t->size;
+}
+
+/*
+ * Implementation notes: ownNode
+ * -----------------------------
+ * Ensures that the node whose address is passed as the tp parameter
+ * belongs to this tree alone, so that it can be changed safely, and
+ * returns that node.  A node shared with another tree is replaced by a
+ * copy, which adds a reference to each of its children.  Because every
+ * function that changes the tree calls ownNode on the way down, updating
+ * a shared tree copies only the nodes on a single path.
+ */
+
+static BSTNode ownNode(BSTNode *tp) {
+   BSTNode t, copy;
+
+   t = *tp;
+   if (t == NULL || t->refCount == 1) return t;
+   copy = newBlock(BSTNode);
+   *copy = *t;
+   copy->refCount = 1;
+   if (copy->left != NULL) copy->left->refCount++;
+   if (copy->right != NULL) copy->right->refCount++;
+   t->refCount--;
+   *tp = copy;
+   return copy;
+}
+
 /*
  * Implementation notes: findTreeNode
  * ----------------------------------
@@ -319,16 +612,18 @@ static BSTNode findTreeNode(BST bst, BSTNode t, void *kp) {
 
 static int insertTreeNode(BST bst, BSTNode *tp, void *kp, BSTNode *rp) {
    BSTNode t;
-   int sign;
+   int sign, hDelta;
 
-   t = *tp;
+   t = ownNode(tp);
    if (t == NULL) {
       t = newBlock(BSTNode);
       memcpy(&t->key, kp, bst->baseTypeSize);
-      t->bst = bst;
+      t->toStringFn = bst->toStringFn;
+      t->refCount = 1;
       t->bf = 0;
       t->left = t->right = NULL;
       t->value = NULL;
+      t->size = 1;
       *tp = t;
       *rp = t;
       bst->count++;
@@ -340,7 +635,9 @@ static int insertTreeNode(BST bst, BSTNode *tp, void *kp, BSTNode *rp) {
       return 0;
    }
    if (sign < 0) {
-      if (insertTreeNode(bst, &t->left, kp, rp) > 0) {
+      hDelta = insertTreeNode(bst, &t->left, kp, rp);
+      updateSize(t);
+      if (hDelta > 0) {
          switch (t->bf) {
            case +1: t->bf =  0; return 0;
            case  0: t->bf = -1; return +1;
@@ -348,7 +645,9 @@ static int insertTreeNode(BST bst, BSTNode *tp, void *kp, BSTNode *rp) {
          }
       }
    } else {
-      if (insertTreeNode(bst, &t->right, kp, rp) > 0) {
+      hDelta = insertTreeNode(bst, &t->right, kp, rp);
+      updateSize(t);
+      if (hDelta > 0) {
          switch (t->bf) {
            case -1: t->bf =  0; return 0;
            case  0: t->bf = +1; return +1;
@@ -367,14 +666,16 @@ static int insertTreeNode(BST bst, BSTNode *tp, void *kp, BSTNode *rp) {
  * The return value is the change in height of the tree, which
  * is either 0 if the height is unchanged or -1 if the height
  * decreases by one.  This value is then used to correct the
- * balance factors in ancestor nodes.
+ * balance factors in ancestor nodes.  Because adjustBF may rotate a new
+ * node into the position, the height change depends on the balance
+ * factor of the node at that position afterward, not on that of t.
  */
 
 static int removeTreeNode(BST bst, BSTNode *tp, void *kp) {
    BSTNode t;
    int sign, hDelta, bfDelta;
 
-   t = *tp;
+   t = ownNode(tp);
    if (t == NULL) return 0;
    bfDelta = 0;
    sign = bst->cmpFn(kp, &t->key);
@@ -386,8 +687,9 @@ static int removeTreeNode(BST bst, BSTNode *tp, void *kp) {
       hDelta = removeTreeNode(bst, &t->right, kp);
       if (hDelta < 0) bfDelta = -1;
    }
+   updateSize(t);
    adjustBF(bst, tp, bfDelta);
-   return ((bfDelta != 0 && t->bf == 0) ? -1 : 0);
+   return ((bfDelta != 0 && (*tp)->bf == 0) ? -1 : 0);
 }
 
 /*
@@ -411,6 +713,7 @@ static int removeTreeNode(BST bst, BSTNode *tp, void *kp) {
 
 static int removeTargetNode(BST bst, BSTNode *tp) {
    BSTNode t, np;
+   int hDelta;
 
    t = *tp;
    if (t->left == NULL) {
@@ -430,9 +733,11 @@ static int removeTargetNode(BST bst, BSTNode *tp) {
       }
       t->key = np->key;
       t->value = np->value;
-      if (removeTreeNode(bst, &t->left, &t->key) < 0) {
+      hDelta = removeTreeNode(bst, &t->left, &t->key);
+      updateSize(t);
+      if (hDelta < 0) {
          adjustBF(bst, tp, +1);
-         return (t->bf == 0) ? -1 : 0;
+         return ((*tp)->bf == 0) ? -1 : 0;
       } else {
          return 0;
       }
@@ -443,11 +748,13 @@ static int removeTargetNode(BST bst, BSTNode *tp) {
  * Implementation notes: freeTree and freeNode
  * -------------------------------------------
  * The freeTree function frees all nodes by conducting a postorder walk.
- * The freeNode function makes a special-case check to free the key string.
+ * A node that is shared with another tree loses a reference instead, and
+ * the walk does not descend into it.  The freeNode function makes a
+ * special-case check to free the key string.
  */
 
 static void freeTree(BSTNode t) {
-   if (t != NULL) {
+   if (t != NULL && --t->refCount == 0) {
       freeTree(t->left);
       freeTree(t->right);
       freeNode(t);
@@ -561,21 +868,25 @@ static void fixRightImbalance(BST bst, BSTNode *tp) {
  * Performs a single left rotation of the tree whose address is
  * passed as an argument.  The balance factors are unchanged by this
  * function and must be corrected at a higher level of the algorithm.
+ * The two nodes that move are first made private to this tree, and their
+ * subtree sizes are recomputed here.
  */
 
 static void rotateLeft(BST bst, BSTNode *tp) {
    BSTNode parent, child;
    string key;
 
-   parent = *tp;
+   parent = ownNode(tp);
    if (bst->debugLog != NULL) {
       key = bst->toStringFn(parent->key);
       fprintf(bst->debugLog, "rotateLeft around %s\n", key);
       freeBlock(key);
    }
-   child = parent->right;
+   child = ownNode(&parent->right);
    parent->right = child->left;
    child->left = parent;
+   updateSize(parent);
+   updateSize(child);
    *tp = child;
 }
 
@@ -585,49 +896,156 @@ static void rotateLeft(BST bst, BSTNode *tp) {
  * Performs a single right rotation of the tree whose address is
  * passed as an argument.  The balance factors are unchanged by this
  * function and must be corrected at a higher level of the algorithm.
+ * The two nodes that move are first made private to this tree, and their
+ * subtree sizes are recomputed here.
  */
 
 static void rotateRight(BST bst, BSTNode *tp) {
    BSTNode parent, child;
    string key;
 
-   parent = *tp;
+   parent = ownNode(tp);
    if (bst->debugLog != NULL) {
       key = bst->toStringFn(parent->key);
       fprintf(bst->debugLog, "rotateRight around %s\n", key);
       freeBlock(key);
    }
-   child = parent->left;
+   child = ownNode(&parent->left);
    parent->left = child->right;
    child->right = parent;
+   updateSize(parent);
+   updateSize(child);
    *tp = child;
 }
 
 /*
- * Implementation notes: mapTree
- * -----------------------------
- * Implements a recursive walk over the tree.
+ * Implementation notes: Traversal
+ * -------------------------------
+ * The traversals keep an explicit stack whose depth never exceeds the
+ * height of the tree, which is logarithmic in its size.  The contents
+ * of the stack depend on the order:
+ *
+ * - For INORDER, the stack holds the nodes on the path to the next node
+ *   whose left subtrees have been visited but which have not yet been
+ *   produced themselves.  Producing a node pushes the leftmost path of
+ *   its right subtree.  For a range, nodes below the lower bound are
+ *   skipped when the path is pushed.
+ *
+ * - For PREORDER, the stack holds the roots of the subtrees that have
+ *   yet to be visited.  Producing a node pushes its right and then its
+ *   left child, so that the left subtree comes first.
+ *
+ * - For POSTORDER, the stack holds the path from the root to the next
+ *   node to produce, which is found by descending to the left whenever
+ *   possible and to the right otherwise.  After a node is produced, if
+ *   it was the left child of the node now on top of the stack, the
+ *   traversal continues with the corresponding path through the right
+ *   sibling.
+ *
+ * Each node is pushed and popped exactly once, so every step takes
+ * constant amortized time.
  */
 
-static void mapTree(BSTNode t, proc fn, TraversalOrder order, void *data) {
-   if (t != NULL) {
-      if (order == PREORDER) fn(t, data);
-      mapTree(t->left, fn, order, data);
-      if (order == INORDER) fn(t, data);
-      mapTree(t->right, fn, order, data);
-      if (order == POSTORDER) fn(t, data);
+static void initWalker(WalkerState *ws, BST bst, TraversalOrder order,
+                       GenericType *lo, GenericType *hi) {
+   ws->bst = bst;
+   ws->order = order;
+   ws->depth = 0;
+   ws->hasUpperBound = (hi != NULL);
+   if (hi != NULL) ws->hi = *hi;
+   switch (order) {
+     case PREORDER: pushNode(ws, bst->root); break;
+     case INORDER: pushLeftPath(ws, bst->root, lo); break;
+     case POSTORDER: pushPostorderPath(ws, bst->root); break;
+     default: error("BST: Illegal traversal order");
+   }
+}
+
+static BSTNode advanceWalker(WalkerState *ws) {
+   BSTNode t, parent;
+
+   if (ws->depth == 0) return NULL;
+   t = ws->stack[--ws->depth];
+   switch (ws->order) {
+     case PREORDER:
+      pushNode(ws, t->right);
+      pushNode(ws, t->left);
+      break;
+     case INORDER:
+      if (ws->hasUpperBound && ws->bst->cmpFn(&t->key, &ws->hi) > 0) {
+         ws->depth = 0;
+         return NULL;
+      }
+      pushLeftPath(ws, t->right, NULL);
+      break;
+     case POSTORDER:
+      if (ws->depth > 0) {
+         parent = ws->stack[ws->depth - 1];
+         if (parent->left == t) pushPostorderPath(ws, parent->right);
+      }
+      break;
+   }
+   return t;
+}
+
+static void pushNode(WalkerState *ws, BSTNode t) {
+   if (t == NULL) return;
+   if (ws->depth == MAX_HEIGHT) error("BST: Tree is too deep");
+   ws->stack[ws->depth++] = t;
+}
+
+static void pushLeftPath(WalkerState *ws, BSTNode t, GenericType *lo) {
+   while (t != NULL) {
+      if (lo != NULL && ws->bst->cmpFn(&t->key, lo) < 0) {
+         t = t->right;
+      } else {
+         pushNode(ws, t);
+         t = t->left;
+      }
+   }
+}
+
+static void pushPostorderPath(WalkerState *ws, BSTNode t) {
+   while (t != NULL) {
+      pushNode(ws, t);
+      t = (t->left != NULL) ? t->left : t->right;
    }
 }
 
 /*
- * Implementation notes: addNodeToIterator
- * ---------------------------------------
- * Adds the specified node to the iterator, which is passed as the
- * <code>data</code> parameter.
+ * Implementation notes: newWalkerIterator, stepWalkerIterator
+ * -----------------------------------------------------------
+ * The iterators keep a walker in the data field and free it as soon as
+ * the traversal is complete.
  */
 
-static void addNodeToIterator(BSTNode node, void *data) {
-   addToIteratorList((Iterator) data, &node);
+static Iterator newWalkerIterator(BST bst, TraversalOrder order,
+                                  GenericType *lo, GenericType *hi) {
+   Iterator iterator;
+   WalkerState *ws;
+
+   ws = newBlock(WalkerState *);
+   initWalker(ws, bst, order, lo, hi);
+   iterator = newStepIterator(sizeof(BSTNode), stepWalkerIterator);
+   setCollection(iterator, bst);
+   setIteratorData(iterator, ws);
+   return iterator;
+}
+
+static bool stepWalkerIterator(Iterator iterator, void *dst) {
+   WalkerState *ws;
+   BSTNode t;
+
+   ws = (WalkerState *) getIteratorData(iterator);
+   if (ws == NULL) return false;
+   t = advanceWalker(ws);
+   if (t == NULL) {
+      freeBlock(ws);
+      setIteratorData(iterator, NULL);
+      return false;
+   }
+   *((BSTNode *) dst) = t;
+   return true;
 }
 
 /*
@@ -734,6 +1152,9 @@ static int PRIMES_PREORDER[] = {
 
 static void testStringBST(void);
 static void testIntBST(void);
+static void testBuildBST(void);
+static void testShareBST(void);
+static void testRemoveSequence(void);
 static void insertArray(BST bst, void *array, int n);
 static void checkIterator(BST bst, TraversalOrder order, void *array);
 static void checkOrdered(BST bst);
@@ -747,6 +1168,9 @@ static string bfToString(int bf);
 void testBSTModule(void) {
    testStringBST();
    testIntBST();
+   testBuildBST();
+   testShareBST();
+   testRemoveSequence();
 }
 
 /* Private functions */
@@ -788,6 +1212,91 @@ static void testIntBST(void) {
    trace(checkIterator(bst2, INORDER, PRIMES));
 }
 
+static void testBuildBST(void) {
+   BST bst;
+   GenericType *keys;
+   int i, n;
+
+   keys = newArray(N_PRIMES, GenericType);
+   for (i = 0; i < N_PRIMES; i++) {
+      keys[i].intRep = PRIMES[i];
+   }
+   trace(bst = newBST(int));
+   for (n = 0; n <= N_PRIMES; n++) {
+      buildBSTFromSorted(bst, keys, NULL, n);
+      if (sizeBST(bst) != n) reportError("Wrong size for n = %d", n);
+      checkOrdered(bst);
+      checkBalanceFactors(bst);
+   }
+   trace(checkIterator(bst, INORDER, PRIMES));
+   trace(removeBSTNode(bst, 311));
+   trace(checkBalanceFactors(bst));
+   test(sizeBST(bst), (int) N_PRIMES - 1);
+   for (i = 0; i < N_PRIMES; i++) {
+      keys[i].intRep = i / 3;
+   }
+   trace(buildBSTFromSorted(bst, keys, NULL, N_PRIMES));
+   test(sizeBST(bst), (int) (N_PRIMES + 2) / 3);
+   trace(checkBalanceFactors(bst));
+   freeBlock(keys);
+}
+
+/*
+ * Function: testRemoveSequence
+ * Usage: testRemoveSequence();
+ * ----------------------------
+ * Removes the keys of a large tree in a scrambled order, checking the
+ * balance factors after each removal, which exercises every rotation
+ * that a deletion can cause.
+ */
+
+static void testRemoveSequence(void) {
+   BST bst;
+   int i;
+
+   trace(bst = newBST(int));
+   for (i = 0; i < 200; i++) {
+      insertBSTNode(bst, i);
+   }
+   reportMessage("Remove the keys in the order 73 * i mod 200");
+   for (i = 0; i < 200; i++) {
+      removeBSTNode(bst, (73 * i) % 200);
+      checkBalanceFactors(bst);
+   }
+   test(sizeBST(bst), 0);
+   freeBST(bst);
+}
+
+static void testShareBST(void) {
+   BST bst, bst2, bst3;
+
+   trace(bst = newBST(string));
+   trace(insertArray(bst, ELEMENTS, N_ELEMENTS));
+   trace(bst2 = shareBST(bst));
+   trace(removeBSTNode(bst, "Sc"));           /* Rotates right around Ru */
+   trace(removeBSTNode(bst, "He"));           /* Rotates left around Hf  */
+   trace(removeBSTNode(bst, "I"));            /* Double around Hf, Ho    */
+   trace(checkBalanceFactors(bst));
+   trace(checkOrdered(bst));
+   test(sizeBST(bst), (int) N_ELEMENTS - 3);
+   trace(checkIterator(bst2, PREORDER, ELEMENTS_PREORDER));
+   trace(checkIterator(bst2, INORDER, ELEMENTS_INORDER));
+   trace(checkIterator(bst2, POSTORDER, ELEMENTS_POSTORDER));
+   trace(checkBalanceFactors(bst2));
+   trace(bst3 = shareBST(bst2));
+   trace(setNodeValue(insertBSTNode(bst3, "He"), "Helium"));
+   trace(insertBSTNode(bst3, "Zz"));
+   test(getNodeValue(findBSTNode(bst3, "He")), "Helium");
+   test(getNodeValue(findBSTNode(bst2, "He")), NULL);
+   test(findBSTNode(bst2, "Zz") == NULL, true);
+   trace(checkBalanceFactors(bst3));
+   trace(freeBST(bst2));
+   test(sizeBST(bst3), (int) N_ELEMENTS + 1);
+   trace(freeBST(bst));
+   trace(checkOrdered(bst3));
+   trace(freeBST(bst3));
+}
+
 static void insertArray(BST bst, void *array, int n) {
    char *cptr;
    string typeName;
@@ -865,6 +1374,9 @@ static void checkNodeBalance(BST bst, BSTNode t) {
       reportError("bf incorrect for %s (%s should be %s)", getKeyString(t),
                   bfToString(storedBF), bfToString(actualBF));
    }
+   if (t->size != subtreeSize(t->left) + subtreeSize(t->right) + 1) {
+      reportError("Size incorrect for %s", getKeyString(t));
+   }
 }
 
 static int treeHeight(BSTNode t) {
@@ -0,0 +1,1246 @@
+/*
+ * File: btree.c
+ * -------------
+ * This file implements the btree.h interface, which provides a general
+ * implementation of B-trees.  It is used as an alternative storage
+ * strategy in the implementations of the Map and Set types.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "btree.h"
+#include "cmpfn.h"
+#include "cslib.h"
+#include "exception.h"
+#include "foreach.h"
+#include "generic.h"
+#include "iterator.h"
+#include "itertype.h"
+#include "strlib.h"
+#include "unittest.h"
+
+/*
+ * Constants
+ * ---------
+ * MIN_DEGREE -- Minimum number of children of a nonroot interior node
+ * MAX_KEYS   -- Maximum number of keys in a node
+ * MAX_DEPTH  -- Maximum height of a tree, which is far more than needed
+ */
+
+#define MIN_DEGREE 16
+#define MAX_KEYS (2 * MIN_DEGREE - 1)
+#define MAX_DEPTH 32
+
+/*
+ * Type: BTreeNode
+ * ---------------
+ * This type defines the structure of a B-tree node.  The keys and values
+ * are stored in parallel arrays so that the binary search within a node
+ * walks over a single contiguous block of keys.  Leaf nodes are
+ * allocated without the children array, which is why that field must
+ * remain the last one in the structure.
+ */
+
+typedef struct BTreeNodeCDT {
+   int nKeys;                  /* Number of keys in use                 */
+   int size;                   /* Number of keys in this subtree        */
+   bool isLeaf;                /* True if the node has no children      */
+   GenericType keys[MAX_KEYS]; /* Keys in ascending order               */
+   void *values[MAX_KEYS];     /* Value associated with each key        */
+   struct BTreeNodeCDT *children[MAX_KEYS + 1];  /* Interior nodes only */
+} *BTreeNode;
+
+#define LEAF_NODE_SIZE offsetof(struct BTreeNodeCDT, children)
+#define INTERIOR_NODE_SIZE sizeof(struct BTreeNodeCDT)
+
+/*
+ * Type: KeyKind
+ * -------------
+ * This type records whether the keys can be compared inline, which
+ * avoids an indirect call to the comparison function for the common
+ * cases of integer and string keys.
+ */
+
+typedef enum { GENERIC_KEYS, INT_KEYS, STRING_KEYS } KeyKind;
+
+/*
+ * Type: BTreeCDT
+ * --------------
+ * This type is the concrete type used to represent the B-tree.
+ */
+
+struct BTreeCDT {
+   IteratorHeader header;      /* Header to enable iteration            */
+   string baseType;            /* The name of the base type             */
+   int baseTypeSize;           /* Size of the base type in bytes        */
+   CompareFn cmpFn;            /* Function to compare two keys          */
+   FetchFn fetchFn;            /* Function to fetch an argument         */
+   StoreFn storeFn;            /* Function to store a value             */
+   KeyKind keyKind;            /* Selects inline comparisons            */
+   BTreeNode root;             /* Root of the tree                      */
+   int count;                  /* Number of keys in the B-tree          */
+};
+
+/*
+ * Type: WalkerState
+ * -----------------
+ * This type holds the path from the root to the current position of an
+ * iterator, which makes it possible to produce the keys one at a time
+ * without copying them into a list.  The tree is stored here rather than
+ * in the collection field of the iterator, because the foreach machinery
+ * overwrites that field for collections that wrap a B-tree.  Iterators
+ * over a range also record the upper bound.
+ */
+
+typedef struct {
+   BTree bt;
+   BTreeNode nodes[MAX_DEPTH];
+   int indices[MAX_DEPTH];
+   int depth;
+   bool hasUpperBound;
+   GenericType hi;
+} WalkerState;
+
+/* Private function prototypes */
+
+static BTreeNode newNode(bool isLeaf);
+static KeyKind getKeyKind(CompareFn cmpFn, int baseTypeSize);
+static int searchNode(BTree bt, BTreeNode np, void *kp, bool *found);
+static void **insertTreeEntry(BTree bt, BTreeNode np, void *kp);
+static void splitChild(BTreeNode parent, int i);
+static bool removeTreeEntry(BTree bt, BTreeNode np, void *kp);
+static void removeFromNode(BTreeNode np, int i);
+static int fillChild(BTreeNode np, int i);
+static void borrowFromPrev(BTreeNode np, int i);
+static void borrowFromNext(BTreeNode np, int i);
+static void mergeChildren(BTreeNode np, int i);
+static BTreeNode buildTree(GenericType keys[], void *values[], int n,
+                           int height);
+static double maxKeysForHeight(int height);
+static BTreeNode copyTree(BTreeNode np);
+static void freeTree(BTreeNode np);
+static void updateSize(BTreeNode np);
+static Iterator newWalkerIterator(BTree bt, GenericType *lo, GenericType *hi,
+                                  int size, StepIteratorFn stepFn);
+static bool advanceWalker(WalkerState *ws, BTreeNode *np, int *ip);
+static void pushLeftmostPath(WalkerState *ws, BTreeNode np);
+static void pushLowerBoundPath(WalkerState *ws, BTreeNode np, void *kp);
+static bool stepKeyIterator(Iterator iterator, void *dst);
+static bool stepEntryIterator(Iterator iterator, void *dst);
+static Iterator newForeachIterator(void *collection);
+
+/* Exported entries */
+
+BTree newBTreeFromType(string baseType) {
+   BTree bt;
+
+   bt = newBlock(BTree);
+   enableIteration(bt, newForeachIterator);
+   bt->baseType = baseType;
+   bt->baseTypeSize = getTypeSizeForType(baseType);
+   bt->fetchFn = getFetchFnForType(baseType);
+   bt->storeFn = getStoreFnForType(baseType);
+   bt->cmpFn = getCompareFnForType(baseType);
+   bt->keyKind = getKeyKind(bt->cmpFn, bt->baseTypeSize);
+   bt->root = NULL;
+   bt->count = 0;
+   return bt;
+}
+
+void freeBTree(BTree bt) {
+   clearBTree(bt);
+   freeBlock(bt);
+}
+
+int sizeBTree(BTree bt) {
+   return bt->count;
+}
+
+bool isEmptyBTree(BTree bt) {
+   return bt->count == 0;
+}
+
+void clearBTree(BTree bt) {
+   freeTree(bt->root);
+   bt->root = NULL;
+   bt->count = 0;
+}
+
+BTree cloneBTree(BTree bt) {
+   BTree newbt;
+
+   newbt = newBlock(BTree);
+   enableIteration(newbt, newForeachIterator);
+   newbt->baseType = bt->baseType;
+   newbt->baseTypeSize = bt->baseTypeSize;
+   newbt->fetchFn = bt->fetchFn;
+   newbt->storeFn = bt->storeFn;
+   newbt->cmpFn = bt->cmpFn;
+   newbt->keyKind = bt->keyKind;
+   newbt->root = copyTree(bt->root);
+   newbt->count = bt->count;
+   return newbt;
+}
+
+void **findBTreeEntry(BTree bt, ...) {
+   va_list args;
+   GenericType any;
+
+   va_start(args, bt);
+   bt->fetchFn(args, &any);
+   va_end(args);
+   return findBTreeEntryFromArg(bt, any);
+}
+
+/*
+ * Implementation notes: findBTreeEntryFromArg
+ * -------------------------------------------
+ * The search is iterative, since each level requires only a binary
+ * search within a single node.
+ */
+
+void **findBTreeEntryFromArg(BTree bt, GenericType any) {
+   BTreeNode np;
+   bool found;
+   int i;
+
+   np = bt->root;
+   while (np != NULL) {
+      i = searchNode(bt, np, &any, &found);
+      if (found) return &np->values[i];
+      np = (np->isLeaf) ? NULL : np->children[i];
+   }
+   return NULL;
+}
+
+void **insertBTreeEntry(BTree bt, ...) {
+   va_list args;
+   GenericType any;
+
+   va_start(args, bt);
+   bt->fetchFn(args, &any);
+   va_end(args);
+   return insertBTreeEntryFromArg(bt, any);
+}
+
+/*
+ * Implementation notes: insertBTreeEntryFromArg
+ * ---------------------------------------------
+ * Insertion splits full nodes on the way down, so that there is always
+ * room for a key moving up from a child.  A full root is split here,
+ * which is the only way in which the tree grows taller.
+ */
+
+void **insertBTreeEntryFromArg(BTree bt, GenericType any) {
+   BTreeNode np;
+
+   if (bt->root == NULL) {
+      bt->root = newNode(true);
+   } else if (bt->root->nKeys == MAX_KEYS) {
+      np = newNode(false);
+      np->size = bt->root->size;
+      np->children[0] = bt->root;
+      bt->root = np;
+      splitChild(np, 0);
+   }
+   return insertTreeEntry(bt, bt->root, &any);
+}
+
+void removeBTreeEntry(BTree bt, ...) {
+   va_list args;
+   GenericType any;
+
+   va_start(args, bt);
+   bt->fetchFn(args, &any);
+   va_end(args);
+   removeBTreeEntryFromArg(bt, any);
+}
+
+/*
+ * Implementation notes: removeBTreeEntryFromArg
+ * ---------------------------------------------
+ * Deletion ensures on the way down that every node it enters has at
+ * least <code>MIN_DEGREE</code> keys, so that a key can be removed
+ * without further repairs.  The root may be left without keys, in
+ * which case its only child (if any) becomes the new root.
+ */
+
+void removeBTreeEntryFromArg(BTree bt, GenericType any) {
+   BTreeNode oldRoot;
+
+   if (bt->root == NULL) return;
+   if (removeTreeEntry(bt, bt->root, &any)) bt->count--;
+   if (bt->root->nKeys == 0) {
+      oldRoot = bt->root;
+      bt->root = (oldRoot->isLeaf) ? NULL : oldRoot->children[0];
+      freeBlock(oldRoot);
+   }
+}
+
+/*
+ * Implementation notes: buildBTreeFromSorted
+ * ------------------------------------------
+ * The keys are checked in a single pass, and any duplicates are removed
+ * from a copy of the arrays.  The height of the new tree is the smallest
+ * one whose capacity is large enough to hold all the keys.  The work of
+ * arranging the keys within that height is done by buildTree.
+ */
+
+void buildBTreeFromSorted(BTree bt, GenericType keys[], void *values[],
+                          int n) {
+   GenericType *keyCopy;
+   void **valueCopy;
+   bool hasDuplicates;
+   int i, sign, height;
+
+   hasDuplicates = false;
+   for (i = 1; i < n; i++) {
+      sign = bt->cmpFn(&keys[i - 1], &keys[i]);
+      if (sign > 0) error("buildBTreeFromSorted: Keys are not sorted");
+      if (sign == 0) hasDuplicates = true;
+   }
+   clearBTree(bt);
+   keyCopy = NULL;
+   valueCopy = NULL;
+   if (hasDuplicates) {
+      keyCopy = newArray(n, GenericType);
+      memcpy(keyCopy, keys, n * sizeof(GenericType));
+      if (values != NULL) {
+         valueCopy = newArray(n, void *);
+         memcpy(valueCopy, values, n * sizeof(void *));
+      }
+      n = uniqueGenericArray(keyCopy, valueCopy, n, bt->cmpFn);
+      keys = keyCopy;
+      values = valueCopy;
+   }
+   if (n > 0) {
+      height = 0;
+      while (maxKeysForHeight(height) < n) {
+         height++;
+      }
+      bt->root = buildTree(keys, values, n, height);
+      bt->count = n;
+   }
+   if (keyCopy != NULL) freeBlock(keyCopy);
+   if (valueCopy != NULL) freeBlock(valueCopy);
+}
+
+Iterator newEntryIterator(BTree bt) {
+   return newWalkerIterator(bt, NULL, NULL, sizeof(BTreeEntry),
+                            stepEntryIterator);
+}
+
+Iterator newRangeEntryIterator(BTree bt, GenericType *lo, GenericType *hi) {
+   return newWalkerIterator(bt, lo, hi, sizeof(BTreeEntry),
+                            stepEntryIterator);
+}
+
+/*
+ * Implementation notes: rankBTreeFromArg
+ * --------------------------------------
+ * At each level, the keys that precede the search position are counted
+ * along with the subtrees to their left, using the subtree size stored
+ * in each node.  A search that ends at a key in an interior node also
+ * counts the subtree just to the left of that key.
+ */
+
+int rankBTreeFromArg(BTree bt, GenericType any) {
+   BTreeNode np;
+   bool found;
+   int i, j, rank;
+
+   rank = 0;
+   np = bt->root;
+   while (np != NULL) {
+      i = searchNode(bt, np, &any, &found);
+      rank += i;
+      if (np->isLeaf) break;
+      for (j = 0; j < i; j++) {
+         rank += np->children[j]->size;
+      }
+      if (found) return rank + np->children[i]->size;
+      np = np->children[i];
+   }
+   return rank;
+}
+
+bool selectBTreeEntry(BTree bt, int k, BTreeEntry *dst) {
+   BTreeNode np;
+   int i;
+
+   if (k < 0 || k >= bt->count) return false;
+   np = bt->root;
+   while (!np->isLeaf) {
+      for (i = 0; k >= np->children[i]->size; i++) {
+         k -= np->children[i]->size;
+         if (k == 0) {
+            dst->key = np->keys[i];
+            dst->value = np->values[i];
+            return true;
+         }
+         k--;
+      }
+      np = np->children[i];
+   }
+   dst->key = np->keys[k];
+   dst->value = np->values[k];
+   return true;
+}
+
+/*
+ * Implementation notes: floorBTreeEntryFromArg, ceilingBTreeEntryFromArg
+ * ----------------------------------------------------------------------
+ * These functions remember the closest key on the appropriate side of
+ * the search position at each level.  Keys found at deeper levels are
+ * always closer to the target, so the last one remembered is the answer.
+ */
+
+bool floorBTreeEntryFromArg(BTree bt, GenericType any, BTreeEntry *dst) {
+   BTreeNode np;
+   bool found, result;
+   int i;
+
+   result = false;
+   np = bt->root;
+   while (np != NULL) {
+      i = searchNode(bt, np, &any, &found);
+      if (found) i++;
+      if (i > 0) {
+         dst->key = np->keys[i - 1];
+         dst->value = np->values[i - 1];
+         result = true;
+      }
+      if (found || np->isLeaf) break;
+      np = np->children[i];
+   }
+   return result;
+}
+
+bool ceilingBTreeEntryFromArg(BTree bt, GenericType any, BTreeEntry *dst) {
+   BTreeNode np;
+   bool found, result;
+   int i;
+
+   result = false;
+   np = bt->root;
+   while (np != NULL) {
+      i = searchNode(bt, np, &any, &found);
+      if (i < np->nKeys) {
+         dst->key = np->keys[i];
+         dst->value = np->values[i];
+         result = true;
+      }
+      if (found || np->isLeaf) break;
+      np = np->children[i];
+   }
+   return result;
+}
+
+string getBaseTypeBTree(BTree bt) {
+   return bt->baseType;
+}
+
+int getBaseTypeSizeBTree(BTree bt) {
+   return bt->baseTypeSize;
+}
+
+void setCompareFnBTree(BTree bt, CompareFn cmpFn) {
+   bt->cmpFn = cmpFn;
+   bt->keyKind = getKeyKind(cmpFn, bt->baseTypeSize);
+}
+
+CompareFn getCompareFnBTree(BTree bt) {
+   return bt->cmpFn;
+}
+
+/* Private functions */
+
+static BTreeNode newNode(bool isLeaf) {
+   BTreeNode np;
+
+   np = (BTreeNode) getBlock((isLeaf) ? LEAF_NODE_SIZE : INTERIOR_NODE_SIZE);
+   np->nKeys = 0;
+   np->size = 0;
+   np->isLeaf = isLeaf;
+   return np;
+}
+
+static KeyKind getKeyKind(CompareFn cmpFn, int baseTypeSize) {
+   if (cmpFn == intCmpFn && baseTypeSize == sizeof(int)) return INT_KEYS;
+   if (cmpFn == stringCmpFn) return STRING_KEYS;
+   return GENERIC_KEYS;
+}
+
+/*
+ * Implementation notes: searchNode
+ * --------------------------------
+ * Performs a binary search for the key addressed by <code>kp</code> in
+ * the node.  If the key is found, the function sets <code>*found</code>
+ * to <code>true</code> and returns its index.  If not, the function
+ * returns the index of the first key that is larger, which is also the
+ * index of the child in which the search must continue.  The loop is
+ * repeated for each key kind so that the common cases compare inline.
+ */
+
+static int searchNode(BTree bt, BTreeNode np, void *kp, bool *found) {
+   int lo, hi, mid, sign, ikey;
+   string skey;
+
+   lo = 0;
+   hi = np->nKeys - 1;
+   switch (bt->keyKind) {
+     case INT_KEYS:
+      ikey = *((int *) kp);
+      while (lo <= hi) {
+         mid = (lo + hi) / 2;
+         if (ikey == np->keys[mid].intRep) {
+            *found = true;
+            return mid;
+         }
+         if (ikey < np->keys[mid].intRep) {
+            hi = mid - 1;
+         } else {
+            lo = mid + 1;
+         }
+      }
+      break;
+     case STRING_KEYS:
+      skey = *((string *) kp);
+      if (skey == NULL) error("BTree: String key is NULL");
+      while (lo <= hi) {
+         mid = (lo + hi) / 2;
+         sign = strcmp(skey, (string) np->keys[mid].pointerRep);
+         if (sign == 0) {
+            *found = true;
+            return mid;
+         }
+         if (sign < 0) {
+            hi = mid - 1;
+         } else {
+            lo = mid + 1;
+         }
+      }
+      break;
+     default:
+      while (lo <= hi) {
+         mid = (lo + hi) / 2;
+         sign = bt->cmpFn(kp, &np->keys[mid]);
+         if (sign == 0) {
+            *found = true;
+            return mid;
+         }
+         if (sign < 0) {
+            hi = mid - 1;
+         } else {
+            lo = mid + 1;
+         }
+      }
+      break;
+   }
+   *found = false;
+   return lo;
+}
+
+/*
+ * Implementation notes: insertTreeEntry
+ * -------------------------------------
+ * Enters the key into the subtree rooted at <code>np</code>, which is
+ * guaranteed not to be full.  Before descending into a full child,
+ * the code splits that child, which moves its median key into this
+ * node.  The return value is the address of the value field associated
+ * with the key.  If the key is new, the size of every subtree on the
+ * path to it grows by one, which the code detects by checking whether
+ * the recursive call changed the count.
+ */
+
+static void **insertTreeEntry(BTree bt, BTreeNode np, void *kp) {
+   void **vp;
+   bool found;
+   int i, n, sign, oldCount;
+
+   i = searchNode(bt, np, kp, &found);
+   if (found) return &np->values[i];
+   if (np->isLeaf) {
+      n = np->nKeys - i;
+      memmove(&np->keys[i + 1], &np->keys[i], n * sizeof(GenericType));
+      memmove(&np->values[i + 1], &np->values[i], n * sizeof(void *));
+      np->keys[i] = *((GenericType *) kp);
+      np->values[i] = NULL;
+      np->nKeys++;
+      np->size++;
+      bt->count++;
+      return &np->values[i];
+   }
+   if (np->children[i]->nKeys == MAX_KEYS) {
+      splitChild(np, i);
+      sign = bt->cmpFn(kp, &np->keys[i]);
+      if (sign == 0) return &np->values[i];
+      if (sign > 0) i++;
+   }
+   oldCount = bt->count;
+   vp = insertTreeEntry(bt, np->children[i], kp);
+   if (bt->count != oldCount) np->size++;
+   return vp;
+}
+
+/*
+ * Implementation notes: splitChild
+ * --------------------------------
+ * Splits the full child at index <code>i</code> into two nodes with
+ * <code>MIN_DEGREE - 1</code> keys each and moves the median key up
+ * into the parent, which must not be full.
+ */
+
+static void splitChild(BTreeNode parent, int i) {
+   BTreeNode left, right;
+   int n;
+
+   left = parent->children[i];
+   right = newNode(left->isLeaf);
+   right->nKeys = MIN_DEGREE - 1;
+   memcpy(right->keys, &left->keys[MIN_DEGREE],
+          (MIN_DEGREE - 1) * sizeof(GenericType));
+   memcpy(right->values, &left->values[MIN_DEGREE],
+          (MIN_DEGREE - 1) * sizeof(void *));
+   if (!left->isLeaf) {
+      memcpy(right->children, &left->children[MIN_DEGREE],
+             MIN_DEGREE * sizeof(BTreeNode));
+   }
+   left->nKeys = MIN_DEGREE - 1;
+   n = parent->nKeys - i;
+   memmove(&parent->children[i + 2], &parent->children[i + 1],
+           n * sizeof(BTreeNode));
+   memmove(&parent->keys[i + 1], &parent->keys[i], n * sizeof(GenericType));
+   memmove(&parent->values[i + 1], &parent->values[i], n * sizeof(void *));
+   parent->children[i + 1] = right;
+   parent->keys[i] = left->keys[MIN_DEGREE - 1];
+   parent->values[i] = left->values[MIN_DEGREE - 1];
+   parent->nKeys++;
+   updateSize(left);
+   updateSize(right);
+}
+
+/*
+ * Implementation notes: removeTreeEntry
+ * -------------------------------------
+ * Removes the key from the subtree rooted at <code>np</code>, which
+ * has at least <code>MIN_DEGREE</code> keys unless it is the root.
+ * The function returns <code>true</code> if the key was found, in which
+ * case the size of each subtree on the path shrinks by one.  If the
+ * key appears in an interior node, it is replaced by its predecessor
+ * or successor from a child that can afford to lose a key; if neither
+ * child can, the two children are merged around the key.
+ */
+
+static bool removeTreeEntry(BTree bt, BTreeNode np, void *kp) {
+   BTreeNode child;
+   GenericType key;
+   bool found, removed;
+   int i;
+
+   i = searchNode(bt, np, kp, &found);
+   if (found && np->isLeaf) {
+      removeFromNode(np, i);
+      removed = true;
+   } else if (found && np->children[i]->nKeys >= MIN_DEGREE) {
+      child = np->children[i];
+      while (!child->isLeaf) child = child->children[child->nKeys];
+      key = child->keys[child->nKeys - 1];
+      np->keys[i] = key;
+      np->values[i] = child->values[child->nKeys - 1];
+      removed = removeTreeEntry(bt, np->children[i], &key);
+   } else if (found && np->children[i + 1]->nKeys >= MIN_DEGREE) {
+      child = np->children[i + 1];
+      while (!child->isLeaf) child = child->children[0];
+      key = child->keys[0];
+      np->keys[i] = key;
+      np->values[i] = child->values[0];
+      removed = removeTreeEntry(bt, np->children[i + 1], &key);
+   } else if (found) {
+      mergeChildren(np, i);
+      removed = removeTreeEntry(bt, np->children[i], kp);
+   } else if (np->isLeaf) {
+      removed = false;
+   } else {
+      if (np->children[i]->nKeys < MIN_DEGREE) i = fillChild(np, i);
+      removed = removeTreeEntry(bt, np->children[i], kp);
+   }
+   if (removed) np->size--;
+   return removed;
+}
+
+static void removeFromNode(BTreeNode np, int i) {
+   int n;
+
+   n = np->nKeys - i - 1;
+   memmove(&np->keys[i], &np->keys[i + 1], n * sizeof(GenericType));
+   memmove(&np->values[i], &np->values[i + 1], n * sizeof(void *));
+   np->nKeys--;
+}
+
+/*
+ * Implementation notes: fillChild
+ * -------------------------------
+ * Ensures that the child at index <code>i</code> has at least
+ * <code>MIN_DEGREE</code> keys, either by borrowing a key from a
+ * sibling or by merging with one.  The return value is the index of
+ * the child that now covers the original range, which changes only
+ * when the child is merged into its left sibling.
+ */
+
+static int fillChild(BTreeNode np, int i) {
+   if (i > 0 && np->children[i - 1]->nKeys >= MIN_DEGREE) {
+      borrowFromPrev(np, i);
+   } else if (i < np->nKeys && np->children[i + 1]->nKeys >= MIN_DEGREE) {
+      borrowFromNext(np, i);
+   } else if (i < np->nKeys) {
+      mergeChildren(np, i);
+   } else {
+      mergeChildren(np, i - 1);
+      i--;
+   }
+   return i;
+}
+
+static void borrowFromPrev(BTreeNode np, int i) {
+   BTreeNode child, sibling;
+
+   child = np->children[i];
+   sibling = np->children[i - 1];
+   memmove(&child->keys[1], &child->keys[0],
+           child->nKeys * sizeof(GenericType));
+   memmove(&child->values[1], &child->values[0],
+           child->nKeys * sizeof(void *));
+   if (!child->isLeaf) {
+      memmove(&child->children[1], &child->children[0],
+              (child->nKeys + 1) * sizeof(BTreeNode));
+      child->children[0] = sibling->children[sibling->nKeys];
+   }
+   child->keys[0] = np->keys[i - 1];
+   child->values[0] = np->values[i - 1];
+   child->nKeys++;
+   np->keys[i - 1] = sibling->keys[sibling->nKeys - 1];
+   np->values[i - 1] = sibling->values[sibling->nKeys - 1];
+   sibling->nKeys--;
+   updateSize(child);
+   updateSize(sibling);
+}
+
+static void borrowFromNext(BTreeNode np, int i) {
+   BTreeNode child, sibling;
+
+   child = np->children[i];
+   sibling = np->children[i + 1];
+   child->keys[child->nKeys] = np->keys[i];
+   child->values[child->nKeys] = np->values[i];
+   if (!child->isLeaf) {
+      child->children[child->nKeys + 1] = sibling->children[0];
+      memmove(&sibling->children[0], &sibling->children[1],
+              sibling->nKeys * sizeof(BTreeNode));
+   }
+   child->nKeys++;
+   np->keys[i] = sibling->keys[0];
+   np->values[i] = sibling->values[0];
+   removeFromNode(sibling, 0);
+   updateSize(child);
+   updateSize(sibling);
+}
+
+/*
+ * Implementation notes: mergeChildren
+ * -----------------------------------
+ * Merges the child at index <code>i + 1</code> into the child at index
+ * <code>i</code>, moving the separating key down from the parent.
+ */
+
+static void mergeChildren(BTreeNode np, int i) {
+   BTreeNode child, sibling;
+   int n;
+
+   child = np->children[i];
+   sibling = np->children[i + 1];
+   n = child->nKeys;
+   child->keys[n] = np->keys[i];
+   child->values[n] = np->values[i];
+   memcpy(&child->keys[n + 1], sibling->keys,
+          sibling->nKeys * sizeof(GenericType));
+   memcpy(&child->values[n + 1], sibling->values,
+          sibling->nKeys * sizeof(void *));
+   if (!child->isLeaf) {
+      memcpy(&child->children[n + 1], sibling->children,
+             (sibling->nKeys + 1) * sizeof(BTreeNode));
+   }
+   child->nKeys += sibling->nKeys + 1;
+   child->size += sibling->size + 1;
+   removeFromNode(np, i);
+   memmove(&np->children[i + 1], &np->children[i + 2],
+           (np->nKeys - i) * sizeof(BTreeNode));
+   freeBlock(sibling);
+}
+
+/*
+ * Implementation notes: buildTree, maxKeysForHeight
+ * -------------------------------------------------
+ * The buildTree function creates a subtree of the given height that
+ * holds the n keys in the array.  An interior node uses the smallest
+ * number of children that can hold the keys not stored in the node
+ * itself and spreads those keys as evenly as possible among the
+ * children.  Because n is always more than a single child can hold,
+ * every child receives at least half of its capacity, which is enough
+ * to satisfy the minimum occupancy of a B-tree node at every level.
+ * The capacities are computed in double precision, which represents
+ * them exactly and avoids overflow for the tallest trees.
+ */
+
+static BTreeNode buildTree(GenericType keys[], void *values[], int n,
+                           int height) {
+   BTreeNode np;
+   double capacity;
+   int nChildren, nChildKeys, i, count;
+
+   np = newNode(height == 0);
+   if (height == 0) {
+      for (i = 0; i < n; i++) {
+         np->keys[i] = keys[i];
+         np->values[i] = (values == NULL) ? NULL : values[i];
+      }
+      np->nKeys = n;
+      np->size = n;
+      return np;
+   }
+   capacity = maxKeysForHeight(height - 1);
+   nChildren = (int) ((n + 1 + capacity) / (capacity + 1));
+   nChildKeys = n - (nChildren - 1);
+   for (i = 0; i < nChildren; i++) {
+      count = nChildKeys / nChildren + ((i < nChildKeys % nChildren) ? 1 : 0);
+      np->children[i] = buildTree(keys, values, count, height - 1);
+      keys += count;
+      if (values != NULL) values += count;
+      if (i < nChildren - 1) {
+         np->keys[i] = *keys++;
+         np->values[i] = (values == NULL) ? NULL : *values++;
+      }
+   }
+   np->nKeys = nChildren - 1;
+   np->size = n;
+   return np;
+}
+
+static double maxKeysForHeight(int height) {
+   double capacity;
+
+   capacity = MAX_KEYS;
+   while (height-- > 0) {
+      capacity = capacity * (MAX_KEYS + 1) + MAX_KEYS;
+   }
+   return capacity;
+}
+
+/*
+ * Implementation notes: updateSize
+ * --------------------------------
+ * Recomputes the number of keys in the subtree rooted at a node whose
+ * keys or children have been moved to or from a sibling.
+ */
+
+static void updateSize(BTreeNode np) {
+   int i;
+
+   np->size = np->nKeys;
+   if (!np->isLeaf) {
+      for (i = 0; i <= np->nKeys; i++) {
+         np->size += np->children[i]->size;
+      }
+   }
+}
+
+/*
+ * Implementation notes: copyTree and freeTree
+ * -------------------------------------------
+ * These functions walk the tree recursively.  The depth of the recursion
+ * is the height of the tree, which is small even for huge trees.
+ */
+
+static BTreeNode copyTree(BTreeNode np) {
+   BTreeNode copy;
+   int i;
+
+   if (np == NULL) return NULL;
+   copy = newNode(np->isLeaf);
+   memcpy(copy, np, LEAF_NODE_SIZE);
+   if (!np->isLeaf) {
+      for (i = 0; i <= np->nKeys; i++) {
+         copy->children[i] = copyTree(np->children[i]);
+      }
+   }
+   return copy;
+}
+
+static void freeTree(BTreeNode np) {
+   int i;
+
+   if (np == NULL) return;
+   if (!np->isLeaf) {
+      for (i = 0; i <= np->nKeys; i++) {
+         freeTree(np->children[i]);
+      }
+   }
+   freeBlock(np);
+}
+
+/*
+ * Implementation notes: Iteration
+ * -------------------------------
+ * The iterators for this type keep a <code>WalkerState</code> that
+ * records, for each node on the path from the root, the index of the
+ * next key to produce.  Producing a key advances that index and then
+ * descends to the leftmost leaf of the following subtree, so each
+ * step takes constant amortized time and no list is ever built.
+ */
+
+static Iterator newWalkerIterator(BTree bt, GenericType *lo, GenericType *hi,
+                                  int size, StepIteratorFn stepFn) {
+   Iterator iterator;
+   WalkerState *ws;
+
+   ws = newBlock(WalkerState *);
+   ws->bt = bt;
+   ws->depth = 0;
+   ws->hasUpperBound = (hi != NULL);
+   if (hi != NULL) ws->hi = *hi;
+   if (lo == NULL) {
+      pushLeftmostPath(ws, bt->root);
+   } else {
+      pushLowerBoundPath(ws, bt->root, lo);
+   }
+   iterator = newStepIterator(size, stepFn);
+   setIteratorData(iterator, ws);
+   return iterator;
+}
+
+static bool advanceWalker(WalkerState *ws, BTreeNode *np, int *ip) {
+   BTreeNode node;
+   int index;
+
+   while (ws->depth > 0) {
+      node = ws->nodes[ws->depth - 1];
+      index = ws->indices[ws->depth - 1];
+      if (index < node->nKeys) {
+         if (ws->hasUpperBound
+               && ws->bt->cmpFn(&node->keys[index], &ws->hi) > 0) {
+            ws->depth = 0;
+            return false;
+         }
+         ws->indices[ws->depth - 1] = index + 1;
+         if (!node->isLeaf) pushLeftmostPath(ws, node->children[index + 1]);
+         *np = node;
+         *ip = index;
+         return true;
+      }
+      ws->depth--;
+   }
+   return false;
+}
+
+static void pushLeftmostPath(WalkerState *ws, BTreeNode np) {
+   while (np != NULL) {
+      if (ws->depth == MAX_DEPTH) error("BTree: Tree is too deep");
+      ws->nodes[ws->depth] = np;
+      ws->indices[ws->depth] = 0;
+      ws->depth++;
+      np = (np->isLeaf) ? NULL : np->children[0];
+   }
+}
+
+/*
+ * Implementation notes: pushLowerBoundPath
+ * ----------------------------------------
+ * Pushes the path to the first key that is not less than the key
+ * addressed by <code>kp</code>.  The index recorded for each node is
+ * the position of the first such key in that node, so the subtrees to
+ * the left of that position are never visited.
+ */
+
+static void pushLowerBoundPath(WalkerState *ws, BTreeNode np, void *kp) {
+   bool found;
+   int i;
+
+   while (np != NULL) {
+      if (ws->depth == MAX_DEPTH) error("BTree: Tree is too deep");
+      i = searchNode(ws->bt, np, kp, &found);
+      ws->nodes[ws->depth] = np;
+      ws->indices[ws->depth] = i;
+      ws->depth++;
+      np = (found || np->isLeaf) ? NULL : np->children[i];
+   }
+}
+
+static bool stepKeyIterator(Iterator iterator, void *dst) {
+   WalkerState *ws;
+   BTreeNode np;
+   int i;
+
+   ws = (WalkerState *) getIteratorData(iterator);
+   if (ws == NULL) return false;
+   if (!advanceWalker(ws, &np, &i)) {
+      freeBlock(ws);
+      setIteratorData(iterator, NULL);
+      return false;
+   }
+   ws->bt->storeFn(np->keys[i], dst);
+   return true;
+}
+
+static bool stepEntryIterator(Iterator iterator, void *dst) {
+   WalkerState *ws;
+   BTreeEntry *ep;
+   BTreeNode np;
+   int i;
+
+   ws = (WalkerState *) getIteratorData(iterator);
+   if (ws == NULL) return false;
+   if (!advanceWalker(ws, &np, &i)) {
+      freeBlock(ws);
+      setIteratorData(iterator, NULL);
+      return false;
+   }
+   ep = (BTreeEntry *) dst;
+   ep->key = np->keys[i];
+   ep->value = np->values[i];
+   return true;
+}
+
+static Iterator newForeachIterator(void *collection) {
+   BTree bt;
+
+   bt = (BTree) collection;
+   return newWalkerIterator(bt, NULL, NULL, bt->baseTypeSize, stepKeyIterator);
+}
+
+/**********************************************************************/
+/* Unit test for the btree module                                     */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+/* Constants */
+
+#define N_TEST_KEYS 5000
+#define KEY_STRIDE 2311
+
+/* Private function prototypes */
+
+static void testIntBTree(void);
+static void testStringBTree(void);
+static void testBuildBTree(void);
+static void checkBTreeInvariants(BTree bt);
+static int checkSubtree(BTree bt, BTreeNode np, bool isRoot,
+                        GenericType *lo, GenericType *hi);
+static void checkOrderedKeys(BTree bt);
+
+/* Unit test */
+
+void testBTreeModule(void) {
+   testIntBTree();
+   testStringBTree();
+   testBuildBTree();
+}
+
+/* Private functions */
+
+static void testIntBTree(void) {
+   BTree bt, bt2;
+   int i, key, count, sum;
+
+   trace(bt = newBTree(int));
+   test(isEmptyBTree(bt), true);
+   for (i = 0; i < N_TEST_KEYS; i++) {
+      *insertBTreeEntry(bt, (i * KEY_STRIDE) % N_TEST_KEYS) = (void *) 1;
+   }
+   test(sizeBTree(bt), (int) N_TEST_KEYS);
+   trace(checkBTreeInvariants(bt));
+   trace(checkOrderedKeys(bt));
+   test(findBTreeEntry(bt, 1234) != NULL, true);
+   test(findBTreeEntry(bt, -1) == NULL, true);
+   test(findBTreeEntry(bt, N_TEST_KEYS) == NULL, true);
+   trace(insertBTreeEntry(bt, 17));
+   test(sizeBTree(bt), (int) N_TEST_KEYS);
+   trace(bt2 = cloneBTree(bt));
+   for (i = 0; i < N_TEST_KEYS; i += 3) {
+      removeBTreeEntry(bt, (i * KEY_STRIDE) % N_TEST_KEYS);
+   }
+   trace(removeBTreeEntry(bt, -1));
+   test(sizeBTree(bt), (int) (N_TEST_KEYS - (N_TEST_KEYS + 2) / 3));
+   trace(checkBTreeInvariants(bt));
+   trace(checkOrderedKeys(bt));
+   test(findBTreeEntry(bt, (3 * KEY_STRIDE) % N_TEST_KEYS) == NULL, true);
+   test(findBTreeEntry(bt, KEY_STRIDE % N_TEST_KEYS) != NULL, true);
+   test(sizeBTree(bt2), (int) N_TEST_KEYS);
+   trace(checkBTreeInvariants(bt2));
+   count = sum = 0;
+   foreach (key in bt2) {
+      if (key != count) reportError("Incorrect key: %d", key);
+      sum += (int) (long) *findBTreeEntry(bt2, key);
+      count++;
+   }
+   test(sum, (int) N_TEST_KEYS);
+   for (i = 0; i < N_TEST_KEYS; i++) {
+      removeBTreeEntry(bt2, i);
+   }
+   test(isEmptyBTree(bt2), true);
+   trace(freeBTree(bt));
+   trace(freeBTree(bt2));
+}
+
+static void testStringBTree(void) {
+   BTree bt;
+   BTreeEntry entry;
+   string key, str;
+   int i;
+
+   trace(bt = newBTree(string));
+   for (i = 0; i < 1000; i++) {
+      key = integerToString((i * 7) % 1000);
+      *insertBTreeEntry(bt, key) = key;
+   }
+   test(sizeBTree(bt), 1000);
+   trace(checkBTreeInvariants(bt));
+   test((string) *findBTreeEntry(bt, "999"), "999");
+   test(findBTreeEntry(bt, "1000") == NULL, true);
+   trace(removeBTreeEntry(bt, "500"));
+   test(findBTreeEntry(bt, "500") == NULL, true);
+   trace(checkBTreeInvariants(bt));
+   str = "";
+   foreach (key in bt) {
+      if (startsWith(key, "99")) str = concat(str, key);
+   }
+   test(str, "99990991992993994995996997998999");
+   str = "";
+   foreach (entry in newEntryIterator(bt)) {
+      if (startsWith(entry.value, "10")) {
+         str = concat(str, (string) entry.key.pointerRep);
+      }
+   }
+   test(str, "10100101102103104105106107108109");
+}
+
+static void testBuildBTree(void) {
+   static int sizes[] = { 0, 1, 31, 32, 33, 1023, 1024, 1025, N_TEST_KEYS };
+   BTree bt;
+   GenericType *keys;
+   int i, j, n;
+
+   keys = newArray(N_TEST_KEYS, GenericType);
+   for (i = 0; i < N_TEST_KEYS; i++) {
+      keys[i].intRep = 2 * i;
+   }
+   trace(bt = newBTree(int));
+   for (j = 0; j < sizeof sizes / sizeof sizes[0]; j++) {
+      n = sizes[j];
+      buildBTreeFromSorted(bt, keys, NULL, n);
+      if (sizeBTree(bt) != n) reportError("Wrong size for n = %d", n);
+      checkBTreeInvariants(bt);
+      checkOrderedKeys(bt);
+   }
+   test(findBTreeEntry(bt, 2 * (N_TEST_KEYS - 1)) != NULL, true);
+   test(findBTreeEntry(bt, 1) == NULL, true);
+   for (i = 0; i < N_TEST_KEYS; i += 2) {
+      removeBTreeEntry(bt, 2 * i);
+   }
+   test(sizeBTree(bt), (int) (N_TEST_KEYS / 2));
+   trace(checkBTreeInvariants(bt));
+   freeBlock(keys);
+   trace(freeBTree(bt));
+}
+
+static void checkBTreeInvariants(BTree bt) {
+   if (bt->root == NULL) {
+      if (bt->count != 0) reportError("Empty tree has nonzero count");
+      return;
+   }
+   checkSubtree(bt, bt->root, true, NULL, NULL);
+}
+
+/*
+ * Function: checkSubtree
+ * ----------------------
+ * Checks the key counts, subtree sizes, and ordering in the subtree and
+ * returns its height, reporting an error if the leaves are not all at
+ * the same depth.
+ */
+
+static int checkSubtree(BTree bt, BTreeNode np, bool isRoot,
+                        GenericType *lo, GenericType *hi) {
+   int i, height, h, count;
+
+   if (np->nKeys > MAX_KEYS || np->nKeys < ((isRoot) ? 1 : MIN_DEGREE - 1)) {
+      reportError("Node has %d keys", np->nKeys);
+   }
+   for (i = 0; i < np->nKeys; i++) {
+      if (i > 0 && bt->cmpFn(&np->keys[i - 1], &np->keys[i]) >= 0) {
+         reportError("Keys out of order within node");
+      }
+   }
+   if (lo != NULL && bt->cmpFn(lo, &np->keys[0]) >= 0) {
+      reportError("Key smaller than lower bound");
+   }
+   if (hi != NULL && bt->cmpFn(&np->keys[np->nKeys - 1], hi) >= 0) {
+      reportError("Key larger than upper bound");
+   }
+   count = np->nKeys;
+   if (!np->isLeaf) {
+      for (i = 0; i <= np->nKeys; i++) {
+         count += np->children[i]->size;
+      }
+   }
+   if (np->size != count) {
+      reportError("Node size is %d, not %d", np->size, count);
+   }
+   if (np->isLeaf) return 1;
+   height = -1;
+   for (i = 0; i <= np->nKeys; i++) {
+      h = checkSubtree(bt, np->children[i], false,
+                       (i == 0) ? lo : &np->keys[i - 1],
+                       (i == np->nKeys) ? hi : &np->keys[i]);
+      if (height != -1 && h != height) reportError("Leaves at unequal depth");
+      height = h;
+   }
+   return height + 1;
+}
+
+static void checkOrderedKeys(BTree bt) {
+   BTreeEntry entry, prev;
+   int count;
+
+   count = 0;
+   foreach (entry in newEntryIterator(bt)) {
+      if (count > 0 && bt->cmpFn(&prev.key, &entry.key) >= 0) {
+         reportError("Iterator keys out of order");
+      }
+      prev = entry;
+      count++;
+   }
+   if (count != bt->count) reportError("Iterator produced %d keys", count);
+}
+
+#endif
@@ -0,0 +1,641 @@
+/*
+ * File: cache.c
+ * -------------
+ * This file implements the cache.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include "cache.h"
+#include "cslib.h"
+#include "hashmap.h"
+#include "strlib.h"
+#include "unittest.h"
+
+/*
+ * Type: CacheEntry
+ * ----------------
+ * This type holds one entry in the cache.  The entries form a circular,
+ * doubly linked list whose order depends on the policy.  Under LRU, the
+ * list runs from the most recently used entry at the head to the least
+ * recently used one just before it.  Under CLOCK, the head is the hand
+ * of the clock, and the referenced flag records whether the entry has
+ * been used since the hand last passed it.
+ */
+
+typedef struct CacheEntry {
+   string key;
+   void *value;
+   int cost;
+   bool referenced;
+   struct CacheEntry *prev;
+   struct CacheEntry *next;
+} CacheEntry;
+
+/*
+ * Type: CacheCDT
+ * --------------
+ * This type defines the concrete structure of a cache.  The index maps
+ * each key to its entry.
+ */
+
+struct CacheCDT {
+   HashMap index;
+   CacheEntry *head;
+   EvictionPolicy policy;
+   int capacity;
+   int totalCost;
+   EvictionFn evictionFn;
+   void *evictionData;
+   long hits;
+   long misses;
+   long evictions;
+};
+
+/*
+ * Type: SharedCacheCDT
+ * --------------------
+ * This type defines the concrete structure of a shared cache, which is
+ * an array of caches, each protected by its own lock.
+ */
+
+struct SharedCacheCDT {
+   Cache *shards;
+   pthread_mutex_t *locks;
+   int nShards;
+};
+
+/* Private function prototypes */
+
+static void linkEntry(Cache cache, CacheEntry *entry);
+static void unlinkEntry(Cache cache, CacheEntry *entry);
+static void discardEntry(Cache cache, CacheEntry *entry);
+static void evictEntries(Cache cache);
+static int findShard(SharedCache cache, string key);
+
+/* Exported entries */
+
+Cache newCache(int capacity, EvictionPolicy policy) {
+   Cache cache;
+
+   if (capacity < 1) error("newCache: Capacity must be positive");
+   cache = newBlock(Cache);
+   cache->index = newHashMap();
+   cache->head = NULL;
+   cache->policy = policy;
+   cache->capacity = capacity;
+   cache->totalCost = 0;
+   cache->evictionFn = NULL;
+   cache->evictionData = NULL;
+   cache->hits = cache->misses = cache->evictions = 0;
+   return cache;
+}
+
+void freeCache(Cache cache) {
+   clearCache(cache);
+   freeHashMap(cache->index);
+   freeBlock(cache);
+}
+
+void setEvictionFn(Cache cache, EvictionFn fn, void *data) {
+   cache->evictionFn = fn;
+   cache->evictionData = data;
+}
+
+void putCache(Cache cache, string key, void *value) {
+   putCacheWithCost(cache, key, value, 1);
+}
+
+/*
+ * Implementation notes: putCacheWithCost
+ * --------------------------------------
+ * A value whose cost alone exceeds the capacity is discarded before it
+ * reaches the list, together with any older value for the same key, so
+ * that it does not push the other entries out first.  Otherwise, a new
+ * entry is linked where the policy will consider it last, a replaced
+ * entry is treated as used, and eviction continues until the total cost
+ * fits.
+ */
+
+void putCacheWithCost(Cache cache, string key, void *value, int cost) {
+   CacheEntry *entry;
+   bool replaced;
+
+   if (cost < 1) error("putCacheWithCost: Cost must be positive");
+   entry = (CacheEntry *) getHashMap(cache->index, key);
+   if (cost > cache->capacity) {
+      replaced = false;
+      if (entry != NULL) {
+         replaced = entry->value == value;
+         discardEntry(cache, entry);
+      }
+      cache->evictions++;
+      if (!replaced && cache->evictionFn != NULL) {
+         cache->evictionFn(key, value, cache->evictionData);
+      }
+      return;
+   }
+   if (entry == NULL) {
+      entry = newBlock(CacheEntry *);
+      entry->key = copyString(key);
+      entry->value = value;
+      entry->cost = cost;
+      entry->referenced = false;
+      putHashMap(cache->index, key, entry);
+      linkEntry(cache, entry);
+   } else {
+      if (entry->value != value && cache->evictionFn != NULL) {
+         cache->evictionFn(entry->key, entry->value, cache->evictionData);
+      }
+      cache->totalCost -= entry->cost;
+      entry->value = value;
+      entry->cost = cost;
+      if (cache->policy == LRU_EVICTION) {
+         unlinkEntry(cache, entry);
+         linkEntry(cache, entry);
+      } else {
+         entry->referenced = true;
+      }
+   }
+   cache->totalCost += cost;
+   evictEntries(cache);
+}
+
+/*
+ * Implementation notes: getCache
+ * ------------------------------
+ * Under LRU, a hit moves the entry to the head of the list.  Under
+ * CLOCK, a hit only sets the referenced flag.
+ */
+
+void *getCache(Cache cache, string key) {
+   CacheEntry *entry;
+
+   entry = (CacheEntry *) getHashMap(cache->index, key);
+   if (entry == NULL) {
+      cache->misses++;
+      return NULL;
+   }
+   cache->hits++;
+   if (cache->policy == LRU_EVICTION) {
+      if (entry != cache->head) {
+         unlinkEntry(cache, entry);
+         linkEntry(cache, entry);
+      }
+   } else {
+      entry->referenced = true;
+   }
+   return entry->value;
+}
+
+bool containsKeyCache(Cache cache, string key) {
+   return containsKeyHashMap(cache->index, key);
+}
+
+void removeCache(Cache cache, string key) {
+   CacheEntry *entry;
+
+   entry = (CacheEntry *) getHashMap(cache->index, key);
+   if (entry != NULL) discardEntry(cache, entry);
+}
+
+void clearCache(Cache cache) {
+   while (cache->head != NULL) {
+      discardEntry(cache, cache->head);
+   }
+}
+
+int sizeCache(Cache cache) {
+   return sizeHashMap(cache->index);
+}
+
+int getCacheCost(Cache cache) {
+   return cache->totalCost;
+}
+
+long getCacheHits(Cache cache) {
+   return cache->hits;
+}
+
+long getCacheMisses(Cache cache) {
+   return cache->misses;
+}
+
+long getCacheEvictions(Cache cache) {
+   return cache->evictions;
+}
+
+/*
+ * Implementation notes: newSharedCache
+ * ------------------------------------
+ * The capacity is divided among the shards, rounding up so that the
+ * total is never less than the capacity requested.
+ */
+
+SharedCache newSharedCache(int capacity, EvictionPolicy policy, int nShards) {
+   SharedCache cache;
+   int i, share;
+
+   if (capacity < 1) error("newSharedCache: Capacity must be positive");
+   if (nShards < 1) error("newSharedCache: Number of shards must be positive");
+   if (nShards > capacity) nShards = capacity;
+   share = (capacity + nShards - 1) / nShards;
+   cache = newBlock(SharedCache);
+   cache->nShards = nShards;
+   cache->shards = newArray(nShards, Cache);
+   cache->locks = newArray(nShards, pthread_mutex_t);
+   for (i = 0; i < nShards; i++) {
+      cache->shards[i] = newCache(share, policy);
+      pthread_mutex_init(&cache->locks[i], NULL);
+   }
+   return cache;
+}
+
+void freeSharedCache(SharedCache cache) {
+   int i;
+
+   for (i = 0; i < cache->nShards; i++) {
+      freeCache(cache->shards[i]);
+      pthread_mutex_destroy(&cache->locks[i]);
+   }
+   freeBlock(cache->shards);
+   freeBlock(cache->locks);
+   freeBlock(cache);
+}
+
+void setSharedEvictionFn(SharedCache cache, EvictionFn fn, void *data) {
+   int i;
+
+   for (i = 0; i < cache->nShards; i++) {
+      pthread_mutex_lock(&cache->locks[i]);
+      setEvictionFn(cache->shards[i], fn, data);
+      pthread_mutex_unlock(&cache->locks[i]);
+   }
+}
+
+void putSharedCache(SharedCache cache, string key, void *value) {
+   putSharedCacheWithCost(cache, key, value, 1);
+}
+
+void putSharedCacheWithCost(SharedCache cache, string key, void *value,
+                            int cost) {
+   int k;
+
+   if (cost < 1) error("putSharedCacheWithCost: Cost must be positive");
+   k = findShard(cache, key);
+   pthread_mutex_lock(&cache->locks[k]);
+   putCacheWithCost(cache->shards[k], key, value, cost);
+   pthread_mutex_unlock(&cache->locks[k]);
+}
+
+void *getSharedCache(SharedCache cache, string key) {
+   void *value;
+   int k;
+
+   k = findShard(cache, key);
+   pthread_mutex_lock(&cache->locks[k]);
+   value = getCache(cache->shards[k], key);
+   pthread_mutex_unlock(&cache->locks[k]);
+   return value;
+}
+
+void removeSharedCache(SharedCache cache, string key) {
+   int k;
+
+   k = findShard(cache, key);
+   pthread_mutex_lock(&cache->locks[k]);
+   removeCache(cache->shards[k], key);
+   pthread_mutex_unlock(&cache->locks[k]);
+}
+
+int sizeSharedCache(SharedCache cache) {
+   int i, n;
+
+   n = 0;
+   for (i = 0; i < cache->nShards; i++) {
+      pthread_mutex_lock(&cache->locks[i]);
+      n += sizeCache(cache->shards[i]);
+      pthread_mutex_unlock(&cache->locks[i]);
+   }
+   return n;
+}
+
+long getSharedCacheHits(SharedCache cache) {
+   long n;
+   int i;
+
+   n = 0;
+   for (i = 0; i < cache->nShards; i++) {
+      pthread_mutex_lock(&cache->locks[i]);
+      n += getCacheHits(cache->shards[i]);
+      pthread_mutex_unlock(&cache->locks[i]);
+   }
+   return n;
+}
+
+long getSharedCacheMisses(SharedCache cache) {
+   long n;
+   int i;
+
+   n = 0;
+   for (i = 0; i < cache->nShards; i++) {
+      pthread_mutex_lock(&cache->locks[i]);
+      n += getCacheMisses(cache->shards[i]);
+      pthread_mutex_unlock(&cache->locks[i]);
+   }
+   return n;
+}
+
+long getSharedCacheEvictions(SharedCache cache) {
+   long n;
+   int i;
+
+   n = 0;
+   for (i = 0; i < cache->nShards; i++) {
+      pthread_mutex_lock(&cache->locks[i]);
+      n += getCacheEvictions(cache->shards[i]);
+      pthread_mutex_unlock(&cache->locks[i]);
+   }
+   return n;
+}
+
+/* Private functions */
+
+/*
+ * Implementation notes: linkEntry, unlinkEntry
+ * --------------------------------------------
+ * Under LRU, linkEntry makes the entry the new head.  Under CLOCK, it
+ * places the entry just behind the hand, so that the hand reaches it
+ * only after examining every other entry.
+ */
+
+static void linkEntry(Cache cache, CacheEntry *entry) {
+   CacheEntry *head;
+
+   head = cache->head;
+   if (head == NULL) {
+      entry->prev = entry->next = entry;
+      cache->head = entry;
+   } else {
+      entry->next = head;
+      entry->prev = head->prev;
+      head->prev->next = entry;
+      head->prev = entry;
+      if (cache->policy == LRU_EVICTION) cache->head = entry;
+   }
+}
+
+static void unlinkEntry(Cache cache, CacheEntry *entry) {
+   if (entry->next == entry) {
+      cache->head = NULL;
+   } else {
+      entry->prev->next = entry->next;
+      entry->next->prev = entry->prev;
+      if (cache->head == entry) cache->head = entry->next;
+   }
+}
+
+static void discardEntry(Cache cache, CacheEntry *entry) {
+   unlinkEntry(cache, entry);
+   removeHashMap(cache->index, entry->key);
+   cache->totalCost -= entry->cost;
+   if (cache->evictionFn != NULL) {
+      cache->evictionFn(entry->key, entry->value, cache->evictionData);
+   }
+   freeBlock(entry->key);
+   freeBlock(entry);
+}
+
+/*
+ * Implementation notes: evictEntries
+ * ----------------------------------
+ * Under LRU, the victim is the entry just before the head.  Under CLOCK,
+ * the hand sweeps forward, clearing the referenced flags it passes,
+ * until it finds an entry whose flag is already clear.  Each flag can be
+ * cleared only once per sweep, so the cost of sweeping is bounded by the
+ * number of hits since the last eviction.
+ */
+
+static void evictEntries(Cache cache) {
+   CacheEntry *victim;
+
+   while (cache->totalCost > cache->capacity) {
+      if (cache->policy == LRU_EVICTION) {
+         victim = cache->head->prev;
+      } else {
+         while (cache->head->referenced) {
+            cache->head->referenced = false;
+            cache->head = cache->head->next;
+         }
+         victim = cache->head;
+      }
+      cache->evictions++;
+      discardEntry(cache, victim);
+   }
+}
+
+static int findShard(SharedCache cache, string key) {
+   return hashString(key) % cache->nShards;
+}
+
+/**********************************************************************/
+/* Unit test for the cache module                                     */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+/*
+ * Constants
+ * ---------
+ * N_THREADS -- Number of threads in the shared cache test
+ * N_KEYS    -- Number of keys used by each thread
+ */
+
+#define N_THREADS 4
+#define N_KEYS 2000
+
+/* Private function prototypes */
+
+static void testLRUCache(void);
+static void testClockCache(void);
+static void testCostAndEviction(void);
+static void testSharedCache(void);
+static void countEviction(string key, void *value, void *data);
+static void recordEviction(string key, void *value, void *data);
+static void *exerciseSharedCache(void *arg);
+
+/* Unit test */
+
+void testCacheModule(void) {
+   testLRUCache();
+   testClockCache();
+   testCostAndEviction();
+   testSharedCache();
+}
+
+static void testLRUCache(void) {
+   Cache cache;
+   string evicted;
+
+   trace(cache = newCache(3, LRU_EVICTION));
+   trace(setEvictionFn(cache, recordEviction, &evicted));
+   trace(putCache(cache, "A", "1"));
+   trace(putCache(cache, "B", "2"));
+   trace(putCache(cache, "C", "3"));
+   test(getCache(cache, "A"), "1");
+   trace(evicted = "");
+   trace(putCache(cache, "D", "4"));
+   test(evicted, "B");
+   test(containsKeyCache(cache, "B"), false);
+   test(getCache(cache, "B"), NULL);
+   test(getCache(cache, "C"), "3");
+   trace(putCache(cache, "E", "5"));
+   test(evicted, "A");
+   test(sizeCache(cache), 3);
+   test((int) getCacheHits(cache), 2);
+   test((int) getCacheMisses(cache), 1);
+   test((int) getCacheEvictions(cache), 2);
+   trace(removeCache(cache, "D"));
+   test(evicted, "D");
+   test(sizeCache(cache), 2);
+   trace(freeCache(cache));
+}
+
+/*
+ * Implementation notes: testClockCache
+ * ------------------------------------
+ * Under CLOCK, a used entry survives the next sweep of the hand, which
+ * evicts the first unused entry it finds.  Here A is the oldest entry
+ * but outlives B, C and D because it was used before the first sweep.
+ */
+
+static void testClockCache(void) {
+   Cache cache;
+   string evicted;
+
+   trace(cache = newCache(3, CLOCK_EVICTION));
+   trace(setEvictionFn(cache, recordEviction, &evicted));
+   trace(putCache(cache, "A", "1"));
+   trace(putCache(cache, "B", "2"));
+   trace(putCache(cache, "C", "3"));
+   test(getCache(cache, "A"), "1");
+   trace(putCache(cache, "D", "4"));
+   test(evicted, "B");
+   trace(putCache(cache, "E", "5"));
+   test(evicted, "C");
+   trace(putCache(cache, "F", "6"));
+   test(evicted, "D");
+   test(getCache(cache, "E"), "5");
+   test(getCache(cache, "F"), "6");
+   trace(putCache(cache, "G", "7"));
+   test(evicted, "A");
+   test(sizeCache(cache), 3);
+   trace(freeCache(cache));
+}
+
+static void testCostAndEviction(void) {
+   Cache cache;
+   int count;
+
+   count = 0;
+   trace(cache = newCache(100, LRU_EVICTION));
+   trace(setEvictionFn(cache, countEviction, &count));
+   trace(putCacheWithCost(cache, "small", "s", 10));
+   trace(putCacheWithCost(cache, "medium", "m", 40));
+   trace(putCacheWithCost(cache, "large", "l", 50));
+   test(getCacheCost(cache), 100);
+   test(count, 0);
+   trace(putCacheWithCost(cache, "tiny", "t", 5));
+   test(count, 1);
+   test(containsKeyCache(cache, "small"), false);
+   test(getCacheCost(cache), 95);
+   trace(putCacheWithCost(cache, "medium", "M", 20));
+   test(count, 2);
+   test(getCacheCost(cache), 75);
+   trace(putCacheWithCost(cache, "huge", "h", 200));
+   test(containsKeyCache(cache, "huge"), false);
+   test(sizeCache(cache), 3);
+   test(getCacheCost(cache), 75);
+   test(count, 3);
+   trace(putCacheWithCost(cache, "large", "L", 200));
+   test(containsKeyCache(cache, "large"), false);
+   test(sizeCache(cache), 2);
+   test(getCacheCost(cache), 25);
+   test(count, 5);
+   testError(putCacheWithCost(cache, "free", "f", 0));
+   trace(putCache(cache, "x", "1"));
+   trace(clearCache(cache));
+   test(count, 8);
+   test(getCacheCost(cache), 0);
+   trace(freeCache(cache));
+}
+
+/*
+ * Implementation notes: testSharedCache
+ * -------------------------------------
+ * Several threads put and get their own keys concurrently.  Every get
+ * counts as a hit or a miss, and the cache never holds more than its
+ * capacity, whatever the interleaving.
+ */
+
+static void testSharedCache(void) {
+   SharedCache cache;
+   pthread_t threads[N_THREADS];
+   int i;
+
+   trace(cache = newSharedCache(1000, CLOCK_EVICTION, 8));
+   for (i = 0; i < N_THREADS; i++) {
+      pthread_create(&threads[i], NULL, exerciseSharedCache, cache);
+   }
+   for (i = 0; i < N_THREADS; i++) {
+      pthread_join(threads[i], NULL);
+   }
+   test(getSharedCacheHits(cache) + getSharedCacheMisses(cache)
+        == 2 * N_THREADS * N_KEYS, true);
+   test(sizeSharedCache(cache) <= 1000, true);
+   test(getSharedCacheEvictions(cache) > 0, true);
+   trace(freeSharedCache(cache));
+}
+
+static void countEviction(string key, void *value, void *data) {
+   (*(int *) data)++;
+}
+
+static void recordEviction(string key, void *value, void *data) {
+   *(string *) data = copyString(key);
+}
+
+static void *exerciseSharedCache(void *arg) {
+   SharedCache cache;
+   char key[40];
+   int i;
+
+   cache = (SharedCache) arg;
+   for (i = 0; i < N_KEYS; i++) {
+      sprintf(key, "%p:%d", (void *) &key, i);
+      putSharedCache(cache, key, "value");
+      getSharedCache(cache, key);
+      getSharedCache(cache, key);
+   }
+   return NULL;
+}
+
+#endif
@@ -23,6 +23,7 @@
 /*************************************************************************/
 
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "charset.h"
@@ -32,32 +33,72 @@
 #include "itertype.h"
 #include "strlib.h"
 #include "unittest.h"
+#include "private/bitops.h"
 
-/* Constants */
+/*
+ * Implementation notes: Vector instructions
+ * -----------------------------------------
+ * On x86 processors, the set operations use the SSE2 instructions that
+ * every 64-bit processor supports, and the string scanning functions use
+ * the SSSE3 byte shuffle when the processor running the program has it.
+ * Other platforms use the portable code, which computes the same results.
+ */
 
-#ifdef _LP64
-#  define BIT_SHIFT_SIZE 6
-#  define BIT_ARRAY_SIZE 4
-#  define BIT_SHIFT_MASK 0x3F
-#else
-#  define BIT_SHIFT_SIZE 5
-#  define BIT_ARRAY_SIZE 8
-#  define BIT_SHIFT_MASK 0x1F
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define CHARSET_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define CHARSET_SSSE3
+#  include <tmmintrin.h>
 #endif
 
+/*
+ * Constants
+ * ---------
+ * CHARSET_WORDS -- Number of 64-bit words in the bit vector
+ * BLOCK_SIZE    -- Number of characters classified at once
+ */
+
+#define CHARSET_WORDS 4
+#define BLOCK_SIZE 16
+
 /*
  * Type: CharSetCDT
  * ----------------
- * This type defines the concrete structure of a character set.
+ * This type defines the concrete structure of a character set.  The bit
+ * for the character ch is bit ch % 64 of the word ch / 64, independent of
+ * the width of <code>long</code>.  The lookup array holds the tables used
+ * by the string scanning functions, which are rebuilt on demand after
+ * the set changes.  Row r of the first half records, for the characters
+ * whose low four bits are r, which of the high nibbles 0 to 7 appear in
+ * the set; row r of the second half does the same for nibbles 8 to 15.
  */
 
 struct CharSetCDT {
    IteratorHeader header;
-   long bits[BIT_ARRAY_SIZE];
+   uint64_t bits[CHARSET_WORDS];
+   unsigned char lookup[2 * BLOCK_SIZE];
+   bool lookupValid;
 };
 
+/*
+ * Type: SetOperation
+ * ------------------
+ * This type identifies an operation that combines two bit vectors.
+ */
+
+typedef enum { UNION_OP, INTERSECTION_OP, DIFFERENCE_OP } SetOperation;
+
 /* Private function prototypes */
 
+static CharSet combineCharSets(CharSet s1, CharSet s2, SetOperation op);
+static int scanCharSet(CharSet set, string str, int start, bool member);
+static void buildLookup(CharSet set);
+#ifdef CHARSET_SSSE3
+static int scanBlocks(CharSet set, string str, int start, bool member);
+#endif
 static Iterator newCharSetIterator(void *collection);
 static bool stepCharSetIterator(Iterator it, void *dst);
 static void advanceCharSetIterator(Iterator it);
@@ -85,19 +126,11 @@ void freeCharSet(CharSet set) {
 }
 
 int sizeCharSet(CharSet set) {
-   int ch, index, n;
-   long mask;
+   int i, n;
 
    n = 0;
-   index = 0;
-   mask = 1L;
-   for (ch = 0; ch < 256; ch++) {
-      if ((set->bits[index] & mask) != 0) n++;
-      mask <<= 1;
-      if (mask == 0) {
-         index++;
-         mask = 1L;
-      }
+   for (i = 0; i < CHARSET_WORDS; i++) {
+      n += countBits(set->bits[i]);
    }
    return n;
 }
@@ -105,7 +138,7 @@ int sizeCharSet(CharSet set) {
 bool isEmptyCharSet(CharSet set) {
    int i;
 
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
+   for (i = 0; i < CHARSET_WORDS; i++) {
       if (set->bits[i] != 0) return false;
    }
    return true;
@@ -114,35 +147,36 @@ bool isEmptyCharSet(CharSet set) {
 void clearCharSet(CharSet set) {
    int i;
 
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
+   for (i = 0; i < CHARSET_WORDS; i++) {
       set->bits[i] = 0;
    }
+   set->lookupValid = false;
 }
 
 CharSet cloneCharSet(CharSet set) {
    CharSet newset;
    int i;
 
-   newset = newBlock(CharSet);
-   enableIteration(newset, newCharSetIterator);
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
+   newset = newCharSet();
+   for (i = 0; i < CHARSET_WORDS; i++) {
       newset->bits[i] = set->bits[i];
    }
    return newset;
 }
 
 bool containsCharSet(CharSet set, char ch) {
-   long mask;
+   int k;
 
-   mask = 1L << (ch & BIT_SHIFT_MASK);
-   return (set->bits[(ch & 0xFF) >> BIT_SHIFT_SIZE] & mask) != 0;
+   k = ch & 0xFF;
+   return ((set->bits[k >> 6] >> (k & 0x3F)) & 1) != 0;
 }
 
 void addCharSet(CharSet set, char ch) {
-   long mask;
+   int k;
 
-   mask = 1L << (ch & BIT_SHIFT_MASK);
-   set->bits[(ch & 0xFF) >> BIT_SHIFT_SIZE] |= mask;
+   k = ch & 0xFF;
+   set->bits[k >> 6] |= (uint64_t) 1 << (k & 0x3F);
+   set->lookupValid = false;
 }
 
 void addString(CharSet set, string str) {
@@ -155,16 +189,17 @@ void addString(CharSet set, string str) {
 }
 
 void removeCharSet(CharSet set, char ch) {
-   long mask;
+   int k;
 
-   mask = 1L << (ch & BIT_SHIFT_MASK);
-   set->bits[(ch & 0xFF) >> BIT_SHIFT_SIZE] &= ~mask;
+   k = ch & 0xFF;
+   set->bits[k >> 6] &= ~((uint64_t) 1 << (k & 0x3F));
+   set->lookupValid = false;
 }
 
 bool equalsCharSet(CharSet s1, CharSet s2) {
    int i;
 
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
+   for (i = 0; i < CHARSET_WORDS; i++) {
       if (s1->bits[i] != s2->bits[i]) return false;
    }
    return true;
@@ -173,46 +208,203 @@ bool equalsCharSet(CharSet s1, CharSet s2) {
 bool isSubsetCharSet(CharSet s1, CharSet s2) {
    int i;
 
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
+   for (i = 0; i < CHARSET_WORDS; i++) {
       if ((s1->bits[i] & ~s2->bits[i]) != 0) return false;
    }
    return true;
 }
 
 CharSet unionCharSet(CharSet s1, CharSet s2) {
-   CharSet set;
-   int i;
+   return combineCharSets(s1, s2, UNION_OP);
+}
 
-   set = newBlock(CharSet);
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
-      set->bits[i] = s1->bits[i] | s2->bits[i];
+CharSet intersectionCharSet(CharSet s1, CharSet s2) {
+   return combineCharSets(s1, s2, INTERSECTION_OP);
+}
+
+CharSet setDifferenceCharSet(CharSet s1, CharSet s2) {
+   return combineCharSets(s1, s2, DIFFERENCE_OP);
+}
+
+int spanCharSet(string str, CharSet set) {
+   return scanCharSet(set, str, 0, false);
+}
+
+int findFirstInCharSet(string str, CharSet set) {
+   int index;
+
+   index = scanCharSet(set, str, 0, true);
+   return (str[index] == '\0') ? -1 : index;
+}
+
+/*
+ * Implementation notes: splitByCharSet
+ * ------------------------------------
+ * The first pass counts the fields so that the array can be allocated
+ * with the correct size, and the second pass copies them.  Each pass
+ * alternates between skipping separators and skipping field characters,
+ * so every character is classified once per pass.
+ */
+
+string *splitByCharSet(string str, CharSet set) {
+   string *array;
+   int start, finish, n, pass;
+
+   array = NULL;
+   for (pass = 0; pass < 2; pass++) {
+      n = 0;
+      start = scanCharSet(set, str, 0, false);
+      while (str[start] != '\0') {
+         finish = scanCharSet(set, str, start, true);
+         if (array != NULL) array[n] = substring(str, start, finish - 1);
+         n++;
+         start = scanCharSet(set, str, finish, false);
+      }
+      if (array == NULL) array = newArray(n + 1, string);
    }
-   return set;
+   array[n] = NULL;
+   return array;
 }
 
-CharSet intersectionCharSet(CharSet s1, CharSet s2) {
+/* Private functions */
+
+/*
+ * Implementation notes: combineCharSets
+ * -------------------------------------
+ * With SSE2, the 256-bit vectors are combined in two 128-bit halves.
+ */
+
+static CharSet combineCharSets(CharSet s1, CharSet s2, SetOperation op) {
    CharSet set;
+#ifdef CHARSET_SSE2
+   __m128i v1, v2;
+   int i;
+
+   set = newCharSet();
+   for (i = 0; i < CHARSET_WORDS; i += 2) {
+      v1 = _mm_loadu_si128((__m128i *) &s1->bits[i]);
+      v2 = _mm_loadu_si128((__m128i *) &s2->bits[i]);
+      switch (op) {
+       case UNION_OP: v1 = _mm_or_si128(v1, v2); break;
+       case INTERSECTION_OP: v1 = _mm_and_si128(v1, v2); break;
+       case DIFFERENCE_OP: v1 = _mm_andnot_si128(v2, v1); break;
+      }
+      _mm_storeu_si128((__m128i *) &set->bits[i], v1);
+   }
+#else
    int i;
 
    set = newCharSet();
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
-      set->bits[i] = s1->bits[i] & s2->bits[i];
+   for (i = 0; i < CHARSET_WORDS; i++) {
+      switch (op) {
+       case UNION_OP: set->bits[i] = s1->bits[i] | s2->bits[i]; break;
+       case INTERSECTION_OP: set->bits[i] = s1->bits[i] & s2->bits[i]; break;
+       case DIFFERENCE_OP: set->bits[i] = s1->bits[i] & ~s2->bits[i]; break;
+      }
    }
+#endif
    return set;
 }
 
-CharSet setDifferenceCharSet(CharSet s1, CharSet s2) {
-   CharSet set;
+/*
+ * Implementation notes: scanCharSet
+ * ---------------------------------
+ * Returns the index of the first character at or after start whose
+ * membership in the set matches the member flag, or the index of the
+ * terminating null character if there is none.  The scan stops at the
+ * terminator whether or not the set contains '\0', so the length of the
+ * string is never needed in advance.  Processors with SSSE3 classify
+ * whole blocks of characters; other processors check the characters one
+ * at a time.
+ */
+
+static int scanCharSet(CharSet set, string str, int start, bool member) {
    int i;
 
-   set = newCharSet();
-   for (i = 0; i < BIT_ARRAY_SIZE; i++) {
-      set->bits[i] = s1->bits[i] & ~s2->bits[i];
+#ifdef CHARSET_SSSE3
+   if (__builtin_cpu_supports("ssse3")) {
+      return scanBlocks(set, str, start, member);
    }
-   return set;
+#endif
+   i = start;
+   while (str[i] != '\0' && containsCharSet(set, str[i]) != member) {
+      i++;
+   }
+   return i;
 }
 
-/* Private functions */
+#ifdef CHARSET_SSSE3
+
+/*
+ * Implementation notes: scanBlocks
+ * --------------------------------
+ * This function classifies BLOCK_SIZE characters with a handful of
+ * instructions.  The low nibble of each character selects a row of both
+ * lookup tables, the high nibble selects the bit within that row, and
+ * the high nibble's top bit selects which table applies.  A second
+ * comparison finds the terminator in the same block, so the scan ends at
+ * the first character that matches or at the end of the string,
+ * whichever comes first.
+ *
+ * The blocks are aligned on BLOCK_SIZE-byte boundaries, and the bits for
+ * the characters in the first block that precede start are masked off.
+ * An aligned block never crosses a page boundary, so reading the bytes
+ * of the last block that follow the terminator cannot fault; those bytes
+ * lie outside the string, however, which is why the function is excluded
+ * from the address sanitizer.
+ */
+
+__attribute__((target("ssse3"), no_sanitize_address))
+static int scanBlocks(CharSet set, string str, int start, bool member) {
+   __m128i lowTable, highTable, bitTable, nibbleMask, seven, zero;
+   __m128i chars, lo, hi, rowLow, rowHigh, row, bit;
+   const char *block;
+   int offset, valid, mask;
+
+   if (!set->lookupValid) buildLookup(set);
+   lowTable = _mm_loadu_si128((__m128i *) set->lookup);
+   highTable = _mm_loadu_si128((__m128i *) (set->lookup + BLOCK_SIZE));
+   bitTable = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                            1, 2, 4, 8, 16, 32, 64, -128);
+   nibbleMask = _mm_set1_epi8(0x0F);
+   seven = _mm_set1_epi8(7);
+   zero = _mm_setzero_si128();
+   offset = (int) ((uintptr_t) (str + start) & (BLOCK_SIZE - 1));
+   block = str + start - offset;
+   valid = (0xFFFF << offset) & 0xFFFF;
+   while (true) {
+      chars = _mm_load_si128((__m128i *) block);
+      lo = _mm_and_si128(chars, nibbleMask);
+      hi = _mm_and_si128(_mm_srli_epi16(chars, 4), nibbleMask);
+      rowLow = _mm_shuffle_epi8(lowTable, lo);
+      rowHigh = _mm_shuffle_epi8(highTable, lo);
+      row = _mm_or_si128(_mm_andnot_si128(_mm_cmpgt_epi8(hi, seven), rowLow),
+                         _mm_and_si128(_mm_cmpgt_epi8(hi, seven), rowHigh));
+      bit = _mm_shuffle_epi8(bitTable, hi);
+      mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit));
+      if (!member) mask = ~mask & 0xFFFF;
+      mask |= _mm_movemask_epi8(_mm_cmpeq_epi8(chars, zero));
+      mask &= valid;
+      if (mask != 0) return (int) (block - str) + lowestBit(mask);
+      valid = 0xFFFF;
+      block += BLOCK_SIZE;
+   }
+}
+
+#endif
+
+static void buildLookup(CharSet set) {
+   int ch;
+
+   memset(set->lookup, 0, sizeof set->lookup);
+   for (ch = 0; ch < 256; ch++) {
+      if (containsCharSet(set, (char) ch)) {
+         set->lookup[(ch >> 7) * BLOCK_SIZE + (ch & 0x0F)] |=
+                                                1 << ((ch >> 4) & 7);
+      }
+   }
+   set->lookupValid = true;
+}
 
 static Iterator newCharSetIterator(void *collection) {
    Iterator it;
@@ -233,25 +425,38 @@ static bool stepCharSetIterator(Iterator it, void *dst) {
    return true;
 }
 
+/*
+ * Implementation notes: advanceCharSetIterator
+ * --------------------------------------------
+ * Finds the next character by masking off the bits of the characters
+ * already produced and locating the lowest remaining bit, which skips
+ * an entire word of absent characters at a time.
+ */
+
 static void advanceCharSetIterator(Iterator it) {
    CharSet set;
    int *cp;
-   long mask;
+   int next, index;
+   uint64_t word;
 
    set = (CharSet) getCollection(it);
    cp = (int *) getIteratorData(it);
    if (cp == NULL) {
       cp = newBlock(int *);
       *cp = -1;
+      setIteratorData(it, cp);
    }
-   while (++(*cp) < 256) {
-      mask = 1L << (*cp & BIT_SHIFT_MASK);
-      if (set->bits[*cp >> BIT_SHIFT_SIZE] & mask) break;
-   }
-   if (*cp == 256) {
-      freeBlock(cp);
-      setIteratorData(it, NULL);
+   next = *cp + 1;
+   for (index = next >> 6; index < CHARSET_WORDS; index++) {
+      word = set->bits[index];
+      if (index == next >> 6) word &= ~(uint64_t) 0 << (next & 0x3F);
+      if (word != 0) {
+         *cp = (index << 6) + lowestBit(word);
+         return;
+      }
    }
+   freeBlock(cp);
+   setIteratorData(it, NULL);
 }
 
 /**********************************************************************/
@@ -260,11 +465,16 @@ static void advanceCharSetIterator(Iterator it) {
 
 #ifndef _NOTEST_
 
+#include "random.h"
+
 /* Private function prototypes */
 
 static void testStringCharSet(void);
 static void testCharacterCharSet(void);
+static void testCharSetScanning(void);
+static void testRandomScanning(void);
 static CharSet createCharSet(string str);
+static string joinStringArray(string *array);
 
 /* Unit test */
 
@@ -288,6 +498,91 @@ void testCharSetModule(void) {
    trace(remove(set, 'o'));
    test(equals(vowels, createCharSet("aeiou")), true);
    test(equals(set, createCharSet("aeiu")), true);
+   test(sizeCharSet(lowercase), 26);
+   test(sizeCharSet(set), 4);
+   testCharSetScanning();
+   testRandomScanning();
+}
+
+static void testCharSetScanning(void) {
+   CharSet space, digits, high;
+   string str, *array;
+   char ch;
+
+   trace(space = createCharSet(" \t\n"));
+   trace(digits = createCharSet("0123456789"));
+   trace(high = newCharSet());
+   trace(add(high, (char) 0xE9));
+   trace(add(high, (char) 0xFF));
+   test(sizeCharSet(high), 2);
+   str = "";
+   foreach (ch in high) {
+      str = concat(str, integerToString(ch & 0xFF));
+   }
+   test(str, "233255");
+   test(spanCharSet("", space), 0);
+   test(spanCharSet("   \t  hello", space), 6);
+   test(spanCharSet("31415926535897932384626433832795 pi", digits), 32);
+   test(spanCharSet("31415926535897932384626433832795", digits), 32);
+   test(findFirstInCharSet("caf\351 au lait", high), 3);
+   test(findFirstInCharSet("the quick brown fox jumps over the lazy dog", digits),
+        -1);
+   test(findFirstInCharSet("the quick brown fox jumps over the lazy dog 1",
+                           digits), 44);
+   trace(array = splitByCharSet("  to be, or  not to be\n", space));
+   test(stringArrayLength(array), 6);
+   test(joinStringArray(array), "to/be,/or/not/to/be");
+   trace(array = splitByCharSet(" \t ", space));
+   test(stringArrayLength(array), 0);
+   trace(array = splitByCharSet("2024-06-30T12:00:00Z",
+                                setDifference(createCharSet("-:TZ"),
+                                              digits)));
+   test(joinStringArray(array), "2024/06/30/12/00/00");
+}
+
+/*
+ * Implementation notes: testRandomScanning
+ * ----------------------------------------
+ * Compares spanCharSet and findFirstInCharSet against a direct check of
+ * each character, using random sets and strings of random lengths that
+ * begin at every offset within a block.
+ */
+
+static void testRandomScanning(void) {
+   CharSet set;
+   char buffer[BLOCK_SIZE + 100], members[20];
+   string str;
+   int trial, i, len, expected, errors;
+
+   errors = 0;
+   for (trial = 0; trial < 500; trial++) {
+      set = newCharSet();
+      for (i = 0; i < 20; i++) {
+         members[i] = (char) randomInteger(1, 255);
+         addCharSet(set, members[i]);
+      }
+      str = buffer + randomInteger(0, BLOCK_SIZE - 1);
+      len = randomInteger(0, 99);
+      for (i = 0; i < len; i++) {
+         if (randomChance(0.95)) {
+            str[i] = members[randomInteger(0, 19)];
+         } else {
+            str[i] = (char) randomInteger(1, 255);
+         }
+      }
+      str[len] = '\0';
+      for (expected = 0; expected < len; expected++) {
+         if (!containsCharSet(set, str[expected])) break;
+      }
+      if (spanCharSet(str, set) != expected) errors++;
+      for (expected = 0; expected < len; expected++) {
+         if (containsCharSet(set, str[expected])) break;
+      }
+      if (expected == len) expected = -1;
+      if (findFirstInCharSet(str, set) != expected) errors++;
+      freeCharSet(set);
+   }
+   test(errors, 0);
 }
 
 static CharSet createCharSet(string str) {
@@ -298,4 +593,15 @@ static CharSet createCharSet(string str) {
    return set;
 }
 
+static string joinStringArray(string *array) {
+   string result;
+   int i;
+
+   result = "";
+   for (i = 0; array[i] != NULL; i++) {
+      result = (i == 0) ? array[i] : concat(concat(result, "/"), array[i]);
+   }
+   return result;
+}
+
 #endif
@@ -0,0 +1,633 @@
+/*
+ * File: disjointset.c
+ * -------------------
+ * This file implements the disjointset.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "cslib.h"
+#include "disjointset.h"
+#include "exception.h"
+#include "foreach.h"
+#include "graph.h"
+#include "set.h"
+#include "unittest.h"
+
+/*
+ * Type: DisjointSetCDT
+ * --------------------
+ * This type defines the concrete structure of a disjoint-set forest.
+ * Each set is a tree whose root is its representative, and the parent
+ * array links each element to its parent, with a root as its own parent.
+ * The rank of a root is an upper bound on the height of its tree.  For a
+ * forest built from a graph, elementOf maps the index of each node to
+ * its element number, or -1 for an index that no node had when the
+ * forest was built, and nodes records the node for each element, which
+ * catches a node that has taken over the index of a removed one.
+ */
+
+struct DisjointSetCDT {
+   int *parent;
+   unsigned char *rank;
+   int nElements;
+   int nSets;
+   int *elementOf;
+   int indexLimit;
+   Node *nodes;
+};
+
+/*
+ * Type: ConcurrentDisjointSetCDT
+ * ------------------------------
+ * This type defines the concrete structure of a concurrent forest.  The
+ * parent links are atomic, and a link changes only when a compare-and-
+ * swap confirms that it still holds the value the thread last read.
+ */
+
+struct ConcurrentDisjointSetCDT {
+   _Atomic int *parent;
+   int nElements;
+   atomic_int nSets;
+};
+
+/*
+ * Type: UnionTask
+ * ---------------
+ * This type describes the share of the pairs that one thread merges in
+ * unionPairsConcurrentDisjointSet.
+ */
+
+typedef struct {
+   ConcurrentDisjointSet cds;
+   int *starts;
+   int *ends;
+   int lo;
+   int hi;
+   int merged;
+} UnionTask;
+
+/* Private function prototypes */
+
+static void checkElement(int k, int n, string fnName);
+static int nodeElement(DisjointSet ds, Node node, string fnName);
+static uint32_t linkPriority(int k);
+static int findRoot(ConcurrentDisjointSet cds, int k);
+static void *unionPairsTask(void *arg);
+
+/* Exported entries */
+
+DisjointSet newDisjointSet(int n) {
+   DisjointSet ds;
+   int i;
+
+   if (n < 0) error("newDisjointSet: Size must not be negative");
+   ds = newBlock(DisjointSet);
+   ds->parent = newArray(n, int);
+   ds->rank = newArray(n, unsigned char);
+   for (i = 0; i < n; i++) {
+      ds->parent[i] = i;
+      ds->rank[i] = 0;
+   }
+   ds->nElements = n;
+   ds->nSets = n;
+   ds->elementOf = NULL;
+   ds->indexLimit = 0;
+   ds->nodes = NULL;
+   return ds;
+}
+
+DisjointSet newDisjointSetFromGraph(Graph g) {
+   DisjointSet ds;
+   Node node;
+   int i;
+
+   ds = newDisjointSet(sizeSet(getNodeSet(g)));
+   ds->indexLimit = getNodeIndexLimit(g);
+   ds->elementOf = newArray(ds->indexLimit + 1, int);
+   ds->nodes = newArray(ds->nElements + 1, Node);
+   for (i = 0; i < ds->indexLimit; i++) {
+      ds->elementOf[i] = -1;
+   }
+   i = 0;
+   foreach (node in getNodeSet(g)) {
+      ds->elementOf[getNodeIndex(node)] = i;
+      ds->nodes[i++] = node;
+   }
+   return ds;
+}
+
+void freeDisjointSet(DisjointSet ds) {
+   if (ds->nodes != NULL) {
+      freeBlock(ds->elementOf);
+      freeBlock(ds->nodes);
+   }
+   freeBlock(ds->parent);
+   freeBlock(ds->rank);
+   freeBlock(ds);
+}
+
+int sizeDisjointSet(DisjointSet ds) {
+   return ds->nElements;
+}
+
+int countDisjointSets(DisjointSet ds) {
+   return ds->nSets;
+}
+
+/*
+ * Implementation notes: findDisjointSet
+ * -------------------------------------
+ * The first pass finds the root, and the second links every element on
+ * the path directly to it, so that later searches from any of those
+ * elements take a single step.
+ */
+
+int findDisjointSet(DisjointSet ds, int k) {
+   int root, next;
+
+   checkElement(k, ds->nElements, "findDisjointSet");
+   root = k;
+   while (ds->parent[root] != root) {
+      root = ds->parent[root];
+   }
+   while (ds->parent[k] != root) {
+      next = ds->parent[k];
+      ds->parent[k] = root;
+      k = next;
+   }
+   return root;
+}
+
+/*
+ * Implementation notes: unionDisjointSet
+ * --------------------------------------
+ * The root of lower rank becomes a child of the other, so that a tree's
+ * height grows only when two trees of equal rank are merged, which keeps
+ * every tree logarithmic in height even before path compression.
+ */
+
+bool unionDisjointSet(DisjointSet ds, int k1, int k2) {
+   int r1, r2, tmp;
+
+   r1 = findDisjointSet(ds, k1);
+   r2 = findDisjointSet(ds, k2);
+   if (r1 == r2) return false;
+   if (ds->rank[r1] < ds->rank[r2]) {
+      tmp = r1;
+      r1 = r2;
+      r2 = tmp;
+   }
+   ds->parent[r2] = r1;
+   if (ds->rank[r1] == ds->rank[r2]) ds->rank[r1]++;
+   ds->nSets--;
+   return true;
+}
+
+bool sameSetDisjointSet(DisjointSet ds, int k1, int k2) {
+   return findDisjointSet(ds, k1) == findDisjointSet(ds, k2);
+}
+
+int unionPairsDisjointSet(DisjointSet ds, int starts[], int ends[], int n) {
+   int i, merged;
+
+   merged = 0;
+   for (i = 0; i < n; i++) {
+      if (unionDisjointSet(ds, starts[i], ends[i])) merged++;
+   }
+   return merged;
+}
+
+int findNodeDisjointSet(DisjointSet ds, Node node) {
+   return findDisjointSet(ds, nodeElement(ds, node, "findNodeDisjointSet"));
+}
+
+bool unionNodesDisjointSet(DisjointSet ds, Node n1, Node n2) {
+   return unionDisjointSet(ds, nodeElement(ds, n1, "unionNodesDisjointSet"),
+                               nodeElement(ds, n2, "unionNodesDisjointSet"));
+}
+
+int unionArcsDisjointSet(DisjointSet ds, Arc arcs[], int n) {
+   int i, k1, k2, merged;
+
+   merged = 0;
+   for (i = 0; i < n; i++) {
+      k1 = nodeElement(ds, startOfArc(arcs[i]), "unionArcsDisjointSet");
+      k2 = nodeElement(ds, endOfArc(arcs[i]), "unionArcsDisjointSet");
+      if (unionDisjointSet(ds, k1, k2)) merged++;
+   }
+   return merged;
+}
+
+ConcurrentDisjointSet newConcurrentDisjointSet(int n) {
+   ConcurrentDisjointSet cds;
+   int i;
+
+   if (n < 0) error("newConcurrentDisjointSet: Size must not be negative");
+   cds = newBlock(ConcurrentDisjointSet);
+   cds->parent = newArray(n, _Atomic int);
+   for (i = 0; i < n; i++) {
+      atomic_init(&cds->parent[i], i);
+   }
+   cds->nElements = n;
+   atomic_init(&cds->nSets, n);
+   return cds;
+}
+
+void freeConcurrentDisjointSet(ConcurrentDisjointSet cds) {
+   freeBlock((void *) cds->parent);
+   freeBlock(cds);
+}
+
+int sizeConcurrentDisjointSet(ConcurrentDisjointSet cds) {
+   return cds->nElements;
+}
+
+int countConcurrentDisjointSets(ConcurrentDisjointSet cds) {
+   return atomic_load(&cds->nSets);
+}
+
+int findConcurrentDisjointSet(ConcurrentDisjointSet cds, int k) {
+   checkElement(k, cds->nElements, "findConcurrentDisjointSet");
+   return findRoot(cds, k);
+}
+
+/*
+ * Implementation notes: unionConcurrentDisjointSet
+ * ------------------------------------------------
+ * A thread merges two sets by swinging the parent link of one root from
+ * the root itself to the other root.  The compare-and-swap fails if
+ * another thread has meanwhile made that root a child, in which case the
+ * thread finds the roots again and retries.  Ranks cannot be kept
+ * consistent with the links without a lock, so the root that becomes the
+ * child is chosen by a fixed pseudorandom priority of each element,
+ * which keeps the expected height of the trees logarithmic.  Because the
+ * priorities form a total order that links always respect, no sequence
+ * of links can create a cycle.
+ */
+
+bool unionConcurrentDisjointSet(ConcurrentDisjointSet cds, int k1, int k2) {
+   int r1, r2, tmp, expected;
+
+   checkElement(k1, cds->nElements, "unionConcurrentDisjointSet");
+   checkElement(k2, cds->nElements, "unionConcurrentDisjointSet");
+   while (true) {
+      r1 = findRoot(cds, k1);
+      r2 = findRoot(cds, k2);
+      if (r1 == r2) return false;
+      if (linkPriority(r1) > linkPriority(r2)) {
+         tmp = r1;
+         r1 = r2;
+         r2 = tmp;
+      }
+      expected = r1;
+      if (atomic_compare_exchange_strong(&cds->parent[r1], &expected, r2)) {
+         atomic_fetch_sub(&cds->nSets, 1);
+         return true;
+      }
+   }
+}
+
+/*
+ * Implementation notes: sameSetConcurrentDisjointSet
+ * --------------------------------------------------
+ * Different roots prove that the elements were in different sets only
+ * if the first root is still a root after the second has been found;
+ * otherwise a merge intervened and the test must be repeated.
+ */
+
+bool sameSetConcurrentDisjointSet(ConcurrentDisjointSet cds, int k1, int k2) {
+   int r1, r2;
+
+   checkElement(k1, cds->nElements, "sameSetConcurrentDisjointSet");
+   checkElement(k2, cds->nElements, "sameSetConcurrentDisjointSet");
+   while (true) {
+      r1 = findRoot(cds, k1);
+      r2 = findRoot(cds, k2);
+      if (r1 == r2) return true;
+      if (atomic_load(&cds->parent[r1]) == r1) return false;
+   }
+}
+
+int unionPairsConcurrentDisjointSet(ConcurrentDisjointSet cds,
+                                    int starts[], int ends[], int n,
+                                    int nThreads) {
+   pthread_t *threads;
+   UnionTask *tasks;
+   int i, merged;
+
+   if (nThreads < 1) error("unionPairsConcurrentDisjointSet: No threads");
+   if (nThreads > n) nThreads = (n == 0) ? 1 : n;
+   threads = newArray(nThreads, pthread_t);
+   tasks = newArray(nThreads, UnionTask);
+   for (i = 0; i < nThreads; i++) {
+      tasks[i].cds = cds;
+      tasks[i].starts = starts;
+      tasks[i].ends = ends;
+      tasks[i].lo = (int) ((long) n * i / nThreads);
+      tasks[i].hi = (int) ((long) n * (i + 1) / nThreads);
+      tasks[i].merged = 0;
+   }
+   for (i = 1; i < nThreads; i++) {
+      pthread_create(&threads[i], NULL, unionPairsTask, &tasks[i]);
+   }
+   unionPairsTask(&tasks[0]);
+   merged = tasks[0].merged;
+   for (i = 1; i < nThreads; i++) {
+      pthread_join(threads[i], NULL);
+      merged += tasks[i].merged;
+   }
+   freeBlock(threads);
+   freeBlock(tasks);
+   return merged;
+}
+
+/* Private functions */
+
+static void checkElement(int k, int n, string fnName) {
+   if (k < 0 || k >= n) error("%s: Element %d out of range", fnName, k);
+}
+
+static int nodeElement(DisjointSet ds, Node node, string fnName) {
+   int index, k;
+
+   if (ds->nodes == NULL) error("%s: Forest has no graph", fnName);
+   index = getNodeIndex(node);
+   k = (index < ds->indexLimit) ? ds->elementOf[index] : -1;
+   if (k == -1 || ds->nodes[k] != node) {
+      error("%s: Node %s is not in the forest", fnName, getName(node));
+   }
+   return k;
+}
+
+/*
+ * Implementation notes: linkPriority
+ * ----------------------------------
+ * Scrambles the bits of k with an invertible function, so that distinct
+ * elements always have distinct priorities.
+ */
+
+static uint32_t linkPriority(int k) {
+   uint32_t x;
+
+   x = (uint32_t) k;
+   x ^= x >> 16;
+   x *= 0x7FEB352DU;
+   x ^= x >> 15;
+   x *= 0x846CA68BU;
+   x ^= x >> 16;
+   return x;
+}
+
+/*
+ * Implementation notes: findRoot
+ * ------------------------------
+ * Full path compression would require a second pass over links that
+ * other threads may be changing, so the concurrent version uses path
+ * halving instead, which links each element it visits to its
+ * grandparent.  A failed compare-and-swap means that another thread has
+ * already shortened the link, which is just as good.
+ */
+
+static int findRoot(ConcurrentDisjointSet cds, int k) {
+   int parent, grandparent;
+
+   while (true) {
+      parent = atomic_load(&cds->parent[k]);
+      if (parent == k) return k;
+      grandparent = atomic_load(&cds->parent[parent]);
+      if (grandparent == parent) return parent;
+      atomic_compare_exchange_weak(&cds->parent[k], &parent, grandparent);
+      k = grandparent;
+   }
+}
+
+static void *unionPairsTask(void *arg) {
+   UnionTask *task;
+   int i;
+
+   task = (UnionTask *) arg;
+   for (i = task->lo; i < task->hi; i++) {
+      if (unionConcurrentDisjointSet(task->cds, task->starts[i],
+                                                task->ends[i])) {
+         task->merged++;
+      }
+   }
+   return NULL;
+}
+
+/**********************************************************************/
+/* Unit test for the disjointset module                               */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+#include "random.h"
+
+#define N_ELEMENTS 1000
+#define N_PAIRS 800
+
+/* Private function prototypes */
+
+static void testSimpleUnions(void);
+static void testAgainstLabels(void);
+static void testGraphComponents(void);
+static void testConcurrentUnions(void);
+static void testGenericFunctions(void);
+
+/* Unit test */
+
+void testDisjointSetModule(void) {
+   testSimpleUnions();
+   testAgainstLabels();
+   testGraphComponents();
+   testConcurrentUnions();
+   testGenericFunctions();
+}
+
+static void testSimpleUnions(void) {
+   DisjointSet ds;
+
+   trace(ds = newDisjointSet(6));
+   test(countDisjointSets(ds), 6);
+   test(unionDisjointSet(ds, 0, 1), true);
+   test(unionDisjointSet(ds, 2, 3), true);
+   test(unionDisjointSet(ds, 1, 0), false);
+   test(sameSetDisjointSet(ds, 0, 2), false);
+   test(unionDisjointSet(ds, 1, 3), true);
+   test(sameSetDisjointSet(ds, 0, 2), true);
+   test(findDisjointSet(ds, 3) == findDisjointSet(ds, 0), true);
+   test(sameSetDisjointSet(ds, 4, 5), false);
+   test(countDisjointSets(ds), 3);
+   test(sizeDisjointSet(ds), 6);
+   trace(freeDisjointSet(ds));
+}
+
+/*
+ * Implementation notes: testAgainstLabels
+ * ---------------------------------------
+ * Checks the forest against a simple partition in which each element
+ * has a label and a merge relabels every element of one of the sets.
+ */
+
+static void testAgainstLabels(void) {
+   DisjointSet ds;
+   int labels[N_ELEMENTS];
+   int starts[N_PAIRS], ends[N_PAIRS];
+   int i, j, old, nSets, merged, errors;
+
+   ds = newDisjointSet(N_ELEMENTS);
+   for (i = 0; i < N_ELEMENTS; i++) {
+      labels[i] = i;
+   }
+   nSets = N_ELEMENTS;
+   for (i = 0; i < N_PAIRS; i++) {
+      starts[i] = randomInteger(0, N_ELEMENTS - 1);
+      ends[i] = randomInteger(0, N_ELEMENTS - 1);
+      old = labels[starts[i]];
+      if (old != labels[ends[i]]) {
+         nSets--;
+         for (j = 0; j < N_ELEMENTS; j++) {
+            if (labels[j] == old) labels[j] = labels[ends[i]];
+         }
+      }
+   }
+   merged = unionPairsDisjointSet(ds, starts, ends, N_PAIRS);
+   test(merged == N_ELEMENTS - nSets, true);
+   test(countDisjointSets(ds) == nSets, true);
+   errors = 0;
+   for (i = 0; i < N_ELEMENTS; i++) {
+      j = randomInteger(0, N_ELEMENTS - 1);
+      if (sameSetDisjointSet(ds, i, j) != (labels[i] == labels[j])) {
+         errors++;
+      }
+   }
+   test(errors, 0);
+   freeDisjointSet(ds);
+}
+
+static void testGraphComponents(void) {
+   Graph g;
+   DisjointSet ds;
+   Arc arcs[4];
+
+   trace(g = newGraph());
+   trace(arcs[0] = addArc(g, addNode(g, "A"), addNode(g, "B")));
+   trace(arcs[1] = addArc(g, getNode(g, "B"), addNode(g, "C")));
+   trace(arcs[2] = addArc(g, addNode(g, "D"), addNode(g, "E")));
+   trace(arcs[3] = addArc(g, getNode(g, "C"), getNode(g, "A")));
+   trace(addNode(g, "F"));
+   trace(ds = newDisjointSetFromGraph(g));
+   test(sizeDisjointSet(ds), 6);
+   test(unionArcsDisjointSet(ds, arcs, 4), 3);
+   test(countDisjointSets(ds), 3);
+   test(findNodeDisjointSet(ds, getNode(g, "A"))
+        == findNodeDisjointSet(ds, getNode(g, "C")), true);
+   test(findNodeDisjointSet(ds, getNode(g, "A"))
+        == findNodeDisjointSet(ds, getNode(g, "D")), false);
+   test(unionNodesDisjointSet(ds, getNode(g, "E"), getNode(g, "F")), true);
+   test(countDisjointSets(ds), 2);
+   trace(freeDisjointSet(ds));
+   trace(freeGraph(g));
+}
+
+/*
+ * Implementation notes: testConcurrentUnions
+ * ------------------------------------------
+ * Merges the same random pairs in a sequential forest and in a
+ * concurrent forest shared by four threads, and checks that the two
+ * partitions agree.
+ */
+
+static void testConcurrentUnions(void) {
+   DisjointSet ds;
+   ConcurrentDisjointSet cds;
+   int *starts, *ends;
+   int i, j, n, nElements, merged, errors;
+
+   nElements = 20 * N_ELEMENTS;
+   n = 20 * N_ELEMENTS;
+   starts = newArray(n, int);
+   ends = newArray(n, int);
+   for (i = 0; i < n; i++) {
+      starts[i] = randomInteger(0, nElements - 1);
+      ends[i] = randomInteger(0, nElements - 1);
+   }
+   ds = newDisjointSet(nElements);
+   cds = newConcurrentDisjointSet(nElements);
+   merged = unionPairsConcurrentDisjointSet(cds, starts, ends, n, 4);
+   test(merged == unionPairsDisjointSet(ds, starts, ends, n), true);
+   test(countConcurrentDisjointSets(cds) == countDisjointSets(ds), true);
+   errors = 0;
+   for (i = 0; i < n; i++) {
+      j = randomInteger(0, nElements - 1);
+      if (sameSetConcurrentDisjointSet(cds, starts[i], j)
+            != sameSetDisjointSet(ds, starts[i], j)) {
+         errors++;
+      }
+   }
+   test(errors, 0);
+   freeDisjointSet(ds);
+   freeConcurrentDisjointSet(cds);
+   freeBlock(starts);
+   freeBlock(ends);
+}
+
+/*
+ * Implementation notes: testGenericFunctions
+ * ------------------------------------------
+ * Checks that the generic functions recognize both kinds of forest
+ * instead of treating them as instances of Set, whose type names share
+ * the same suffix.
+ */
+
+static void testGenericFunctions(void) {
+   DisjointSet ds;
+   ConcurrentDisjointSet cds;
+   string msg;
+
+   trace(ds = newDisjointSet(6));
+   trace(unionDisjointSet(ds, 0, 1));
+   test(size(ds), 6);
+   test(isEmpty(ds), false);
+   msg = "";
+   try {
+      clear(ds);
+   } catch (ErrorException) {
+      msg = (string) getExceptionValue();
+   } endtry
+   test(msg, "clear: Unrecognized type DisjointSet");
+   test(countDisjointSets(ds), 5);
+   trace(freeDisjointSet(ds));
+   trace(ds = newDisjointSet(0));
+   test(size(ds), 0);
+   test(isEmpty(ds), true);
+   trace(freeDisjointSet(ds));
+   trace(cds = newConcurrentDisjointSet(4));
+   test(size(cds), 4);
+   test(isEmpty(cds), false);
+   test(sizeConcurrentDisjointSet(cds), 4);
+   trace(freeConcurrentDisjointSet(cds));
+}
+
+#endif
@@ -0,0 +1,617 @@
+/*
+ * File: flatmap.c
+ * ---------------
+ * This file implements the flatmap.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmpfn.h"
+#include "cslib.h"
+#include "flatmap.h"
+#include "foreach.h"
+#include "generic.h"
+#include "iterator.h"
+#include "itertype.h"
+#include "strlib.h"
+#include "unittest.h"
+
+/*
+ * Constants
+ * ---------
+ * INITIAL_CAPACITY -- Initial number of entries allocated
+ * LINEAR_LIMIT     -- Largest number of prefixes searched linearly
+ */
+
+#define INITIAL_CAPACITY 8
+#define LINEAR_LIMIT 16
+
+/*
+ * Type: FlatMapCDT
+ * ----------------
+ * This type defines the concrete structure of the map, which consists of
+ * three parallel arrays sorted by key.  The prefixes array holds the
+ * first eight bytes of each key packed into an integer with the first
+ * byte most significant, so that comparing two prefixes as integers
+ * gives the same result as comparing the beginnings of the keys.  Most
+ * searches never look beyond this array, and the keys themselves are
+ * compared only to distinguish keys that share a prefix.
+ */
+
+struct FlatMapCDT {
+   IteratorHeader header;
+   uint64_t *prefixes;
+   string *keys;
+   void **values;
+   int count;
+   int capacity;
+};
+
+/*
+ * Type: FlatMapRange
+ * ------------------
+ * This type holds the state of a range iterator, which is the index of
+ * the next key and the index just past the last one.
+ */
+
+typedef struct {
+   int next;
+   int limit;
+} FlatMapRange;
+
+/* Private function prototypes */
+
+static uint64_t keyPrefix(string key);
+static int countPrefixesBelow(FlatMap map, uint64_t prefix, bool inclusive);
+static int lowerBound(FlatMap map, string key);
+static int findKey(FlatMap map, string key);
+static void expandCapacity(FlatMap map, int capacity);
+static void insertEntry(FlatMap map, int index, string key, void *value);
+static void removeEntry(FlatMap map, int index);
+static void rebuildFlatMap(FlatMap map, GenericType keys[], void *values[],
+                                        int n);
+static bool stepRangeIterator(Iterator iterator, void *dst);
+static Iterator newForeachIterator(void *collection);
+
+/* Exported entries */
+
+FlatMap newFlatMap(void) {
+   FlatMap map;
+
+   map = newBlock(FlatMap);
+   enableIteration(map, newForeachIterator);
+   map->count = 0;
+   map->capacity = 0;
+   map->prefixes = NULL;
+   map->keys = NULL;
+   map->values = NULL;
+   expandCapacity(map, INITIAL_CAPACITY);
+   return map;
+}
+
+void freeFlatMap(FlatMap map) {
+   clearFlatMap(map);
+   freeBlock(map->prefixes);
+   freeBlock(map->keys);
+   freeBlock(map->values);
+   freeBlock(map);
+}
+
+int sizeFlatMap(FlatMap map) {
+   return map->count;
+}
+
+bool isEmptyFlatMap(FlatMap map) {
+   return map->count == 0;
+}
+
+void clearFlatMap(FlatMap map) {
+   int i;
+
+   for (i = 0; i < map->count; i++) {
+      freeBlock(map->keys[i]);
+   }
+   map->count = 0;
+}
+
+FlatMap cloneFlatMap(FlatMap map) {
+   FlatMap newmap;
+   int i;
+
+   newmap = newFlatMap();
+   expandCapacity(newmap, map->count);
+   for (i = 0; i < map->count; i++) {
+      newmap->prefixes[i] = map->prefixes[i];
+      newmap->keys[i] = copyString(map->keys[i]);
+      newmap->values[i] = map->values[i];
+   }
+   newmap->count = map->count;
+   return newmap;
+}
+
+void putFlatMap(FlatMap map, string key, void *value) {
+   int index;
+
+   index = lowerBound(map, key);
+   if (index < map->count && stringEqual(map->keys[index], key)) {
+      map->values[index] = value;
+   } else {
+      insertEntry(map, index, key, value);
+   }
+}
+
+/*
+ * Implementation notes: putAllFlatMap
+ * -----------------------------------
+ * The new entries are sorted with a stable sort, so that removing the
+ * duplicates keeps the value supplied last, and then merged with the
+ * existing entries, with the new value taking precedence for a key in
+ * both.  The strategy matches the one that putAllMap uses.
+ */
+
+void putAllFlatMap(FlatMap map, string keys[], void *values[], int n) {
+   GenericType *newKeys, *allKeys;
+   void **newValues, **allValues;
+   int i, j, nAll, sign;
+
+   newKeys = newArray(n, GenericType);
+   newValues = newArray(n, void *);
+   for (i = 0; i < n; i++) {
+      newKeys[i].pointerRep = keys[i];
+      newValues[i] = values[i];
+   }
+   sortGenericArray(newKeys, newValues, n, stringCmpFn);
+   n = uniqueGenericArray(newKeys, newValues, n, stringCmpFn);
+   allKeys = newArray(map->count + n, GenericType);
+   allValues = newArray(map->count + n, void *);
+   nAll = i = j = 0;
+   while (i < map->count || j < n) {
+      if (j == n) {
+         sign = -1;
+      } else if (i == map->count) {
+         sign = +1;
+      } else {
+         sign = stringCompare(map->keys[i], newKeys[j].pointerRep);
+      }
+      if (sign < 0) {
+         allKeys[nAll].pointerRep = copyString(map->keys[i]);
+         allValues[nAll++] = map->values[i++];
+      } else {
+         allKeys[nAll].pointerRep = copyString(newKeys[j].pointerRep);
+         allValues[nAll++] = newValues[j++];
+         if (sign == 0) i++;
+      }
+   }
+   rebuildFlatMap(map, allKeys, allValues, nAll);
+   freeBlock(newKeys);
+   freeBlock(newValues);
+   freeBlock(allKeys);
+   freeBlock(allValues);
+}
+
+void *getFlatMap(FlatMap map, string key) {
+   int index;
+
+   index = findKey(map, key);
+   return (index < 0) ? NULL : map->values[index];
+}
+
+bool containsKeyFlatMap(FlatMap map, string key) {
+   return findKey(map, key) >= 0;
+}
+
+void removeFlatMap(FlatMap map, string key) {
+   int index;
+
+   index = findKey(map, key);
+   if (index >= 0) removeEntry(map, index);
+}
+
+int rankFlatMap(FlatMap map, string key) {
+   return lowerBound(map, key);
+}
+
+string selectFlatMap(FlatMap map, int k) {
+   if (k < 0 || k >= map->count) error("selectFlatMap: Index out of range");
+   return map->keys[k];
+}
+
+string floorKeyFlatMap(FlatMap map, string key) {
+   int index;
+
+   index = lowerBound(map, key);
+   if (index < map->count && stringEqual(map->keys[index], key)) {
+      return map->keys[index];
+   }
+   return (index == 0) ? NULL : map->keys[index - 1];
+}
+
+string ceilingKeyFlatMap(FlatMap map, string key) {
+   int index;
+
+   index = lowerBound(map, key);
+   return (index == map->count) ? NULL : map->keys[index];
+}
+
+string firstKeyFlatMap(FlatMap map) {
+   return (map->count == 0) ? NULL : map->keys[0];
+}
+
+string lastKeyFlatMap(FlatMap map) {
+   return (map->count == 0) ? NULL : map->keys[map->count - 1];
+}
+
+Iterator newFlatMapRangeIterator(FlatMap map, string lo, string hi) {
+   Iterator iterator;
+   FlatMapRange *range;
+
+   range = newBlock(FlatMapRange *);
+   range->next = (lo == NULL) ? 0 : lowerBound(map, lo);
+   range->limit = map->count;
+   if (hi != NULL) {
+      range->limit = lowerBound(map, hi);
+      if (range->limit < map->count
+            && stringEqual(map->keys[range->limit], hi)) {
+         range->limit++;
+      }
+   }
+   iterator = newStepIterator(sizeof(string), stepRangeIterator);
+   setCollection(iterator, map);
+   setIteratorData(iterator, range);
+   return iterator;
+}
+
+void mapFlatMap(FlatMap map, proc fn, void *data) {
+   int i;
+
+   for (i = 0; i < map->count; i++) {
+      fn(map->keys[i], map->values[i], data);
+   }
+}
+
+/* Private functions */
+
+/*
+ * Implementation notes: keyPrefix
+ * -------------------------------
+ * A key shorter than eight bytes is padded with zeros, which sort before
+ * every other character just as the end of a string does in strcmp.
+ */
+
+static uint64_t keyPrefix(string key) {
+   uint64_t prefix;
+   int i;
+
+   prefix = 0;
+   for (i = 0; i < 8 && key[i] != '\0'; i++) {
+      prefix |= (uint64_t) (unsigned char) key[i] << (56 - 8 * i);
+   }
+   return prefix;
+}
+
+/*
+ * Implementation notes: countPrefixesBelow
+ * ----------------------------------------
+ * Returns the number of prefixes less than prefix, or less than or equal
+ * to it if inclusive is true.  For small maps, the function counts the
+ * matching prefixes in a single loop with no branches that depend on the
+ * data, which compilers turn into vector comparisons.  For larger maps,
+ * it uses a binary search in which each step moves the base of the range
+ * with a conditional move rather than a branch, so that the processor
+ * never mispredicts the direction of the search.
+ */
+
+static int countPrefixesBelow(FlatMap map, uint64_t prefix, bool inclusive) {
+   const uint64_t *base;
+   int i, n, half, count;
+
+   n = map->count;
+   if (inclusive) {
+      if (prefix == UINT64_MAX) return n;
+      prefix++;
+   }
+   if (n <= LINEAR_LIMIT) {
+      count = 0;
+      for (i = 0; i < n; i++) {
+         count += (map->prefixes[i] < prefix);
+      }
+      return count;
+   }
+   base = map->prefixes;
+   while (n > 1) {
+      half = n / 2;
+      base = (base[half] < prefix) ? base + half : base;
+      n -= half;
+   }
+   return (int) (base - map->prefixes) + (*base < prefix);
+}
+
+/*
+ * Implementation notes: lowerBound
+ * --------------------------------
+ * Returns the index of the first key that is greater than or equal to
+ * key.  The keys whose prefix matches the prefix of key occupy a range
+ * of the array, which is usually empty or a single entry; only within
+ * that range does the search compare full keys.
+ */
+
+static int lowerBound(FlatMap map, string key) {
+   uint64_t prefix;
+   int lh, rh, mid;
+
+   prefix = keyPrefix(key);
+   lh = countPrefixesBelow(map, prefix, false);
+   if (lh == map->count || map->prefixes[lh] != prefix) return lh;
+   rh = countPrefixesBelow(map, prefix, true);
+   while (lh < rh) {
+      mid = (lh + rh) / 2;
+      if (stringCompare(map->keys[mid], key) < 0) {
+         lh = mid + 1;
+      } else {
+         rh = mid;
+      }
+   }
+   return lh;
+}
+
+static int findKey(FlatMap map, string key) {
+   int index;
+
+   index = lowerBound(map, key);
+   if (index < map->count && stringEqual(map->keys[index], key)) {
+      return index;
+   }
+   return -1;
+}
+
+static void expandCapacity(FlatMap map, int capacity) {
+   uint64_t *prefixes;
+   string *keys;
+   void **values;
+
+   if (capacity <= map->capacity) return;
+   prefixes = newArray(capacity, uint64_t);
+   keys = newArray(capacity, string);
+   values = newArray(capacity, void *);
+   if (map->count > 0) {
+      memcpy(prefixes, map->prefixes, map->count * sizeof(uint64_t));
+      memcpy(keys, map->keys, map->count * sizeof(string));
+      memcpy(values, map->values, map->count * sizeof(void *));
+   }
+   if (map->prefixes != NULL) {
+      freeBlock(map->prefixes);
+      freeBlock(map->keys);
+      freeBlock(map->values);
+   }
+   map->prefixes = prefixes;
+   map->keys = keys;
+   map->values = values;
+   map->capacity = capacity;
+}
+
+static void insertEntry(FlatMap map, int index, string key, void *value) {
+   int n;
+
+   if (map->count == map->capacity) expandCapacity(map, 2 * map->capacity);
+   n = map->count - index;
+   memmove(map->prefixes + index + 1, map->prefixes + index,
+           n * sizeof(uint64_t));
+   memmove(map->keys + index + 1, map->keys + index, n * sizeof(string));
+   memmove(map->values + index + 1, map->values + index, n * sizeof(void *));
+   map->prefixes[index] = keyPrefix(key);
+   map->keys[index] = copyString(key);
+   map->values[index] = value;
+   map->count++;
+}
+
+static void removeEntry(FlatMap map, int index) {
+   int n;
+
+   freeBlock(map->keys[index]);
+   n = map->count - index - 1;
+   memmove(map->prefixes + index, map->prefixes + index + 1,
+           n * sizeof(uint64_t));
+   memmove(map->keys + index, map->keys + index + 1, n * sizeof(string));
+   memmove(map->values + index, map->values + index + 1, n * sizeof(void *));
+   map->count--;
+}
+
+/*
+ * Implementation notes: rebuildFlatMap
+ * ------------------------------------
+ * Replaces the contents of the map with n sorted, distinct entries whose
+ * keys have already been copied.
+ */
+
+static void rebuildFlatMap(FlatMap map, GenericType keys[], void *values[],
+                                        int n) {
+   int i;
+
+   clearFlatMap(map);
+   expandCapacity(map, n);
+   for (i = 0; i < n; i++) {
+      map->keys[i] = keys[i].pointerRep;
+      map->prefixes[i] = keyPrefix(map->keys[i]);
+      map->values[i] = values[i];
+   }
+   map->count = n;
+}
+
+static bool stepRangeIterator(Iterator iterator, void *dst) {
+   FlatMap map;
+   FlatMapRange *range;
+
+   range = (FlatMapRange *) getIteratorData(iterator);
+   if (range == NULL) return false;
+   if (range->next >= range->limit) {
+      freeBlock(range);
+      setIteratorData(iterator, NULL);
+      return false;
+   }
+   map = (FlatMap) getCollection(iterator);
+   *((string *) dst) = map->keys[range->next++];
+   return true;
+}
+
+static Iterator newForeachIterator(void *collection) {
+   return newFlatMapRangeIterator((FlatMap) collection, NULL, NULL);
+}
+
+/**********************************************************************/
+/* Unit test for the flatmap module                                   */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+#include "map.h"
+
+/* Private function prototypes */
+
+static void testElementMap(void);
+static void testSharedPrefixes(void);
+static void testAgainstMap(void);
+
+/* Unit test */
+
+void testFlatMapModule(void) {
+   testElementMap();
+   testSharedPrefixes();
+   testAgainstMap();
+}
+
+static void testElementMap(void) {
+   FlatMap map, copy;
+   string keys[] = { "H", "He", "Li", "Be", "H", "C" };
+   string values[] = { "Hydrogen", "Helium", "Lithium", "Beryllium",
+                       "hydrogen", "Carbon" };
+   string key, str;
+
+   trace(map = newFlatMap());
+   test(isEmpty(map), true);
+   test(firstKeyFlatMap(map), NULL);
+   trace(putAllFlatMap(map, keys, (void **) values, 6));
+   test(size(map), 5);
+   test(get(map, "H"), "hydrogen");
+   test(get(map, "Xe"), NULL);
+   trace(put(map, "N", "Nitrogen"));
+   trace(put(map, "B", "Boron"));
+   test(size(map), 7);
+   trace(str = "");
+   trace(foreach (key in map) str = concat(str, key));
+   test(str, "BBeCHHeLiN");
+   test(rankFlatMap(map, "C"), 2);
+   test(rankFlatMap(map, "Ca"), 3);
+   test(selectFlatMap(map, 4), "He");
+   test(floorKeyFlatMap(map, "Ca"), "C");
+   test(ceilingKeyFlatMap(map, "Ca"), "H");
+   test(floorKeyFlatMap(map, "A"), NULL);
+   test(ceilingKeyFlatMap(map, "O"), NULL);
+   test(lastKeyFlatMap(map), "N");
+   trace(str = "");
+   trace(foreach (key in newFlatMapRangeIterator(map, "Be", "He")) {
+      str = concat(str, key);
+   });
+   test(str, "BeCHHe");
+   trace(copy = clone(map));
+   trace(remove(map, "C"));
+   test(containsKey(map, "C"), false);
+   test(containsKey(copy, "C"), true);
+   test(size(copy), 7);
+   trace(clear(map));
+   test(size(map), 0);
+   trace(freeFlatMap(map));
+   trace(freeFlatMap(copy));
+}
+
+/*
+ * Implementation notes: testSharedPrefixes
+ * ----------------------------------------
+ * Uses keys that agree in their first eight bytes, which the search must
+ * distinguish by comparing the full keys, as well as keys that are
+ * shorter than eight bytes.
+ */
+
+static void testSharedPrefixes(void) {
+   FlatMap map;
+   string key;
+   int i;
+
+   map = newFlatMap();
+   for (i = 0; i < 100; i++) {
+      key = concat("/api/v1/users/", integerToString(i));
+      putFlatMap(map, key, key);
+   }
+   putFlatMap(map, "/api", "short");
+   putFlatMap(map, "/api/v1", "eight");
+   putFlatMap(map, "/api/v1/", "nine");
+   test(sizeFlatMap(map), 103);
+   test(getFlatMap(map, "/api/v1/users/42"), "/api/v1/users/42");
+   test(getFlatMap(map, "/api/v1/users/420"), NULL);
+   test(getFlatMap(map, "/api/v1"), "eight");
+   test(getFlatMap(map, "/api/v1/"), "nine");
+   test(getFlatMap(map, "/api/v"), NULL);
+   test(firstKeyFlatMap(map), "/api");
+   test(selectFlatMap(map, 3), "/api/v1/users/0");
+   test(rankFlatMap(map, "/api/v1/users/5"), 48);
+   trace(freeFlatMap(map));
+}
+
+/*
+ * Implementation notes: testAgainstMap
+ * ------------------------------------
+ * Performs the same insertions and deletions on a FlatMap and a Map and
+ * checks that they agree on every key and on the order of iteration.
+ */
+
+static void testAgainstMap(void) {
+   FlatMap flat;
+   Map map;
+   Iterator it;
+   string key, expected;
+   int i, errors;
+
+   flat = newFlatMap();
+   map = newMap();
+   for (i = 0; i < 1000; i++) {
+      key = integerToString((i * 7919) % 1009);
+      put(flat, key, key);
+      put(map, key, key);
+   }
+   for (i = 0; i < 1000; i += 3) {
+      key = integerToString((i * 7919) % 1009);
+      remove(flat, key);
+      remove(map, key);
+   }
+   test(size(flat) == size(map), true);
+   errors = 0;
+   it = newIterator(map);
+   foreach (key in flat) {
+      if (!stepIterator(it, &expected) || !stringEqual(key, expected)) {
+         errors++;
+      }
+      if (get(flat, key) != get(map, key)) errors++;
+   }
+   if (stepIterator(it, &expected)) errors++;
+   test(errors, 0);
+}
+
+#endif
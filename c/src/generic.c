@@ -25,15 +25,19 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include "bitvector.h"
 #include "charset.h"
 #include "cmpfn.h"
 #include "cslib.h"
+#include "disjointset.h"
 #include "exception.h"
+#include "flatmap.h"
 #include "generic.h"
 #include "gevents.h"
 #include "gobjects.h"
 #include "gtypes.h"
 #include "hashmap.h"
+#include "intervalmap.h"
 #include "pqueue.h"
 #include "queue.h"
 #include "map.h"
@@ -42,6 +46,7 @@
 #include "stack.h"
 #include "strbuf.h"
 #include "strlib.h"
+#include "triemap.h"
 #include "vector.h"
 
 /* Private function prototypes */
@@ -80,6 +85,9 @@ static string unsignedLongToStringFn(GenericType any);
 static string unsignedCharToStringFn(GenericType any);
 static string stringToStringFn(GenericType any);
 static string pointerToStringFn(GenericType any);
+static void mergeSortGeneric(GenericType keys[], void *values[],
+                             GenericType keyTemp[], void *valueTemp[],
+                             int n, CompareFn cmpFn);
 
 /* Constants */
 
@@ -91,7 +99,9 @@ int size(void *arg) {
    string type;
 
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      return sizeBitVector((BitVector) arg);
+   } else if (endsWith(type, "Vector")) {
       return sizeVector((Vector) arg);
    } else if (endsWith(type, "PriorityQueue")) {
       return sizePriorityQueue((PriorityQueue) arg);
@@ -99,8 +109,18 @@ int size(void *arg) {
       return sizeQueue((Queue) arg);
    } else if (endsWith(type, "CharSet")) {
       return sizeCharSet((CharSet) arg);
+   } else if (endsWith(type, "ConcurrentDisjointSet")) {
+      return sizeConcurrentDisjointSet((ConcurrentDisjointSet) arg);
+   } else if (endsWith(type, "DisjointSet")) {
+      return sizeDisjointSet((DisjointSet) arg);
    } else if (endsWith(type, "Set")) {
       return sizeSet((Set) arg);
+   } else if (endsWith(type, "IntervalMap")) {
+      return sizeIntervalMap((IntervalMap) arg);
+   } else if (endsWith(type, "FlatMap")) {
+      return sizeFlatMap((FlatMap) arg);
+   } else if (endsWith(type, "TrieMap")) {
+      return sizeTrieMap((TrieMap) arg);
    } else if (endsWith(type, "HashMap")) {
       return sizeHashMap((HashMap) arg);
    } else if (endsWith(type, "Map")) {
@@ -129,7 +149,9 @@ bool isEmptyGeneric(int size, ...) {
    arg = va_arg(args, void *);
    va_end(args);
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      return isEmptyBitVector((BitVector) arg);
+   } else if (endsWith(type, "Vector")) {
       return isEmptyVector((Vector) arg);
    } else if (endsWith(type, "PriorityQueue")) {
       return isEmptyPriorityQueue((PriorityQueue) arg);
@@ -137,8 +159,18 @@ bool isEmptyGeneric(int size, ...) {
       return isEmptyQueue((Queue) arg);
    } else if (endsWith(type, "CharSet")) {
       return isEmptyCharSet((CharSet) arg);
+   } else if (endsWith(type, "ConcurrentDisjointSet")) {
+      return sizeConcurrentDisjointSet((ConcurrentDisjointSet) arg) == 0;
+   } else if (endsWith(type, "DisjointSet")) {
+      return sizeDisjointSet((DisjointSet) arg) == 0;
    } else if (endsWith(type, "Set")) {
       return isEmptySet((Set) arg);
+   } else if (endsWith(type, "IntervalMap")) {
+      return isEmptyIntervalMap((IntervalMap) arg);
+   } else if (endsWith(type, "FlatMap")) {
+      return isEmptyFlatMap((FlatMap) arg);
+   } else if (endsWith(type, "TrieMap")) {
+      return isEmptyTrieMap((TrieMap) arg);
    } else if (endsWith(type, "HashMap")) {
       return isEmptyHashMap((HashMap) arg);
    } else if (endsWith(type, "Map")) {
@@ -156,7 +188,9 @@ void clear(void *arg) {
    string type;
 
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      clearBitVector((BitVector) arg);
+   } else if (endsWith(type, "Vector")) {
       clearVector((Vector) arg);
    } else if (endsWith(type, "PriorityQueue")) {
       clearPriorityQueue((PriorityQueue) arg);
@@ -164,8 +198,16 @@ void clear(void *arg) {
       clearQueue((Queue) arg);
    } else if (endsWith(type, "CharSet")) {
       clearCharSet((CharSet) arg);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("clear: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       clearSet((Set) arg);
+   } else if (endsWith(type, "IntervalMap")) {
+      clearIntervalMap((IntervalMap) arg);
+   } else if (endsWith(type, "FlatMap")) {
+      clearFlatMap((FlatMap) arg);
+   } else if (endsWith(type, "TrieMap")) {
+      clearTrieMap((TrieMap) arg);
    } else if (endsWith(type, "HashMap")) {
       clearHashMap((HashMap) arg);
    } else if (endsWith(type, "Map")) {
@@ -183,7 +225,9 @@ void *clone(void *arg) {
    string type;
 
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      return cloneBitVector((BitVector) arg);
+   } else if (endsWith(type, "Vector")) {
       return cloneVector((Vector) arg);
    } else if (endsWith(type, "PriorityQueue")) {
       return clonePriorityQueue((PriorityQueue) arg);
@@ -191,8 +235,16 @@ void *clone(void *arg) {
       return cloneQueue((Queue) arg);
    } else if (endsWith(type, "CharSet")) {
       return cloneCharSet((CharSet) arg);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("clone: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       return cloneSet((Set) arg);
+   } else if (endsWith(type, "IntervalMap")) {
+      return cloneIntervalMap((IntervalMap) arg);
+   } else if (endsWith(type, "FlatMap")) {
+      return cloneFlatMap((FlatMap) arg);
+   } else if (endsWith(type, "TrieMap")) {
+      return cloneTrieMap((TrieMap) arg);
    } else if (endsWith(type, "HashMap")) {
       return cloneHashMap((HashMap) arg);
    } else if (endsWith(type, "Map")) {
@@ -211,11 +263,28 @@ void *get(void *arg, ...) {
    va_list args;
 
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      error("get: Use contains to test a bit in a BitVector");
+   } else if (endsWith(type, "Vector")) {
       va_start(args, arg);
       index = va_arg(args, int);
       va_end(args);
       return getVector((Vector) arg, index);
+   } else if (endsWith(type, "IntervalMap")) {
+      va_start(args, arg);
+      key = getIntervalMapFromArgs((IntervalMap) arg, args);
+      va_end(args);
+      return key;
+   } else if (endsWith(type, "FlatMap")) {
+      va_start(args, arg);
+      key = va_arg(args, string);
+      va_end(args);
+      return getFlatMap((FlatMap) arg, key);
+   } else if (endsWith(type, "TrieMap")) {
+      va_start(args, arg);
+      key = va_arg(args, string);
+      va_end(args);
+      return getTrieMap((TrieMap) arg, key);
    } else if (endsWith(type, "HashMap")) {
       va_start(args, arg);
       key = va_arg(args, string);
@@ -238,7 +307,9 @@ void set(void *arg, ...) {
    va_list args;
 
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      error("set: Use add or remove to change a bit in a BitVector");
+   } else if (endsWith(type, "Vector")) {
       va_start(args, arg);
       index = va_arg(args, int);
       value = va_arg(args, void *);
@@ -256,7 +327,23 @@ void put(void *arg, ...) {
    va_list args;
 
    type = getBlockType(arg);
-   if (endsWith(type, "HashMap")) {
+   if (endsWith(type, "IntervalMap")) {
+      va_start(args, arg);
+      putIntervalMapFromArgs((IntervalMap) arg, args);
+      va_end(args);
+   } else if (endsWith(type, "FlatMap")) {
+      va_start(args, arg);
+      key = va_arg(args, string);
+      value = va_arg(args, void *);
+      va_end(args);
+      putFlatMap((FlatMap) arg, key, value);
+   } else if (endsWith(type, "TrieMap")) {
+      va_start(args, arg);
+      key = va_arg(args, string);
+      value = va_arg(args, void *);
+      va_end(args);
+      putTrieMap((TrieMap) arg, key, value);
+   } else if (endsWith(type, "HashMap")) {
       va_start(args, arg);
       key = va_arg(args, string);
       value = va_arg(args, void *);
@@ -277,7 +364,13 @@ bool containsKey(void *arg, void *key) {
    string type;
 
    type = getBlockType(arg);
-   if (endsWith(type, "HashMap")) {
+   if (endsWith(type, "IntervalMap")) {
+      error("containsKey: Use getIntervalMap to look up an interval");
+   } else if (endsWith(type, "FlatMap")) {
+      return containsKeyFlatMap((FlatMap) arg, (string) key);
+   } else if (endsWith(type, "TrieMap")) {
+      return containsKeyTrieMap((TrieMap) arg, (string) key);
+   } else if (endsWith(type, "HashMap")) {
       return containsKeyHashMap((HashMap) arg, (string) key);
    } else if (endsWith(type, "Map")) {
       return containsKeyMap((Map) arg, key);
@@ -291,6 +384,7 @@ bool containsGeneric(int size, ...) {
    void *value, *arg;
    double x, y;
    char ch;
+   int index;
    bool result;
    va_list args;
    GRectangle r;
@@ -305,10 +399,16 @@ bool containsGeneric(int size, ...) {
    }
    arg = va_arg(args, void *);
    type = getBlockType(arg);
-   if (endsWith(type, "CharSet")) {
+   if (endsWith(type, "BitVector")) {
+      index = va_arg(args, int);
+      va_end(args);
+      return containsBitVector((BitVector) arg, index);
+   } else if (endsWith(type, "CharSet")) {
       ch = va_arg(args, int);
       va_end(args);
       return containsCharSet((CharSet) arg, ch);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("contains: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       result = containsSetFromArgs((Set) arg, args);
       va_end(args);
@@ -327,11 +427,17 @@ bool containsGeneric(int size, ...) {
 void add(void *arg, ...) {
    string type;
    char ch;
+   int index;
    void *value;
    va_list args;
 
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      va_start(args, arg);
+      index = va_arg(args, int);
+      va_end(args);
+      addBitVector((BitVector) arg, index);
+   } else if (endsWith(type, "Vector")) {
       va_start(args, arg);
       value = va_arg(args, void *);
       va_end(args);
@@ -341,6 +447,8 @@ void add(void *arg, ...) {
       ch = va_arg(args, int);
       va_end(args);
       addCharSet((CharSet) arg, ch);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("add: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       va_start(args, arg);
       addSetFromArgs((Set) arg, args);
@@ -367,7 +475,12 @@ void remove(void *arg, ...) {
    va_list args;
 
    type = getBlockType(arg);
-   if (endsWith(type, "Vector")) {
+   if (endsWith(type, "BitVector")) {
+      va_start(args, arg);
+      index = va_arg(args, int);
+      va_end(args);
+      removeBitVector((BitVector) arg, index);
+   } else if (endsWith(type, "Vector")) {
       va_start(args, arg);
       index = va_arg(args, int);
       va_end(args);
@@ -377,10 +490,26 @@ void remove(void *arg, ...) {
       ch = va_arg(args, int);
       va_end(args);
       removeCharSet((CharSet) arg, ch);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("remove: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       va_start(args, arg);
       removeSetFromArgs((Set) arg, args);
       va_end(args);
+   } else if (endsWith(type, "IntervalMap")) {
+      va_start(args, arg);
+      removeIntervalMapFromArgs((IntervalMap) arg, args);
+      va_end(args);
+   } else if (endsWith(type, "FlatMap")) {
+      va_start(args, arg);
+      key = va_arg(args, string);
+      va_end(args);
+      removeFlatMap((FlatMap) arg, key);
+   } else if (endsWith(type, "TrieMap")) {
+      va_start(args, arg);
+      key = va_arg(args, string);
+      va_end(args);
+      removeTrieMap((TrieMap) arg, key);
    } else if (endsWith(type, "HashMap")) {
       va_start(args, arg);
       key = va_arg(args, string);
@@ -475,8 +604,12 @@ bool equals(void *s1, void *s2) {
    string type;
 
    type = getBlockType(s1);
-   if (endsWith(type, "CharSet")) {
+   if (endsWith(type, "BitVector")) {
+      return equalsBitVector((BitVector) s1, (BitVector) s2);
+   } else if (endsWith(type, "CharSet")) {
       return equalsCharSet((CharSet) s1, (CharSet) s2);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("equals: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       return equalsSet((Set) s1, (Set) s2);
    } else {
@@ -488,8 +621,12 @@ bool isSubset(void *s1, void *s2) {
    string type;
 
    type = getBlockType(s1);
-   if (endsWith(type, "CharSet")) {
+   if (endsWith(type, "BitVector")) {
+      return isSubsetBitVector((BitVector) s1, (BitVector) s2);
+   } else if (endsWith(type, "CharSet")) {
       return isSubsetCharSet((CharSet) s1, (CharSet) s2);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("isSubset: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       return isSubsetSet((Set) s1, (Set) s2);
    } else {
@@ -501,8 +638,12 @@ void *xunion(void *s1, void *s2) {
    string type;
 
    type = getBlockType(s1);
-   if (endsWith(type, "CharSet")) {
+   if (endsWith(type, "BitVector")) {
+      return unionBitVector((BitVector) s1, (BitVector) s2);
+   } else if (endsWith(type, "CharSet")) {
       return unionCharSet((CharSet) s1, (CharSet) s2);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("union: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       return unionSet((Set) s1, (Set) s2);
    } else {
@@ -514,8 +655,12 @@ void *intersection(void *s1, void *s2) {
    string type;
 
    type = getBlockType(s1);
-   if (endsWith(type, "CharSet")) {
+   if (endsWith(type, "BitVector")) {
+      return intersectionBitVector((BitVector) s1, (BitVector) s2);
+   } else if (endsWith(type, "CharSet")) {
       return intersectionCharSet((CharSet) s1, (CharSet) s2);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("intersection: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       return intersectionSet((Set) s1, (Set) s2);
    } else {
@@ -527,8 +672,12 @@ void *setDifference(void *s1, void *s2) {
    string type;
 
    type = getBlockType(s1);
-   if (endsWith(type, "CharSet")) {
+   if (endsWith(type, "BitVector")) {
+      return setDifferenceBitVector((BitVector) s1, (BitVector) s2);
+   } else if (endsWith(type, "CharSet")) {
       return setDifferenceCharSet((CharSet) s1, (CharSet) s2);
+   } else if (endsWith(type, "DisjointSet")) {
+      error("setDifference: Unrecognized type %s", type);
    } else if (endsWith(type, "Set")) {
       return setDifferenceSet((Set) s1, (Set) s2);
    } else {
@@ -808,8 +957,88 @@ ToStringFn getToStringFn(string type) {
    return pointerToStringFn;
 }
 
+/*
+ * Implementation notes: sortGenericArray
+ * --------------------------------------
+ * The implementation uses merge sort, which is stable and guarantees
+ * O(N log N) behavior.  The initial scan makes the common case of input
+ * that is already sorted run in linear time.
+ */
+
+void sortGenericArray(GenericType keys[], void *values[], int n,
+                      CompareFn cmpFn) {
+   GenericType *keyTemp;
+   void **valueTemp;
+   int i;
+
+   for (i = 1; i < n && cmpFn(&keys[i - 1], &keys[i]) <= 0; i++) {
+      /* Empty */
+   }
+   if (i >= n) return;
+   keyTemp = newArray(n / 2, GenericType);
+   valueTemp = (values == NULL) ? NULL : newArray(n / 2, void *);
+   mergeSortGeneric(keys, values, keyTemp, valueTemp, n, cmpFn);
+   freeBlock(keyTemp);
+   if (valueTemp != NULL) freeBlock(valueTemp);
+}
+
+int uniqueGenericArray(GenericType keys[], void *values[], int n,
+                       CompareFn cmpFn) {
+   int i, j;
+
+   if (n == 0) return 0;
+   j = 0;
+   for (i = 1; i < n; i++) {
+      if (cmpFn(&keys[j], &keys[i]) != 0) j++;
+      keys[j] = keys[i];
+      if (values != NULL) values[j] = values[i];
+   }
+   return j + 1;
+}
+
 /* Private functions */
 
+/*
+ * Implementation notes: mergeSortGeneric
+ * --------------------------------------
+ * Sorts the two halves recursively and then merges them.  Only the left
+ * half needs to be copied to the temporary arrays, because the merge
+ * never overwrites an element of the right half before reading it.  The
+ * merge is skipped if the halves are already in order.
+ */
+
+static void mergeSortGeneric(GenericType keys[], void *values[],
+                             GenericType keyTemp[], void *valueTemp[],
+                             int n, CompareFn cmpFn) {
+   int mid, i, j, k;
+
+   if (n <= 1) return;
+   mid = n / 2;
+   mergeSortGeneric(keys, values, keyTemp, valueTemp, mid, cmpFn);
+   mergeSortGeneric(keys + mid, (values == NULL) ? NULL : values + mid,
+                    keyTemp, valueTemp, n - mid, cmpFn);
+   if (cmpFn(&keys[mid - 1], &keys[mid]) <= 0) return;
+   for (i = 0; i < mid; i++) {
+      keyTemp[i] = keys[i];
+      if (values != NULL) valueTemp[i] = values[i];
+   }
+   i = 0;
+   j = mid;
+   k = 0;
+   while (i < mid) {
+      if (j < n && cmpFn(&keys[j], &keyTemp[i]) < 0) {
+         keys[k] = keys[j];
+         if (values != NULL) values[k] = values[j];
+         j++;
+      } else {
+         keys[k] = keyTemp[i];
+         if (values != NULL) values[k] = valueTemp[i];
+         i++;
+      }
+      k++;
+   }
+}
+
 static void intFetchFn(va_list args, GenericType *dst) {
    dst->intRep = va_arg(args, int);
 }
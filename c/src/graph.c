@@ -23,9 +23,12 @@
 /* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
 /*************************************************************************/
 
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "foreach.h"
 #include "cslib.h"
+#include "flatmap.h"
 #include "generic.h"
 #include "graph.h"
 #include "hashmap.h"
@@ -35,6 +38,70 @@
 #include "strlib.h"
 #include "unittest.h"
 
+/*
+ * Constants
+ * ---------
+ * INITIAL_INDEX_CAPACITY -- Initial size of the node and arc tables
+ * INITIAL_ARC_CAPACITY   -- Initial size of the array of outgoing arcs
+ * TARGET_TABLE_THRESHOLD -- Number of outgoing arcs beyond which a node
+ *                           keeps a hash table of their ends
+ * TARGET_HASH_MULTIPLIER -- Odd multiplier that scatters keys in that table
+ */
+
+#define INITIAL_INDEX_CAPACITY 16
+#define INITIAL_ARC_CAPACITY 4
+#define TARGET_TABLE_THRESHOLD 16
+#define TARGET_HASH_MULTIPLIER 2654435769U
+
+/*
+ * Type: IndexTable
+ * ----------------
+ * This type assigns small integer indices to the nodes or arcs of a
+ * graph.  The items array records the element with each index, or NULL
+ * if the index is not in use, and the indices of removed elements wait
+ * on a stack for reuse, so that the indices stay within the number of
+ * elements the graph has held at one time.
+ */
+
+typedef struct {
+   void **items;                /* Element with each index, or NULL   */
+   int *released;               /* Stack of indices available again   */
+   int nFree;                   /* Number of indices on the stack     */
+   int limit;                   /* One more than the highest index    */
+   int capacity;                /* Allocated size of the arrays       */
+} IndexTable;
+
+/*
+ * Type: TargetTable
+ * -----------------
+ * This type is a hash table of the ends of the arcs leaving a node,
+ * keyed by node index, which lets isConnected answer in constant time.
+ * It uses open addressing with linear probing in arrays whose size is a
+ * power of two.  Each key is one more than the index of an end node, so
+ * that 0 marks an empty slot, and the matching count records how many
+ * arcs lead to that node.  Removing a key shifts the later keys in its
+ * probe sequence back, so that no deleted markers are needed.
+ */
+
+typedef struct {
+   int *keys;                   /* Index of each end plus one, or 0   */
+   int *counts;                 /* Number of arcs to each end         */
+   int nSlots;                  /* Size of the arrays, a power of 2   */
+   int nKeys;                   /* Number of slots in use             */
+} TargetTable;
+
+/*
+ * Type: NodeAttribute
+ * -------------------
+ * This type holds the values of one node attribute in an array indexed
+ * by node index, whose size always matches the capacity of the node
+ * table.
+ */
+
+typedef struct {
+   double *values;
+} NodeAttribute;
+
 /*
  * Type: GraphCDT
  * --------------
@@ -49,18 +116,32 @@ struct GraphCDT {
    CompareFn nodeCmpFn;         /* Comparison function to order nodes */
    CompareFn arcCmpFn;          /* Comparison function to order arcs  */
    HashMap nameMap;             /* Map from names to nodes            */
+   IndexTable nodeTable;        /* Table of nodes by index            */
+   IndexTable arcTable;         /* Table of arcs by index             */
+   HashMap attributes;          /* Map from names to node attributes  */
 };
 
 /*
  * Type: NodeCDT
  * -------------
  * This type defines the concrete structure of a graph node.  All nodes
- * have a name, which is used to identify the node.
+ * have a name, which is used to identify the node.  Each node records
+ * the arcs that enter it as well as those that leave it, so that
+ * removing a node touches only the arcs attached to it.  The arcs that
+ * leave the node also appear in the outArcs array, which mapNeighbors
+ * can traverse without allocating an iterator, and, once there are more
+ * than TARGET_TABLE_THRESHOLD of them, in the targets table.
  */
 
 struct NodeCDT {
    string name;                 /* Name identifying the node          */
+   int index;                   /* Index of the node in the graph     */
    Set arcs;                    /* Set of arcs leaving this node      */
+   Set incoming;                /* Set of arcs entering this node     */
+   Arc *outArcs;                /* Array of arcs leaving this node    */
+   int outDegree;               /* Number of arcs in outArcs          */
+   int outCapacity;             /* Allocated size of outArcs          */
+   TargetTable *targets;        /* Table of arc ends, or NULL         */
    Graph graph;                 /* The graph containing this node     */
 };
 
@@ -73,17 +154,73 @@ struct NodeCDT {
  */
 
 struct ArcCDT {
+   int index;                   /* Index of the arc in the graph      */
+   int slot;                    /* Position in the outArcs array      */
    Node start;                  /* The starting node for the arc      */
    Node end;                    /* The ending node for the arc        */
    double cost;                 /* The "cost" of travesing the arc    */
    Graph graph;                 /* The graph containing this arc      */
 };
 
+/*
+ * Type: FrozenGraphCDT
+ * --------------------
+ * This type defines the concrete structure of a graph snapshot.  The
+ * offsets, targets, and costs arrays form the compressed sparse row
+ * representation of the arcs.  The idMap table maps each node name to
+ * one more than its ID, so that no ID maps to NULL.  Because the table
+ * never changes, it is a FlatMap built in a single sorting pass, which
+ * happens the first time a client looks up a name.  The idByIndex array
+ * maps the index of each node in the original graph to its ID, or to -1
+ * for an index that no node had, so that a Node can be converted to an
+ * ID without its name.  The inOffsets and sources arrays hold the
+ * reversed rows, which remain NULL until a client asks for them.  A
+ * snapshot read from a file has no nodes or idByIndex array and keeps
+ * its names in the single block nameBuffer.  A snapshot from
+ * freezeGraphStructure has no names at all.
+ */
+
+struct FrozenGraphCDT {
+   int nNodes;                  /* Number of nodes in the snapshot    */
+   int nArcs;                   /* Number of arcs in the snapshot     */
+   int *offsets;                /* Start of each node's row of arcs   */
+   int *targets;                /* ID of the end node of each arc     */
+   double *costs;               /* Cost of each arc                   */
+   string *names;               /* Name of each node                  */
+   Node *nodes;                 /* Node in the original graph         */
+   int *idByIndex;              /* ID for each node index             */
+   int indexLimit;              /* Number of entries in idByIndex     */
+   int *inOffsets;              /* Start of each node's incoming row  */
+   int *sources;                /* ID of the start node of each arc   */
+   FlatMap idMap;               /* Map from names to IDs              */
+   char *nameBuffer;            /* Block holding the names, or NULL   */
+};
+
 /* Private function prototypes */
 
 static Iterator newGraphIterator(void *collection);
 static int defaultNodeOrdering(const void *p1, const void *p2);
 static int defaultArcOrdering(const void *p1, const void *p2);
+static void buildReverseRows(FrozenGraph fg);
+static FrozenGraph takeSnapshot(Graph g, bool copyNames);
+static void buildIdMap(FrozenGraph fg);
+static void initIndexTable(IndexTable *table);
+static void freeIndexTable(IndexTable *table);
+static int claimIndex(IndexTable *table, void *item);
+static void releaseIndex(IndexTable *table, int index);
+static void resizeAttribute(string name, void *value, void *data);
+static void clearAttributeValue(string name, void *value, void *data);
+static void freeAttribute(string name, void *value, void *data);
+static void addOutArc(Node node, Arc arc);
+static void removeOutArc(Node node, Arc arc);
+static void freeOutArcs(Node node);
+static TargetTable *newTargetTable(int nSlots);
+static void freeTargetTable(TargetTable *table);
+static int findTargetSlot(TargetTable *table, int key);
+static int homeSlot(TargetTable *table, int key);
+static void addTarget(TargetTable *table, int index);
+static void removeTarget(TargetTable *table, int index);
+static bool containsTarget(TargetTable *table, int index);
 
 /* Exported entries */
 
@@ -99,6 +236,9 @@ Graph newGraph(void) {
    setCompareFn(g->nodes, defaultNodeOrdering);
    setCompareFn(g->arcs, defaultArcOrdering);
    g->nameMap = newHashMap();
+   initIndexTable(&g->nodeTable);
+   initIndexTable(&g->arcTable);
+   g->attributes = newHashMap();
    return g;
 }
 
@@ -107,6 +247,9 @@ void freeGraph(Graph g) {
    Arc arc;
 
    foreach (node in g->nodes) {
+      freeSet(node->arcs);
+      freeSet(node->incoming);
+      freeOutArcs(node);
       freeBlock(node);
    }
    foreach (arc in g->arcs) {
@@ -115,34 +258,81 @@ void freeGraph(Graph g) {
    freeSet(g->nodes);
    freeSet(g->arcs);
    freeHashMap(g->nameMap);
+   freeIndexTable(&g->nodeTable);
+   freeIndexTable(&g->arcTable);
+   mapHashMap(g->attributes, freeAttribute, NULL);
+   freeHashMap(g->attributes);
    freeBlock(g);
 }
 
+/*
+ * Implementation notes: addNode
+ * -----------------------------
+ * If the node table grows, every attribute array grows with it.  The
+ * attribute values for the new index are cleared, because the index may
+ * have belonged to a node that has since been removed.
+ */
+
 Node addNode(Graph g, string name) {
    Node node;
+   int capacity;
 
+   if (containsKeyHashMap(g->nameMap, name)) {
+      error("addNode: Duplicate node %s", name);
+   }
    node = newBlock(Node);
    node->name = name;
    node->arcs = newSet(Arc);
+   node->incoming = newSet(Arc);
+   node->outArcs = NULL;
+   node->outDegree = 0;
+   node->outCapacity = 0;
+   node->targets = NULL;
    node->graph = g;
    setCompareFn(node->arcs, g->arcCmpFn);
-   addSet(g->nodes, node);
-   if (containsKeyHashMap(g->nameMap, name)) {
-      error("addNode: Duplicate node %s", name);
+   setCompareFn(node->incoming, g->arcCmpFn);
+   capacity = g->nodeTable.capacity;
+   node->index = claimIndex(&g->nodeTable, node);
+   if (g->nodeTable.capacity != capacity) {
+      mapHashMap(g->attributes, resizeAttribute, &capacity);
    }
+   mapHashMap(g->attributes, clearAttributeValue, &node->index);
+   addSet(g->nodes, node);
    putHashMap(g->nameMap, name, node);
    return node;
 }
 
+/*
+ * Implementation notes: removeNode
+ * --------------------------------
+ * The arcs to be removed are collected first, because a set must not be
+ * modified while an iteration over it is in progress.  Collecting them
+ * in a set ensures that an arc from the node to itself, which appears in
+ * both of its sets, is removed only once.
+ */
+
 void removeNode(Graph g, Node node) {
+   Set arcs;
    Arc arc;
 
-   foreach (arc in g->arcs) {
-      if (arc->start == node || arc->end == node) removeArc(g, arc);
+   arcs = newSet(Arc);
+   setCompareFn(arcs, g->arcCmpFn);
+   foreach (arc in node->arcs) {
+      addSet(arcs, arc);
+   }
+   foreach (arc in node->incoming) {
+      addSet(arcs, arc);
    }
+   foreach (arc in arcs) {
+      removeArc(g, arc);
+   }
+   freeSet(arcs);
    freeSet(node->arcs);
+   freeSet(node->incoming);
+   freeOutArcs(node);
    removeSet(g->nodes, node);
    removeHashMap(g->nameMap, node->name);
+   releaseIndex(&g->nodeTable, node->index);
    freeBlock(node);
 }
 
@@ -158,29 +348,33 @@ Arc addArc(Graph g, Node n1, Node n2) {
    arc->end = n2;
    arc->cost = 0;
    arc->graph = g;
+   arc->index = claimIndex(&g->arcTable, arc);
    addSet(g->arcs, arc);
    addSet(n1->arcs, arc);
+   addSet(n2->incoming, arc);
+   addOutArc(n1, arc);
    return arc;
 }
 
 void removeArc(Graph g, Arc arc) {
    removeSet(g->arcs, arc);
    removeSet(arc->start->arcs, arc);
+   removeOutArc(arc->start, arc);
+   removeSet(arc->end->incoming, arc);
+   releaseIndex(&g->arcTable, arc->index);
    freeBlock(arc);
 }
 
 bool isConnected(Node n1, Node n2) {
-   Iterator it;
-   Arc arc;
-   bool result;
+   int i;
 
-   result = false;
-   it = newIterator(n1->arcs);
-   while (!result && stepIterator(it, &arc)) {
-      if (arc->end == n2) result = true;
+   if (n1->targets != NULL) {
+      return n1->graph == n2->graph && containsTarget(n1->targets, n2->index);
    }
-   freeIterator(it);
-   return result;
+   for (i = 0; i < n1->outDegree; i++) {
+      if (n1->outArcs[i]->end == n2) return true;
+   }
+   return false;
 }
 
 Set getNodeSet(Graph g) {
@@ -212,6 +406,36 @@ Set getNeighbors(Node node) {
    return result;
 }
 
+void mapNeighbors(Node node, NeighborFn fn, void *data) {
+   Arc arc;
+   int i;
+
+   for (i = 0; i < node->outDegree; i++) {
+      arc = node->outArcs[i];
+      fn(arc->end, arc, data);
+   }
+}
+
+int getOutDegree(Node node) {
+   return node->outDegree;
+}
+
+Set getIncomingArcs(Node node) {
+   return node->incoming;
+}
+
+Set getPredecessors(Node node) {
+   Set result;
+   Arc arc;
+
+   result = newSet(Node);
+   setCompareFn(result, node->graph->nodeCmpFn);
+   foreach (arc in node->incoming) {
+      addSet(result, arc->start);
+   }
+   return result;
+}
+
 string getName(Node node) {
    return node->name;
 }
@@ -232,6 +456,73 @@ void setCost(Arc arc, double cost) {
    arc->cost = cost;
 }
 
+int getNodeIndex(Node node) {
+   return node->index;
+}
+
+int getArcIndex(Arc arc) {
+   return arc->index;
+}
+
+int getNodeIndexLimit(Graph g) {
+   return g->nodeTable.limit;
+}
+
+int getArcIndexLimit(Graph g) {
+   return g->arcTable.limit;
+}
+
+Node getNodeByIndex(Graph g, int index) {
+   if (index < 0 || index >= g->nodeTable.limit) {
+      error("getNodeByIndex: Index %d out of range", index);
+   }
+   return (Node) g->nodeTable.items[index];
+}
+
+Arc getArcByIndex(Graph g, int index) {
+   if (index < 0 || index >= g->arcTable.limit) {
+      error("getArcByIndex: Index %d out of range", index);
+   }
+   return (Arc) g->arcTable.items[index];
+}
+
+void setNodeAttribute(Graph g, string name, Node node, double value) {
+   getNodeAttributeArray(g, name)[node->index] = value;
+}
+
+double getNodeAttribute(Graph g, string name, Node node) {
+   NodeAttribute *attribute;
+
+   attribute = (NodeAttribute *) getHashMap(g->attributes, name);
+   return (attribute == NULL) ? 0 : attribute->values[node->index];
+}
+
+double *getNodeAttributeArray(Graph g, string name) {
+   NodeAttribute *attribute;
+   int i;
+
+   attribute = (NodeAttribute *) getHashMap(g->attributes, name);
+   if (attribute == NULL) {
+      attribute = newBlock(NodeAttribute *);
+      attribute->values = newArray(g->nodeTable.capacity, double);
+      for (i = 0; i < g->nodeTable.capacity; i++) {
+         attribute->values[i] = 0;
+      }
+      putHashMap(g->attributes, name, attribute);
+   }
+   return attribute->values;
+}
+
+void removeNodeAttribute(Graph g, string name) {
+   NodeAttribute *attribute;
+
+   attribute = (NodeAttribute *) getHashMap(g->attributes, name);
+   if (attribute != NULL) {
+      freeAttribute(name, attribute, NULL);
+      removeHashMap(g->attributes, name);
+   }
+}
+
 void setNodeOrdering(Graph g, CompareFn cmpFn) {
    g->nodeCmpFn = cmpFn;
    setCompareFn(g->nodes, cmpFn);
@@ -242,6 +533,176 @@ void setArcOrdering(Graph g, CompareFn cmpFn) {
    setCompareFn(g->arcs, cmpFn);
 }
 
+/*
+ * Implementation notes: freezeGraph
+ * ---------------------------------
+ * The first pass assigns the IDs and records where each row of arcs
+ * begins, and the second fills in the rows.  Because the arcs of a node
+ * are already grouped in its own set, no sorting is required.  The
+ * second pass finds the ID of the end of each arc through the idByIndex
+ * array, which avoids looking up its name.  The snapshot keeps that
+ * array for getFrozenIdForNode.
+ */
+
+FrozenGraph freezeGraph(Graph g) {
+   return takeSnapshot(g, true);
+}
+
+FrozenGraph freezeGraphStructure(Graph g) {
+   return takeSnapshot(g, false);
+}
+
+static FrozenGraph takeSnapshot(Graph g, bool copyNames) {
+   FrozenGraph fg;
+   Node node;
+   Arc arc;
+   int id, k;
+
+   fg = newBlock(FrozenGraph);
+   fg->nNodes = sizeSet(g->nodes);
+   fg->nArcs = sizeSet(g->arcs);
+   fg->offsets = newArray(fg->nNodes + 1, int);
+   fg->targets = newArray(fg->nArcs, int);
+   fg->costs = newArray(fg->nArcs, double);
+   fg->names = (copyNames) ? newArray(fg->nNodes, string) : NULL;
+   fg->nodes = newArray(fg->nNodes, Node);
+   fg->indexLimit = g->nodeTable.limit;
+   fg->idByIndex = newArray(fg->indexLimit + 1, int);
+   fg->inOffsets = NULL;
+   fg->sources = NULL;
+   fg->idMap = NULL;
+   fg->nameBuffer = NULL;
+   for (k = 0; k < fg->indexLimit; k++) {
+      fg->idByIndex[k] = -1;
+   }
+   id = k = 0;
+   foreach (node in g->nodes) {
+      fg->idByIndex[node->index] = id;
+      if (copyNames) fg->names[id] = copyString(node->name);
+      fg->nodes[id] = node;
+      fg->offsets[id] = k;
+      k += sizeSet(node->arcs);
+      id++;
+   }
+   fg->offsets[id] = k;
+   k = 0;
+   foreach (node in g->nodes) {
+      foreach (arc in node->arcs) {
+         fg->targets[k] = fg->idByIndex[arc->end->index];
+         fg->costs[k] = arc->cost;
+         k++;
+      }
+   }
+   return fg;
+}
+
+void freeFrozenGraph(FrozenGraph fg) {
+   int i;
+
+   if (fg->nameBuffer != NULL) {
+      freeBlock(fg->nameBuffer);
+   } else if (fg->names != NULL) {
+      for (i = 0; i < fg->nNodes; i++) {
+         freeBlock(fg->names[i]);
+      }
+   }
+   freeBlock(fg->offsets);
+   freeBlock(fg->targets);
+   freeBlock(fg->costs);
+   if (fg->names != NULL) freeBlock(fg->names);
+   if (fg->nodes != NULL) freeBlock(fg->nodes);
+   if (fg->idByIndex != NULL) freeBlock(fg->idByIndex);
+   if (fg->inOffsets != NULL) {
+      freeBlock(fg->inOffsets);
+      freeBlock(fg->sources);
+   }
+   if (fg->idMap != NULL) freeFlatMap(fg->idMap);
+   freeBlock(fg);
+}
+
+int getFrozenNodeCount(FrozenGraph fg) {
+   return fg->nNodes;
+}
+
+int getFrozenArcCount(FrozenGraph fg) {
+   return fg->nArcs;
+}
+
+int getFrozenNodeId(FrozenGraph fg, string name) {
+   if (fg->names == NULL) error("getFrozenNodeId: Snapshot has no names");
+   if (fg->idMap == NULL) buildIdMap(fg);
+   return (int) (intptr_t) getFlatMap(fg->idMap, name) - 1;
+}
+
+/*
+ * Implementation notes: getFrozenIdForNode
+ * ----------------------------------------
+ * The check against the nodes array rejects a node that was added to
+ * the graph after the snapshot and took over the index of a removed one.
+ */
+
+int getFrozenIdForNode(FrozenGraph fg, Node node) {
+   int id;
+
+   if (fg->idByIndex == NULL || node->index >= fg->indexLimit) return -1;
+   id = fg->idByIndex[node->index];
+   return (id >= 0 && fg->nodes[id] == node) ? id : -1;
+}
+
+string getFrozenNodeName(FrozenGraph fg, int id) {
+   if (id < 0 || id >= fg->nNodes) error("getFrozenNodeName: Illegal ID");
+   if (fg->names == NULL) error("getFrozenNodeName: Snapshot has no names");
+   return fg->names[id];
+}
+
+Node getFrozenNode(FrozenGraph fg, int id) {
+   if (id < 0 || id >= fg->nNodes) error("getFrozenNode: Illegal ID");
+   return (fg->nodes == NULL) ? NULL : fg->nodes[id];
+}
+
+const int *getFrozenOffsets(FrozenGraph fg) {
+   return fg->offsets;
+}
+
+const int *getFrozenTargets(FrozenGraph fg) {
+   return fg->targets;
+}
+
+const double *getFrozenCosts(FrozenGraph fg) {
+   return fg->costs;
+}
+
+const int *getFrozenInOffsets(FrozenGraph fg) {
+   if (fg->inOffsets == NULL) buildReverseRows(fg);
+   return fg->inOffsets;
+}
+
+const int *getFrozenSources(FrozenGraph fg) {
+   if (fg->inOffsets == NULL) buildReverseRows(fg);
+   return fg->sources;
+}
+
+FrozenGraph assembleFrozenGraph(int n, int m, int *offsets, int *targets,
+                                double *costs, string *names, char *buf) {
+   FrozenGraph fg;
+
+   fg = newBlock(FrozenGraph);
+   fg->nNodes = n;
+   fg->nArcs = m;
+   fg->offsets = offsets;
+   fg->targets = targets;
+   fg->costs = costs;
+   fg->names = names;
+   fg->nodes = NULL;
+   fg->idByIndex = NULL;
+   fg->indexLimit = 0;
+   fg->inOffsets = NULL;
+   fg->sources = NULL;
+   fg->idMap = NULL;
+   fg->nameBuffer = buf;
+   return fg;
+}
+
 /* Private functions */
 
 /*
@@ -280,6 +741,329 @@ static int defaultArcOrdering(const void *p1, const void *p2) {
    return 0;
 }
 
+/*
+ * Function: buildReverseRows
+ * Usage: buildReverseRows(fg);
+ * ----------------------------
+ * Builds the rows of incoming arcs with a counting sort on the end node
+ * of each arc.  Because the outgoing rows are visited in order of their
+ * start nodes, the sources in each incoming row come out in ascending
+ * order.
+ */
+
+static void buildReverseRows(FrozenGraph fg) {
+   int *next;
+   int u, i, k;
+
+   fg->inOffsets = newArray(fg->nNodes + 1, int);
+   fg->sources = newArray(fg->nArcs, int);
+   next = newArray(fg->nNodes + 1, int);
+   for (u = 0; u <= fg->nNodes; u++) {
+      next[u] = 0;
+   }
+   for (i = 0; i < fg->nArcs; i++) {
+      next[fg->targets[i] + 1]++;
+   }
+   for (u = 0; u < fg->nNodes; u++) {
+      next[u + 1] += next[u];
+   }
+   for (u = 0; u <= fg->nNodes; u++) {
+      fg->inOffsets[u] = next[u];
+   }
+   for (u = 0; u < fg->nNodes; u++) {
+      for (i = fg->offsets[u]; i < fg->offsets[u + 1]; i++) {
+         k = next[fg->targets[i]]++;
+         fg->sources[k] = u;
+      }
+   }
+   freeBlock(next);
+}
+
+/*
+ * Function: buildIdMap
+ * Usage: buildIdMap(fg);
+ * ----------------------
+ * Builds the table that maps the name of each node to one more than its
+ * ID.
+ */
+
+static void buildIdMap(FrozenGraph fg) {
+   void **ids;
+   int id;
+
+   fg->idMap = newFlatMap();
+   ids = newArray(fg->nNodes, void *);
+   for (id = 0; id < fg->nNodes; id++) {
+      ids[id] = (void *) (intptr_t) (id + 1);
+   }
+   putAllFlatMap(fg->idMap, fg->names, ids, fg->nNodes);
+   freeBlock(ids);
+}
+
+static void initIndexTable(IndexTable *table) {
+   table->capacity = INITIAL_INDEX_CAPACITY;
+   table->items = newArray(table->capacity, void *);
+   table->released = newArray(table->capacity, int);
+   table->nFree = 0;
+   table->limit = 0;
+}
+
+static void freeIndexTable(IndexTable *table) {
+   freeBlock(table->items);
+   freeBlock(table->released);
+}
+
+/*
+ * Function: claimIndex
+ * Usage: index = claimIndex(table, item);
+ * ---------------------------------------
+ * Assigns an index to item, reusing the most recently released index if
+ * there is one, and doubles the capacity of the table if it is full.
+ */
+
+static int claimIndex(IndexTable *table, void *item) {
+   void **items;
+   int *released;
+   int index;
+
+   if (table->nFree > 0) {
+      index = table->released[--table->nFree];
+   } else {
+      if (table->limit == table->capacity) {
+         items = newArray(2 * table->capacity, void *);
+         released = newArray(2 * table->capacity, int);
+         memcpy(items, table->items, table->capacity * sizeof(void *));
+         freeBlock(table->items);
+         freeBlock(table->released);
+         table->items = items;
+         table->released = released;
+         table->capacity *= 2;
+      }
+      index = table->limit++;
+   }
+   table->items[index] = item;
+   return index;
+}
+
+static void releaseIndex(IndexTable *table, int index) {
+   table->items[index] = NULL;
+   table->released[table->nFree++] = index;
+}
+
+/*
+ * Function: resizeAttribute
+ * Usage: mapHashMap(g->attributes, resizeAttribute, &oldCapacity);
+ * ----------------------------------------------------------------
+ * Doubles the size of an attribute array after the node table grows,
+ * which always doubles its capacity.
+ */
+
+static void resizeAttribute(string name, void *value, void *data) {
+   NodeAttribute *attribute;
+   double *values;
+   int i, capacity;
+
+   attribute = (NodeAttribute *) value;
+   capacity = *((int *) data);
+   values = newArray(2 * capacity, double);
+   memcpy(values, attribute->values, capacity * sizeof(double));
+   for (i = capacity; i < 2 * capacity; i++) {
+      values[i] = 0;
+   }
+   freeBlock(attribute->values);
+   attribute->values = values;
+}
+
+static void clearAttributeValue(string name, void *value, void *data) {
+   ((NodeAttribute *) value)->values[*((int *) data)] = 0;
+}
+
+static void freeAttribute(string name, void *value, void *data) {
+   freeBlock(((NodeAttribute *) value)->values);
+   freeBlock(value);
+}
+
+/*
+ * Function: addOutArc
+ * Usage: addOutArc(node, arc);
+ * ----------------------------
+ * Appends the arc to the outArcs array of the node, which doubles in
+ * size when it is full, and records its end in the targets table.  The
+ * table is created when the number of arcs first passes the threshold
+ * and is sized at four times that number, so that it stays less than
+ * half full until it must grow.
+ */
+
+static void addOutArc(Node node, Arc arc) {
+   Arc *outArcs;
+   int nSlots, i;
+
+   if (node->outDegree == node->outCapacity) {
+      node->outCapacity = (node->outCapacity == 0) ? INITIAL_ARC_CAPACITY
+                                                   : 2 * node->outCapacity;
+      outArcs = newArray(node->outCapacity, Arc);
+      if (node->outArcs != NULL) {
+         memcpy(outArcs, node->outArcs, node->outDegree * sizeof (Arc));
+         freeBlock(node->outArcs);
+      }
+      node->outArcs = outArcs;
+   }
+   arc->slot = node->outDegree;
+   node->outArcs[node->outDegree++] = arc;
+   if (node->targets != NULL) {
+      addTarget(node->targets, arc->end->index);
+   } else if (node->outDegree > TARGET_TABLE_THRESHOLD) {
+      nSlots = 1;
+      while (nSlots < 4 * node->outDegree) {
+         nSlots *= 2;
+      }
+      node->targets = newTargetTable(nSlots);
+      for (i = 0; i < node->outDegree; i++) {
+         addTarget(node->targets, node->outArcs[i]->end->index);
+      }
+   }
+}
+
+/*
+ * Function: removeOutArc
+ * Usage: removeOutArc(node, arc);
+ * -------------------------------
+ * Removes the arc from the outArcs array by moving the last arc into its
+ * slot, and removes its end from the targets table.
+ */
+
+static void removeOutArc(Node node, Arc arc) {
+   Arc last;
+
+   last = node->outArcs[--node->outDegree];
+   node->outArcs[arc->slot] = last;
+   last->slot = arc->slot;
+   if (node->targets != NULL) removeTarget(node->targets, arc->end->index);
+}
+
+static void freeOutArcs(Node node) {
+   if (node->outArcs != NULL) freeBlock(node->outArcs);
+   if (node->targets != NULL) freeTargetTable(node->targets);
+}
+
+static TargetTable *newTargetTable(int nSlots) {
+   TargetTable *table;
+   int i;
+
+   table = newBlock(TargetTable *);
+   table->keys = newArray(nSlots, int);
+   table->counts = newArray(nSlots, int);
+   table->nSlots = nSlots;
+   table->nKeys = 0;
+   for (i = 0; i < nSlots; i++) {
+      table->keys[i] = 0;
+   }
+   return table;
+}
+
+static void freeTargetTable(TargetTable *table) {
+   freeBlock(table->keys);
+   freeBlock(table->counts);
+   freeBlock(table);
+}
+
+/*
+ * Function: findTargetSlot
+ * Usage: slot = findTargetSlot(table, key);
+ * -----------------------------------------
+ * Returns the slot that holds the key or, if the key is absent, the
+ * empty slot at which its probe sequence ends.
+ */
+
+static int findTargetSlot(TargetTable *table, int key) {
+   int slot;
+
+   slot = homeSlot(table, key);
+   while (table->keys[slot] != 0 && table->keys[slot] != key) {
+      slot = (slot + 1) & (table->nSlots - 1);
+   }
+   return slot;
+}
+
+/*
+ * Function: homeSlot
+ * Usage: slot = homeSlot(table, key);
+ * -----------------------------------
+ * Returns the slot at which the probe sequence for the key begins.
+ * Because the multiplier is odd, consecutive indices still land in
+ * distinct slots.
+ */
+
+static int homeSlot(TargetTable *table, int key) {
+   return (int) (((unsigned) key * TARGET_HASH_MULTIPLIER)
+                 & (table->nSlots - 1));
+}
+
+static void addTarget(TargetTable *table, int index) {
+   TargetTable *larger;
+   int slot, i;
+
+   slot = findTargetSlot(table, index + 1);
+   if (table->keys[slot] != 0) {
+      table->counts[slot]++;
+      return;
+   }
+   if (2 * (table->nKeys + 1) > table->nSlots) {
+      larger = newTargetTable(2 * table->nSlots);
+      for (i = 0; i < table->nSlots; i++) {
+         if (table->keys[i] != 0) {
+            slot = findTargetSlot(larger, table->keys[i]);
+            larger->keys[slot] = table->keys[i];
+            larger->counts[slot] = table->counts[i];
+         }
+      }
+      larger->nKeys = table->nKeys;
+      freeBlock(table->keys);
+      freeBlock(table->counts);
+      *table = *larger;
+      freeBlock(larger);
+      slot = findTargetSlot(table, index + 1);
+   }
+   table->keys[slot] = index + 1;
+   table->counts[slot] = 1;
+   table->nKeys++;
+}
+
+/*
+ * Implementation notes: removeTarget
+ * ----------------------------------
+ * When the last arc to a node goes away, the loop closes the gap left
+ * by its key.  A later key in the same run may move into the gap unless
+ * its home slot lies between the gap and its current slot, in which
+ * case moving it would take it out of reach of its own probe sequence.
+ */
+
+static void removeTarget(TargetTable *table, int index) {
+   int mask, gap, slot, home;
+
+   gap = findTargetSlot(table, index + 1);
+   if (table->keys[gap] == 0) return;
+   if (--table->counts[gap] > 0) return;
+   mask = table->nSlots - 1;
+   slot = gap;
+   while (true) {
+      slot = (slot + 1) & mask;
+      if (table->keys[slot] == 0) break;
+      home = homeSlot(table, table->keys[slot]);
+      if (((slot - home) & mask) >= ((slot - gap) & mask)) {
+         table->keys[gap] = table->keys[slot];
+         table->counts[gap] = table->counts[slot];
+         gap = slot;
+      }
+   }
+   table->keys[gap] = 0;
+   table->nKeys--;
+}
+
+static bool containsTarget(TargetTable *table, int index) {
+   return table->keys[findTargetSlot(table, index + 1)] != 0;
+}
+
 /**********************************************************************/
 /* Unit test for the graph module                                     */
 /**********************************************************************/
@@ -310,7 +1094,14 @@ static void testNodeIterator(Graph g);
 static void testArcIterator(Graph g);
 static void testArcsFrom(Graph g);
 static void testNeighbors(Graph g);
+static void testIncomingArcs(Graph g);
+static void testFrozenGraph(Graph g);
+static void testRemoveNode(Graph g);
+static void testIndicesAndAttributes(void);
+static void testNeighborMapping(void);
+static void addCost(Node neighbor, Arc arc, void *data);
 static string arcString(Arc arc);
+static string nodeSetString(Set nodes);
 
 /* Unit test */
 
@@ -322,6 +1113,11 @@ void testGraphModule(void) {
    testArcIterator(g);
    testArcsFrom(g);
    testNeighbors(g);
+   testIncomingArcs(g);
+   testFrozenGraph(g);
+   testRemoveNode(g);
+   testIndicesAndAttributes();
+   testNeighborMapping();
 }
 
 /* Private functions */
@@ -422,8 +1218,220 @@ static void testNeighbors(Graph g) {
    }
 }
 
+/*
+ * Implementation notes: testFrozenGraph
+ * -------------------------------------
+ * Checks the rows of a snapshot of the test graph and then confirms that
+ * the snapshot is unaffected by a change to the graph.  A node from
+ * another graph, whose index the snapshot also uses, must not be given
+ * an ID.
+ */
+
+static void testFrozenGraph(Graph g) {
+   FrozenGraph fg;
+   Graph other;
+   const int *offsets, *targets;
+   string str;
+   int i, a;
+
+   trace(fg = freezeGraph(g));
+   test(getFrozenNodeCount(fg), 4);
+   test(getFrozenArcCount(fg), 6);
+   test(getFrozenNodeId(fg, "C"), 2);
+   test(getFrozenNodeId(fg, "Z"), -1);
+   test(getFrozenNodeName(fg, 3), "D");
+   test(getFrozenNode(fg, 1) == getNode(g, "B"), true);
+   test(getFrozenIdForNode(fg, getNode(g, "C")), 2);
+   trace(offsets = getFrozenOffsets(fg));
+   trace(targets = getFrozenTargets(fg));
+   trace(a = getFrozenNodeId(fg, "A"));
+   trace(str = "");
+   trace(for (i = offsets[a]; i < offsets[a + 1]; i++) {
+      str = concat(str, getFrozenNodeName(fg, targets[i]));
+   });
+   test(str, "BCD");
+   trace(offsets = getFrozenInOffsets(fg));
+   trace(targets = getFrozenSources(fg));
+   test(offsets[a + 1] - offsets[a], 0);
+   trace(str = "");
+   trace(for (i = offsets[3]; i < offsets[4]; i++) {
+      str = concat(str, getFrozenNodeName(fg, targets[i]));
+   });
+   test(str, "ABC");
+   trace(offsets = getFrozenOffsets(fg));
+   trace(addArc(g, getNode(g, "D"), getNode(g, "A")));
+   test(getFrozenArcCount(fg), 6);
+   test(offsets[4] - offsets[3], 0);
+   trace(freeFrozenGraph(fg));
+   trace(fg = freezeGraphStructure(g));
+   test(getFrozenArcCount(fg), 7);
+   test(getFrozenIdForNode(fg, getNode(g, "D")), 3);
+   test(getFrozenNode(fg, 3) == getNode(g, "D"), true);
+   trace(other = newGraph());
+   trace(addNode(other, "A"));
+   test(getFrozenIdForNode(fg, getNode(other, "A")), -1);
+   trace(freeGraph(other));
+   trace(freeFrozenGraph(fg));
+}
+
+/*
+ * Implementation notes: testIncomingArcs
+ * --------------------------------------
+ * Checks the incoming arcs of the test graph, in which each node has an
+ * arc from every node that precedes it alphabetically.
+ */
+
+static void testIncomingArcs(Graph g) {
+   test(sizeSet(getIncomingArcs(getNode(g, "A"))), 0);
+   test(sizeSet(getIncomingArcs(getNode(g, "D"))), 3);
+   test(nodeSetString(getPredecessors(getNode(g, "C"))), "AB");
+   test(nodeSetString(getPredecessors(getNode(g, "D"))), "ABC");
+}
+
+/*
+ * Implementation notes: testRemoveNode
+ * ------------------------------------
+ * Removes nodes from the graph left by testFrozenGraph, which has an
+ * additional arc from D to A, and checks that the arcs entering and
+ * leaving those nodes disappear from every set.  The second removal
+ * covers a node with an arc to itself.
+ */
+
+static void testRemoveNode(Graph g) {
+   trace(removeNode(g, getNode(g, "B")));
+   test(getNode(g, "B") == NULL, true);
+   test(sizeSet(getArcSet(g)), 4);
+   test(nodeSetString(getNeighbors(getNode(g, "A"))), "CD");
+   test(nodeSetString(getPredecessors(getNode(g, "D"))), "AC");
+   test(nodeSetString(getPredecessors(getNode(g, "A"))), "D");
+   trace(addArc(g, getNode(g, "C"), getNode(g, "C")));
+   test(sizeSet(getIncomingArcs(getNode(g, "C"))), 2);
+   trace(removeNode(g, getNode(g, "C")));
+   test(sizeSet(getArcSet(g)), 2);
+   test(nodeSetString(getNeighbors(getNode(g, "A"))), "D");
+   test(nodeSetString(getPredecessors(getNode(g, "D"))), "A");
+   test(sizeSet(getIncomingArcs(getNode(g, "D"))), 1);
+}
+
+/*
+ * Implementation notes: testIndicesAndAttributes
+ * ----------------------------------------------
+ * Checks that indices are dense and reused after a removal, and that
+ * attribute values survive the growth of the node table but not the
+ * reuse of an index.
+ */
+
+static void testIndicesAndAttributes(void) {
+   Graph g;
+   Node a, b, c;
+   Arc arc;
+   double *dist;
+   int i;
+
+   trace(g = newGraph());
+   trace(a = addNode(g, "A"));
+   trace(b = addNode(g, "B"));
+   trace(c = addNode(g, "C"));
+   test(getNodeIndex(a), 0);
+   test(getNodeIndex(c), 2);
+   test(getNodeIndexLimit(g), 3);
+   trace(arc = addArc(g, a, c));
+   test(getArcIndex(arc), 0);
+   test(getArcByIndex(g, 0) == arc, true);
+   trace(setNodeAttribute(g, "dist", a, 2.5));
+   trace(setNodeAttribute(g, "dist", b, 7.0));
+   test(getNodeAttribute(g, "dist", a), 2.5);
+   test(getNodeAttribute(g, "dist", c), 0.0);
+   test(getNodeAttribute(g, "rank", a), 0.0);
+   trace(removeNode(g, b));
+   test(getNodeByIndex(g, 1) == NULL, true);
+   trace(b = addNode(g, "D"));
+   test(getNodeIndex(b), 1);
+   test(getNodeByIndex(g, 1) == b, true);
+   test(getNodeAttribute(g, "dist", b), 0.0);
+   trace(for (i = 0; i < 100; i++) addNode(g, concat("N", integerToString(i))));
+   test(getNodeIndexLimit(g), 103);
+   test(getNodeAttribute(g, "dist", a), 2.5);
+   trace(dist = getNodeAttributeArray(g, "dist"));
+   test(dist[getNodeIndex(getNode(g, "N99"))], 0.0);
+   trace(dist[getNodeIndex(c)] = 4.0);
+   test(getNodeAttribute(g, "dist", c), 4.0);
+   trace(removeNodeAttribute(g, "dist"));
+   test(getNodeAttribute(g, "dist", c), 0.0);
+   testError(getNodeByIndex(g, 103));
+   trace(freeGraph(g));
+}
+
+static void testNeighborMapping(void) {
+   Graph g, other;
+   Node hub, z, nodes[40];
+   Arc arcs[40], extra;
+   double total;
+   bool ok;
+   int i;
+
+   trace(g = newGraph());
+   trace(hub = addNode(g, "H"));
+   reportMessage("Add arcs from H to N0 through N39 with costs 0 to 39");
+   for (i = 0; i < 40; i++) {
+      nodes[i] = addNode(g, concat("N", integerToString(i)));
+      arcs[i] = addArc(g, hub, nodes[i]);
+      setCost(arcs[i], i);
+   }
+   test(getOutDegree(hub), 40);
+   test(isConnected(hub, nodes[39]), true);
+   test(isConnected(nodes[39], hub), false);
+   trace(total = 0);
+   trace(mapNeighbors(hub, addCost, &total));
+   test(total, 780.0);
+   trace(extra = addArc(g, hub, nodes[5]));
+   trace(removeArc(g, arcs[5]));
+   test(isConnected(hub, nodes[5]), true);
+   trace(removeArc(g, extra));
+   test(isConnected(hub, nodes[5]), false);
+   trace(removeNode(g, nodes[7]));
+   trace(z = addNode(g, "Z"));
+   test(getNodeIndex(z), 8);
+   test(isConnected(hub, z), false);
+   test(getOutDegree(hub), 38);
+   reportMessage("Remove the arcs to every third node");
+   for (i = 0; i < 40; i += 3) {
+      removeArc(g, arcs[i]);
+   }
+   ok = true;
+   for (i = 0; i < 40; i++) {
+      if (i == 5 || i == 7) continue;
+      if (isConnected(hub, nodes[i]) != (i % 3 != 0)) ok = false;
+   }
+   test(ok, true);
+   trace(total = 0);
+   trace(mapNeighbors(hub, addCost, &total));
+   test(total, 495.0);
+   trace(other = newGraph());
+   trace(addNode(other, "X"));
+   trace(addNode(other, "Y"));
+   test(isConnected(hub, addNode(other, "W")), false);
+   trace(freeGraph(other));
+   trace(freeGraph(g));
+}
+
+static void addCost(Node neighbor, Arc arc, void *data) {
+   *((double *) data) += getCost(arc);
+}
+
 static string arcString(Arc arc) {
    return concat(getName(arc->start), concat(" -> ", getName(arc->end)));
 }
 
+static string nodeSetString(Set nodes) {
+   Node node;
+   string str;
+
+   str = "";
+   foreach (node in nodes) {
+      str = concat(str, getName(node));
+   }
+   return str;
+}
+
 #endif
@@ -0,0 +1,2205 @@
+/*
+ * File: graphalgo.c
+ * -----------------
+ * This file implements the graphalgo.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bitvector.h"
+#include "cslib.h"
+#include "disjointset.h"
+#include "graph.h"
+#include "graphalgo.h"
+#include "unittest.h"
+#include "vector.h"
+#include "private/bitops.h"
+
+/*
+ * Type: NodeHeap
+ * --------------
+ * This type is a binary min-heap of node IDs ordered by a priority for
+ * each node.  The pos array records where each node is in the heap, or
+ * -1 if it is not there, which lets the shortest-path algorithms lower
+ * the priority of a node already in the heap instead of adding it again.
+ */
+
+typedef struct {
+   int *heap;
+   int *pos;
+   double *priority;
+   int size;
+} NodeHeap;
+
+/*
+ * Type: AStarContext
+ * ------------------
+ * This type carries a heuristic for Graph nodes through the version of
+ * A* search that works on IDs.
+ */
+
+typedef struct {
+   FrozenGraph fg;
+   HeuristicFn heuristic;
+   void *data;
+} AStarContext;
+
+/*
+ * Constants
+ * ---------
+ * QUEUE_CHUNK          -- Number of queue entries a thread claims at once
+ * WORD_CHUNK           -- Number of bitmap words a thread claims at once
+ * BUFFER_SIZE          -- Capacity of each thread's buffer of new nodes
+ * TOP_DOWN_FACTOR      -- Switch to bottom-up steps once the frontier has
+ *                         more than this fraction of the unexplored arcs
+ * BOTTOM_UP_FACTOR     -- Switch back once a shrinking frontier holds less
+ *                         than this fraction of the nodes
+ * MAX_BUCKET           -- Highest bucket number in delta stepping
+ * MAX_PAGERANK_STEPS   -- Most iterations that pageRankFrozenGraph runs
+ */
+
+#define QUEUE_CHUNK 64
+#define WORD_CHUNK 16
+#define BUFFER_SIZE 256
+#define TOP_DOWN_FACTOR 15
+#define BOTTOM_UP_FACTOR 18
+#define MAX_BUCKET (1 << 20)
+#define MAX_PAGERANK_STEPS 1000
+
+/*
+ * Type: AtomicWord, AtomicDouble
+ * ------------------------------
+ * These types hold the words of the bitmaps and the tentative distances
+ * that several threads update at once.
+ */
+
+typedef _Atomic uint64_t AtomicWord;
+typedef _Atomic double AtomicDouble;
+
+/*
+ * Type: Barrier
+ * -------------
+ * This type lets the threads of a parallel algorithm wait for each other
+ * at the end of each phase.  The last thread to arrive runs the serial
+ * part of the algorithm before it releases the others.  The generation
+ * count tells a thread that the barrier has opened, even if a faster
+ * thread has already arrived at the next phase.
+ */
+
+typedef struct {
+   pthread_mutex_t lock;
+   pthread_cond_t released;
+   int nThreads;
+   int waiting;
+   int generation;
+} Barrier;
+
+/*
+ * Type: BFSState
+ * --------------
+ * This type holds the state that the threads of a parallel breadth-first
+ * search share.  The frontier is kept both as a queue, which top-down
+ * steps divide among the threads, and as a bitmap, which bottom-up steps
+ * test for the sources of incoming arcs.  The fields below the cursor
+ * change only in the serial part of each level.
+ */
+
+typedef struct {
+   FrozenGraph fg;              /* Snapshot being searched            */
+   const int *offsets;          /* Rows of outgoing arcs              */
+   const int *targets;          /* End node of each outgoing arc      */
+   const int *inOffsets;        /* Rows of incoming arcs, once needed */
+   const int *sources;          /* Start node of each incoming arc    */
+   int nNodes;                  /* Number of nodes in the snapshot    */
+   int nWords;                  /* Number of words in each bitmap     */
+   int *depth;                  /* Client's array of depths           */
+   AtomicWord *visited;         /* Bitmap of nodes already reached    */
+   AtomicWord *frontier;        /* Bitmap of the current frontier     */
+   AtomicWord *next;            /* Bitmap of the next frontier        */
+   int *queue;                  /* Queue of the current frontier      */
+   int *nextQueue;              /* Queue of the next frontier         */
+   atomic_int nextSize;         /* Number of nodes in nextQueue       */
+   atomic_long nextArcs;        /* Arcs leaving the next frontier     */
+   atomic_int cursor;           /* Start of the next unclaimed chunk  */
+   int queueSize;               /* Number of nodes in queue           */
+   long unexplored;             /* Arcs leaving unreached nodes       */
+   int level;                   /* Depth of the current frontier      */
+   int reached;                 /* Number of nodes reached so far     */
+   bool bottomUp;               /* True if the next step is bottom-up */
+   bool done;                   /* True once the frontier is empty    */
+   Barrier barrier;             /* Barrier between levels             */
+} BFSState;
+
+/*
+ * Type: BFSWorker
+ * ---------------
+ * This type holds the private state of one thread in a parallel search.
+ * Each thread collects the nodes it reaches in a buffer and appends the
+ * whole buffer to the next queue with a single atomic operation.
+ */
+
+typedef struct {
+   BFSState *state;             /* Shared state of the search         */
+   int index;                   /* Index of this thread               */
+   int nThreads;                /* Number of threads in the search    */
+   int buffer[BUFFER_SIZE];     /* Nodes not yet in the next queue    */
+   int count;                   /* Number of nodes in the buffer      */
+   long arcs;                   /* Arcs leaving the nodes it reached  */
+} BFSWorker;
+
+/*
+ * Type: IdList
+ * ------------
+ * This type is an array of node IDs that grows as needed.
+ */
+
+typedef struct {
+   int *ids;
+   int count;
+   int capacity;
+} IdList;
+
+/*
+ * Type: DeltaState
+ * ----------------
+ * This type holds the state that the threads share in delta stepping.
+ * The frontier holds the nodes in the bucket that the threads are
+ * settling, gathered from the private buckets of each thread.
+ */
+
+typedef struct {
+   const int *offsets;          /* Rows of outgoing arcs              */
+   const int *targets;          /* End node of each arc               */
+   const double *costs;         /* Cost of each arc                   */
+   int nArcs;                   /* Number of arcs in the snapshot     */
+   int nThreads;                /* Number of threads                  */
+   double delta;                /* Width of each bucket               */
+   AtomicDouble *dist;          /* Tentative distance of each node    */
+   int *frontier;               /* Nodes in the current bucket        */
+   int frontierSize;            /* Number of entries in frontier      */
+   int capacity;                /* Allocated size of frontier         */
+   atomic_int nextSize;         /* Entries copied into frontier       */
+   atomic_int cursor;           /* Start of the next unclaimed chunk  */
+   atomic_bool negative;        /* True if some arc cost is negative  */
+   int bucket;                  /* Number of the current bucket       */
+   bool done;                   /* True once every bucket is empty    */
+   Barrier barrier;             /* Barrier between phases             */
+   struct DeltaWorker *workers; /* Private state of each thread       */
+} DeltaState;
+
+/*
+ * Type: DeltaWorker
+ * -----------------
+ * This type holds the private state of one thread in delta stepping,
+ * which includes its own buckets of nodes whose distances it lowered.
+ */
+
+typedef struct DeltaWorker {
+   DeltaState *state;           /* Shared state of the algorithm      */
+   int index;                   /* Index of this thread               */
+   IdList *buckets;             /* Buckets indexed by bucket number   */
+   int nBuckets;                /* Number of allocated buckets        */
+   int lowest;                  /* Lowest nonempty bucket, or -1      */
+} DeltaWorker;
+
+/*
+ * Type: VertexState
+ * -----------------
+ * This type holds the state that the threads of a vertex program share.
+ * The values array holds the results of the previous iteration, which
+ * every update reads, and the next array receives the new values.  The
+ * serial part of each iteration exchanges the two.
+ */
+
+typedef struct {
+   FrozenGraph fg;              /* Snapshot on which the program runs */
+   VertexUpdateFn update;       /* Function that computes each value  */
+   VertexPrepareFn prepare;     /* Function called before iterations  */
+   void *data;                  /* Client data for both functions     */
+   double *values;              /* Values from the previous iteration */
+   double *next;                /* Values being computed              */
+   int *bounds;                 /* Range of IDs for each thread       */
+   int nThreads;                /* Number of threads                  */
+   int iteration;               /* Number of iterations completed     */
+   int maxIterations;           /* Limit on the number of iterations  */
+   double tolerance;            /* Total change that ends the program */
+   bool done;                   /* True once the program has finished */
+   Barrier barrier;             /* Barrier between iterations         */
+   struct VertexWorker *workers; /* Private state of each thread      */
+} VertexState;
+
+/*
+ * Type: VertexWorker
+ * ------------------
+ * This type holds the private state of one thread in a vertex program.
+ */
+
+typedef struct VertexWorker {
+   VertexState *state;          /* Shared state of the program        */
+   int index;                   /* Index of this thread               */
+   double change;               /* Total change in this thread's part */
+} VertexWorker;
+
+/*
+ * Type: PageRankContext
+ * ---------------------
+ * This type holds the data that the PageRank update needs.  Before each
+ * iteration, the prepare function divides the rank of every node by the
+ * number of arcs leaving it, so that each update reads one share per
+ * incoming arc, and adds the rank of the nodes without arcs, which the
+ * walker leaves by jumping to any node, to the base rank of every node.
+ */
+
+typedef struct {
+   const int *offsets;          /* Rows of outgoing arcs              */
+   const int *inOffsets;        /* Rows of incoming arcs              */
+   const int *sources;          /* Start node of each incoming arc    */
+   double *share;               /* Rank each node passes along an arc */
+   double damping;              /* Probability of following an arc    */
+   double base;                 /* Rank every node receives by jumps  */
+} PageRankContext;
+
+/* Private function prototypes */
+
+static void initNodeHeap(NodeHeap *heap, int n);
+static void freeNodeHeap(NodeHeap *heap);
+static void updateNodeHeap(NodeHeap *heap, int id, double priority);
+static int popNodeHeap(NodeHeap *heap);
+static void siftUp(NodeHeap *heap, int k);
+static void siftDown(NodeHeap *heap, int k);
+static void checkNodeId(FrozenGraph fg, int id, string fnName);
+static Vector idsToNodes(FrozenGraph fg, int ids[], int n);
+static Vector groupComponents(FrozenGraph fg, int component[], int nComps);
+static double frozenHeuristic(int id, int goal, void *data);
+static void initBarrier(Barrier *barrier, int nThreads);
+static void destroyBarrier(Barrier *barrier);
+static void waitBarrier(Barrier *barrier, void (*fn)(void *), void *data);
+static void runThreads(void *(*fn)(void *), void *workers, size_t size,
+                       int nThreads);
+static void *bfsWorker(void *arg);
+static void topDownStep(BFSWorker *worker);
+static void bottomUpStep(BFSWorker *worker);
+static void addToNextFrontier(BFSWorker *worker, int id);
+static void flushBuffer(BFSWorker *worker);
+static void finishLevel(void *data);
+static void chooseDirection(BFSState *state, long arcs, int previous);
+static void *deltaWorker(void *arg);
+static void relaxBucket(DeltaWorker *worker);
+static bool lowerDistance(AtomicDouble *dp, double d);
+static void addToBucket(DeltaWorker *worker, int id, int bucket);
+static int lowestBucket(DeltaWorker *worker);
+static void chooseBucket(void *data);
+static void startBucket(void *data);
+static int bucketNumber(double d, double delta);
+static double defaultDelta(FrozenGraph fg);
+static void *vertexWorker(void *arg);
+static void finishIteration(void *data);
+static void preparePageRank(FrozenGraph fg, const double rank[], void *data);
+static double updatePageRank(FrozenGraph fg, int id, const double rank[],
+                             void *data);
+
+/* Exported entries */
+
+/*
+ * Implementation notes: breadthFirstSearch and the other Graph functions
+ * ----------------------------------------------------------------------
+ * These functions run the algorithms for snapshots on a snapshot from
+ * freezeGraphStructure, which does not copy the node names, and find
+ * the IDs of the nodes passed to them with getFrozenIdForNode, which
+ * takes constant time instead of building a table of the names.
+ */
+
+Vector breadthFirstSearch(Graph g, Node start) {
+   FrozenGraph fg;
+   Vector result;
+   int *order;
+   int n;
+
+   fg = freezeGraphStructure(g);
+   order = newArray(getFrozenNodeCount(fg), int);
+   n = breadthFirstFrozenGraph(fg, getFrozenIdForNode(fg, start), order);
+   result = idsToNodes(fg, order, n);
+   freeBlock(order);
+   freeFrozenGraph(fg);
+   return result;
+}
+
+Vector depthFirstSearch(Graph g, Node start) {
+   FrozenGraph fg;
+   Vector result;
+   int *order;
+   int n;
+
+   fg = freezeGraphStructure(g);
+   order = newArray(getFrozenNodeCount(fg), int);
+   n = depthFirstFrozenGraph(fg, getFrozenIdForNode(fg, start), order);
+   result = idsToNodes(fg, order, n);
+   freeBlock(order);
+   freeFrozenGraph(fg);
+   return result;
+}
+
+Vector findShortestPath(Graph g, Node start, Node finish) {
+   return findPathAStar(g, start, finish, NULL, NULL);
+}
+
+/*
+ * Implementation notes: findPathAStar
+ * -----------------------------------
+ * Dijkstra's algorithm is A* search with an estimate of zero, which is
+ * how findShortestPath is implemented.
+ */
+
+Vector findPathAStar(Graph g, Node start, Node finish,
+                     HeuristicFn heuristic, void *data) {
+   FrozenGraph fg;
+   AStarContext context;
+   Vector result;
+   int *path;
+   int n;
+
+   fg = freezeGraphStructure(g);
+   context.fg = fg;
+   context.heuristic = heuristic;
+   context.data = data;
+   path = newArray(getFrozenNodeCount(fg), int);
+   n = aStarFrozenGraph(fg, getFrozenIdForNode(fg, start),
+                        getFrozenIdForNode(fg, finish),
+                        (heuristic == NULL) ? NULL : frozenHeuristic,
+                        &context, path);
+   result = idsToNodes(fg, path, n);
+   freeBlock(path);
+   freeFrozenGraph(fg);
+   return result;
+}
+
+Vector topologicalSort(Graph g) {
+   FrozenGraph fg;
+   Vector result;
+   int *order;
+
+   fg = freezeGraphStructure(g);
+   order = newArray(getFrozenNodeCount(fg), int);
+   result = NULL;
+   if (topologicalSortFrozenGraph(fg, order)) {
+      result = idsToNodes(fg, order, getFrozenNodeCount(fg));
+   }
+   freeBlock(order);
+   freeFrozenGraph(fg);
+   return result;
+}
+
+Vector findStronglyConnectedComponents(Graph g) {
+   FrozenGraph fg;
+   Vector result;
+   int *component;
+   int nComps;
+
+   fg = freezeGraphStructure(g);
+   component = newArray(getFrozenNodeCount(fg), int);
+   nComps = strongComponentsFrozenGraph(fg, component);
+   result = groupComponents(fg, component, nComps);
+   freeBlock(component);
+   freeFrozenGraph(fg);
+   return result;
+}
+
+Vector findConnectedComponents(Graph g) {
+   FrozenGraph fg;
+   Vector result;
+   int *component;
+   int nComps;
+
+   fg = freezeGraphStructure(g);
+   component = newArray(getFrozenNodeCount(fg), int);
+   nComps = connectedComponentsFrozenGraph(fg, component);
+   result = groupComponents(fg, component, nComps);
+   freeBlock(component);
+   freeFrozenGraph(fg);
+   return result;
+}
+
+/*
+ * Implementation notes: breadthFirstFrozenGraph
+ * ---------------------------------------------
+ * The order array doubles as the queue, because nodes leave the queue
+ * in the same order in which they enter it.
+ */
+
+int breadthFirstFrozenGraph(FrozenGraph fg, int start, int order[]) {
+   const int *offsets, *targets;
+   BitVector visited;
+   int head, tail, u, v, i;
+
+   checkNodeId(fg, start, "breadthFirstFrozenGraph");
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   visited = newBitVector(getFrozenNodeCount(fg));
+   addBitVector(visited, start);
+   order[0] = start;
+   head = 0;
+   tail = 1;
+   while (head < tail) {
+      u = order[head++];
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         v = targets[i];
+         if (!containsBitVector(visited, v)) {
+            addBitVector(visited, v);
+            order[tail++] = v;
+         }
+      }
+   }
+   freeBitVector(visited);
+   return tail;
+}
+
+/*
+ * Implementation notes: depthFirstFrozenGraph
+ * -------------------------------------------
+ * The search keeps its own stack of nodes, along with the index of the
+ * next arc to examine for each, so that it visits the nodes in the same
+ * order as the recursive algorithm without risking a stack overflow on
+ * a long path.
+ */
+
+int depthFirstFrozenGraph(FrozenGraph fg, int start, int order[]) {
+   const int *offsets, *targets;
+   BitVector visited;
+   int *stack, *next;
+   int sp, count, u, v;
+
+   checkNodeId(fg, start, "depthFirstFrozenGraph");
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   visited = newBitVector(getFrozenNodeCount(fg));
+   stack = newArray(getFrozenNodeCount(fg), int);
+   next = newArray(getFrozenNodeCount(fg), int);
+   addBitVector(visited, start);
+   order[0] = start;
+   count = 1;
+   stack[0] = start;
+   next[0] = offsets[start];
+   sp = 1;
+   while (sp > 0) {
+      u = stack[sp - 1];
+      if (next[sp - 1] == offsets[u + 1]) {
+         sp--;
+         continue;
+      }
+      v = targets[next[sp - 1]++];
+      if (!containsBitVector(visited, v)) {
+         addBitVector(visited, v);
+         order[count++] = v;
+         stack[sp] = v;
+         next[sp] = offsets[v];
+         sp++;
+      }
+   }
+   freeBitVector(visited);
+   freeBlock(stack);
+   freeBlock(next);
+   return count;
+}
+
+void shortestDistancesFrozenGraph(FrozenGraph fg, int start, double dist[],
+                                  int parent[]) {
+   const int *offsets, *targets;
+   const double *costs;
+   NodeHeap heap;
+   double *d, nd;
+   int *p;
+   int n, u, v, i;
+
+   checkNodeId(fg, start, "shortestDistancesFrozenGraph");
+   n = getFrozenNodeCount(fg);
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   costs = getFrozenCosts(fg);
+   d = (dist == NULL) ? newArray(n, double) : dist;
+   p = (parent == NULL) ? newArray(n, int) : parent;
+   for (i = 0; i < n; i++) {
+      d[i] = HUGE_VAL;
+      p[i] = -1;
+   }
+   initNodeHeap(&heap, n);
+   d[start] = 0;
+   updateNodeHeap(&heap, start, 0);
+   while (heap.size > 0) {
+      u = popNodeHeap(&heap);
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         if (costs[i] < 0) {
+            error("shortestDistancesFrozenGraph: Negative arc cost");
+         }
+         v = targets[i];
+         nd = d[u] + costs[i];
+         if (nd < d[v]) {
+            d[v] = nd;
+            p[v] = u;
+            updateNodeHeap(&heap, v, nd);
+         }
+      }
+   }
+   freeNodeHeap(&heap);
+   if (dist == NULL) freeBlock(d);
+   if (parent == NULL) freeBlock(p);
+}
+
+/*
+ * Implementation notes: aStarFrozenGraph
+ * --------------------------------------
+ * The heap orders nodes by their distance from the start plus the
+ * estimate of their distance to the goal.  A node can return to the heap
+ * after it has left it if a shorter path to it turns up later, which
+ * happens only if the estimate is inconsistent, so the search finds the
+ * shortest path for any estimate that never overstates the true cost.
+ */
+
+int aStarFrozenGraph(FrozenGraph fg, int start, int goal,
+                     FrozenHeuristicFn heuristic, void *data, int path[]) {
+   const int *offsets, *targets;
+   const double *costs;
+   NodeHeap heap;
+   double *dist, nd, h;
+   int *parent;
+   int n, u, v, i, count;
+
+   checkNodeId(fg, start, "aStarFrozenGraph");
+   checkNodeId(fg, goal, "aStarFrozenGraph");
+   n = getFrozenNodeCount(fg);
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   costs = getFrozenCosts(fg);
+   dist = newArray(n, double);
+   parent = newArray(n, int);
+   for (i = 0; i < n; i++) {
+      dist[i] = HUGE_VAL;
+      parent[i] = -1;
+   }
+   initNodeHeap(&heap, n);
+   dist[start] = 0;
+   updateNodeHeap(&heap, start, 0);
+   while (heap.size > 0) {
+      u = popNodeHeap(&heap);
+      if (u == goal) break;
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         if (costs[i] < 0) error("aStarFrozenGraph: Negative arc cost");
+         v = targets[i];
+         nd = dist[u] + costs[i];
+         if (nd < dist[v]) {
+            dist[v] = nd;
+            parent[v] = u;
+            h = (heuristic == NULL) ? 0 : heuristic(v, goal, data);
+            updateNodeHeap(&heap, v, nd + h);
+         }
+      }
+   }
+   count = 0;
+   if (dist[goal] < HUGE_VAL) {
+      for (v = goal; v != -1; v = parent[v]) {
+         count++;
+      }
+      i = count;
+      for (v = goal; v != -1; v = parent[v]) {
+         path[--i] = v;
+      }
+   }
+   freeNodeHeap(&heap);
+   freeBlock(dist);
+   freeBlock(parent);
+   return count;
+}
+
+/*
+ * Implementation notes: topologicalSortFrozenGraph
+ * ------------------------------------------------
+ * The function uses Kahn's algorithm, which repeatedly removes a node
+ * with no incoming arcs.  As in breadthFirstFrozenGraph, the order array
+ * serves as the queue.  If nodes remain when the queue runs out, each of
+ * them has an incoming arc from another, so the graph has a cycle.
+ */
+
+bool topologicalSortFrozenGraph(FrozenGraph fg, int order[]) {
+   const int *offsets, *targets;
+   int *inDegree;
+   int n, m, head, tail, u, i;
+
+   n = getFrozenNodeCount(fg);
+   m = getFrozenArcCount(fg);
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   inDegree = newArray(n, int);
+   for (i = 0; i < n; i++) {
+      inDegree[i] = 0;
+   }
+   for (i = 0; i < m; i++) {
+      inDegree[targets[i]]++;
+   }
+   tail = 0;
+   for (i = 0; i < n; i++) {
+      if (inDegree[i] == 0) order[tail++] = i;
+   }
+   head = 0;
+   while (head < tail) {
+      u = order[head++];
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         if (--inDegree[targets[i]] == 0) order[tail++] = targets[i];
+      }
+   }
+   freeBlock(inDegree);
+   return tail == n;
+}
+
+/*
+ * Implementation notes: strongComponentsFrozenGraph
+ * -------------------------------------------------
+ * This function is Tarjan's algorithm with the recursion replaced by an
+ * explicit stack, which holds each node on the current search path along
+ * with the index of its next arc.  The index array records the order in
+ * which the search reaches each node, and low records the smallest index
+ * reachable from the subtree below it through nodes still on the
+ * component stack.  A node whose low value equals its own index is the
+ * first node of a component, which consists of the nodes above it on the
+ * component stack.  Tarjan's algorithm completes a component only after
+ * every component reachable from it, which gives the numbering its
+ * reverse topological order.
+ */
+
+int strongComponentsFrozenGraph(FrozenGraph fg, int component[]) {
+   const int *offsets, *targets;
+   BitVector onStack;
+   int *index, *low, *stack, *path, *next;
+   int n, s, u, v, w, sp, pp, counter, nComps;
+
+   n = getFrozenNodeCount(fg);
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   index = newArray(n, int);
+   low = newArray(n, int);
+   stack = newArray(n, int);
+   path = newArray(n, int);
+   next = newArray(n, int);
+   onStack = newBitVector(n);
+   for (s = 0; s < n; s++) {
+      index[s] = -1;
+   }
+   counter = nComps = sp = 0;
+   for (s = 0; s < n; s++) {
+      if (index[s] != -1) continue;
+      index[s] = low[s] = counter++;
+      stack[sp++] = s;
+      addBitVector(onStack, s);
+      path[0] = s;
+      next[0] = offsets[s];
+      pp = 1;
+      while (pp > 0) {
+         u = path[pp - 1];
+         if (next[pp - 1] < offsets[u + 1]) {
+            v = targets[next[pp - 1]++];
+            if (index[v] == -1) {
+               index[v] = low[v] = counter++;
+               stack[sp++] = v;
+               addBitVector(onStack, v);
+               path[pp] = v;
+               next[pp] = offsets[v];
+               pp++;
+            } else if (containsBitVector(onStack, v) && index[v] < low[u]) {
+               low[u] = index[v];
+            }
+            continue;
+         }
+         pp--;
+         if (low[u] == index[u]) {
+            do {
+               w = stack[--sp];
+               removeBitVector(onStack, w);
+               component[w] = nComps;
+            } while (w != u);
+            nComps++;
+         }
+         if (pp > 0 && low[u] < low[path[pp - 1]]) {
+            low[path[pp - 1]] = low[u];
+         }
+      }
+   }
+   freeBlock(index);
+   freeBlock(low);
+   freeBlock(stack);
+   freeBlock(path);
+   freeBlock(next);
+   freeBitVector(onStack);
+   return nComps;
+}
+
+int connectedComponentsFrozenGraph(FrozenGraph fg, int component[]) {
+   const int *offsets, *targets;
+   DisjointSet ds;
+   int *label;
+   int n, u, i, root, nComps;
+
+   n = getFrozenNodeCount(fg);
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   ds = newDisjointSet(n);
+   for (u = 0; u < n; u++) {
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         unionDisjointSet(ds, u, targets[i]);
+      }
+   }
+   label = newArray(n, int);
+   for (i = 0; i < n; i++) {
+      label[i] = -1;
+   }
+   nComps = 0;
+   for (u = 0; u < n; u++) {
+      root = findDisjointSet(ds, u);
+      if (label[root] == -1) label[root] = nComps++;
+      component[u] = label[root];
+   }
+   freeBlock(label);
+   freeDisjointSet(ds);
+   return nComps;
+}
+
+/*
+ * Implementation notes: parallelBreadthFirstFrozenGraph
+ * -----------------------------------------------------
+ * The calling thread sets up the first frontier and then works alongside
+ * the threads it creates.  Each level of the search has two phases.  In
+ * the first, the threads claim chunks of the frontier, or of the bitmap
+ * of visited nodes in a bottom-up step, and add the nodes they reach to
+ * the next frontier.  A thread claims a node in a top-down step by
+ * setting its bit in the visited bitmap, so that only one thread records
+ * each node.  In a bottom-up step, each word of that bitmap belongs to
+ * the thread that claimed it.  The last thread to finish the first phase
+ * swaps the frontiers and decides the direction of the next step, after
+ * which the threads clear the old frontier bitmap for reuse.  The choice
+ * of direction follows Beamer, Asanovic, and Patterson, "Direction-
+ * Optimizing Breadth-First Search" (SC 2012).
+ */
+
+int parallelBreadthFirstFrozenGraph(FrozenGraph fg, int starts[], int n,
+                                    int depth[], int nThreads) {
+   BFSState state;
+   BFSWorker *workers;
+   uint64_t mask;
+   long arcs;
+   int i, u;
+
+   if (nThreads < 1) error("parallelBreadthFirstFrozenGraph: No threads");
+   for (i = 0; i < n; i++) {
+      checkNodeId(fg, starts[i], "parallelBreadthFirstFrozenGraph");
+   }
+   state.fg = fg;
+   state.offsets = getFrozenOffsets(fg);
+   state.targets = getFrozenTargets(fg);
+   state.inOffsets = NULL;
+   state.sources = NULL;
+   state.nNodes = getFrozenNodeCount(fg);
+   state.nWords = (state.nNodes + 63) / 64;
+   state.depth = depth;
+   state.visited = newArray(state.nWords + 1, AtomicWord);
+   state.frontier = newArray(state.nWords + 1, AtomicWord);
+   state.next = newArray(state.nWords + 1, AtomicWord);
+   for (i = 0; i <= state.nWords; i++) {
+      atomic_init(&state.visited[i], 0);
+      atomic_init(&state.frontier[i], 0);
+      atomic_init(&state.next[i], 0);
+   }
+   if (state.nNodes % 64 != 0) {
+      atomic_store(&state.visited[state.nWords - 1],
+                   ~(((uint64_t) 1 << (state.nNodes % 64)) - 1));
+   }
+   state.queue = newArray(state.nNodes + 1, int);
+   state.nextQueue = newArray(state.nNodes + 1, int);
+   for (i = 0; i < state.nNodes; i++) {
+      depth[i] = -1;
+   }
+   state.queueSize = 0;
+   arcs = 0;
+   for (i = 0; i < n; i++) {
+      u = starts[i];
+      if (depth[u] == -1) {
+         depth[u] = 0;
+         mask = (uint64_t) 1 << (u & 63);
+         atomic_fetch_or(&state.visited[u >> 6], mask);
+         atomic_fetch_or(&state.frontier[u >> 6], mask);
+         state.queue[state.queueSize++] = u;
+         arcs += state.offsets[u + 1] - state.offsets[u];
+      }
+   }
+   atomic_init(&state.nextSize, 0);
+   atomic_init(&state.nextArcs, 0);
+   atomic_init(&state.cursor, 0);
+   state.unexplored = getFrozenArcCount(fg);
+   state.level = 0;
+   state.reached = state.queueSize;
+   state.bottomUp = false;
+   state.done = (state.queueSize == 0);
+   chooseDirection(&state, arcs, 0);
+   if (!state.done) {
+      workers = newArray(nThreads, BFSWorker);
+      for (i = 0; i < nThreads; i++) {
+         workers[i].state = &state;
+         workers[i].index = i;
+         workers[i].nThreads = nThreads;
+         workers[i].count = 0;
+         workers[i].arcs = 0;
+      }
+      initBarrier(&state.barrier, nThreads);
+      runThreads(bfsWorker, workers, sizeof(BFSWorker), nThreads);
+      destroyBarrier(&state.barrier);
+      freeBlock(workers);
+   }
+   freeBlock(state.visited);
+   freeBlock(state.frontier);
+   freeBlock(state.next);
+   freeBlock(state.queue);
+   freeBlock(state.nextQueue);
+   return state.reached;
+}
+
+/*
+ * Implementation notes: deltaSteppingFrozenGraph
+ * ----------------------------------------------
+ * The algorithm follows Meyer and Sanders, "Delta-Stepping: A
+ * Parallelizable Shortest Path Algorithm" (J. Algorithms, 2003), except
+ * that it relaxes every arc leaving a node in the current bucket rather
+ * than separating light arcs from heavy ones.  Each thread keeps its own
+ * buckets, so that a thread that lowers a distance needs no lock to
+ * record the node.  Each round has two phases.  In the first, the
+ * threads claim chunks of the frontier and relax the arcs leaving those
+ * nodes, skipping any node whose distance has fallen into an earlier
+ * bucket since it was added.  The last thread to finish chooses the
+ * lowest bucket that any thread holds, which may be the current bucket
+ * again.  In the second phase, every thread copies its part of that
+ * bucket into the shared frontier.  Because the threads must not call
+ * error, they only note a negative cost, and the calling thread reports
+ * it once the others have finished.
+ */
+
+void deltaSteppingFrozenGraph(FrozenGraph fg, int starts[], int n,
+                              double dist[], double delta, int nThreads) {
+   DeltaState state;
+   DeltaWorker *workers;
+   int nNodes, i, j, u;
+
+   if (nThreads < 1) error("deltaSteppingFrozenGraph: No threads");
+   if (delta < 0) error("deltaSteppingFrozenGraph: Negative delta");
+   for (i = 0; i < n; i++) {
+      checkNodeId(fg, starts[i], "deltaSteppingFrozenGraph");
+   }
+   nNodes = getFrozenNodeCount(fg);
+   state.offsets = getFrozenOffsets(fg);
+   state.targets = getFrozenTargets(fg);
+   state.costs = getFrozenCosts(fg);
+   state.nArcs = getFrozenArcCount(fg);
+   state.nThreads = nThreads;
+   state.delta = (delta == 0) ? defaultDelta(fg) : delta;
+   state.dist = newArray(nNodes + 1, AtomicDouble);
+   for (i = 0; i < nNodes; i++) {
+      atomic_init(&state.dist[i], HUGE_VAL);
+   }
+   state.capacity = n + 1;
+   state.frontier = newArray(state.capacity, int);
+   state.frontierSize = 0;
+   for (i = 0; i < n; i++) {
+      u = starts[i];
+      if (atomic_load(&state.dist[u]) != 0) {
+         atomic_store(&state.dist[u], 0);
+         state.frontier[state.frontierSize++] = u;
+      }
+   }
+   atomic_init(&state.nextSize, 0);
+   atomic_init(&state.cursor, 0);
+   atomic_init(&state.negative, false);
+   state.bucket = 0;
+   state.done = false;
+   workers = newArray(nThreads, DeltaWorker);
+   for (i = 0; i < nThreads; i++) {
+      workers[i].state = &state;
+      workers[i].index = i;
+      workers[i].buckets = NULL;
+      workers[i].nBuckets = 0;
+      workers[i].lowest = -1;
+   }
+   state.workers = workers;
+   initBarrier(&state.barrier, nThreads);
+   runThreads(deltaWorker, workers, sizeof(DeltaWorker), nThreads);
+   destroyBarrier(&state.barrier);
+   for (i = 0; i < nThreads; i++) {
+      for (j = 0; j < workers[i].nBuckets; j++) {
+         if (workers[i].buckets[j].ids != NULL) {
+            freeBlock(workers[i].buckets[j].ids);
+         }
+      }
+      if (workers[i].buckets != NULL) freeBlock(workers[i].buckets);
+   }
+   freeBlock(workers);
+   freeBlock(state.frontier);
+   if (atomic_load(&state.negative)) {
+      freeBlock(state.dist);
+      error("deltaSteppingFrozenGraph: Negative arc cost");
+   }
+   for (i = 0; i < nNodes; i++) {
+      dist[i] = atomic_load(&state.dist[i]);
+   }
+   freeBlock(state.dist);
+}
+
+/*
+ * Implementation notes: partitionFrozenGraph
+ * ------------------------------------------
+ * The total weight of the nodes before ID u is u + offsets[u] +
+ * inOffsets[u], which grows with u, so each bound is found by binary
+ * search without summing the weights.
+ */
+
+void partitionFrozenGraph(FrozenGraph fg, int nParts, int bounds[]) {
+   const int *offsets, *inOffsets;
+   long total, target;
+   int nNodes, k, lh, rh, mid;
+
+   if (nParts < 1) error("partitionFrozenGraph: No parts");
+   offsets = getFrozenOffsets(fg);
+   inOffsets = getFrozenInOffsets(fg);
+   nNodes = getFrozenNodeCount(fg);
+   total = nNodes + 2L * getFrozenArcCount(fg);
+   bounds[0] = 0;
+   for (k = 1; k < nParts; k++) {
+      target = total * k / nParts;
+      lh = bounds[k - 1];
+      rh = nNodes;
+      while (lh < rh) {
+         mid = lh + (rh - lh) / 2;
+         if (mid + (long) offsets[mid] + inOffsets[mid] < target) {
+            lh = mid + 1;
+         } else {
+            rh = mid;
+         }
+      }
+      bounds[k] = lh;
+   }
+   bounds[nParts] = nNodes;
+}
+
+/*
+ * Implementation notes: runVertexProgram
+ * --------------------------------------
+ * Each thread updates the nodes in its own range, so no two threads
+ * write the same element, and all of them read the values array, which
+ * no thread changes during an iteration.  The last thread to finish an
+ * iteration adds up the changes, exchanges the arrays, and calls the
+ * prepare function for the next iteration.  If the final values end up
+ * in the scratch array, they are copied back into the client's array.
+ */
+
+int runVertexProgram(FrozenGraph fg, VertexUpdateFn update,
+                     VertexPrepareFn prepare, void *data, double values[],
+                     int maxIterations, double tolerance, int nThreads) {
+   VertexState state;
+   VertexWorker *workers;
+   double *scratch;
+   int nNodes, i;
+
+   if (nThreads < 1) error("runVertexProgram: No threads");
+   nNodes = getFrozenNodeCount(fg);
+   scratch = newArray(nNodes + 1, double);
+   state.fg = fg;
+   state.update = update;
+   state.prepare = prepare;
+   state.data = data;
+   state.values = values;
+   state.next = scratch;
+   state.bounds = newArray(nThreads + 1, int);
+   partitionFrozenGraph(fg, nThreads, state.bounds);
+   state.nThreads = nThreads;
+   state.iteration = 0;
+   state.maxIterations = maxIterations;
+   state.tolerance = tolerance;
+   state.done = maxIterations <= 0;
+   if (!state.done) {
+      if (prepare != NULL) prepare(fg, values, data);
+      workers = newArray(nThreads, VertexWorker);
+      for (i = 0; i < nThreads; i++) {
+         workers[i].state = &state;
+         workers[i].index = i;
+         workers[i].change = 0;
+      }
+      state.workers = workers;
+      initBarrier(&state.barrier, nThreads);
+      runThreads(vertexWorker, workers, sizeof(VertexWorker), nThreads);
+      destroyBarrier(&state.barrier);
+      freeBlock(workers);
+   }
+   if (state.values == scratch) {
+      memcpy(values, scratch, nNodes * sizeof(double));
+   }
+   freeBlock(scratch);
+   freeBlock(state.bounds);
+   return state.iteration;
+}
+
+/*
+ * Implementation notes: pageRankFrozenGraph
+ * -----------------------------------------
+ * Each update pulls the shares of rank along the incoming arcs, so that
+ * every node is written by exactly one thread.
+ */
+
+int pageRankFrozenGraph(FrozenGraph fg, double rank[], double damping,
+                        double tolerance, int nThreads) {
+   PageRankContext context;
+   int nNodes, i, n;
+
+   if (damping < 0 || damping > 1) {
+      error("pageRankFrozenGraph: Damping must be between 0 and 1");
+   }
+   nNodes = getFrozenNodeCount(fg);
+   for (i = 0; i < nNodes; i++) {
+      rank[i] = 1.0 / nNodes;
+   }
+   context.offsets = getFrozenOffsets(fg);
+   context.inOffsets = getFrozenInOffsets(fg);
+   context.sources = getFrozenSources(fg);
+   context.share = newArray(nNodes + 1, double);
+   context.damping = damping;
+   n = runVertexProgram(fg, updatePageRank, preparePageRank, &context, rank,
+                        MAX_PAGERANK_STEPS, tolerance, nThreads);
+   freeBlock(context.share);
+   return n;
+}
+
+/* Private functions */
+
+static void initNodeHeap(NodeHeap *heap, int n) {
+   int i;
+
+   heap->heap = newArray(n, int);
+   heap->pos = newArray(n, int);
+   heap->priority = newArray(n, double);
+   heap->size = 0;
+   for (i = 0; i < n; i++) {
+      heap->pos[i] = -1;
+   }
+}
+
+static void freeNodeHeap(NodeHeap *heap) {
+   freeBlock(heap->heap);
+   freeBlock(heap->pos);
+   freeBlock(heap->priority);
+}
+
+/*
+ * Implementation notes: updateNodeHeap
+ * ------------------------------------
+ * Adds the node to the heap with the specified priority or, if it is
+ * already there, lowers its priority.  The shortest-path algorithms call
+ * this function only when a priority decreases, so the node can only
+ * need to move toward the root.
+ */
+
+static void updateNodeHeap(NodeHeap *heap, int id, double priority) {
+   heap->priority[id] = priority;
+   if (heap->pos[id] == -1) {
+      heap->heap[heap->size] = id;
+      heap->pos[id] = heap->size++;
+   }
+   siftUp(heap, heap->pos[id]);
+}
+
+static int popNodeHeap(NodeHeap *heap) {
+   int top;
+
+   top = heap->heap[0];
+   heap->pos[top] = -1;
+   heap->size--;
+   if (heap->size > 0) {
+      heap->heap[0] = heap->heap[heap->size];
+      heap->pos[heap->heap[0]] = 0;
+      siftDown(heap, 0);
+   }
+   return top;
+}
+
+static void siftUp(NodeHeap *heap, int k) {
+   int id, parent;
+   double priority;
+
+   id = heap->heap[k];
+   priority = heap->priority[id];
+   while (k > 0) {
+      parent = (k - 1) / 2;
+      if (heap->priority[heap->heap[parent]] <= priority) break;
+      heap->heap[k] = heap->heap[parent];
+      heap->pos[heap->heap[k]] = k;
+      k = parent;
+   }
+   heap->heap[k] = id;
+   heap->pos[id] = k;
+}
+
+static void siftDown(NodeHeap *heap, int k) {
+   int id, child;
+   double priority;
+
+   id = heap->heap[k];
+   priority = heap->priority[id];
+   while ((child = 2 * k + 1) < heap->size) {
+      if (child + 1 < heap->size && heap->priority[heap->heap[child + 1]]
+                                    < heap->priority[heap->heap[child]]) {
+         child++;
+      }
+      if (priority <= heap->priority[heap->heap[child]]) break;
+      heap->heap[k] = heap->heap[child];
+      heap->pos[heap->heap[k]] = k;
+      k = child;
+   }
+   heap->heap[k] = id;
+   heap->pos[id] = k;
+}
+
+static void checkNodeId(FrozenGraph fg, int id, string fnName) {
+   if (id < 0 || id >= getFrozenNodeCount(fg)) {
+      error("%s: Node ID %d out of range", fnName, id);
+   }
+}
+
+static Vector idsToNodes(FrozenGraph fg, int ids[], int n) {
+   Vector vec;
+   int i;
+
+   vec = newVector();
+   for (i = 0; i < n; i++) {
+      addVector(vec, getFrozenNode(fg, ids[i]));
+   }
+   return vec;
+}
+
+static Vector groupComponents(FrozenGraph fg, int component[], int nComps) {
+   Vector result;
+   int i;
+
+   result = newVector();
+   for (i = 0; i < nComps; i++) {
+      addVector(result, newVector());
+   }
+   for (i = 0; i < getFrozenNodeCount(fg); i++) {
+      addVector(getVector(result, component[i]), getFrozenNode(fg, i));
+   }
+   return result;
+}
+
+static double frozenHeuristic(int id, int goal, void *data) {
+   AStarContext *context;
+
+   context = (AStarContext *) data;
+   return context->heuristic(getFrozenNode(context->fg, id),
+                             getFrozenNode(context->fg, goal),
+                             context->data);
+}
+
+/*
+ * Implementation notes: initBarrier, destroyBarrier, waitBarrier
+ * --------------------------------------------------------------
+ * The barrier is built from a mutex and a condition variable, because
+ * not every platform provides pthread_barrier_t.  The last thread to
+ * arrive calls fn while it holds the lock, so that the serial part of
+ * each phase sees the results of every thread and all of them see its
+ * results in turn.
+ */
+
+static void initBarrier(Barrier *barrier, int nThreads) {
+   pthread_mutex_init(&barrier->lock, NULL);
+   pthread_cond_init(&barrier->released, NULL);
+   barrier->nThreads = nThreads;
+   barrier->waiting = 0;
+   barrier->generation = 0;
+}
+
+static void destroyBarrier(Barrier *barrier) {
+   pthread_mutex_destroy(&barrier->lock);
+   pthread_cond_destroy(&barrier->released);
+}
+
+static void waitBarrier(Barrier *barrier, void (*fn)(void *), void *data) {
+   int generation;
+
+   pthread_mutex_lock(&barrier->lock);
+   generation = barrier->generation;
+   barrier->waiting++;
+   if (barrier->waiting == barrier->nThreads) {
+      if (fn != NULL) fn(data);
+      barrier->waiting = 0;
+      barrier->generation++;
+      pthread_cond_broadcast(&barrier->released);
+   } else {
+      while (generation == barrier->generation) {
+         pthread_cond_wait(&barrier->released, &barrier->lock);
+      }
+   }
+   pthread_mutex_unlock(&barrier->lock);
+}
+
+/*
+ * Function: runThreads
+ * Usage: runThreads(fn, workers, size, nThreads);
+ * -----------------------------------------------
+ * Calls fn on each of the nThreads elements of the workers array, whose
+ * elements are size bytes long, with each call in its own thread.  The
+ * calling thread handles the first element itself and returns once
+ * every call has finished.
+ */
+
+static void runThreads(void *(*fn)(void *), void *workers, size_t size,
+                       int nThreads) {
+   pthread_t *threads;
+   char *base;
+   int i;
+
+   base = (char *) workers;
+   threads = newArray(nThreads, pthread_t);
+   for (i = 1; i < nThreads; i++) {
+      pthread_create(&threads[i], NULL, fn, base + i * size);
+   }
+   fn(base);
+   for (i = 1; i < nThreads; i++) {
+      pthread_join(threads[i], NULL);
+   }
+   freeBlock(threads);
+}
+
+static void *bfsWorker(void *arg) {
+   BFSWorker *worker;
+   BFSState *state;
+   int lo, hi, i;
+
+   worker = (BFSWorker *) arg;
+   state = worker->state;
+   lo = (int) ((long) state->nWords * worker->index / worker->nThreads);
+   hi = (int) ((long) state->nWords * (worker->index + 1) / worker->nThreads);
+   while (true) {
+      if (state->bottomUp) {
+         bottomUpStep(worker);
+      } else {
+         topDownStep(worker);
+      }
+      flushBuffer(worker);
+      atomic_fetch_add(&state->nextArcs, worker->arcs);
+      worker->arcs = 0;
+      waitBarrier(&state->barrier, finishLevel, state);
+      if (state->done) break;
+      for (i = lo; i < hi; i++) {
+         atomic_store_explicit(&state->next[i], 0, memory_order_relaxed);
+      }
+      waitBarrier(&state->barrier, NULL, NULL);
+   }
+   return NULL;
+}
+
+static void topDownStep(BFSWorker *worker) {
+   BFSState *state;
+   uint64_t mask;
+   int lo, hi, k, i, u, v;
+
+   state = worker->state;
+   while ((lo = atomic_fetch_add(&state->cursor, QUEUE_CHUNK))
+                                                   < state->queueSize) {
+      hi = lo + QUEUE_CHUNK;
+      if (hi > state->queueSize) hi = state->queueSize;
+      for (k = lo; k < hi; k++) {
+         u = state->queue[k];
+         for (i = state->offsets[u]; i < state->offsets[u + 1]; i++) {
+            v = state->targets[i];
+            mask = (uint64_t) 1 << (v & 63);
+            if (atomic_load_explicit(&state->visited[v >> 6],
+                                     memory_order_relaxed) & mask) continue;
+            if (atomic_fetch_or(&state->visited[v >> 6], mask) & mask) {
+               continue;
+            }
+            state->depth[v] = state->level + 1;
+            atomic_fetch_or_explicit(&state->next[v >> 6], mask,
+                                     memory_order_relaxed);
+            addToNextFrontier(worker, v);
+         }
+      }
+   }
+}
+
+static void bottomUpStep(BFSWorker *worker) {
+   BFSState *state;
+   uint64_t unreached, found;
+   int lo, hi, w, i, u, v;
+
+   state = worker->state;
+   while ((lo = atomic_fetch_add(&state->cursor, WORD_CHUNK))
+                                                   < state->nWords) {
+      hi = lo + WORD_CHUNK;
+      if (hi > state->nWords) hi = state->nWords;
+      for (w = lo; w < hi; w++) {
+         unreached = ~atomic_load_explicit(&state->visited[w],
+                                           memory_order_relaxed);
+         found = 0;
+         while (unreached != 0) {
+            v = w * 64 + lowestBit(unreached);
+            unreached &= unreached - 1;
+            for (i = state->inOffsets[v]; i < state->inOffsets[v + 1]; i++) {
+               u = state->sources[i];
+               if ((atomic_load_explicit(&state->frontier[u >> 6],
+                                         memory_order_relaxed)
+                    >> (u & 63)) & 1) {
+                  found |= (uint64_t) 1 << (v & 63);
+                  state->depth[v] = state->level + 1;
+                  addToNextFrontier(worker, v);
+                  break;
+               }
+            }
+         }
+         if (found != 0) {
+            atomic_fetch_or_explicit(&state->visited[w], found,
+                                     memory_order_relaxed);
+            atomic_store_explicit(&state->next[w], found,
+                                  memory_order_relaxed);
+         }
+      }
+   }
+}
+
+static void addToNextFrontier(BFSWorker *worker, int id) {
+   const int *offsets;
+
+   offsets = worker->state->offsets;
+   worker->arcs += offsets[id + 1] - offsets[id];
+   worker->buffer[worker->count++] = id;
+   if (worker->count == BUFFER_SIZE) flushBuffer(worker);
+}
+
+static void flushBuffer(BFSWorker *worker) {
+   BFSState *state;
+   int start;
+
+   if (worker->count == 0) return;
+   state = worker->state;
+   start = atomic_fetch_add(&state->nextSize, worker->count);
+   memcpy(state->nextQueue + start, worker->buffer,
+          worker->count * sizeof(int));
+   worker->count = 0;
+}
+
+/*
+ * Function: finishLevel
+ * Usage: waitBarrier(&state->barrier, finishLevel, state);
+ * --------------------------------------------------------
+ * Makes the next frontier current once every thread has finished a
+ * level of the search.
+ */
+
+static void finishLevel(void *data) {
+   BFSState *state;
+   AtomicWord *bitmap;
+   int *queue;
+   int previous;
+
+   state = (BFSState *) data;
+   previous = state->queueSize;
+   queue = state->queue;
+   state->queue = state->nextQueue;
+   state->nextQueue = queue;
+   bitmap = state->frontier;
+   state->frontier = state->next;
+   state->next = bitmap;
+   state->queueSize = atomic_load(&state->nextSize);
+   atomic_store(&state->nextSize, 0);
+   atomic_store(&state->cursor, 0);
+   state->reached += state->queueSize;
+   state->level++;
+   state->done = (state->queueSize == 0);
+   chooseDirection(state, atomic_exchange(&state->nextArcs, 0), previous);
+}
+
+/*
+ * Function: chooseDirection
+ * Usage: chooseDirection(state, arcs, previous);
+ * ----------------------------------------------
+ * Decides whether the next step of the search is top-down or bottom-up,
+ * given the number of arcs leaving the new frontier and the size of the
+ * previous frontier.  A top-down step examines every arc leaving the
+ * frontier, and a bottom-up step examines at most the arcs entering the
+ * unreached nodes, which the function estimates by the arcs leaving
+ * them.  The bottom-up rows are built the first time they are needed,
+ * while the other threads wait.
+ */
+
+static void chooseDirection(BFSState *state, long arcs, int previous) {
+   state->unexplored -= arcs;
+   if (state->bottomUp) {
+      if (state->queueSize < previous
+            && state->queueSize < state->nNodes / BOTTOM_UP_FACTOR) {
+         state->bottomUp = false;
+      }
+   } else if (arcs > state->unexplored / TOP_DOWN_FACTOR) {
+      state->bottomUp = true;
+      if (state->inOffsets == NULL) {
+         state->inOffsets = getFrozenInOffsets(state->fg);
+         state->sources = getFrozenSources(state->fg);
+      }
+   }
+}
+
+static void *deltaWorker(void *arg) {
+   DeltaWorker *worker;
+   DeltaState *state;
+   IdList *bucket;
+   int lo, hi, i, start;
+
+   worker = (DeltaWorker *) arg;
+   state = worker->state;
+   lo = (int) ((long) state->nArcs * worker->index / state->nThreads);
+   hi = (int) ((long) state->nArcs * (worker->index + 1) / state->nThreads);
+   for (i = lo; i < hi; i++) {
+      if (state->costs[i] < 0) atomic_store(&state->negative, true);
+   }
+   waitBarrier(&state->barrier, NULL, NULL);
+   if (atomic_load(&state->negative)) return NULL;
+   while (true) {
+      relaxBucket(worker);
+      worker->lowest = lowestBucket(worker);
+      waitBarrier(&state->barrier, chooseBucket, state);
+      if (state->done) break;
+      if (worker->lowest == state->bucket) {
+         bucket = &worker->buckets[state->bucket];
+         start = atomic_fetch_add(&state->nextSize, bucket->count);
+         memcpy(state->frontier + start, bucket->ids,
+                bucket->count * sizeof(int));
+         freeBlock(bucket->ids);
+         bucket->ids = NULL;
+         bucket->count = 0;
+         bucket->capacity = 0;
+      }
+      waitBarrier(&state->barrier, startBucket, state);
+   }
+   return NULL;
+}
+
+static void relaxBucket(DeltaWorker *worker) {
+   DeltaState *state;
+   double du, nd;
+   int lo, hi, k, i, u, v;
+
+   state = worker->state;
+   while ((lo = atomic_fetch_add(&state->cursor, QUEUE_CHUNK))
+                                                   < state->frontierSize) {
+      hi = lo + QUEUE_CHUNK;
+      if (hi > state->frontierSize) hi = state->frontierSize;
+      for (k = lo; k < hi; k++) {
+         u = state->frontier[k];
+         du = atomic_load_explicit(&state->dist[u], memory_order_relaxed);
+         if (bucketNumber(du, state->delta) < state->bucket) continue;
+         for (i = state->offsets[u]; i < state->offsets[u + 1]; i++) {
+            v = state->targets[i];
+            nd = du + state->costs[i];
+            if (lowerDistance(&state->dist[v], nd)) {
+               addToBucket(worker, v, bucketNumber(nd, state->delta));
+            }
+         }
+      }
+   }
+}
+
+static bool lowerDistance(AtomicDouble *dp, double d) {
+   double old;
+
+   old = atomic_load_explicit(dp, memory_order_relaxed);
+   while (d < old) {
+      if (atomic_compare_exchange_weak(dp, &old, d)) return true;
+   }
+   return false;
+}
+
+static void addToBucket(DeltaWorker *worker, int id, int bucket) {
+   IdList *list, *buckets;
+   int *ids;
+   int i, n;
+
+   if (bucket >= worker->nBuckets) {
+      n = 2 * worker->nBuckets;
+      if (n <= bucket) n = bucket + 1;
+      buckets = newArray(n, IdList);
+      for (i = 0; i < n; i++) {
+         if (i < worker->nBuckets) {
+            buckets[i] = worker->buckets[i];
+         } else {
+            buckets[i].ids = NULL;
+            buckets[i].count = 0;
+            buckets[i].capacity = 0;
+         }
+      }
+      if (worker->buckets != NULL) freeBlock(worker->buckets);
+      worker->buckets = buckets;
+      worker->nBuckets = n;
+   }
+   list = &worker->buckets[bucket];
+   if (list->count == list->capacity) {
+      list->capacity = (list->capacity == 0) ? 16 : 2 * list->capacity;
+      ids = newArray(list->capacity, int);
+      if (list->ids != NULL) {
+         memcpy(ids, list->ids, list->count * sizeof(int));
+         freeBlock(list->ids);
+      }
+      list->ids = ids;
+   }
+   list->ids[list->count++] = id;
+}
+
+static int lowestBucket(DeltaWorker *worker) {
+   int i;
+
+   for (i = worker->state->bucket; i < worker->nBuckets; i++) {
+      if (worker->buckets[i].count > 0) return i;
+   }
+   return -1;
+}
+
+/*
+ * Function: chooseBucket
+ * Usage: waitBarrier(&state->barrier, chooseBucket, state);
+ * ---------------------------------------------------------
+ * Chooses the lowest bucket that any thread holds and makes sure that
+ * the frontier has room for all its nodes.
+ */
+
+static void chooseBucket(void *data) {
+   DeltaState *state;
+   DeltaWorker *worker;
+   int i, bucket, total;
+
+   state = (DeltaState *) data;
+   bucket = -1;
+   for (i = 0; i < state->nThreads; i++) {
+      worker = &state->workers[i];
+      if (worker->lowest != -1 && (bucket == -1 || worker->lowest < bucket)) {
+         bucket = worker->lowest;
+      }
+   }
+   if (bucket == -1) {
+      state->done = true;
+      return;
+   }
+   total = 0;
+   for (i = 0; i < state->nThreads; i++) {
+      worker = &state->workers[i];
+      if (worker->lowest == bucket) total += worker->buckets[bucket].count;
+   }
+   if (total > state->capacity) {
+      freeBlock(state->frontier);
+      state->capacity = (total > 2 * state->capacity) ? total
+                                                      : 2 * state->capacity;
+      state->frontier = newArray(state->capacity, int);
+   }
+   state->bucket = bucket;
+   atomic_store(&state->nextSize, 0);
+}
+
+static void startBucket(void *data) {
+   DeltaState *state;
+
+   state = (DeltaState *) data;
+   state->frontierSize = atomic_load(&state->nextSize);
+   atomic_store(&state->cursor, 0);
+}
+
+/*
+ * Function: bucketNumber
+ * Usage: bucket = bucketNumber(d, delta);
+ * ---------------------------------------
+ * Returns the number of the bucket for distance d.  Distances beyond the
+ * last bucket share it, which costs some repeated work but does not
+ * affect the result, because the algorithm settles a bucket by relaxing
+ * its nodes until none of their distances changes.
+ */
+
+static int bucketNumber(double d, double delta) {
+   double bucket;
+
+   bucket = floor(d / delta);
+   return (bucket < MAX_BUCKET) ? (int) bucket : MAX_BUCKET;
+}
+
+static double defaultDelta(FrozenGraph fg) {
+   const double *costs;
+   double maxCost;
+   int i, nArcs;
+
+   costs = getFrozenCosts(fg);
+   nArcs = getFrozenArcCount(fg);
+   maxCost = 0;
+   for (i = 0; i < nArcs; i++) {
+      if (costs[i] > maxCost) maxCost = costs[i];
+   }
+   if (maxCost == 0) return 1;
+   return maxCost * getFrozenNodeCount(fg) / nArcs;
+}
+
+static void *vertexWorker(void *arg) {
+   VertexWorker *worker;
+   VertexState *state;
+   double value, change;
+   int id, hi;
+
+   worker = (VertexWorker *) arg;
+   state = worker->state;
+   while (true) {
+      change = 0;
+      hi = state->bounds[worker->index + 1];
+      for (id = state->bounds[worker->index]; id < hi; id++) {
+         value = state->update(state->fg, id, state->values, state->data);
+         change += fabs(value - state->values[id]);
+         state->next[id] = value;
+      }
+      worker->change = change;
+      waitBarrier(&state->barrier, finishIteration, state);
+      if (state->done) break;
+   }
+   return NULL;
+}
+
+/*
+ * Function: finishIteration
+ * Usage: waitBarrier(&state->barrier, finishIteration, state);
+ * ------------------------------------------------------------
+ * Completes an iteration of a vertex program on the last thread to
+ * reach the barrier.
+ */
+
+static void finishIteration(void *data) {
+   VertexState *state;
+   double *tmp, change;
+   int i;
+
+   state = (VertexState *) data;
+   change = 0;
+   for (i = 0; i < state->nThreads; i++) {
+      change += state->workers[i].change;
+   }
+   tmp = state->values;
+   state->values = state->next;
+   state->next = tmp;
+   state->iteration++;
+   state->done = change <= state->tolerance
+              || state->iteration >= state->maxIterations;
+   if (!state->done && state->prepare != NULL) {
+      state->prepare(state->fg, state->values, state->data);
+   }
+}
+
+static void preparePageRank(FrozenGraph fg, const double rank[], void *data) {
+   PageRankContext *context;
+   double dangling;
+   int nNodes, u, degree;
+
+   context = (PageRankContext *) data;
+   nNodes = getFrozenNodeCount(fg);
+   dangling = 0;
+   for (u = 0; u < nNodes; u++) {
+      degree = context->offsets[u + 1] - context->offsets[u];
+      if (degree == 0) {
+         dangling += rank[u];
+         context->share[u] = 0;
+      } else {
+         context->share[u] = rank[u] / degree;
+      }
+   }
+   context->base = ((1 - context->damping) + context->damping * dangling)
+                 / nNodes;
+}
+
+static double updatePageRank(FrozenGraph fg, int id, const double rank[],
+                             void *data) {
+   PageRankContext *context;
+   double sum;
+   int i;
+
+   context = (PageRankContext *) data;
+   sum = 0;
+   for (i = context->inOffsets[id]; i < context->inOffsets[id + 1]; i++) {
+      sum += context->share[context->sources[i]];
+   }
+   return context->base + context->damping * sum;
+}
+
+/**********************************************************************/
+/* Unit test for the graphalgo module                                 */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+#include "random.h"
+#include "strlib.h"
+
+#define N_RANDOM_NODES 60
+#define N_RANDOM_ARCS 150
+#define N_LARGE_NODES 3000
+#define N_LARGE_ARCS 24000
+#define N_TEST_THREADS 4
+
+/* Private function prototypes */
+
+static Graph createRoadGraph(void);
+static Graph createRandomGraph(int nNodes, int nArcs);
+static void testSearchOrders(void);
+static void testShortestPaths(void);
+static void testTopologicalSort(void);
+static void testComponents(void);
+static void testAgainstReachability(void);
+static void testParallelSearch(void);
+static void testVertexPrograms(void);
+static void breadthFirstDepths(FrozenGraph fg, int starts[], int n,
+                               int depth[]);
+static void linkNodes(Graph g, string n1, string n2, double cost);
+static string nodeNames(Vector nodes);
+static double straightLine(Node node, Node goal, void *data);
+static double lowestLabel(FrozenGraph fg, int id, const double label[],
+                          void *data);
+
+/* Unit test */
+
+void testGraphAlgoModule(void) {
+   testSearchOrders();
+   testShortestPaths();
+   testTopologicalSort();
+   testComponents();
+   testAgainstReachability();
+   testParallelSearch();
+   testVertexPrograms();
+}
+
+static void testSearchOrders(void) {
+   Graph g;
+
+   trace(g = createRoadGraph());
+   test(nodeNames(breadthFirstSearch(g, getNode(g, "A"))), "ABCDFE");
+   test(nodeNames(depthFirstSearch(g, getNode(g, "A"))), "ABDEFC");
+   test(nodeNames(breadthFirstSearch(g, getNode(g, "E"))), "EF");
+   trace(freeGraph(g));
+}
+
+static void testShortestPaths(void) {
+   Graph g;
+   FrozenGraph fg;
+   double dist[6];
+
+   trace(g = createRoadGraph());
+   test(nodeNames(findShortestPath(g, getNode(g, "A"), getNode(g, "F"))),
+        "ACDEF");
+   test(nodeNames(findPathAStar(g, getNode(g, "A"), getNode(g, "F"),
+                                straightLine, NULL)), "ACDEF");
+   test(nodeNames(findShortestPath(g, getNode(g, "F"), getNode(g, "A"))), "");
+   trace(fg = freezeGraph(g));
+   trace(shortestDistancesFrozenGraph(fg, 0, dist, NULL));
+   test(dist[5], 9.0);
+   test(dist[3], 4.0);
+   trace(freeFrozenGraph(fg));
+   trace(freeGraph(g));
+}
+
+static void testTopologicalSort(void) {
+   Graph g;
+
+   trace(g = createRoadGraph());
+   test(nodeNames(topologicalSort(g)), "ABCDEF");
+   trace(linkNodes(g, "F", "B", 1));
+   test(topologicalSort(g) == NULL, true);
+   trace(freeGraph(g));
+}
+
+static void testComponents(void) {
+   Graph g;
+   Vector comps;
+
+   trace(g = createRoadGraph());
+   trace(linkNodes(g, "E", "D", 1));
+   trace(linkNodes(g, "F", "D", 1));
+   trace(addNode(g, "G"));
+   trace(comps = findStronglyConnectedComponents(g));
+   test(sizeVector(comps), 5);
+   test(nodeNames(getVector(comps, 0)), "DEF");
+   test(nodeNames(getVector(comps, 3)), "A");
+   trace(comps = findConnectedComponents(g));
+   test(sizeVector(comps), 2);
+   test(nodeNames(getVector(comps, 1)), "G");
+   trace(freeGraph(g));
+}
+
+/*
+ * Implementation notes: testAgainstReachability
+ * ---------------------------------------------
+ * Checks on a random graph that two nodes are in the same strong
+ * component exactly when each can reach the other, and that A* search
+ * with a zero estimate agrees with Dijkstra's algorithm.
+ */
+
+static void testAgainstReachability(void) {
+   Graph g;
+   FrozenGraph fg;
+   BitVector *reach;
+   double dist[N_RANDOM_NODES], pathCost, arcCost;
+   int component[N_RANDOM_NODES], order[N_RANDOM_NODES];
+   int path[N_RANDOM_NODES];
+   int i, j, k, n, errors;
+   const int *offsets, *targets;
+   const double *costs;
+
+   g = createRandomGraph(N_RANDOM_NODES, N_RANDOM_ARCS);
+   fg = freezeGraph(g);
+   strongComponentsFrozenGraph(fg, component);
+   reach = newArray(N_RANDOM_NODES, BitVector);
+   for (i = 0; i < N_RANDOM_NODES; i++) {
+      reach[i] = newBitVector(N_RANDOM_NODES);
+      n = breadthFirstFrozenGraph(fg, i, order);
+      for (j = 0; j < n; j++) {
+         addBitVector(reach[i], order[j]);
+      }
+   }
+   errors = 0;
+   for (i = 0; i < N_RANDOM_NODES; i++) {
+      for (j = 0; j < N_RANDOM_NODES; j++) {
+         if ((component[i] == component[j])
+               != (containsBitVector(reach[i], j)
+                   && containsBitVector(reach[j], i))) {
+            errors++;
+         }
+      }
+   }
+   test(errors, 0);
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   costs = getFrozenCosts(fg);
+   shortestDistancesFrozenGraph(fg, 0, dist, NULL);
+   errors = 0;
+   for (i = 1; i < N_RANDOM_NODES; i++) {
+      n = aStarFrozenGraph(fg, 0, i, NULL, NULL, path);
+      if ((n > 0) != containsBitVector(reach[0], i)) errors++;
+      pathCost = 0;
+      for (j = 0; j + 1 < n; j++) {
+         arcCost = HUGE_VAL;
+         for (k = offsets[path[j]]; k < offsets[path[j] + 1]; k++) {
+            if (targets[k] == path[j + 1] && costs[k] < arcCost) {
+               arcCost = costs[k];
+            }
+         }
+         pathCost += arcCost;
+      }
+      if (n > 0 && fabs(pathCost - dist[i]) > 1e-9) errors++;
+   }
+   test(errors, 0);
+   for (i = 0; i < N_RANDOM_NODES; i++) {
+      freeBitVector(reach[i]);
+   }
+   freeBlock(reach);
+   freeFrozenGraph(fg);
+   freeGraph(g);
+}
+
+/*
+ * Implementation notes: testParallelSearch
+ * ----------------------------------------
+ * Checks the parallel algorithms against the sequential ones on a random
+ * graph that is dense enough for the breadth-first search to switch to
+ * bottom-up steps and back.  The starting nodes include a duplicate, and
+ * the test uses more threads than some machines have, with bucket
+ * widths from one that puts every distance in its own bucket to one
+ * that puts them all in the first.
+ */
+
+static void testParallelSearch(void) {
+   Graph g;
+   FrozenGraph fg;
+   double *dist, *expected, *single;
+   double deltas[] = { 0, 1, 1000 };
+   int starts[] = { 0, 17, 17, 1234 };
+   int *depth, *expectedDepth;
+   int i, j, k, nThreads, reached, errors;
+
+   g = createRandomGraph(N_LARGE_NODES, N_LARGE_ARCS);
+   fg = freezeGraph(g);
+   depth = newArray(N_LARGE_NODES, int);
+   expectedDepth = newArray(N_LARGE_NODES, int);
+   dist = newArray(N_LARGE_NODES, double);
+   expected = newArray(N_LARGE_NODES, double);
+   single = newArray(N_LARGE_NODES, double);
+   breadthFirstDepths(fg, starts, 4, expectedDepth);
+   reached = 0;
+   for (i = 0; i < N_LARGE_NODES; i++) {
+      if (expectedDepth[i] != -1) reached++;
+      expected[i] = HUGE_VAL;
+   }
+   for (j = 0; j < 4; j++) {
+      shortestDistancesFrozenGraph(fg, starts[j], single, NULL);
+      for (i = 0; i < N_LARGE_NODES; i++) {
+         if (single[i] < expected[i]) expected[i] = single[i];
+      }
+   }
+   for (nThreads = 1; nThreads <= N_TEST_THREADS; nThreads *= 2) {
+      reportMessage("Using %d threads", nThreads);
+      test(parallelBreadthFirstFrozenGraph(fg, starts, 4, depth, nThreads)
+             == reached, true);
+      errors = 0;
+      for (i = 0; i < N_LARGE_NODES; i++) {
+         if (depth[i] != expectedDepth[i]) errors++;
+      }
+      test(errors, 0);
+      for (k = 0; k < 3; k++) {
+         deltaSteppingFrozenGraph(fg, starts, 4, dist, deltas[k], nThreads);
+         errors = 0;
+         for (i = 0; i < N_LARGE_NODES; i++) {
+            if (dist[i] != expected[i]) errors++;
+         }
+         test(errors, 0);
+      }
+   }
+   test(parallelBreadthFirstFrozenGraph(fg, starts, 0, depth, 2), 0);
+   test(depth[0], -1);
+   freeFrozenGraph(fg);
+   setCost(addArc(g, getNode(g, "N10000"), getNode(g, "N10001")), -1);
+   fg = freezeGraph(g);
+   testError(deltaSteppingFrozenGraph(fg, starts, 1, dist, 0, 2));
+   freeFrozenGraph(fg);
+   freeGraph(g);
+   freeBlock(depth);
+   freeBlock(expectedDepth);
+   freeBlock(dist);
+   freeBlock(expected);
+   freeBlock(single);
+}
+
+static void testVertexPrograms(void) {
+   Graph g;
+   FrozenGraph fg;
+   double *rank, *single, *label;
+   double sum;
+   int *bounds, *component, *lowest;
+   int i, nThreads, nComps, errors;
+
+   g = newGraph();
+   addNode(g, "A");
+   addNode(g, "B");
+   addNode(g, "C");
+   linkNodes(g, "A", "B", 1);
+   linkNodes(g, "B", "C", 1);
+   linkNodes(g, "C", "A", 1);
+   fg = freezeGraph(g);
+   rank = newArray(3, double);
+   test(pageRankFrozenGraph(fg, rank, 0.85, 1e-12, 2), 1);
+   test(fabs(rank[0] - 1.0 / 3) < 1e-12 && fabs(rank[2] - 1.0 / 3) < 1e-12,
+        true);
+   testError(pageRankFrozenGraph(fg, rank, 1.5, 1e-12, 1));
+   testError(runVertexProgram(fg, lowestLabel, NULL, NULL, rank, 1, 0, 0));
+   freeBlock(rank);
+   freeFrozenGraph(fg);
+   freeGraph(g);
+   g = createRandomGraph(N_LARGE_NODES, N_LARGE_ARCS / 4);
+   fg = freezeGraph(g);
+   bounds = newArray(N_TEST_THREADS + 1, int);
+   partitionFrozenGraph(fg, N_TEST_THREADS, bounds);
+   test(bounds[0], 0);
+   test(bounds[N_TEST_THREADS] == N_LARGE_NODES, true);
+   errors = 0;
+   for (i = 0; i < N_TEST_THREADS; i++) {
+      if (bounds[i] > bounds[i + 1]) errors++;
+   }
+   test(errors, 0);
+   rank = newArray(N_LARGE_NODES, double);
+   single = newArray(N_LARGE_NODES, double);
+   label = newArray(N_LARGE_NODES, double);
+   pageRankFrozenGraph(fg, single, 0.85, 1e-10, 1);
+   sum = 0;
+   for (i = 0; i < N_LARGE_NODES; i++) {
+      sum += single[i];
+   }
+   test(fabs(sum - 1) < 1e-9, true);
+   component = newArray(N_LARGE_NODES, int);
+   lowest = newArray(N_LARGE_NODES, int);
+   nComps = connectedComponentsFrozenGraph(fg, component);
+   for (i = N_LARGE_NODES - 1; i >= 0; i--) {
+      lowest[component[i]] = i;
+   }
+   for (nThreads = 1; nThreads <= N_TEST_THREADS; nThreads *= 2) {
+      reportMessage("Using %d threads", nThreads);
+      pageRankFrozenGraph(fg, rank, 0.85, 1e-10, nThreads);
+      errors = 0;
+      for (i = 0; i < N_LARGE_NODES; i++) {
+         if (fabs(rank[i] - single[i]) > 1e-12) errors++;
+      }
+      test(errors, 0);
+      for (i = 0; i < N_LARGE_NODES; i++) {
+         label[i] = i;
+      }
+      test(runVertexProgram(fg, lowestLabel, NULL, NULL, label,
+                            N_LARGE_NODES, 0, nThreads) < N_LARGE_NODES,
+           true);
+      errors = 0;
+      for (i = 0; i < N_LARGE_NODES; i++) {
+         if (label[i] != lowest[component[i]]) errors++;
+      }
+      test(errors, 0);
+   }
+   test(nComps > 1, true);
+   test(runVertexProgram(fg, lowestLabel, NULL, NULL, label, 0, 0, 2), 0);
+   freeFrozenGraph(fg);
+   freeGraph(g);
+   freeBlock(bounds);
+   freeBlock(rank);
+   freeBlock(single);
+   freeBlock(label);
+   freeBlock(component);
+   freeBlock(lowest);
+}
+
+/*
+ * Implementation notes: createRoadGraph
+ * -------------------------------------
+ * Creates a small acyclic graph in which the cheapest path from A to F
+ * is not the one with the fewest arcs.  The nodes lie on a line, so the
+ * distance between their letters is an admissible estimate for A*.
+ */
+
+static Graph createRoadGraph(void) {
+   Graph g;
+
+   g = newGraph();
+   addNode(g, "A");
+   addNode(g, "B");
+   addNode(g, "C");
+   addNode(g, "D");
+   addNode(g, "E");
+   addNode(g, "F");
+   linkNodes(g, "A", "B", 4);
+   linkNodes(g, "A", "C", 1);
+   linkNodes(g, "B", "D", 1);
+   linkNodes(g, "C", "D", 3);
+   linkNodes(g, "B", "F", 7);
+   linkNodes(g, "D", "E", 2);
+   linkNodes(g, "E", "F", 3);
+   return g;
+}
+
+static Graph createRandomGraph(int nNodes, int nArcs) {
+   Graph g;
+   string *names;
+   int i;
+
+   g = newGraph();
+   names = newArray(nNodes, string);
+   for (i = 0; i < nNodes; i++) {
+      names[i] = concat("N", integerToString(10000 + i));
+      addNode(g, names[i]);
+   }
+   for (i = 0; i < nArcs; i++) {
+      linkNodes(g, names[randomInteger(0, nNodes - 1)],
+                   names[randomInteger(0, nNodes - 1)],
+                   randomInteger(1, 20));
+   }
+   freeBlock(names);
+   return g;
+}
+
+static void breadthFirstDepths(FrozenGraph fg, int starts[], int n,
+                               int depth[]) {
+   const int *offsets, *targets;
+   int *queue;
+   int head, tail, u, i;
+
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   queue = newArray(getFrozenNodeCount(fg), int);
+   for (i = 0; i < getFrozenNodeCount(fg); i++) {
+      depth[i] = -1;
+   }
+   tail = 0;
+   for (i = 0; i < n; i++) {
+      if (depth[starts[i]] == -1) {
+         depth[starts[i]] = 0;
+         queue[tail++] = starts[i];
+      }
+   }
+   for (head = 0; head < tail; head++) {
+      u = queue[head];
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         if (depth[targets[i]] == -1) {
+            depth[targets[i]] = depth[u] + 1;
+            queue[tail++] = targets[i];
+         }
+      }
+   }
+   freeBlock(queue);
+}
+
+static void linkNodes(Graph g, string n1, string n2, double cost) {
+   setCost(addArc(g, getNode(g, n1), getNode(g, n2)), cost);
+}
+
+static string nodeNames(Vector nodes) {
+   string str;
+   int i;
+
+   str = "";
+   for (i = 0; i < sizeVector(nodes); i++) {
+      str = concat(str, getName(getVector(nodes, i)));
+   }
+   return str;
+}
+
+static double straightLine(Node node, Node goal, void *data) {
+   return fabs(getName(goal)[0] - getName(node)[0]);
+}
+
+/*
+ * Implementation notes: lowestLabel
+ * ---------------------------------
+ * Updates a node to the lowest label among itself and its neighbors in
+ * either direction.  Starting from the IDs, the labels settle on the
+ * lowest ID in each connected component.
+ */
+
+static double lowestLabel(FrozenGraph fg, int id, const double label[],
+                          void *data) {
+   const int *offsets, *targets, *inOffsets, *sources;
+   double min;
+   int i;
+
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   inOffsets = getFrozenInOffsets(fg);
+   sources = getFrozenSources(fg);
+   min = label[id];
+   for (i = offsets[id]; i < offsets[id + 1]; i++) {
+      if (label[targets[i]] < min) min = label[targets[i]];
+   }
+   for (i = inOffsets[id]; i < inOffsets[id + 1]; i++) {
+      if (label[sources[i]] < min) min = label[sources[i]];
+   }
+   return min;
+}
+
+#endif
@@ -0,0 +1,1091 @@
+/*
+ * File: graphio.c
+ * ---------------
+ * This file implements the graphio.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef unixlike
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+#include "cslib.h"
+#include "graph.h"
+#include "graphio.h"
+#include "strlib.h"
+#include "unittest.h"
+
+/*
+ * Constants
+ * ---------
+ * SNAPSHOT_MAGIC      -- The eight bytes that begin every saved snapshot
+ * BYTE_ORDER_MARK     -- A value whose bytes show the order of the writer
+ * SWAPPED_ORDER_MARK  -- The same value as read with the other byte order
+ * FORMAT_VERSION      -- The version of the binary format
+ * MAX_FAST_DIGITS     -- Most significant digits that readCost converts
+ *                        exactly without calling strtod
+ * MAX_TOKEN_LENGTH    -- Longest cost that readCost passes to strtod
+ * DENSE_LABEL_FACTOR  -- Labels index an array directly unless the
+ *                        largest is this many times the number of arcs
+ */
+
+#define SNAPSHOT_MAGIC "SPLGRAPH"
+#define BYTE_ORDER_MARK 0x01020304
+#define SWAPPED_ORDER_MARK 0x04030201
+#define FORMAT_VERSION 1
+#define MAX_FAST_DIGITS 15
+#define MAX_TOKEN_LENGTH 128
+#define DENSE_LABEL_FACTOR 4
+
+/*
+ * Type: FileImage
+ * ---------------
+ * This type holds the contents of a file, which are either mapped into
+ * memory or, where mapping is unavailable, read into an allocated block.
+ * The contents are not terminated by a null character.
+ */
+
+typedef struct {
+   char *data;
+   size_t size;
+   bool mapped;
+} FileImage;
+
+/*
+ * Type: TextCursor
+ * ----------------
+ * This type records the position of the parser in a file image and the
+ * number of the line it is reading, for use in error messages.
+ */
+
+typedef struct {
+   const char *cp;
+   const char *end;
+   int line;
+} TextCursor;
+
+/*
+ * Type: ArcList
+ * -------------
+ * This type holds the arcs read from a file in three parallel arrays.
+ * The endpoints are labels until assignIds replaces them with IDs.  An
+ * entry whose end is -1 records a node from an adjacency list that has
+ * no neighbors and is not an arc.
+ */
+
+typedef struct {
+   int *starts;
+   int *ends;
+   double *costs;
+   int count;
+   int capacity;
+   int nArcs;
+   int maxLabel;
+} ArcList;
+
+/*
+ * Type: SnapshotHeader
+ * --------------------
+ * This type defines the header of a saved snapshot.  The header is
+ * followed by the offsets, targets, and costs arrays and then by the
+ * names, each of which is terminated by a null character.
+ */
+
+typedef struct {
+   char magic[8];
+   uint32_t byteOrder;
+   uint32_t version;
+   int32_t nNodes;
+   int32_t nArcs;
+   int64_t nameBytes;
+} SnapshotHeader;
+
+/*
+ * Constant: POWERS_OF_TEN
+ * -----------------------
+ * The powers of ten that a double represents exactly.
+ */
+
+static const double POWERS_OF_TEN[] = {
+   1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_POWER 22
+
+/* Private function prototypes */
+
+static void readArcList(string fn, string path, int options,
+                        ArcList *arcs);
+static bool openFileImage(FileImage *image, string path);
+static bool readFileImage(FileImage *image, string path);
+static void closeFileImage(FileImage *image);
+static int parseArcList(FileImage *image, int options, ArcList *arcs);
+static bool parseLine(TextCursor *tc, int options, ArcList *arcs);
+static bool readLabel(TextCursor *tc, int *label);
+static bool readCost(TextCursor *tc, double *cost);
+static bool atDelimiter(const char *cp, const char *end);
+static void skipSpaces(TextCursor *tc);
+static bool atLineEnd(TextCursor *tc);
+static void initArcList(ArcList *arcs, int capacity);
+static void freeArcList(ArcList *arcs);
+static void appendArc(ArcList *arcs, int start, int end, double cost);
+static int *assignIds(ArcList *arcs, int *nNodes);
+static int findLabel(int labels[], int n, int label);
+static int compareLabels(const void *p1, const void *p2);
+static char *createNames(int labels[], int n, string **names);
+static int checkSnapshot(SnapshotHeader *header, FileImage *image);
+static bool checkRows(int offsets[], int targets[], int nNodes, int nArcs);
+static void writeBlock(FILE *outfile, void *data, size_t size, string path);
+
+/* Exported entries */
+
+Graph loadGraphFromEdgeList(string path, int options) {
+   ArcList arcs;
+   Graph g;
+   Node *nodes;
+   Arc arc;
+   int *labels;
+   int nNodes, id, i;
+
+   readArcList("loadGraphFromEdgeList", path, options, &arcs);
+   labels = assignIds(&arcs, &nNodes);
+   g = newGraph();
+   nodes = newArray(nNodes, Node);
+   for (id = 0; id < nNodes; id++) {
+      nodes[id] = addNode(g, integerToString(labels[id]));
+   }
+   for (i = 0; i < arcs.count; i++) {
+      if (arcs.ends[i] >= 0) {
+         arc = addArc(g, nodes[arcs.starts[i]], nodes[arcs.ends[i]]);
+         setCost(arc, arcs.costs[i]);
+      }
+   }
+   freeBlock(nodes);
+   freeBlock(labels);
+   freeArcList(&arcs);
+   return g;
+}
+
+/*
+ * Implementation notes: loadFrozenGraphFromEdgeList
+ * -------------------------------------------------
+ * The rows are filled by a counting sort on the start of each arc, which
+ * keeps the arcs leaving each node in the order of the file.
+ */
+
+FrozenGraph loadFrozenGraphFromEdgeList(string path, int options) {
+   ArcList arcs;
+   string *names;
+   char *buf;
+   double *costs;
+   int *labels, *offsets, *targets, *next;
+   int nNodes, nArcs, u, i, k;
+
+   readArcList("loadFrozenGraphFromEdgeList", path, options, &arcs);
+   labels = assignIds(&arcs, &nNodes);
+   nArcs = arcs.nArcs;
+   offsets = newArray(nNodes + 1, int);
+   targets = newArray(nArcs, int);
+   costs = newArray(nArcs, double);
+   next = newArray(nNodes + 1, int);
+   for (u = 0; u <= nNodes; u++) {
+      next[u] = 0;
+   }
+   for (i = 0; i < arcs.count; i++) {
+      if (arcs.ends[i] >= 0) next[arcs.starts[i] + 1]++;
+   }
+   for (u = 0; u < nNodes; u++) {
+      next[u + 1] += next[u];
+   }
+   for (u = 0; u <= nNodes; u++) {
+      offsets[u] = next[u];
+   }
+   for (i = 0; i < arcs.count; i++) {
+      if (arcs.ends[i] >= 0) {
+         k = next[arcs.starts[i]]++;
+         targets[k] = arcs.ends[i];
+         costs[k] = arcs.costs[i];
+      }
+   }
+   freeBlock(next);
+   buf = createNames(labels, nNodes, &names);
+   freeBlock(labels);
+   freeArcList(&arcs);
+   return assembleFrozenGraph(nNodes, nArcs, offsets, targets, costs, names,
+                              buf);
+}
+
+void saveFrozenGraph(FrozenGraph fg, string path) {
+   SnapshotHeader header;
+   FILE *outfile;
+   string name;
+   int n, m, id;
+
+   n = getFrozenNodeCount(fg);
+   m = getFrozenArcCount(fg);
+   memset(&header, 0, sizeof header);
+   memcpy(header.magic, SNAPSHOT_MAGIC, sizeof header.magic);
+   header.byteOrder = BYTE_ORDER_MARK;
+   header.version = FORMAT_VERSION;
+   header.nNodes = n;
+   header.nArcs = m;
+   header.nameBytes = 0;
+   for (id = 0; id < n; id++) {
+      header.nameBytes += strlen(getFrozenNodeName(fg, id)) + 1;
+   }
+   outfile = fopen(path, "wb");
+   if (outfile == NULL) error("saveFrozenGraph: Can't open %s", path);
+   writeBlock(outfile, &header, sizeof header, path);
+   writeBlock(outfile, (void *) getFrozenOffsets(fg), (n + 1) * sizeof (int),
+              path);
+   writeBlock(outfile, (void *) getFrozenTargets(fg), m * sizeof (int), path);
+   writeBlock(outfile, (void *) getFrozenCosts(fg), m * sizeof (double),
+              path);
+   for (id = 0; id < n; id++) {
+      name = getFrozenNodeName(fg, id);
+      writeBlock(outfile, name, strlen(name) + 1, path);
+   }
+   if (fclose(outfile) != 0) error("saveFrozenGraph: Can't write %s", path);
+}
+
+/*
+ * Implementation notes: loadFrozenGraph
+ * -------------------------------------
+ * The arrays are copied out of the mapped file, so that the snapshot
+ * owns ordinary blocks and the file can be closed at once.  The rows are
+ * checked before the snapshot is assembled, because a damaged file would
+ * otherwise send the graph algorithms outside their arrays.  For the same
+ * reason, each name is found with memchr inside the name table, and a
+ * name without its terminator marks the file as damaged.
+ */
+
+FrozenGraph loadFrozenGraph(string path) {
+   FileImage image;
+   SnapshotHeader header;
+   string *names;
+   char *buf, *cp, *end;
+   double *costs;
+   int *offsets, *targets;
+   int n, m, id, status;
+
+   if (!openFileImage(&image, path)) {
+      error("loadFrozenGraph: Can't open %s", path);
+   }
+   status = checkSnapshot(&header, &image);
+   if (status != 0) {
+      closeFileImage(&image);
+      if (status == 2) {
+         error("loadFrozenGraph: %s has the wrong byte order", path);
+      }
+      error("loadFrozenGraph: %s is not a saved graph", path);
+   }
+   n = header.nNodes;
+   m = header.nArcs;
+   offsets = newArray(n + 1, int);
+   targets = newArray(m, int);
+   costs = newArray(m, double);
+   buf = newArray(header.nameBytes + 1, char);
+   cp = image.data + sizeof header;
+   memcpy(offsets, cp, (n + 1) * sizeof (int));
+   cp += (n + 1) * sizeof (int);
+   memcpy(targets, cp, m * sizeof (int));
+   cp += m * sizeof (int);
+   memcpy(costs, cp, m * sizeof (double));
+   cp += m * sizeof (double);
+   memcpy(buf, cp, header.nameBytes);
+   buf[header.nameBytes] = '\0';
+   closeFileImage(&image);
+   names = newArray(n, string);
+   cp = buf;
+   for (id = 0; id < n; id++) {
+      end = memchr(cp, '\0', buf + header.nameBytes - cp);
+      if (end == NULL) break;
+      names[id] = cp;
+      cp = end + 1;
+   }
+   if (id < n || cp != buf + header.nameBytes
+              || !checkRows(offsets, targets, n, m)) {
+      freeBlock(offsets);
+      freeBlock(targets);
+      freeBlock(costs);
+      freeBlock(names);
+      freeBlock(buf);
+      error("loadFrozenGraph: %s is damaged", path);
+   }
+   return assembleFrozenGraph(n, m, offsets, targets, costs, names, buf);
+}
+
+/* Private functions */
+
+/*
+ * Function: readArcList
+ * Usage: readArcList(fn, path, options, &arcs);
+ * ---------------------------------------------
+ * Reads the arcs in the named file into the list, calling error if the
+ * file cannot be read or contains a syntax error.  The fn argument is
+ * the name of the exported function, for use in error messages.
+ */
+
+static void readArcList(string fn, string path, int options,
+                        ArcList *arcs) {
+   FileImage image;
+   int line;
+
+   if (!openFileImage(&image, path)) {
+      error("%s: Can't open %s", fn, path);
+   }
+   line = parseArcList(&image, options, arcs);
+   closeFileImage(&image);
+   if (line != 0) {
+      freeArcList(arcs);
+      error("%s: Syntax error on line %d of %s", fn, line, path);
+   }
+}
+
+/*
+ * Function: openFileImage
+ * Usage: if (openFileImage(&image, path)) . . .
+ * ---------------------------------------------
+ * Maps the named file into memory and returns true, or returns false if
+ * the file cannot be opened.  If the file cannot be mapped, as on
+ * platforms without mmap, the function reads it into a block instead.
+ */
+
+static bool openFileImage(FileImage *image, string path) {
+#ifdef unixlike
+   struct stat info;
+   void *addr;
+   int fd;
+
+   fd = open(path, O_RDONLY);
+   if (fd < 0) return false;
+   if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+      close(fd);
+      return false;
+   }
+   image->data = NULL;
+   image->size = info.st_size;
+   image->mapped = false;
+   if (image->size > 0) {
+      addr = mmap(NULL, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+         madvise(addr, image->size, MADV_SEQUENTIAL);
+         image->data = addr;
+         image->mapped = true;
+      }
+   }
+   close(fd);
+   if (image->size > 0 && !image->mapped) return readFileImage(image, path);
+   return true;
+#else
+   return readFileImage(image, path);
+#endif
+}
+
+static bool readFileImage(FileImage *image, string path) {
+   FILE *infile;
+   long size;
+
+   infile = fopen(path, "rb");
+   if (infile == NULL) return false;
+   if (fseek(infile, 0, SEEK_END) != 0 || (size = ftell(infile)) < 0) {
+      fclose(infile);
+      return false;
+   }
+   rewind(infile);
+   image->size = size;
+   image->data = newArray(size + 1, char);
+   image->mapped = false;
+   if (fread(image->data, 1, size, infile) != (size_t) size) {
+      fclose(infile);
+      freeBlock(image->data);
+      return false;
+   }
+   fclose(infile);
+   return true;
+}
+
+static void closeFileImage(FileImage *image) {
+#ifdef unixlike
+   if (image->mapped) {
+      munmap(image->data, image->size);
+      return;
+   }
+#endif
+   if (image->data != NULL) freeBlock(image->data);
+}
+
+/*
+ * Function: parseArcList
+ * Usage: line = parseArcList(&image, options, &arcs);
+ * ---------------------------------------------------
+ * Parses the file image into the arc list and returns 0, or returns the
+ * number of the first line that contains an error.  The list is sized
+ * from the number of lines, which bounds the number of arcs in an edge
+ * list, so that it grows only for adjacency lists.
+ */
+
+static int parseArcList(FileImage *image, int options, ArcList *arcs) {
+   TextCursor tc;
+   const char *cp;
+   int nLines;
+
+   tc.cp = image->data;
+   tc.end = image->data + image->size;
+   tc.line = 1;
+   nLines = 1;
+   for (cp = tc.cp; cp < tc.end; cp++) {
+      cp = memchr(cp, '\n', tc.end - cp);
+      if (cp == NULL) break;
+      nLines++;
+   }
+   if (options & EDGE_LIST_UNDIRECTED) nLines *= 2;
+   initArcList(arcs, nLines);
+   while (tc.cp < tc.end) {
+      if (!parseLine(&tc, options, arcs)) return tc.line;
+      if (tc.cp < tc.end) tc.cp++;
+      tc.line++;
+   }
+   return 0;
+}
+
+/*
+ * Function: parseLine
+ * Usage: if (parseLine(&tc, options, &arcs)) . . .
+ * ------------------------------------------------
+ * Parses the line at the cursor, adds its arcs to the list, and returns
+ * true, leaving the cursor at the end of the line.  The function returns
+ * false if the line contains an error.
+ */
+
+static bool parseLine(TextCursor *tc, int options, ArcList *arcs) {
+   bool undirected;
+   double cost;
+   int start, end;
+
+   undirected = (options & EDGE_LIST_UNDIRECTED) != 0;
+   skipSpaces(tc);
+   if (atLineEnd(tc) || *tc->cp == '#' || *tc->cp == '%') {
+      while (!atLineEnd(tc)) {
+         tc->cp++;
+      }
+      return true;
+   }
+   if (!readLabel(tc, &start)) return false;
+   skipSpaces(tc);
+   if (options & EDGE_LIST_ADJACENCY) {
+      if (atLineEnd(tc)) appendArc(arcs, start, -1, 0);
+      while (!atLineEnd(tc)) {
+         if (!readLabel(tc, &end)) return false;
+         appendArc(arcs, start, end, 1);
+         if (undirected && start != end) appendArc(arcs, end, start, 1);
+         skipSpaces(tc);
+      }
+      return true;
+   }
+   if (!readLabel(tc, &end)) return false;
+   skipSpaces(tc);
+   cost = 1;
+   if (!atLineEnd(tc)) {
+      if (!readCost(tc, &cost)) return false;
+      skipSpaces(tc);
+      if (!atLineEnd(tc)) return false;
+   }
+   appendArc(arcs, start, end, cost);
+   if (undirected && start != end) appendArc(arcs, end, start, cost);
+   return true;
+}
+
+/*
+ * Function: readLabel
+ * Usage: if (readLabel(&tc, &label)) . . .
+ * ----------------------------------------
+ * Reads a nonnegative decimal integer at the cursor and returns true, or
+ * returns false if there is none or if it does not fit in an int.
+ */
+
+static bool readLabel(TextCursor *tc, int *label) {
+   const char *cp;
+   int value, digit;
+
+   cp = tc->cp;
+   if (cp == tc->end || *cp < '0' || *cp > '9') return false;
+   value = 0;
+   while (cp < tc->end && *cp >= '0' && *cp <= '9') {
+      digit = *cp++ - '0';
+      if (value > (INT_MAX - digit) / 10) return false;
+      value = 10 * value + digit;
+   }
+   if (!atDelimiter(cp, tc->end)) return false;
+   tc->cp = cp;
+   *label = value;
+   return true;
+}
+
+/*
+ * Implementation notes: readCost
+ * ------------------------------
+ * Most costs have few enough digits that the digits, read as an integer,
+ * are exact in a double.  Multiplying or dividing that integer by an
+ * exact power of ten then rounds only once, so the result is the same
+ * as the one from strtod.  Costs with more digits or larger exponents
+ * are copied into a buffer and passed to strtod, which cannot be called
+ * on the file image directly because the image is not terminated.
+ */
+
+static bool readCost(TextCursor *tc, double *cost) {
+   char buffer[MAX_TOKEN_LENGTH];
+   const char *cp, *end;
+   uint64_t mantissa;
+   int nDigits, scale, exponent, expSign;
+   bool negative, found;
+
+   cp = tc->cp;
+   end = tc->end;
+   negative = false;
+   if (cp < end && (*cp == '+' || *cp == '-')) negative = (*cp++ == '-');
+   mantissa = 0;
+   nDigits = scale = 0;
+   found = false;
+   while (cp < end && *cp >= '0' && *cp <= '9') {
+      if (mantissa != 0 || *cp != '0') nDigits++;
+      if (nDigits <= MAX_FAST_DIGITS) mantissa = 10 * mantissa + *cp - '0';
+      if (nDigits > MAX_FAST_DIGITS) scale++;
+      found = true;
+      cp++;
+   }
+   if (cp < end && *cp == '.') {
+      cp++;
+      while (cp < end && *cp >= '0' && *cp <= '9') {
+         if (mantissa != 0 || *cp != '0') nDigits++;
+         if (nDigits <= MAX_FAST_DIGITS) {
+            mantissa = 10 * mantissa + *cp - '0';
+            scale--;
+         }
+         found = true;
+         cp++;
+      }
+   }
+   if (!found) return false;
+   exponent = 0;
+   if (cp < end && (*cp == 'e' || *cp == 'E')) {
+      cp++;
+      expSign = 1;
+      if (cp < end && (*cp == '+' || *cp == '-')) {
+         if (*cp++ == '-') expSign = -1;
+      }
+      if (cp == end || *cp < '0' || *cp > '9') return false;
+      while (cp < end && *cp >= '0' && *cp <= '9') {
+         if (exponent < 10000) exponent = 10 * exponent + *cp - '0';
+         cp++;
+      }
+      exponent *= expSign;
+   }
+   if (!atDelimiter(cp, end)) return false;
+   exponent += scale;
+   if (nDigits <= MAX_FAST_DIGITS && exponent >= -MAX_EXACT_POWER
+                                  && exponent <= MAX_EXACT_POWER) {
+      *cost = (exponent < 0) ? mantissa / POWERS_OF_TEN[-exponent]
+                             : mantissa * POWERS_OF_TEN[exponent];
+      if (negative) *cost = -*cost;
+   } else {
+      if (cp - tc->cp >= MAX_TOKEN_LENGTH) return false;
+      memcpy(buffer, tc->cp, cp - tc->cp);
+      buffer[cp - tc->cp] = '\0';
+      *cost = strtod(buffer, NULL);
+   }
+   tc->cp = cp;
+   return true;
+}
+
+static bool atDelimiter(const char *cp, const char *end) {
+   return cp == end || *cp == ' ' || *cp == '\t' || *cp == '\r'
+                    || *cp == '\n';
+}
+
+static void skipSpaces(TextCursor *tc) {
+   while (tc->cp < tc->end
+          && (*tc->cp == ' ' || *tc->cp == '\t' || *tc->cp == '\r')) {
+      tc->cp++;
+   }
+}
+
+static bool atLineEnd(TextCursor *tc) {
+   return tc->cp == tc->end || *tc->cp == '\n';
+}
+
+static void initArcList(ArcList *arcs, int capacity) {
+   arcs->capacity = capacity;
+   arcs->starts = newArray(capacity, int);
+   arcs->ends = newArray(capacity, int);
+   arcs->costs = newArray(capacity, double);
+   arcs->count = 0;
+   arcs->nArcs = 0;
+   arcs->maxLabel = -1;
+}
+
+static void freeArcList(ArcList *arcs) {
+   freeBlock(arcs->starts);
+   freeBlock(arcs->ends);
+   freeBlock(arcs->costs);
+}
+
+static void appendArc(ArcList *arcs, int start, int end, double cost) {
+   int *starts, *ends;
+   double *costs;
+
+   if (arcs->count == arcs->capacity) {
+      arcs->capacity *= 2;
+      starts = newArray(arcs->capacity, int);
+      ends = newArray(arcs->capacity, int);
+      costs = newArray(arcs->capacity, double);
+      memcpy(starts, arcs->starts, arcs->count * sizeof (int));
+      memcpy(ends, arcs->ends, arcs->count * sizeof (int));
+      memcpy(costs, arcs->costs, arcs->count * sizeof (double));
+      freeArcList(arcs);
+      arcs->starts = starts;
+      arcs->ends = ends;
+      arcs->costs = costs;
+   }
+   arcs->starts[arcs->count] = start;
+   arcs->ends[arcs->count] = end;
+   arcs->costs[arcs->count] = cost;
+   arcs->count++;
+   if (end >= 0) arcs->nArcs++;
+   if (start > arcs->maxLabel) arcs->maxLabel = start;
+   if (end > arcs->maxLabel) arcs->maxLabel = end;
+}
+
+/*
+ * Function: assignIds
+ * Usage: labels = assignIds(&arcs, &nNodes);
+ * ------------------------------------------
+ * Numbers the distinct labels in the arc list in ascending order,
+ * replaces each label in the list with its number, and returns an array
+ * that maps each number back to its label.  When the labels are dense
+ * enough, the function finds the numbers through an array indexed by
+ * label.  Otherwise, it sorts the labels and finds each one by binary
+ * search.
+ */
+
+static int *assignIds(ArcList *arcs, int *nNodes) {
+   int *labels, *idOf;
+   int n, i, label;
+
+   if (arcs->maxLabel < DENSE_LABEL_FACTOR * ((int64_t) arcs->count + 1)) {
+      idOf = newArray(arcs->maxLabel + 1, int);
+      for (label = 0; label <= arcs->maxLabel; label++) {
+         idOf[label] = -1;
+      }
+      for (i = 0; i < arcs->count; i++) {
+         idOf[arcs->starts[i]] = 0;
+         if (arcs->ends[i] >= 0) idOf[arcs->ends[i]] = 0;
+      }
+      n = 0;
+      for (label = 0; label <= arcs->maxLabel; label++) {
+         if (idOf[label] == 0) n++;
+      }
+      labels = newArray(n, int);
+      n = 0;
+      for (label = 0; label <= arcs->maxLabel; label++) {
+         if (idOf[label] == 0) {
+            labels[n] = label;
+            idOf[label] = n++;
+         }
+      }
+      for (i = 0; i < arcs->count; i++) {
+         arcs->starts[i] = idOf[arcs->starts[i]];
+         if (arcs->ends[i] >= 0) arcs->ends[i] = idOf[arcs->ends[i]];
+      }
+      freeBlock(idOf);
+   } else {
+      labels = newArray(2 * arcs->count, int);
+      n = 0;
+      for (i = 0; i < arcs->count; i++) {
+         labels[n++] = arcs->starts[i];
+         if (arcs->ends[i] >= 0) labels[n++] = arcs->ends[i];
+      }
+      qsort(labels, n, sizeof (int), compareLabels);
+      label = n;
+      n = 0;
+      for (i = 0; i < label; i++) {
+         if (i == 0 || labels[i] != labels[n - 1]) labels[n++] = labels[i];
+      }
+      for (i = 0; i < arcs->count; i++) {
+         arcs->starts[i] = findLabel(labels, n, arcs->starts[i]);
+         if (arcs->ends[i] >= 0) {
+            arcs->ends[i] = findLabel(labels, n, arcs->ends[i]);
+         }
+      }
+   }
+   *nNodes = n;
+   return labels;
+}
+
+static int findLabel(int labels[], int n, int label) {
+   int lh, rh, mid;
+
+   lh = 0;
+   rh = n - 1;
+   while (lh < rh) {
+      mid = lh + (rh - lh) / 2;
+      if (labels[mid] < label) {
+         lh = mid + 1;
+      } else {
+         rh = mid;
+      }
+   }
+   return lh;
+}
+
+static int compareLabels(const void *p1, const void *p2) {
+   int v1, v2;
+
+   v1 = *((int *) p1);
+   v2 = *((int *) p2);
+   return (v1 > v2) - (v1 < v2);
+}
+
+/*
+ * Function: createNames
+ * Usage: buf = createNames(labels, n, &names);
+ * --------------------------------------------
+ * Writes the decimal form of each label into a single block, which it
+ * returns, and sets names to a new array of pointers into that block.
+ */
+
+static char *createNames(int labels[], int n, string **names) {
+   char digits[MAX_TOKEN_LENGTH];
+   char *buf, *cp;
+   size_t size;
+   int id;
+
+   size = 0;
+   for (id = 0; id < n; id++) {
+      size += sprintf(digits, "%d", labels[id]) + 1;
+   }
+   buf = newArray(size + 1, char);
+   *names = newArray(n, string);
+   cp = buf;
+   for (id = 0; id < n; id++) {
+      (*names)[id] = cp;
+      cp += sprintf(cp, "%d", labels[id]) + 1;
+   }
+   return buf;
+}
+
+/*
+ * Function: checkSnapshot
+ * Usage: status = checkSnapshot(&header, &image);
+ * -----------------------------------------------
+ * Copies the header out of the file image and checks that it describes
+ * a file of exactly this size.  The function returns 0 if the header is
+ * valid, 2 if the file comes from a machine with the other byte order,
+ * and 1 if it is not a saved snapshot at all.
+ */
+
+static int checkSnapshot(SnapshotHeader *header, FileImage *image) {
+   uint64_t expected;
+
+   if (image->size < sizeof *header) return 1;
+   memcpy(header, image->data, sizeof *header);
+   if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof header->magic) != 0) {
+      return 1;
+   }
+   if (header->byteOrder == SWAPPED_ORDER_MARK) return 2;
+   if (header->byteOrder != BYTE_ORDER_MARK) return 1;
+   if (header->version != FORMAT_VERSION) return 1;
+   if (header->nNodes < 0 || header->nArcs < 0) return 1;
+   if (header->nameBytes < 0) return 1;
+   expected = sizeof *header + (header->nNodes + (uint64_t) 1) * sizeof (int)
+            + (uint64_t) header->nArcs * (sizeof (int) + sizeof (double))
+            + header->nameBytes;
+   return (expected == image->size) ? 0 : 1;
+}
+
+static bool checkRows(int offsets[], int targets[], int nNodes, int nArcs) {
+   int u, i;
+
+   if (offsets[0] != 0 || offsets[nNodes] != nArcs) return false;
+   for (u = 0; u < nNodes; u++) {
+      if (offsets[u] > offsets[u + 1]) return false;
+   }
+   for (i = 0; i < nArcs; i++) {
+      if (targets[i] < 0 || targets[i] >= nNodes) return false;
+   }
+   return true;
+}
+
+static void writeBlock(FILE *outfile, void *data, size_t size, string path) {
+   if (size > 0 && fwrite(data, 1, size, outfile) != size) {
+      fclose(outfile);
+      error("saveFrozenGraph: Can't write %s", path);
+   }
+}
+
+/**********************************************************************/
+/* Unit test for the graphio module                                   */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+#include "filelib.h"
+#include "foreach.h"
+
+#define TEST_FILE "graphio-test.txt"
+#define TEST_SNAPSHOT "graphio-test.dat"
+
+/* Private function prototypes */
+
+static void testEdgeLists(void);
+static void testAdjacencyLists(void);
+static void testCosts(void);
+static void testSyntaxErrors(void);
+static void testSavedSnapshots(void);
+static void testDamagedSnapshots(void);
+static void writeTestFile(string path, string text);
+static void patchTestFile(string path, long offset, void *data, int size);
+static string snapshotString(FrozenGraph fg);
+
+/* Unit test */
+
+void testGraphIOModule(void) {
+   testEdgeLists();
+   testAdjacencyLists();
+   testCosts();
+   testSyntaxErrors();
+   testSavedSnapshots();
+}
+
+static void testEdgeLists(void) {
+   Graph g;
+   FrozenGraph fg;
+
+   writeTestFile(TEST_FILE, "# Directed edge list\n"
+                            "7 3 2.5\n"
+                            "\n"
+                            "3 7\r\n"
+                            "  12\t3   0.25  \n"
+                            "% comment\n"
+                            "7 12 4");
+   trace(fg = loadFrozenGraphFromEdgeList(TEST_FILE, 0));
+   test(getFrozenNodeCount(fg), 3);
+   test(getFrozenArcCount(fg), 4);
+   test(snapshotString(fg), "3>7:1 7>3:2.5 7>12:4 12>3:0.25");
+   test(getFrozenNodeId(fg, "12"), 2);
+   test(getFrozenNode(fg, 0), NULL);
+   freeFrozenGraph(fg);
+   trace(g = loadGraphFromEdgeList(TEST_FILE, 0));
+   test(sizeSet(getNodeSet(g)), 3);
+   test(sizeSet(getArcSet(g)), 4);
+   fg = freezeGraph(g);
+   test(snapshotString(fg), "12>3:0.25 3>7:1 7>12:4 7>3:2.5");
+   freeFrozenGraph(fg);
+   freeGraph(g);
+   writeTestFile(TEST_FILE, "2000000000 5\n5 2000000000 3\n");
+   trace(fg = loadFrozenGraphFromEdgeList(TEST_FILE, EDGE_LIST_UNDIRECTED));
+   test(snapshotString(fg),
+        "5>2000000000:1 5>2000000000:3 2000000000>5:1 2000000000>5:3");
+   freeFrozenGraph(fg);
+   writeTestFile(TEST_FILE, "");
+   trace(fg = loadFrozenGraphFromEdgeList(TEST_FILE, 0));
+   test(getFrozenNodeCount(fg), 0);
+   freeFrozenGraph(fg);
+   deleteFile(TEST_FILE);
+}
+
+static void testAdjacencyLists(void) {
+   FrozenGraph fg;
+   Graph g;
+
+   writeTestFile(TEST_FILE, "1 2 3\n2 3\n4\n");
+   trace(fg = loadFrozenGraphFromEdgeList(TEST_FILE, EDGE_LIST_ADJACENCY));
+   test(getFrozenNodeCount(fg), 4);
+   test(snapshotString(fg), "1>2:1 1>3:1 2>3:1");
+   freeFrozenGraph(fg);
+   trace(fg = loadFrozenGraphFromEdgeList(TEST_FILE, EDGE_LIST_ADJACENCY
+                                                     | EDGE_LIST_UNDIRECTED));
+   test(snapshotString(fg), "1>2:1 1>3:1 2>1:1 2>3:1 3>1:1 3>2:1");
+   freeFrozenGraph(fg);
+   trace(g = loadGraphFromEdgeList(TEST_FILE, EDGE_LIST_ADJACENCY));
+   test(sizeSet(getNodeSet(g)), 4);
+   test(sizeSet(getArcSet(getNode(g, "4"))), 0);
+   freeGraph(g);
+   deleteFile(TEST_FILE);
+}
+
+static void testCosts(void) {
+   FrozenGraph fg;
+   const double *costs;
+
+   writeTestFile(TEST_FILE, "0 1 0.1\n0 1 -3\n0 1 +1.5e3\n0 1 .5\n"
+                            "0 1 1.23456789012345678901\n0 1 2E-400\n"
+                            "0 1 007\n");
+   trace(fg = loadFrozenGraphFromEdgeList(TEST_FILE, 0));
+   costs = getFrozenCosts(fg);
+   test(costs[0] == 0.1, true);
+   test(costs[1] == -3.0, true);
+   test(costs[2], 1500.0);
+   test(costs[3], 0.5);
+   test(costs[4] == 1.23456789012345678901, true);
+   test(costs[5], 0.0);
+   test(costs[6], 7.0);
+   freeFrozenGraph(fg);
+   deleteFile(TEST_FILE);
+}
+
+static void testSyntaxErrors(void) {
+   writeTestFile(TEST_FILE, "1 2\n1 x\n");
+   testError(loadGraphFromEdgeList(TEST_FILE, 0));
+   writeTestFile(TEST_FILE, "1 2 3 4\n");
+   testError(loadFrozenGraphFromEdgeList(TEST_FILE, 0));
+   writeTestFile(TEST_FILE, "-1 2\n");
+   testError(loadFrozenGraphFromEdgeList(TEST_FILE, 0));
+   writeTestFile(TEST_FILE, "1 99999999999\n");
+   testError(loadFrozenGraphFromEdgeList(TEST_FILE, 0));
+   writeTestFile(TEST_FILE, "1 2 1.5x\n");
+   testError(loadFrozenGraphFromEdgeList(TEST_FILE, 0));
+   deleteFile(TEST_FILE);
+   testError(loadGraphFromEdgeList(TEST_FILE, 0));
+}
+
+static void testSavedSnapshots(void) {
+   FrozenGraph fg, copy;
+
+   writeTestFile(TEST_FILE, "10 20 1.5\n20 30 2\n30 10 4\n10 30 8\n40 40\n");
+   fg = loadFrozenGraphFromEdgeList(TEST_FILE, 0);
+   trace(saveFrozenGraph(fg, TEST_SNAPSHOT));
+   trace(copy = loadFrozenGraph(TEST_SNAPSHOT));
+   test(getFrozenNodeCount(copy), 4);
+   test(getFrozenArcCount(copy), 5);
+   test(stringEqual(snapshotString(copy), snapshotString(fg)), true);
+   test(getFrozenNodeId(copy, "30"), 2);
+   test(getFrozenInOffsets(copy)[4], 5);
+   freeFrozenGraph(copy);
+   freeFrozenGraph(fg);
+   testError(loadFrozenGraph(TEST_FILE));
+   writeTestFile(TEST_SNAPSHOT, "SPLGRAPH");
+   testError(loadFrozenGraph(TEST_SNAPSHOT));
+   testDamagedSnapshots();
+   deleteFile(TEST_FILE);
+   deleteFile(TEST_SNAPSHOT);
+}
+
+static void testDamagedSnapshots(void) {
+   FrozenGraph fg;
+   int32_t count;
+   int64_t nameBytes;
+
+   fg = loadFrozenGraphFromEdgeList(TEST_FILE, 0);
+   saveFrozenGraph(fg, TEST_SNAPSHOT);
+   patchTestFile(TEST_SNAPSHOT, -1, "x", 1);
+   testError(loadFrozenGraph(TEST_SNAPSHOT));
+   saveFrozenGraph(fg, TEST_SNAPSHOT);
+   count = 6;
+   patchTestFile(TEST_SNAPSHOT, offsetof(SnapshotHeader, nArcs),
+                 &count, sizeof count);
+   testError(loadFrozenGraph(TEST_SNAPSHOT));
+   saveFrozenGraph(fg, TEST_SNAPSHOT);
+   count = 5;
+   nameBytes = getFrozenNodeCount(fg) * 3 - sizeof (int);
+   patchTestFile(TEST_SNAPSHOT, offsetof(SnapshotHeader, nNodes),
+                 &count, sizeof count);
+   patchTestFile(TEST_SNAPSHOT, offsetof(SnapshotHeader, nameBytes),
+                 &nameBytes, sizeof nameBytes);
+   testError(loadFrozenGraph(TEST_SNAPSHOT));
+   saveFrozenGraph(fg, TEST_SNAPSHOT);
+   count = 3;
+   nameBytes = getFrozenNodeCount(fg) * 3 + sizeof (int);
+   patchTestFile(TEST_SNAPSHOT, offsetof(SnapshotHeader, nNodes),
+                 &count, sizeof count);
+   patchTestFile(TEST_SNAPSHOT, offsetof(SnapshotHeader, nameBytes),
+                 &nameBytes, sizeof nameBytes);
+   testError(loadFrozenGraph(TEST_SNAPSHOT));
+   freeFrozenGraph(fg);
+}
+
+static void writeTestFile(string path, string text) {
+   FILE *outfile;
+
+   outfile = fopen(path, "wb");
+   if (outfile == NULL) error("Can't create %s", path);
+   fputs(text, outfile);
+   fclose(outfile);
+}
+
+/*
+ * Function: snapshotString
+ * Usage: str = snapshotString(fg);
+ * --------------------------------
+ * Returns a string that lists the arcs of the snapshot in the order of
+ * its rows, with each arc written as start>end:cost.
+ */
+
+/*
+ * Function: patchTestFile
+ * Usage: patchTestFile(path, offset, data, size);
+ * -----------------------------------------------
+ * Overwrites size bytes of the file at the given offset, which counts
+ * back from the end of the file if it is negative.
+ */
+
+static void patchTestFile(string path, long offset, void *data, int size) {
+   FILE *file;
+
+   file = fopen(path, "r+b");
+   if (file == NULL) error("Can't open %s", path);
+   fseek(file, offset, (offset < 0) ? SEEK_END : SEEK_SET);
+   fwrite(data, 1, size, file);
+   fclose(file);
+}
+
+static string snapshotString(FrozenGraph fg) {
+   const int *offsets, *targets;
+   const double *costs;
+   string str;
+   int u, i;
+
+   offsets = getFrozenOffsets(fg);
+   targets = getFrozenTargets(fg);
+   costs = getFrozenCosts(fg);
+   str = "";
+   for (u = 0; u < getFrozenNodeCount(fg); u++) {
+      for (i = offsets[u]; i < offsets[u + 1]; i++) {
+         if (i > 0) str = concat(str, " ");
+         str = concat(str, getFrozenNodeName(fg, u));
+         str = concat(str, ">");
+         str = concat(str, getFrozenNodeName(fg, targets[i]));
+         str = concat(str, ":");
+         str = concat(str, realToString(costs[i]));
+      }
+   }
+   return str;
+}
+
+#endif
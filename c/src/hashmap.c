@@ -37,6 +37,7 @@
 /* Constants */
 
 #define INITIAL_BUCKET_COUNT 101
+#define MAX_LOAD_FACTOR 2
 #define HASH_SEED 5381
 #define HASH_MULTIPLIER 33
 #define HASH_MASK ((unsigned) -1 >> 1)
@@ -73,10 +74,9 @@ struct HashMapCDT {
 
 /* Private function prototypes */
 
-static int hashCode(string str);
 static void rehash(HashMap map, int nBuckets);
 static void freeBucketChain(Cell *cp);
-static Cell *findCell(Cell *cp, string s);
+static Cell *findCell(Cell *cp, StringView key);
 static Iterator newMapIterator(void *collection);
 static void addKeyToIterator(string key, void *value, void *data);
 
@@ -95,6 +95,7 @@ HashMap newHashMap(void) {
 
 void freeHashMap(HashMap map) {
    clearHashMap(map);
+   freeBlock(map->buckets);
    freeBlock(map);
 }
 
@@ -134,24 +135,31 @@ void putHashMap(HashMap map, string key, void *value) {
    int bucket;
    Cell *cp;
 
-   bucket = hashCode(key) % map->nBuckets;
-   cp = findCell(map->buckets[bucket], key);
+   bucket = hashString(key) % map->nBuckets;
+   cp = findCell(map->buckets[bucket], viewString(key));
    if (cp == NULL) {
       cp = newBlock(Cell *);
       cp->key = copyString(key);
       cp->link = map->buckets[bucket];
       map->buckets[bucket] = cp;
       map->count++;
+      if (map->count > MAX_LOAD_FACTOR * map->nBuckets) {
+         rehash(map, 2 * map->nBuckets + 1);
+      }
    }
    cp->value = value;
 }
 
 void *getHashMap(HashMap map, string key) {
+   return getHashMapView(map, viewString(key));
+}
+
+void *getHashMapView(HashMap map, StringView view) {
    int bucket;
    Cell *cp;
 
-   bucket = hashCode(key) % map->nBuckets;
-   cp = findCell(map->buckets[bucket], key);
+   bucket = hashView(view) % map->nBuckets;
+   cp = findCell(map->buckets[bucket], view);
    if (cp == NULL) return NULL;
    return cp->value;
 }
@@ -160,7 +168,7 @@ void removeHashMap(HashMap map, string key) {
    int bucket;
    Cell **cpp, *cp;
 
-   bucket = hashCode(key) % map->nBuckets;
+   bucket = hashString(key) % map->nBuckets;
    cpp = &map->buckets[bucket];
    while (*cpp != NULL && !stringEqual((*cpp)->key, key)) {
       cpp = &(*cpp)->link;
@@ -175,10 +183,14 @@ void removeHashMap(HashMap map, string key) {
 }
 
 bool containsKeyHashMap(HashMap map, string key) {
+   return containsKeyHashMapView(map, viewString(key));
+}
+
+bool containsKeyHashMapView(HashMap map, StringView view) {
    int bucket;
 
-   bucket = hashCode(key) % map->nBuckets;
-   return findCell(map->buckets[bucket], key) != NULL;
+   bucket = hashView(view) % map->nBuckets;
+   return findCell(map->buckets[bucket], view) != NULL;
 }
 
 void mapHashMap(HashMap map, proc fn, void *data) {
@@ -192,20 +204,33 @@ void mapHashMap(HashMap map, proc fn, void *data) {
    }
 }
 
-/* Private functions */
+int hashString(string str) {
+   if (str == NULL) error("hashString: String value is NULL");
+   return hashView(viewString(str));
+}
 
-static int hashCode(string str) {
+int hashView(StringView view) {
    unsigned hash;
-   int i, n;
+   int i;
 
    hash = HASH_SEED;
-   n = stringLength(str);
-   for (i = 0; i < n; i++) {
-      hash = HASH_MULTIPLIER * hash + str[i];
+   for (i = 0; i < view.len; i++) {
+      hash = HASH_MULTIPLIER * hash + view.p[i];
    }
    return (int) (hash & HASH_MASK);
 }
 
+/* Private functions */
+
+/*
+ * Implementation notes: rehash
+ * ----------------------------
+ * This function moves the cells into a new array of buckets.  The map
+ * calls it whenever the average chain grows longer than MAX_LOAD_FACTOR,
+ * doubling the number of buckets each time, so that the cost of growing
+ * the table is constant when averaged over the calls to putHashMap.
+ */
+
 static void rehash(HashMap map, int nBuckets) {
    Cell **oldBuckets, *cp, *np;
    int oldNBuckets, bucket, i;
@@ -224,12 +249,13 @@ static void rehash(HashMap map, int nBuckets) {
          cp = oldBuckets[i];
          while (cp != NULL) {
             np = cp->link;
-            bucket = hashCode(cp->key) % nBuckets;
+            bucket = hashString(cp->key) % nBuckets;
             cp->link = map->buckets[bucket];
             map->buckets[bucket] = cp;
             cp = np;
          }
       }
+      freeBlock(oldBuckets);
    }
 }
 
@@ -252,8 +278,8 @@ static void freeBucketChain(Cell *cp) {
    }
 }
 
-static Cell *findCell(Cell *cp, string key) {
-   while (cp != NULL && !stringEqual(cp->key, key)) {
+static Cell *findCell(Cell *cp, StringView key) {
+   while (cp != NULL && !viewEquals(key, cp->key)) {
       cp = cp->link;
    }
    return cp;
@@ -295,7 +321,7 @@ static void markElement(string name, int *bitSet);
 
 void testHashMapModule(void) {
    HashMap map, map2;
-   string key;
+   string key, text;
    int bits;
 
    trace(map = newHashMap());
@@ -328,6 +354,14 @@ void testHashMapModule(void) {
    trace(bits = 0);
    trace(foreach (key in map2) markElement(key, &bits));
    test(bits, 15);
+   trace(text = "H He Hel");
+   test(getHashMapView(map, sliceString(text, 2, 3)), "Helium");
+   test(getHashMapView(map, sliceString(text, 0, 0)), "Hydrogen");
+   test(getHashMapView(map, sliceString(text, 5, 7)), NULL);
+   test(getHashMapView(map, sliceString(text, 5, 5)), "Hydrogen");
+   test(containsKeyHashMapView(map, sliceString(text, 2, 3)), true);
+   test(containsKeyHashMapView(map, sliceString(text, 1, 1)), false);
+   test(hashView(sliceString(text, 2, 3)) == hashString("He"), true);
 }
 
 /* Private functions */
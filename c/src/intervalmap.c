@@ -0,0 +1,834 @@
+/*
+ * File: intervalmap.c
+ * -------------------
+ * This file implements the intervalmap.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmpfn.h"
+#include "cslib.h"
+#include "generic.h"
+#include "intervalmap.h"
+#include "unittest.h"
+
+/*
+ * Type: IntervalNode
+ * ------------------
+ * This type defines a node in the tree of an interval map.  The tree is
+ * an AVL tree ordered by lower endpoint and then by upper endpoint, and
+ * each node also records the largest upper endpoint in its subtree.  A
+ * search for overlapping intervals can skip any subtree whose largest
+ * upper endpoint lies before the query, which is what makes the search
+ * take logarithmic rather than linear time.
+ */
+
+typedef struct IntervalNode {
+   GenericType lo;
+   GenericType hi;
+   GenericType maxHi;
+   void *value;
+   int height;
+   struct IntervalNode *left;
+   struct IntervalNode *right;
+} IntervalNode;
+
+/*
+ * Type: IntervalMapCDT
+ * --------------------
+ * This type defines the concrete structure of an interval map.
+ */
+
+struct IntervalMapCDT {
+   IntervalNode *root;
+   int count;
+   string baseType;
+   CompareFn cmpFn;
+   FetchFn fetchFn;
+};
+
+/*
+ * Type: SegmentTreeCDT
+ * --------------------
+ * This type defines the concrete structure of a segment tree.  The
+ * intervals are stored in parallel arrays sorted by lower endpoint.  The
+ * tree itself is a complete binary tree stored in the maxIndex array,
+ * in which node k has children 2k and 2k + 1, and the leaves are the
+ * nodes from leafBase up, one for each interval.  Each node holds the
+ * index of the interval with the largest upper endpoint among the
+ * leaves below it, or -1 if those leaves are all past the last interval.
+ */
+
+struct SegmentTreeCDT {
+   GenericType *los;
+   GenericType *his;
+   void **values;
+   int *maxIndex;
+   int leafBase;
+   int count;
+   CompareFn cmpFn;
+   FetchFn fetchFn;
+};
+
+/*
+ * Type: IntervalQuery
+ * -------------------
+ * This type holds the arguments of an overlap query while it descends
+ * through one of the trees.
+ */
+
+typedef struct {
+   GenericType lo;
+   GenericType hi;
+   IntervalFn fn;
+   void *data;
+   int limit;
+} IntervalQuery;
+
+/* Private function prototypes */
+
+static int compareKeys(CompareFn cmpFn, GenericType k1, GenericType k2);
+static void fetchInterval(FetchFn fetchFn, CompareFn cmpFn, va_list args,
+                          GenericType *lo, GenericType *hi, string fnName);
+static IntervalNode *findNode(IntervalMap map, GenericType lo,
+                                               GenericType hi);
+static IntervalNode *insertNode(IntervalMap map, IntervalNode *t,
+                                GenericType lo, GenericType hi, void *value);
+static IntervalNode *removeNode(IntervalMap map, IntervalNode *t,
+                                GenericType lo, GenericType hi);
+static IntervalNode *detachMin(IntervalMap map, IntervalNode *t,
+                                                IntervalNode **min);
+static IntervalNode *rebalance(IntervalMap map, IntervalNode *t);
+static IntervalNode *rotateLeft(IntervalMap map, IntervalNode *t);
+static IntervalNode *rotateRight(IntervalMap map, IntervalNode *t);
+static void updateNode(IntervalMap map, IntervalNode *t);
+static int heightOf(IntervalNode *t);
+static IntervalNode *copyTree(IntervalNode *t);
+static void freeTree(IntervalNode *t);
+static int searchTree(IntervalMap map, IntervalNode *t, IntervalQuery *q);
+static void walkTree(IntervalNode *t, IntervalFn fn, void *data);
+static int searchSegments(SegmentTree st, int k, int left, int right,
+                                          IntervalQuery *q);
+static int mapOverlapsFromArgs(IntervalMap map, IntervalFn fn, void *data,
+                               va_list args, bool stabbing);
+static int mapSegmentsFromArgs(SegmentTree st, IntervalFn fn, void *data,
+                               va_list args, bool stabbing);
+
+/* Exported entries */
+
+IntervalMap newIntervalMapFromType(string baseType) {
+   IntervalMap map;
+
+   map = newBlock(IntervalMap);
+   map->root = NULL;
+   map->count = 0;
+   map->baseType = baseType;
+   map->cmpFn = getCompareFnForType(baseType);
+   map->fetchFn = getFetchFnForType(baseType);
+   return map;
+}
+
+void freeIntervalMap(IntervalMap map) {
+   freeTree(map->root);
+   freeBlock(map);
+}
+
+int sizeIntervalMap(IntervalMap map) {
+   return map->count;
+}
+
+bool isEmptyIntervalMap(IntervalMap map) {
+   return map->count == 0;
+}
+
+void clearIntervalMap(IntervalMap map) {
+   freeTree(map->root);
+   map->root = NULL;
+   map->count = 0;
+}
+
+IntervalMap cloneIntervalMap(IntervalMap map) {
+   IntervalMap newmap;
+
+   newmap = newIntervalMapFromType(map->baseType);
+   newmap->root = copyTree(map->root);
+   newmap->count = map->count;
+   return newmap;
+}
+
+void putIntervalMap(IntervalMap map, ...) {
+   va_list args;
+
+   va_start(args, map);
+   putIntervalMapFromArgs(map, args);
+   va_end(args);
+}
+
+void putIntervalMapFromArgs(IntervalMap map, va_list args) {
+   GenericType lo, hi;
+   void *value;
+
+   fetchInterval(map->fetchFn, map->cmpFn, args, &lo, &hi, "putIntervalMap");
+   value = va_arg(args, void *);
+   map->root = insertNode(map, map->root, lo, hi, value);
+}
+
+void *getIntervalMap(IntervalMap map, ...) {
+   va_list args;
+   void *value;
+
+   va_start(args, map);
+   value = getIntervalMapFromArgs(map, args);
+   va_end(args);
+   return value;
+}
+
+void *getIntervalMapFromArgs(IntervalMap map, va_list args) {
+   IntervalNode *t;
+   GenericType lo, hi;
+
+   fetchInterval(map->fetchFn, map->cmpFn, args, &lo, &hi, "getIntervalMap");
+   t = findNode(map, lo, hi);
+   return (t == NULL) ? NULL : t->value;
+}
+
+void removeIntervalMap(IntervalMap map, ...) {
+   va_list args;
+
+   va_start(args, map);
+   removeIntervalMapFromArgs(map, args);
+   va_end(args);
+}
+
+void removeIntervalMapFromArgs(IntervalMap map, va_list args) {
+   GenericType lo, hi;
+
+   fetchInterval(map->fetchFn, map->cmpFn, args, &lo, &hi,
+                 "removeIntervalMap");
+   map->root = removeNode(map, map->root, lo, hi);
+}
+
+/*
+ * Implementation notes: overlapsIntervalMap
+ * -----------------------------------------
+ * If the left subtree contains an interval that ends at or after the
+ * start of the query but none of them overlaps it, every interval in
+ * the left subtree must start after the end of the query, and so must
+ * every interval in the right subtree.  The search can therefore follow
+ * a single path, going left whenever the left subtree reaches far enough.
+ */
+
+bool overlapsIntervalMap(IntervalMap map, ...) {
+   IntervalNode *t;
+   GenericType lo, hi;
+   va_list args;
+
+   va_start(args, map);
+   fetchInterval(map->fetchFn, map->cmpFn, args, &lo, &hi,
+                 "overlapsIntervalMap");
+   va_end(args);
+   t = map->root;
+   while (t != NULL) {
+      if (compareKeys(map->cmpFn, t->lo, hi) <= 0
+            && compareKeys(map->cmpFn, lo, t->hi) <= 0) {
+         return true;
+      }
+      if (t->left != NULL && compareKeys(map->cmpFn, t->left->maxHi, lo) >= 0) {
+         t = t->left;
+      } else {
+         t = t->right;
+      }
+   }
+   return false;
+}
+
+int mapOverlapsIntervalMap(IntervalMap map, IntervalFn fn, void *data, ...) {
+   va_list args;
+   int count;
+
+   va_start(args, data);
+   count = mapOverlapsFromArgs(map, fn, data, args, false);
+   va_end(args);
+   return count;
+}
+
+int mapStabbingIntervalMap(IntervalMap map, IntervalFn fn, void *data, ...) {
+   va_list args;
+   int count;
+
+   va_start(args, data);
+   count = mapOverlapsFromArgs(map, fn, data, args, true);
+   va_end(args);
+   return count;
+}
+
+void mapIntervalMap(IntervalMap map, IntervalFn fn, void *data) {
+   walkTree(map->root, fn, data);
+}
+
+/*
+ * Implementation notes: newSegmentTreeFromType
+ * --------------------------------------------
+ * The constructor sorts the intervals by lower endpoint, carrying the
+ * original index of each along, and then fills in the tree from the
+ * leaves up.
+ */
+
+SegmentTree newSegmentTreeFromType(string baseType, void *los, void *his,
+                                   void *values[], int n) {
+   SegmentTree st;
+   GenericType *keys, *sortedHis;
+   void **order;
+   char *lp, *hp;
+   int i, k, typeSize, i1, i2;
+
+   st = newBlock(SegmentTree);
+   st->cmpFn = getCompareFnForType(baseType);
+   st->fetchFn = getFetchFnForType(baseType);
+   typeSize = getTypeSizeForType(baseType);
+   keys = newArray(n, GenericType);
+   sortedHis = newArray(n, GenericType);
+   order = newArray(n, void *);
+   memset(keys, 0, n * sizeof(GenericType));
+   memset(sortedHis, 0, n * sizeof(GenericType));
+   lp = (char *) los;
+   hp = (char *) his;
+   for (i = 0; i < n; i++) {
+      memcpy(&keys[i], lp + i * typeSize, typeSize);
+      memcpy(&sortedHis[i], hp + i * typeSize, typeSize);
+      if (compareKeys(st->cmpFn, keys[i], sortedHis[i]) > 0) {
+         error("newSegmentTree: Interval %d has lo > hi", i);
+      }
+      order[i] = (void *) (intptr_t) i;
+   }
+   sortGenericArray(keys, order, n, st->cmpFn);
+   st->los = keys;
+   st->his = newArray(n, GenericType);
+   st->values = newArray(n, void *);
+   for (i = 0; i < n; i++) {
+      st->his[i] = sortedHis[(intptr_t) order[i]];
+      st->values[i] = values[(intptr_t) order[i]];
+   }
+   freeBlock(sortedHis);
+   freeBlock(order);
+   st->count = n;
+   st->leafBase = 1;
+   while (st->leafBase < n) {
+      st->leafBase *= 2;
+   }
+   st->maxIndex = newArray(2 * st->leafBase, int);
+   for (i = 0; i < st->leafBase; i++) {
+      st->maxIndex[st->leafBase + i] = (i < n) ? i : -1;
+   }
+   for (k = st->leafBase - 1; k > 0; k--) {
+      i1 = st->maxIndex[2 * k];
+      i2 = st->maxIndex[2 * k + 1];
+      if (i2 >= 0 && compareKeys(st->cmpFn, st->his[i2], st->his[i1]) > 0) {
+         i1 = i2;
+      }
+      st->maxIndex[k] = i1;
+   }
+   return st;
+}
+
+void freeSegmentTree(SegmentTree st) {
+   freeBlock(st->los);
+   freeBlock(st->his);
+   freeBlock(st->values);
+   freeBlock(st->maxIndex);
+   freeBlock(st);
+}
+
+int sizeSegmentTree(SegmentTree st) {
+   return st->count;
+}
+
+int mapOverlapsSegmentTree(SegmentTree st, IntervalFn fn, void *data, ...) {
+   va_list args;
+   int count;
+
+   va_start(args, data);
+   count = mapSegmentsFromArgs(st, fn, data, args, false);
+   va_end(args);
+   return count;
+}
+
+int mapStabbingSegmentTree(SegmentTree st, IntervalFn fn, void *data, ...) {
+   va_list args;
+   int count;
+
+   va_start(args, data);
+   count = mapSegmentsFromArgs(st, fn, data, args, true);
+   va_end(args);
+   return count;
+}
+
+/* Private functions */
+
+static int compareKeys(CompareFn cmpFn, GenericType k1, GenericType k2) {
+   return cmpFn(&k1, &k2);
+}
+
+static void fetchInterval(FetchFn fetchFn, CompareFn cmpFn, va_list args,
+                          GenericType *lo, GenericType *hi, string fnName) {
+   fetchFn(args, lo);
+   fetchFn(args, hi);
+   if (compareKeys(cmpFn, *lo, *hi) > 0) error("%s: lo > hi", fnName);
+}
+
+static IntervalNode *findNode(IntervalMap map, GenericType lo,
+                                               GenericType hi) {
+   IntervalNode *t;
+   int sign;
+
+   t = map->root;
+   while (t != NULL) {
+      sign = compareKeys(map->cmpFn, lo, t->lo);
+      if (sign == 0) sign = compareKeys(map->cmpFn, hi, t->hi);
+      if (sign == 0) return t;
+      t = (sign < 0) ? t->left : t->right;
+   }
+   return NULL;
+}
+
+static IntervalNode *insertNode(IntervalMap map, IntervalNode *t,
+                                GenericType lo, GenericType hi, void *value) {
+   int sign;
+
+   if (t == NULL) {
+      t = newBlock(IntervalNode *);
+      t->lo = lo;
+      t->hi = hi;
+      t->maxHi = hi;
+      t->value = value;
+      t->height = 1;
+      t->left = t->right = NULL;
+      map->count++;
+      return t;
+   }
+   sign = compareKeys(map->cmpFn, lo, t->lo);
+   if (sign == 0) sign = compareKeys(map->cmpFn, hi, t->hi);
+   if (sign == 0) {
+      t->value = value;
+      return t;
+   }
+   if (sign < 0) {
+      t->left = insertNode(map, t->left, lo, hi, value);
+   } else {
+      t->right = insertNode(map, t->right, lo, hi, value);
+   }
+   return rebalance(map, t);
+}
+
+/*
+ * Implementation notes: removeNode
+ * --------------------------------
+ * A node with two children is replaced by the smallest node in its right
+ * subtree, which is detached from that subtree first.
+ */
+
+static IntervalNode *removeNode(IntervalMap map, IntervalNode *t,
+                                GenericType lo, GenericType hi) {
+   IntervalNode *left, *right, *min;
+   int sign;
+
+   if (t == NULL) return NULL;
+   sign = compareKeys(map->cmpFn, lo, t->lo);
+   if (sign == 0) sign = compareKeys(map->cmpFn, hi, t->hi);
+   if (sign < 0) {
+      t->left = removeNode(map, t->left, lo, hi);
+   } else if (sign > 0) {
+      t->right = removeNode(map, t->right, lo, hi);
+   } else {
+      left = t->left;
+      right = t->right;
+      freeBlock(t);
+      map->count--;
+      if (right == NULL) return left;
+      right = detachMin(map, right, &min);
+      min->left = left;
+      min->right = right;
+      t = min;
+   }
+   return rebalance(map, t);
+}
+
+static IntervalNode *detachMin(IntervalMap map, IntervalNode *t,
+                                                IntervalNode **min) {
+   if (t->left == NULL) {
+      *min = t;
+      return t->right;
+   }
+   t->left = detachMin(map, t->left, min);
+   return rebalance(map, t);
+}
+
+static IntervalNode *rebalance(IntervalMap map, IntervalNode *t) {
+   int balance;
+
+   updateNode(map, t);
+   balance = heightOf(t->right) - heightOf(t->left);
+   if (balance > 1) {
+      if (heightOf(t->right->left) > heightOf(t->right->right)) {
+         t->right = rotateRight(map, t->right);
+      }
+      return rotateLeft(map, t);
+   }
+   if (balance < -1) {
+      if (heightOf(t->left->right) > heightOf(t->left->left)) {
+         t->left = rotateLeft(map, t->left);
+      }
+      return rotateRight(map, t);
+   }
+   return t;
+}
+
+static IntervalNode *rotateLeft(IntervalMap map, IntervalNode *t) {
+   IntervalNode *child;
+
+   child = t->right;
+   t->right = child->left;
+   child->left = t;
+   updateNode(map, t);
+   updateNode(map, child);
+   return child;
+}
+
+static IntervalNode *rotateRight(IntervalMap map, IntervalNode *t) {
+   IntervalNode *child;
+
+   child = t->left;
+   t->left = child->right;
+   child->right = t;
+   updateNode(map, t);
+   updateNode(map, child);
+   return child;
+}
+
+static void updateNode(IntervalMap map, IntervalNode *t) {
+   int hl, hr;
+
+   hl = heightOf(t->left);
+   hr = heightOf(t->right);
+   t->height = 1 + ((hl > hr) ? hl : hr);
+   t->maxHi = t->hi;
+   if (t->left != NULL
+         && compareKeys(map->cmpFn, t->left->maxHi, t->maxHi) > 0) {
+      t->maxHi = t->left->maxHi;
+   }
+   if (t->right != NULL
+         && compareKeys(map->cmpFn, t->right->maxHi, t->maxHi) > 0) {
+      t->maxHi = t->right->maxHi;
+   }
+}
+
+static int heightOf(IntervalNode *t) {
+   return (t == NULL) ? 0 : t->height;
+}
+
+static IntervalNode *copyTree(IntervalNode *t) {
+   IntervalNode *copy;
+
+   if (t == NULL) return NULL;
+   copy = newBlock(IntervalNode *);
+   *copy = *t;
+   copy->left = copyTree(t->left);
+   copy->right = copyTree(t->right);
+   return copy;
+}
+
+static void freeTree(IntervalNode *t) {
+   if (t == NULL) return;
+   freeTree(t->left);
+   freeTree(t->right);
+   freeBlock(t);
+}
+
+/*
+ * Implementation notes: searchTree
+ * --------------------------------
+ * The search skips a subtree if its largest upper endpoint is before the
+ * query, and it skips the node and its right subtree if the node starts
+ * after the query, because every interval in that subtree starts at
+ * least as late.
+ */
+
+static int searchTree(IntervalMap map, IntervalNode *t, IntervalQuery *q) {
+   int count;
+
+   if (t == NULL || compareKeys(map->cmpFn, t->maxHi, q->lo) < 0) return 0;
+   count = searchTree(map, t->left, q);
+   if (compareKeys(map->cmpFn, t->lo, q->hi) > 0) return count;
+   if (compareKeys(map->cmpFn, t->hi, q->lo) >= 0) {
+      if (q->fn != NULL) q->fn(t->lo, t->hi, t->value, q->data);
+      count++;
+   }
+   return count + searchTree(map, t->right, q);
+}
+
+static void walkTree(IntervalNode *t, IntervalFn fn, void *data) {
+   if (t == NULL) return;
+   walkTree(t->left, fn, data);
+   fn(t->lo, t->hi, t->value, data);
+   walkTree(t->right, fn, data);
+}
+
+/*
+ * Implementation notes: searchSegments
+ * ------------------------------------
+ * Only the first q->limit intervals start early enough to overlap the
+ * query.  Among those, the search descends into a subtree only if its
+ * largest upper endpoint reaches the start of the query, so every
+ * subtree it visits contains at least one interval that it reports.
+ */
+
+static int searchSegments(SegmentTree st, int k, int left, int right,
+                                          IntervalQuery *q) {
+   int index, mid;
+
+   index = st->maxIndex[k];
+   if (index < 0 || left >= q->limit) return 0;
+   if (compareKeys(st->cmpFn, st->his[index], q->lo) < 0) return 0;
+   if (right - left == 1) {
+      if (q->fn != NULL) {
+         q->fn(st->los[index], st->his[index], st->values[index], q->data);
+      }
+      return 1;
+   }
+   mid = (left + right) / 2;
+   return searchSegments(st, 2 * k, left, mid, q)
+        + searchSegments(st, 2 * k + 1, mid, right, q);
+}
+
+static int mapOverlapsFromArgs(IntervalMap map, IntervalFn fn, void *data,
+                               va_list args, bool stabbing) {
+   IntervalQuery q;
+
+   if (stabbing) {
+      map->fetchFn(args, &q.lo);
+      q.hi = q.lo;
+   } else {
+      fetchInterval(map->fetchFn, map->cmpFn, args, &q.lo, &q.hi,
+                    "mapOverlapsIntervalMap");
+   }
+   q.fn = fn;
+   q.data = data;
+   return searchTree(map, map->root, &q);
+}
+
+/*
+ * Implementation notes: mapSegmentsFromArgs
+ * -----------------------------------------
+ * The limit on the intervals that can overlap the query is found by a
+ * binary search for the first interval that starts after it.
+ */
+
+static int mapSegmentsFromArgs(SegmentTree st, IntervalFn fn, void *data,
+                               va_list args, bool stabbing) {
+   IntervalQuery q;
+   int lh, rh, mid;
+
+   if (stabbing) {
+      st->fetchFn(args, &q.lo);
+      q.hi = q.lo;
+   } else {
+      fetchInterval(st->fetchFn, st->cmpFn, args, &q.lo, &q.hi,
+                    "mapOverlapsSegmentTree");
+   }
+   q.fn = fn;
+   q.data = data;
+   lh = 0;
+   rh = st->count;
+   while (lh < rh) {
+      mid = (lh + rh) / 2;
+      if (compareKeys(st->cmpFn, st->los[mid], q.hi) <= 0) {
+         lh = mid + 1;
+      } else {
+         rh = mid;
+      }
+   }
+   q.limit = lh;
+   if (st->count == 0) return 0;
+   return searchSegments(st, 1, 0, st->leafBase, &q);
+}
+
+/**********************************************************************/
+/* Unit test for the intervalmap module                               */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+#include "random.h"
+#include "strlib.h"
+
+#define N_INTERVALS 300
+#define N_QUERIES 200
+
+/* Private function prototypes */
+
+static void testIntervalMap(void);
+static void testDoubleEndpoints(void);
+static void testSegmentTree(void);
+static void testAgainstLinearScan(void);
+static void appendValue(GenericType lo, GenericType hi, void *value,
+                        void *data);
+
+/* Unit test */
+
+void testIntervalMapModule(void) {
+   testIntervalMap();
+   testDoubleEndpoints();
+   testSegmentTree();
+   testAgainstLinearScan();
+}
+
+static void testIntervalMap(void) {
+   IntervalMap map, copy;
+   string str;
+
+   trace(map = newIntervalMap(int));
+   trace(putIntervalMap(map, 1, 5, "A"));
+   trace(putIntervalMap(map, 3, 8, "B"));
+   trace(putIntervalMap(map, 10, 12, "C"));
+   trace(putIntervalMap(map, 6, 6, "D"));
+   trace(put(map, 0, 2, "E"));
+   test(size(map), 5);
+   test(getIntervalMap(map, 3, 8), "B");
+   test(get(map, 3, 7), NULL);
+   trace(putIntervalMap(map, 3, 8, "b"));
+   test(size(map), 5);
+   test(overlapsIntervalMap(map, 9, 9), false);
+   test(overlapsIntervalMap(map, 8, 9), true);
+   trace(str = "");
+   test(mapOverlapsIntervalMap(map, appendValue, &str, 4, 6), 3);
+   test(str, "AbD");
+   trace(str = "");
+   test(mapStabbingIntervalMap(map, appendValue, &str, 2), 2);
+   test(str, "EA");
+   test(mapOverlapsIntervalMap(map, NULL, NULL, 12, 20), 1);
+   trace(copy = clone(map));
+   trace(remove(map, 1, 5));
+   trace(removeIntervalMap(map, 10, 12));
+   test(sizeIntervalMap(map), 3);
+   trace(str = "");
+   trace(mapIntervalMap(map, appendValue, &str));
+   test(str, "EbD");
+   test(sizeIntervalMap(copy), 5);
+   trace(clear(map));
+   test(isEmpty(map), true);
+   trace(freeIntervalMap(map));
+   trace(freeIntervalMap(copy));
+}
+
+static void testDoubleEndpoints(void) {
+   IntervalMap map;
+   string str;
+
+   trace(map = newIntervalMap(double));
+   trace(putIntervalMap(map, 0.5, 1.5, "A"));
+   trace(putIntervalMap(map, 1.25, 3.0, "B"));
+   trace(putIntervalMap(map, 2.75, 2.875, "C"));
+   trace(str = "");
+   test(mapStabbingIntervalMap(map, appendValue, &str, 1.375), 2);
+   test(str, "AB");
+   test(overlapsIntervalMap(map, 3.0625, 4.0), false);
+   trace(freeIntervalMap(map));
+}
+
+static void testSegmentTree(void) {
+   SegmentTree st;
+   int los[] = { 10, 1, 6, 3, 1 };
+   int his[] = { 12, 5, 6, 8, 5 };
+   string values[] = { "C", "A", "D", "B", "a" };
+   string str;
+
+   trace(st = newSegmentTree(int, los, his, (void **) values, 5));
+   test(sizeSegmentTree(st), 5);
+   trace(str = "");
+   test(mapOverlapsSegmentTree(st, appendValue, &str, 4, 6), 4);
+   test(stringEqual(str, "AaBD") || stringEqual(str, "aABD"), true);
+   test(mapStabbingSegmentTree(st, NULL, NULL, 9), 0);
+   test(mapStabbingSegmentTree(st, NULL, NULL, 12), 1);
+   trace(freeSegmentTree(st));
+}
+
+/*
+ * Implementation notes: testAgainstLinearScan
+ * -------------------------------------------
+ * Builds an interval map and a segment tree from the same random
+ * intervals, removes some of them from the map, and checks the number
+ * of overlaps that each reports against a linear scan.
+ */
+
+static void testAgainstLinearScan(void) {
+   IntervalMap map;
+   SegmentTree st;
+   int los[N_INTERVALS], his[N_INTERVALS];
+   void *values[N_INTERVALS];
+   bool removed[N_INTERVALS];
+   int i, j, lo, hi, nMap, nAll, errors;
+
+   map = newIntervalMap(int);
+   for (i = 0; i < N_INTERVALS; i++) {
+      los[i] = randomInteger(0, 999);
+      his[i] = los[i] + randomInteger(0, 50);
+      values[i] = NULL;
+      removed[i] = false;
+      for (j = 0; j < i; j++) {
+         if (los[j] == los[i] && his[j] == his[i]) removed[j] = true;
+      }
+      putIntervalMap(map, los[i], his[i], NULL);
+   }
+   st = newSegmentTree(int, los, his, values, N_INTERVALS);
+   for (i = 0; i < N_INTERVALS; i += 4) {
+      removeIntervalMap(map, los[i], his[i]);
+      for (j = 0; j < N_INTERVALS; j++) {
+         if (los[j] == los[i] && his[j] == his[i]) removed[j] = true;
+      }
+   }
+   errors = 0;
+   for (i = 0; i < N_QUERIES; i++) {
+      lo = randomInteger(-20, 1050);
+      hi = lo + randomInteger(0, 30);
+      nMap = nAll = 0;
+      for (j = 0; j < N_INTERVALS; j++) {
+         if (los[j] <= hi && lo <= his[j]) {
+            nAll++;
+            if (!removed[j]) nMap++;
+         }
+      }
+      if (mapOverlapsIntervalMap(map, NULL, NULL, lo, hi) != nMap) errors++;
+      if (overlapsIntervalMap(map, lo, hi) != (nMap > 0)) errors++;
+      if (mapOverlapsSegmentTree(st, NULL, NULL, lo, hi) != nAll) errors++;
+   }
+   test(errors, 0);
+   freeIntervalMap(map);
+   freeSegmentTree(st);
+}
+
+static void appendValue(GenericType lo, GenericType hi, void *value,
+                        void *data) {
+   *((string *) data) = concat(*((string *) data), (string) value);
+}
+
+#endif
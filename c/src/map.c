@@ -2,7 +2,8 @@
  * File: map.c
  * -----------
  * This file implements the map.h interface, which implements maps using
- * the balanced binary tree abstraction exported by the bst.h interface.
+ * the balanced binary tree abstraction exported by the bst.h interface
+ * or, if the client asks for it, the B-tree from the btree.h interface.
  */
 
 /*************************************************************************/
@@ -26,6 +27,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "bst.h"
+#include "btree.h"
 #include "cmpfn.h"
 #include "cslib.h"
 #include "exception.h"
@@ -45,40 +47,66 @@
 
 struct MapCDT {
    IteratorHeader header;              /* Header to enable iteration   */
+   StorageType storage;                /* Selects which tree is used   */
    BST bst;                            /* BST that does all the work   */
+   BTree btree;                        /* B-tree used instead, if any  */
 };
 
 /* Private function prototypes */
 
+static int collectEntries(Map map, GenericType keys[], void *values[]);
+static void buildMapFromSorted(Map map, GenericType keys[], void *values[],
+                               int n);
+static bool stepRangeIterator(Iterator iterator, void *dst);
 static Iterator newMapIterator(void *collection);
-static void addKeyToIterator(BSTNode node, void *data);
 
 /* Exported entries */
 
 Map newMap() {
+   return newMapWithStorage(AVL_TREE);
+}
+
+Map newMapWithStorage(StorageType storage) {
    Map map;
 
    map = newBlock(Map);
    enableIteration(map, newMapIterator);
-   map->bst = newBST(string);
+   map->storage = storage;
+   map->bst = NULL;
+   map->btree = NULL;
+   switch (storage) {
+     case AVL_TREE:
+     case PERSISTENT_TREE: map->bst = newBST(string); break;
+     case B_TREE: map->btree = newBTree(string); break;
+     default: error("newMap: Illegal storage type");
+   }
    return map;
 }
 
 void freeMap(Map map) {
-   freeBST(map->bst);
+   if (map->storage == B_TREE) {
+      freeBTree(map->btree);
+   } else {
+      freeBST(map->bst);
+   }
    freeBlock(map);
 }
 
 int sizeMap(Map map) {
+   if (map->storage == B_TREE) return sizeBTree(map->btree);
    return sizeBST(map->bst);
 }
 
 bool isEmptyMap(Map map) {
-   return isEmptyBST(map->bst);
+   return sizeMap(map) == 0;
 }
 
 void clearMap(Map map) {
-   clearBST(map->bst);
+   if (map->storage == B_TREE) {
+      clearBTree(map->btree);
+   } else {
+      clearBST(map->bst);
+   }
 }
 
 Map cloneMap(Map map) {
@@ -86,64 +114,294 @@ Map cloneMap(Map map) {
 
    newmap = newBlock(Map);
    enableIteration(newmap, newMapIterator);
-   newmap->bst = cloneBST(map->bst);
+   newmap->storage = map->storage;
+   if (map->storage == PERSISTENT_TREE) {
+      newmap->bst = shareBST(map->bst);
+   } else {
+      newmap->bst = (map->bst == NULL) ? NULL : cloneBST(map->bst);
+   }
+   newmap->btree = (map->btree == NULL) ? NULL : cloneBTree(map->btree);
    return newmap;
 }
 
 void putMap(Map map, string key, void *value) {
    BSTNode node;
 
-   node = insertBSTNode(map->bst, key);
-   setNodeValue(node, value);
+   if (map->storage == B_TREE) {
+      *insertBTreeEntry(map->btree, key) = value;
+   } else {
+      node = insertBSTNode(map->bst, key);
+      setNodeValue(node, value);
+   }
+}
+
+/*
+ * Implementation notes: putAllMap
+ * -------------------------------
+ * The new entries are sorted with a stable sort, so that removing the
+ * duplicates keeps the value supplied last.  If the map already has
+ * entries, the old and new entries are merged, with the new value
+ * taking precedence for a key in both.  The map is then rebuilt from
+ * the sorted entries in linear time.
+ */
+
+void putAllMap(Map map, string keys[], void *values[], int n) {
+   GenericType *newKeys, *oldKeys, *allKeys;
+   void **newValues, **oldValues, **allValues;
+   int i, j, nOld, nAll, sign;
+
+   newKeys = newArray(n, GenericType);
+   newValues = newArray(n, void *);
+   for (i = 0; i < n; i++) {
+      newKeys[i].pointerRep = keys[i];
+      newValues[i] = values[i];
+   }
+   sortGenericArray(newKeys, newValues, n, stringCmpFn);
+   n = uniqueGenericArray(newKeys, newValues, n, stringCmpFn);
+   nOld = sizeMap(map);
+   if (nOld == 0) {
+      buildMapFromSorted(map, newKeys, newValues, n);
+      freeBlock(newKeys);
+      freeBlock(newValues);
+      return;
+   }
+   oldKeys = newArray(nOld, GenericType);
+   oldValues = newArray(nOld, void *);
+   collectEntries(map, oldKeys, oldValues);
+   allKeys = newArray(nOld + n, GenericType);
+   allValues = newArray(nOld + n, void *);
+   nAll = i = j = 0;
+   while (i < nOld || j < n) {
+      if (j == n) {
+         sign = -1;
+      } else if (i == nOld) {
+         sign = +1;
+      } else {
+         sign = stringCmpFn(&oldKeys[i], &newKeys[j]);
+      }
+      if (sign < 0) {
+         allKeys[nAll] = oldKeys[i];
+         allValues[nAll++] = oldValues[i++];
+      } else {
+         allKeys[nAll] = newKeys[j];
+         allValues[nAll++] = newValues[j++];
+         if (sign == 0) i++;
+      }
+   }
+   buildMapFromSorted(map, allKeys, allValues, nAll);
+   freeBlock(newKeys);
+   freeBlock(newValues);
+   freeBlock(oldKeys);
+   freeBlock(oldValues);
+   freeBlock(allKeys);
+   freeBlock(allValues);
 }
 
 void *getMap(Map map, string key) {
    BSTNode node;
+   void **vp;
 
+   if (map->storage == B_TREE) {
+      vp = findBTreeEntry(map->btree, key);
+      return (vp == NULL) ? NULL : *vp;
+   }
    node = findBSTNode(map->bst, key);
    return (node == NULL) ? NULL : getNodeValue(node);
 }
 
 bool containsKeyMap(Map map, string key) {
+   if (map->storage == B_TREE) {
+      return findBTreeEntry(map->btree, key) != NULL;
+   }
    return findBSTNode(map->bst, key) != NULL;
 }
 
 void removeMap(Map map, string key) {
-   removeBSTNode(map->bst, key);
+   if (map->storage == B_TREE) {
+      removeBTreeEntry(map->btree, key);
+   } else {
+      removeBSTNode(map->bst, key);
+   }
+}
+
+int rankMap(Map map, string key) {
+   GenericType any;
+
+   any.pointerRep = key;
+   if (map->storage == B_TREE) return rankBTreeFromArg(map->btree, any);
+   return rankBSTFromArg(map->bst, any);
+}
+
+string selectMap(Map map, int k) {
+   BTreeEntry entry;
+
+   if (k < 0 || k >= sizeMap(map)) error("selectMap: Index out of range");
+   if (map->storage == B_TREE) {
+      selectBTreeEntry(map->btree, k, &entry);
+      return (string) entry.key.pointerRep;
+   }
+   return (string) getKey(selectBSTNode(map->bst, k)).pointerRep;
+}
+
+string floorKeyMap(Map map, string key) {
+   GenericType any;
+   BTreeEntry entry;
+   BSTNode node;
+
+   any.pointerRep = key;
+   if (map->storage == B_TREE) {
+      if (!floorBTreeEntryFromArg(map->btree, any, &entry)) return NULL;
+      return (string) entry.key.pointerRep;
+   }
+   node = floorBSTNodeFromArg(map->bst, any);
+   return (node == NULL) ? NULL : (string) getKey(node).pointerRep;
+}
+
+string ceilingKeyMap(Map map, string key) {
+   GenericType any;
+   BTreeEntry entry;
+   BSTNode node;
+
+   any.pointerRep = key;
+   if (map->storage == B_TREE) {
+      if (!ceilingBTreeEntryFromArg(map->btree, any, &entry)) return NULL;
+      return (string) entry.key.pointerRep;
+   }
+   node = ceilingBSTNodeFromArg(map->bst, any);
+   return (node == NULL) ? NULL : (string) getKey(node).pointerRep;
+}
+
+string firstKeyMap(Map map) {
+   return (isEmptyMap(map)) ? NULL : selectMap(map, 0);
+}
+
+string lastKeyMap(Map map) {
+   return (isEmptyMap(map)) ? NULL : selectMap(map, sizeMap(map) - 1);
+}
+
+/*
+ * Implementation notes: newRangeIterator
+ * --------------------------------------
+ * The range iterator wraps the corresponding iterator for the tree and
+ * keeps it in the data field.  Its step function converts the nodes or
+ * entries produced by that iterator into keys.
+ */
+
+Iterator newRangeIterator(Map map, string lo, string hi) {
+   Iterator iterator;
+   GenericType loKey, hiKey;
+   GenericType *lp, *hp;
+
+   loKey.pointerRep = lo;
+   hiKey.pointerRep = hi;
+   lp = (lo == NULL) ? NULL : &loKey;
+   hp = (hi == NULL) ? NULL : &hiKey;
+   iterator = newStepIterator(sizeof(string), stepRangeIterator);
+   setCollection(iterator, map);
+   if (map->storage == B_TREE) {
+      setIteratorData(iterator, newRangeEntryIterator(map->btree, lp, hp));
+   } else {
+      setIteratorData(iterator, newRangeNodeIterator(map->bst, lp, hp));
+   }
+   return iterator;
 }
 
 void mapMap(Map map, proc fn, void *data) {
    Iterator it;
    BSTNode node;
-
-   it = newNodeIterator(map->bst, INORDER);
-   while (stepIterator(it, &node)) {
-      fn(getKeyString(node), getNodeValue(node), data);
+   BTreeEntry entry;
+
+   if (map->storage == B_TREE) {
+      it = newEntryIterator(map->btree);
+      while (stepIterator(it, &entry)) {
+         fn((string) entry.key.pointerRep, entry.value, data);
+      }
+   } else {
+      it = newNodeIterator(map->bst, INORDER);
+      while (stepIterator(it, &node)) {
+         fn((string) getKey(node).pointerRep, getNodeValue(node), data);
+      }
    }
+   freeIterator(it);
 }
 
 /* Private functions */
 
-static Iterator newMapIterator(void *collection) {
-   Iterator iterator;
+/*
+ * Implementation notes: collectEntries
+ * ------------------------------------
+ * Copies the entries of the map in key order into the parallel arrays
+ * and returns the number of entries.
+ */
 
-   iterator = newListIterator(sizeof(string), NULL);
-   mapBST(((Map) collection)->bst, addKeyToIterator, INORDER, iterator);
-   return iterator;
+static int collectEntries(Map map, GenericType keys[], void *values[]) {
+   BTreeEntry entry;
+   BSTNode node;
+   int n;
+
+   n = 0;
+   if (map->storage == B_TREE) {
+      foreach (entry in newEntryIterator(map->btree)) {
+         keys[n] = entry.key;
+         values[n++] = entry.value;
+      }
+   } else {
+      foreach (node in newNodeIterator(map->bst, INORDER)) {
+         keys[n] = getKey(node);
+         values[n++] = getNodeValue(node);
+      }
+   }
+   return n;
+}
+
+static void buildMapFromSorted(Map map, GenericType keys[], void *values[],
+                               int n) {
+   if (map->storage == B_TREE) {
+      buildBTreeFromSorted(map->btree, keys, values, n);
+   } else {
+      buildBSTFromSorted(map->bst, keys, values, n);
+   }
+}
+
+static bool stepRangeIterator(Iterator iterator, void *dst) {
+   Map map;
+   Iterator treeIterator;
+   BTreeEntry entry;
+   BSTNode node;
+   bool result;
+
+   map = (Map) getCollection(iterator);
+   treeIterator = (Iterator) getIteratorData(iterator);
+   if (treeIterator == NULL) return false;
+   if (map->storage == B_TREE) {
+      result = stepIterator(treeIterator, &entry);
+      if (result) *((string *) dst) = (string) entry.key.pointerRep;
+   } else {
+      result = stepIterator(treeIterator, &node);
+      if (result) *((string *) dst) = (string) getKey(node).pointerRep;
+   }
+   if (!result) {
+      freeIterator(treeIterator);
+      setIteratorData(iterator, NULL);
+   }
+   return result;
 }
 
 /*
- * Implementation notes: addKeyToIterator
- * --------------------------------------
- * Adds the key from the specified node to the iterator, which is
- * passed as the <code>data</code> parameter.
+ * Implementation notes: newMapIterator
+ * ------------------------------------
+ * For the binary search trees, the iterator over the keys is the range
+ * iterator with both ends open, which walks the tree as the iteration
+ * proceeds instead of copying the keys into a list before the first one
+ * is returned.
  */
 
-static void addKeyToIterator(BSTNode node, void *data) {
-   string key;
+static Iterator newMapIterator(void *collection) {
+   Map map;
 
-   key = (string) getKey(node).pointerRep;
-   addToIteratorList((Iterator) data, &key);
+   map = (Map) collection;
+   if (map->storage == B_TREE) return newIterator(map->btree);
+   return newRangeIterator(map, NULL, NULL);
 }
 
 /**********************************************************************/
@@ -152,6 +410,15 @@ static void addKeyToIterator(BSTNode node, void *data) {
 
 #ifndef _NOTEST_
 
+/* Private function prototypes */
+
+static void testBTreeMap(void);
+static void testPutAllMap(StorageType storage);
+static void testOrderedMap(StorageType storage);
+static void testPersistentMap(void);
+
+/* Unit test */
+
 void testMapModule(void) {
    Map map, map2;
    string key;
@@ -190,6 +457,162 @@ void testMapModule(void) {
    trace(str = "");
    trace(foreach (key in map2) str = concat(str, get(map2, key)));
    test(str, "BerylliumHydrogenHeliumLithium");
+   testBTreeMap();
+   testPutAllMap(AVL_TREE);
+   testPutAllMap(B_TREE);
+   testOrderedMap(AVL_TREE);
+   testOrderedMap(B_TREE);
+   testPutAllMap(PERSISTENT_TREE);
+   testOrderedMap(PERSISTENT_TREE);
+   testPersistentMap();
+}
+
+static void testBTreeMap(void) {
+   Map map, map2;
+   string key, str;
+   int i;
+
+   trace(map = newMapWithStorage(B_TREE));
+   test(isEmpty(map), true);
+   trace(put(map, "H", "Hydrogen"));
+   trace(put(map, "He", "Helium"));
+   trace(put(map, "Al", "Aluminum"));
+   test(get(map, "He"), "Helium");
+   test(get(map, "Li"), NULL);
+   trace(put(map, "Al", "Aluminium"));
+   test(get(map, "Al"), "Aluminium");
+   trace(remove(map, "Al"));
+   test(containsKey(map, "Al"), false);
+   trace(put(map, "Li", "Lithium"));
+   trace(put(map, "Be", "Beryllium"));
+   test(size(map), 4);
+   trace(map2 = clone(map));
+   trace(str = "");
+   trace(foreach (key in map2) str = concat(str, get(map2, key)));
+   test(str, "BerylliumHydrogenHeliumLithium");
+   for (i = 0; i < 500; i++) {
+      key = integerToString(1000 + (i * 13) % 500);
+      put(map, key, key);
+   }
+   test(size(map), 504);
+   test(get(map, "1499"), "1499");
+   trace(str = "");
+   trace(foreach (key in map) if (!startsWith(key, "1")) str = concat(str, key));
+   test(str, "BeHHeLi");
+}
+
+static void testPutAllMap(StorageType storage) {
+   static string keys[] = { "Li", "H", "He", "Be", "H", "B" };
+   static string values[] = {
+      "Lithium", "Hydrogen", "Helium", "Beryllium", "hydrogen", "Boron"
+   };
+   static string moreKeys[] = { "C", "B", "N" };
+   static string moreValues[] = { "Carbon", "boron", "Nitrogen" };
+   Map map;
+   string key, str;
+
+   trace(map = newMapWithStorage(storage));
+   trace(putAllMap(map, keys, (void **) values, 6));
+   test(size(map), 5);
+   test(get(map, "H"), "hydrogen");
+   test(get(map, "Li"), "Lithium");
+   trace(putAllMap(map, moreKeys, (void **) moreValues, 3));
+   test(size(map), 7);
+   test(get(map, "B"), "boron");
+   test(get(map, "He"), "Helium");
+   trace(str = "");
+   trace(foreach (key in map) str = concat(str, key));
+   test(str, "BBeCHHeLiN");
+   trace(remove(map, "C"));
+   trace(put(map, "O", "Oxygen"));
+   test(size(map), 7);
+   test(get(map, "O"), "Oxygen");
+}
+
+static void testOrderedMap(StorageType storage) {
+   Map map;
+   string key, str;
+   int i, errors;
+
+   trace(map = newMapWithStorage(storage));
+   test(firstKeyMap(map), NULL);
+   test(floorKeyMap(map, "5"), NULL);
+   for (i = 0; i < 2000; i++) {
+      key = integerToString(10000 + 2 * ((i * 7) % 2000));
+      put(map, key, key);
+   }
+   test(rankMap(map, "10000"), 0);
+   test(rankMap(map, "10001"), 1);
+   test(rankMap(map, "13000"), 1500);
+   test(rankMap(map, "2"), 2000);
+   test(selectMap(map, 0), "10000");
+   test(selectMap(map, 1234), "12468");
+   test(firstKeyMap(map), "10000");
+   test(lastKeyMap(map), "13998");
+   test(floorKeyMap(map, "12469"), "12468");
+   test(floorKeyMap(map, "12468"), "12468");
+   test(floorKeyMap(map, "1"), NULL);
+   test(ceilingKeyMap(map, "12467"), "12468");
+   test(ceilingKeyMap(map, "13999"), NULL);
+   trace(str = "");
+   trace(foreach (key in newRangeIterator(map, "11001", "11010")) {
+      str = concat(str, substring(key, 3, 4));
+   });
+   test(str, "0204060810");
+   trace(str = "");
+   trace(foreach (key in newRangeIterator(map, "13993", NULL)) {
+      str = concat(str, substring(key, 3, 4));
+   });
+   test(str, "949698");
+   for (i = 0; i < 2000; i += 2) {
+      remove(map, integerToString(10000 + 2 * i));
+   }
+   test(size(map), 1000);
+   errors = 0;
+   for (i = 0; i < 1000; i++) {
+      key = selectMap(map, i);
+      if (!stringEqual(key, integerToString(10002 + 4 * i))) errors++;
+      if (rankMap(map, key) != i) errors++;
+   }
+   test(errors, 0);
+}
+
+static void testPersistentMap(void) {
+   Map versions[10];
+   string key;
+   int i, j, n;
+
+   trace(versions[0] = newMapWithStorage(PERSISTENT_TREE));
+   for (i = 0; i < 500; i++) {
+      key = integerToString(1000 + i);
+      putMap(versions[0], key, key);
+   }
+   for (i = 1; i < 10; i++) {
+      versions[i] = cloneMap(versions[i - 1]);
+      for (j = 0; j < 500; j += 10) {
+         removeMap(versions[i], integerToString(1000 + j + i));
+      }
+      putMap(versions[i], "1000", integerToString(i));
+   }
+   test(size(versions[0]), 500);
+   test(size(versions[9]), 50);
+   test(get(versions[0], "1000"), "1000");
+   test(get(versions[4], "1000"), "4");
+   test(containsKey(versions[3], "1013"), false);
+   test(containsKey(versions[2], "1013"), true);
+   test(selectMap(versions[9], 1), "1010");
+   trace(freeMap(versions[0]));
+   trace(freeMap(versions[5]));
+   test(size(versions[6]), 200);
+   test(get(versions[6], "1000"), "6");
+   n = 0;
+   foreach (key in versions[9]) {
+      if (!endsWith(key, "0")) n++;
+   }
+   test(n, 0);
+   for (i = 1; i < 10; i++) {
+      if (i != 5) freeMap(versions[i]);
+   }
 }
 
 #endif
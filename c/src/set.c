@@ -22,10 +22,13 @@
 /* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
 /*************************************************************************/
 
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include "bitmap.h"
 #include "bst.h"
+#include "btree.h"
 #include "cmpfn.h"
 #include "cslib.h"
 #include "exception.h"
@@ -46,7 +49,10 @@
 
 struct SetCDT {
    IteratorHeader header;      /* Header to enable iteration            */
-   BST bst;                    /* The underlying binary search tree     */
+   StorageType storage;        /* Selects which tree holds the elements */
+   BST bst;                    /* The binary search tree, if selected   */
+   BTree btree;                /* The B-tree, if selected               */
+   Bitmap bitmap;              /* The compressed bitmap, if selected    */
    string baseType;            /* The name of the base type             */
    int baseTypeSize;           /* Size of the base type in bytes        */
    CompareFn cmpFn;            /* Function to compare two keys          */
@@ -55,44 +61,108 @@ struct SetCDT {
    ToStringFn toStringFn;      /* Function to convert key to a string   */
 };
 
+/*
+ * Type: SetOperation
+ * ------------------
+ * This type identifies the set operations implemented by merging.
+ */
+
+typedef enum { UNION_OP, INTERSECTION_OP, DIFFERENCE_OP } SetOperation;
+
 /* Private function prototypes */
 
 static string checkBaseTypes(Set s1, Set s2);
+static Set newEmptySetLike(Set set);
+static Set newSetFromBitmap(Set model, Bitmap bitmap);
+static unsigned encodeKey(Set set, GenericType any);
+static GenericType decodeKey(Set set, unsigned value);
+static bool findKey(Set set, GenericType any);
+static void insertKey(Set set, GenericType any);
+static bool preferLookups(Set s1, Set s2);
+static Set mergeSets(Set s1, Set s2, SetOperation op);
+static Set filterSet(Set s1, Set s2, bool keep, Set model);
+static Set newSetFromSortedKeys(Set model, GenericType keys[], int n);
+static void buildSetFromSorted(Set set, GenericType keys[], int n);
+static Iterator newKeyIterator(Set set);
+static Iterator newRangeKeyIterator(Set set, GenericType *lo, GenericType *hi);
+static bool stepKeyIterator(Iterator iterator, void *dst);
+static void freeKeyIterator(Iterator iterator);
 static Iterator newSetIterator(void *collection);
 static bool stepSetIterator(Iterator iterator, void *dst);
 
 /* Exported entries */
 
 Set newSetFromType(string baseType) {
+   return newSetFromTypeWithStorage(baseType, AVL_TREE);
+}
+
+Set newSetFromTypeWithStorage(string baseType, StorageType storage) {
    Set set;
 
    set = newBlock(Set);
    enableIteration(set, newSetIterator);
+   set->storage = storage;
    set->baseType = baseType;
    set->fetchFn = getFetchFnForType(baseType);
    set->storeFn = getStoreFnForType(baseType);
    set->cmpFn = getCompareFnForType(baseType);
    set->toStringFn = getToStringFn(baseType);
    set->baseTypeSize = getTypeSizeForType(baseType);
-   set->bst = newBSTFromType(baseType);
+   set->bst = NULL;
+   set->btree = NULL;
+   set->bitmap = NULL;
+   switch (storage) {
+     case AVL_TREE:
+     case PERSISTENT_TREE: set->bst = newBSTFromType(baseType); break;
+     case B_TREE: set->btree = newBTreeFromType(baseType); break;
+     case COMPRESSED_BITMAP:
+      if (!stringEqual(baseType, "int") && !stringEqual(baseType, "unsigned")) {
+         error("newSet: Bitmap sets require int or unsigned elements");
+      }
+      set->bitmap = newBitmap();
+      break;
+     default: error("newSet: Illegal storage type");
+   }
+   return set;
+}
+
+Set newSetFromArray(string baseType, void *array, int n) {
+   Set set;
+
+   set = newSetFromType(baseType);
+   addAllSet(set, array, n);
    return set;
 }
 
 void freeSet(Set set) {
-   freeBST(set->bst);
+   if (set->storage == COMPRESSED_BITMAP) {
+      freeBitmap(set->bitmap);
+   } else if (set->storage == B_TREE) {
+      freeBTree(set->btree);
+   } else {
+      freeBST(set->bst);
+   }
    freeBlock(set);
 }
 
 int sizeSet(Set set) {
+   if (set->storage == COMPRESSED_BITMAP) return sizeBitmap(set->bitmap);
+   if (set->storage == B_TREE) return sizeBTree(set->btree);
    return sizeBST(set->bst);
 }
 
 bool isEmptySet(Set set) {
-   return isEmptyBST(set->bst);
+   return sizeSet(set) == 0;
 }
 
 void clearSet(Set set) {
-   clearBST(set->bst);
+   if (set->storage == COMPRESSED_BITMAP) {
+      clearBitmap(set->bitmap);
+   } else if (set->storage == B_TREE) {
+      clearBTree(set->btree);
+   } else {
+      clearBST(set->bst);
+   }
 }
 
 Set cloneSet(Set set) {
@@ -100,12 +170,20 @@ Set cloneSet(Set set) {
 
    newset = newBlock(Set);
    enableIteration(newset, newSetIterator);
+   newset->storage = set->storage;
    newset->baseType = set->baseType;
    newset->baseTypeSize = set->baseTypeSize;
    newset->fetchFn = set->fetchFn;
    newset->storeFn = set->storeFn;
    newset->cmpFn = set->cmpFn;
-   newset->bst = cloneBST(set->bst);
+   newset->toStringFn = set->toStringFn;
+   if (set->storage == PERSISTENT_TREE) {
+      newset->bst = shareBST(set->bst);
+   } else {
+      newset->bst = (set->bst == NULL) ? NULL : cloneBST(set->bst);
+   }
+   newset->btree = (set->btree == NULL) ? NULL : cloneBTree(set->btree);
+   newset->bitmap = (set->bitmap == NULL) ? NULL : cloneBitmap(set->bitmap);
    return newset;
 }
 
@@ -123,7 +201,7 @@ bool containsSetFromArgs(Set set, va_list args) {
    GenericType any;
 
    set->fetchFn(args, &any);
-   return findBSTNodeFromArg(set->bst, any) != NULL;
+   return findKey(set, any);
 }
 
 void addSet(Set set, ...) {
@@ -138,7 +216,64 @@ void addSetFromArgs(Set set, va_list args) {
    GenericType any;
 
    set->fetchFn(args, &any);
-   insertBSTNodeFromArg(set->bst, any);
+   insertKey(set, any);
+}
+
+/*
+ * Implementation notes: addAllSet
+ * -------------------------------
+ * The array elements are copied into a GenericType array, sorted, and
+ * stripped of duplicates.  If the set already has elements, the two
+ * sorted sequences are merged into a single array.  In either case, the
+ * set is then rebuilt from the sorted keys in linear time.
+ */
+
+void addAllSet(Set set, void *array, int n) {
+   Iterator it;
+   GenericType *keys, *merged, old;
+   char *cp;
+   int i, nMerged, sign;
+   bool more;
+
+   keys = newArray(n, GenericType);
+   memset(keys, 0, n * sizeof(GenericType));
+   cp = (char *) array;
+   for (i = 0; i < n; i++) {
+      memcpy(&keys[i], cp, set->baseTypeSize);
+      cp += set->baseTypeSize;
+   }
+   sortGenericArray(keys, NULL, n, set->cmpFn);
+   n = uniqueGenericArray(keys, NULL, n, set->cmpFn);
+   if (isEmptySet(set)) {
+      buildSetFromSorted(set, keys, n);
+      freeBlock(keys);
+      return;
+   }
+   merged = newArray(n + sizeSet(set), GenericType);
+   nMerged = 0;
+   i = 0;
+   it = newKeyIterator(set);
+   more = stepIterator(it, &old);
+   while (more || i < n) {
+      if (!more) {
+         sign = +1;
+      } else if (i == n) {
+         sign = -1;
+      } else {
+         sign = set->cmpFn(&old, &keys[i]);
+      }
+      if (sign <= 0) {
+         merged[nMerged++] = old;
+         more = stepIterator(it, &old);
+         if (sign == 0) i++;
+      } else {
+         merged[nMerged++] = keys[i++];
+      }
+   }
+   freeKeyIterator(it);
+   buildSetFromSorted(set, merged, nMerged);
+   freeBlock(keys);
+   freeBlock(merged);
 }
 
 void removeSet(Set set, ...) {
@@ -153,94 +288,163 @@ void removeSetFromArgs(Set set, va_list args) {
    GenericType any;
 
    set->fetchFn(args, &any);
-   removeBSTNodeFromArg(set->bst, any);
+   if (set->storage == COMPRESSED_BITMAP) {
+      removeBitmap(set->bitmap, encodeKey(set, any));
+   } else if (set->storage == B_TREE) {
+      removeBTreeEntryFromArg(set->btree, any);
+   } else {
+      removeBSTNodeFromArg(set->bst, any);
+   }
 }
 
-bool equalsSet(Set s1, Set s2) {
-   checkBaseTypes(s1, s2);
-   return isSubset(s1, s2) && isSubset(s2, s1);
+int rankSet(Set set, ...) {
+   va_list args;
+   GenericType any;
+
+   va_start(args, set);
+   set->fetchFn(args, &any);
+   va_end(args);
+   if (set->storage == COMPRESSED_BITMAP) {
+      return rankBitmap(set->bitmap, encodeKey(set, any));
+   }
+   if (set->storage == B_TREE) return rankBTreeFromArg(set->btree, any);
+   return rankBSTFromArg(set->bst, any);
 }
 
-bool isSubsetSet(Set s1, Set s2) {
+Iterator newSetRangeIterator(Set set, ...) {
+   va_list args;
+   GenericType lo, hi;
+   Iterator iterator;
+
+   va_start(args, set);
+   set->fetchFn(args, &lo);
+   set->fetchFn(args, &hi);
+   va_end(args);
+   iterator = newStepIterator(set->baseTypeSize, stepSetIterator);
+   setCollection(iterator, set);
+   setIteratorData(iterator, newRangeKeyIterator(set, &lo, &hi));
+   return iterator;
+}
+
+void mapSet(Set set, proc fn, void *data) {
    Iterator it;
-   BSTNode node;
+   GenericType any, value;
+
+   it = newKeyIterator(set);
+   while (stepIterator(it, &any)) {
+      set->storeFn(any, &value);
+      fn(&value, data);
+   }
+   freeKeyIterator(it);
+}
+
+/*
+ * Implementation notes: equalsSet, isSubsetSet
+ * --------------------------------------------
+ * These functions step through the elements of both sets in parallel,
+ * which takes linear time.  For isSubsetSet, a small s1 is instead
+ * checked by looking up each of its elements in s2.
+ */
+
+bool equalsSet(Set s1, Set s2) {
+   Iterator it1, it2;
+   GenericType k1, k2;
    bool result;
 
    checkBaseTypes(s1, s2);
+   if (sizeSet(s1) != sizeSet(s2)) return false;
+   if (s1->storage == COMPRESSED_BITMAP && s2->storage == COMPRESSED_BITMAP) {
+      return equalsBitmap(s1->bitmap, s2->bitmap);
+   }
    result = true;
-   it = newNodeIterator(s1->bst, INORDER);
-   while (result && stepIterator(it, &node)) {
-      if (!findBSTNodeFromArg(s2->bst, getKey(node))) result = false;
+   it1 = newKeyIterator(s1);
+   it2 = newKeyIterator(s2);
+   while (result && stepIterator(it1, &k1) && stepIterator(it2, &k2)) {
+      if (s1->cmpFn(&k1, &k2) != 0) result = false;
    }
-   freeIterator(it);
+   freeKeyIterator(it1);
+   freeKeyIterator(it2);
    return result;
 }
 
-Set unionSet(Set s1, Set s2) {
-   Iterator it;
-   BSTNode node;
-   Set set;
+bool isSubsetSet(Set s1, Set s2) {
+   Iterator it1, it2;
+   GenericType k1, k2;
+   bool result, more2;
+   int sign;
 
-   set = newSetFromType(checkBaseTypes(s1, s2));
-   setCompareFn(set, getCompareFn(s1));
-   it = newNodeIterator(s1->bst, INORDER);
-   while (stepIterator(it, &node)) {
-      insertBSTNodeFromArg(set->bst, getKey(node));
+   checkBaseTypes(s1, s2);
+   if (sizeSet(s1) > sizeSet(s2)) return false;
+   if (s1->storage == COMPRESSED_BITMAP && s2->storage == COMPRESSED_BITMAP) {
+      return isSubsetBitmap(s1->bitmap, s2->bitmap);
    }
-   freeIterator(it);
-   it = newNodeIterator(s2->bst, INORDER);
-   while (stepIterator(it, &node)) {
-      insertBSTNodeFromArg(set->bst, getKey(node));
+   result = true;
+   it1 = newKeyIterator(s1);
+   if (preferLookups(s1, s2)) {
+      while (result && stepIterator(it1, &k1)) {
+         if (!findKey(s2, k1)) result = false;
+      }
+      freeKeyIterator(it1);
+      return result;
    }
-   freeIterator(it);
-   return set;
+   it2 = newKeyIterator(s2);
+   more2 = stepIterator(it2, &k2);
+   while (result && stepIterator(it1, &k1)) {
+      sign = 1;
+      while (more2 && (sign = s1->cmpFn(&k1, &k2)) > 0) {
+         more2 = stepIterator(it2, &k2);
+      }
+      if (sign != 0) result = false;
+   }
+   freeKeyIterator(it1);
+   freeKeyIterator(it2);
+   return result;
 }
 
-Set intersectionSet(Set s1, Set s2) {
-   Iterator it;
-   GenericType any;
-   BSTNode node;
-   Set set;
+Set unionSet(Set s1, Set s2) {
+   checkBaseTypes(s1, s2);
+   if (s1->storage == COMPRESSED_BITMAP && s2->storage == COMPRESSED_BITMAP) {
+      return newSetFromBitmap(s1, unionBitmap(s1->bitmap, s2->bitmap));
+   }
+   return mergeSets(s1, s2, UNION_OP);
+}
 
-   set = newSetFromType(checkBaseTypes(s1, s2));
-   setCompareFn(set, getCompareFn(s1));
-   it = newNodeIterator(s1->bst, INORDER);
-   while (stepIterator(it, &node)) {
-      any = getKey(node);
-      if (findBSTNodeFromArg(s2->bst, any) != NULL) {
-         insertBSTNodeFromArg(set->bst, any);
-      }
+Set intersectionSet(Set s1, Set s2) {
+   checkBaseTypes(s1, s2);
+   if (s1->storage == COMPRESSED_BITMAP && s2->storage == COMPRESSED_BITMAP) {
+      return newSetFromBitmap(s1, intersectionBitmap(s1->bitmap, s2->bitmap));
    }
-   freeIterator(it);
-   return set;
+   if (preferLookups(s1, s2)) return filterSet(s1, s2, true, s1);
+   if (preferLookups(s2, s1)) return filterSet(s2, s1, true, s1);
+   return mergeSets(s1, s2, INTERSECTION_OP);
 }
 
 Set setDifferenceSet(Set s1, Set s2) {
-   Iterator it;
-   BSTNode node;
-   GenericType any;
-   Set set;
-
-   set = newSetFromType(checkBaseTypes(s1, s2));
-   setCompareFn(set, getCompareFn(s1));
-   it = newNodeIterator(s1->bst, INORDER);
-   while (stepIterator(it, &node)) {
-      any = getKey(node);
-      if (findBSTNodeFromArg(s2->bst, any) == NULL) {
-         insertBSTNodeFromArg(set->bst, any);
-      }
+   checkBaseTypes(s1, s2);
+   if (s1->storage == COMPRESSED_BITMAP && s2->storage == COMPRESSED_BITMAP) {
+      return newSetFromBitmap(s1, differenceBitmap(s1->bitmap, s2->bitmap));
    }
-   freeIterator(it);
-   return set;
+   if (preferLookups(s1, s2)) return filterSet(s1, s2, false, s1);
+   return mergeSets(s1, s2, DIFFERENCE_OP);
 }
 
 void setCompareFn(Set set, CompareFn cmpFn) {
+   if (set->storage == COMPRESSED_BITMAP) {
+      if (cmpFn != set->cmpFn) {
+         error("setCompareFn: Bitmap sets must use the standard order");
+      }
+      return;
+   }
    set->cmpFn = cmpFn;
-   setCompareFnBST(set->bst, cmpFn);
+   if (set->storage == B_TREE) {
+      setCompareFnBTree(set->btree, cmpFn);
+   } else {
+      setCompareFnBST(set->bst, cmpFn);
+   }
 }
 
 CompareFn getCompareFn(Set set) {
-   return getCompareFnBST(set->bst);
+   return set->cmpFn;
 }
 
 /* Private functions */
@@ -248,16 +452,290 @@ CompareFn getCompareFn(Set set) {
 static string checkBaseTypes(Set s1, Set s2) {
    string type;
 
-   type = getBaseTypeBST(s1->bst);
-   if (!stringEqual(type, getBaseTypeBST(s2->bst))) {
+   type = s1->baseType;
+   if (!stringEqual(type, s2->baseType)) {
       error("Sets have different base types");
    }
-   if (getCompareFnBST(s1->bst) != getCompareFnBST(s2->bst)) {
+   if (s1->cmpFn != s2->cmpFn) {
       error("Sets have different comparison functions");
    }
    return type;
 }
 
+/*
+ * Implementation notes: newEmptySetLike
+ * -------------------------------------
+ * Creates an empty set with the same base type, storage type, and
+ * comparison function as the argument.  The results of the set
+ * operations are created using this function.
+ */
+
+static Set newEmptySetLike(Set set) {
+   Set result;
+
+   result = newSetFromTypeWithStorage(set->baseType, set->storage);
+   setCompareFn(result, set->cmpFn);
+   return result;
+}
+
+/*
+ * Implementation notes: newSetFromBitmap
+ * --------------------------------------
+ * Creates a set like model that takes ownership of the bitmap.
+ */
+
+static Set newSetFromBitmap(Set model, Bitmap bitmap) {
+   Set result;
+
+   result = newEmptySetLike(model);
+   freeBitmap(result->bitmap);
+   result->bitmap = bitmap;
+   return result;
+}
+
+/*
+ * Implementation notes: encodeKey, decodeKey
+ * ------------------------------------------
+ * A bitmap stores unsigned values.  Flipping the sign bit of an int maps
+ * the negative values below the nonnegative ones, so that the bitmap
+ * keeps the elements in the same order as the comparison function.
+ */
+
+static unsigned encodeKey(Set set, GenericType any) {
+   if (stringEqual(set->baseType, "int")) {
+      return (unsigned) any.intRep ^ 0x80000000U;
+   }
+   return any.unsignedRep;
+}
+
+static GenericType decodeKey(Set set, unsigned value) {
+   GenericType any;
+
+   memset(&any, 0, sizeof any);
+   if (stringEqual(set->baseType, "int")) {
+      any.intRep = (int) (value ^ 0x80000000U);
+   } else {
+      any.unsignedRep = value;
+   }
+   return any;
+}
+
+static bool findKey(Set set, GenericType any) {
+   if (set->storage == COMPRESSED_BITMAP) {
+      return containsBitmap(set->bitmap, encodeKey(set, any));
+   }
+   if (set->storage == B_TREE) {
+      return findBTreeEntryFromArg(set->btree, any) != NULL;
+   }
+   return findBSTNodeFromArg(set->bst, any) != NULL;
+}
+
+static void insertKey(Set set, GenericType any) {
+   if (set->storage == COMPRESSED_BITMAP) {
+      addBitmap(set->bitmap, encodeKey(set, any));
+   } else if (set->storage == B_TREE) {
+      insertBTreeEntryFromArg(set->btree, any);
+   } else {
+      insertBSTNodeFromArg(set->bst, any);
+   }
+}
+
+/*
+ * Implementation notes: preferLookups
+ * -----------------------------------
+ * Returns true if it is faster to look up each element of s1 in s2 than
+ * to step through both sets, which is the case when n1 log n2 is less
+ * than n1 + n2.
+ */
+
+static bool preferLookups(Set s1, Set s2) {
+   int n1, n2, log2;
+
+   n1 = sizeSet(s1);
+   n2 = sizeSet(s2);
+   log2 = 0;
+   while ((n2 >> log2) > 1) {
+      log2++;
+   }
+   return (double) n1 * log2 < (double) n1 + n2;
+}
+
+/*
+ * Implementation notes: mergeSets
+ * -------------------------------
+ * Steps through the two sets in parallel, in the manner of the merge
+ * phase of merge sort, and collects the elements selected by the
+ * operation in an array.  Because that array is sorted, the result
+ * can then be built in linear time.
+ */
+
+static Set mergeSets(Set s1, Set s2, SetOperation op) {
+   Iterator it1, it2;
+   GenericType k1, k2, *keys;
+   bool more1, more2;
+   int n, sign;
+   Set result;
+
+   keys = newArray(sizeSet(s1) + sizeSet(s2), GenericType);
+   n = 0;
+   it1 = newKeyIterator(s1);
+   it2 = newKeyIterator(s2);
+   more1 = stepIterator(it1, &k1);
+   more2 = stepIterator(it2, &k2);
+   while (more1 || more2) {
+      if (!more2) {
+         if (op == INTERSECTION_OP) break;
+         sign = -1;
+      } else if (!more1) {
+         if (op != UNION_OP) break;
+         sign = +1;
+      } else {
+         sign = s1->cmpFn(&k1, &k2);
+      }
+      if (sign < 0) {
+         if (op != INTERSECTION_OP) keys[n++] = k1;
+         more1 = stepIterator(it1, &k1);
+      } else if (sign > 0) {
+         if (op == UNION_OP) keys[n++] = k2;
+         more2 = stepIterator(it2, &k2);
+      } else {
+         if (op != DIFFERENCE_OP) keys[n++] = k1;
+         more1 = stepIterator(it1, &k1);
+         more2 = stepIterator(it2, &k2);
+      }
+   }
+   freeKeyIterator(it1);
+   freeKeyIterator(it2);
+   result = newSetFromSortedKeys(s1, keys, n);
+   freeBlock(keys);
+   return result;
+}
+
+/*
+ * Implementation notes: filterSet
+ * -------------------------------
+ * Creates a set like <code>model</code> that contains the elements of
+ * s1 that are (if <code>keep</code> is true) or are not (if it is false)
+ * elements of s2.  The elements of s1 are produced in order, so the
+ * result can again be built in linear time.
+ */
+
+static Set filterSet(Set s1, Set s2, bool keep, Set model) {
+   Iterator it;
+   GenericType any, *keys;
+   int n;
+   Set result;
+
+   keys = newArray(sizeSet(s1), GenericType);
+   n = 0;
+   it = newKeyIterator(s1);
+   while (stepIterator(it, &any)) {
+      if (findKey(s2, any) == keep) keys[n++] = any;
+   }
+   freeKeyIterator(it);
+   result = newSetFromSortedKeys(model, keys, n);
+   freeBlock(keys);
+   return result;
+}
+
+static Set newSetFromSortedKeys(Set model, GenericType keys[], int n) {
+   Set result;
+
+   result = newEmptySetLike(model);
+   buildSetFromSorted(result, keys, n);
+   return result;
+}
+
+static void buildSetFromSorted(Set set, GenericType keys[], int n) {
+   int i;
+
+   if (set->storage == COMPRESSED_BITMAP) {
+      clearBitmap(set->bitmap);
+      for (i = 0; i < n; i++) {
+         addBitmap(set->bitmap, encodeKey(set, keys[i]));
+      }
+      optimizeBitmap(set->bitmap);
+   } else if (set->storage == B_TREE) {
+      buildBTreeFromSorted(set->btree, keys, NULL, n);
+   } else {
+      buildBSTFromSorted(set->bst, keys, NULL, n);
+   }
+}
+
+/*
+ * Implementation notes: newKeyIterator, stepKeyIterator
+ * -----------------------------------------------------
+ * These functions create an iterator that produces the elements of the
+ * set (or those in a range) in ascending order as GenericType values,
+ * hiding the differences between the storage types.  The iterator over the
+ * underlying tree or bitmap is kept in the data field and freed at the
+ * end or by freeKeyIterator.
+ */
+
+static Iterator newKeyIterator(Set set) {
+   return newRangeKeyIterator(set, NULL, NULL);
+}
+
+static Iterator newRangeKeyIterator(Set set, GenericType *lo, GenericType *hi) {
+   Iterator iterator;
+
+   iterator = newStepIterator(sizeof(GenericType), stepKeyIterator);
+   setCollection(iterator, set);
+   if (set->storage == COMPRESSED_BITMAP) {
+      setIteratorData(iterator, newBitmapRangeIterator(set->bitmap,
+                      (lo == NULL) ? 0 : encodeKey(set, *lo),
+                      (hi == NULL) ? UINT_MAX : encodeKey(set, *hi)));
+   } else if (set->storage == B_TREE) {
+      setIteratorData(iterator, newRangeEntryIterator(set->btree, lo, hi));
+   } else {
+      setIteratorData(iterator, newRangeNodeIterator(set->bst, lo, hi));
+   }
+   return iterator;
+}
+
+static bool stepKeyIterator(Iterator iterator, void *dst) {
+   Set set;
+   BSTNode node;
+   BTreeEntry entry;
+   Iterator treeIterator;
+   unsigned value;
+   bool result;
+
+   set = (Set) getCollection(iterator);
+   treeIterator = (Iterator) getIteratorData(iterator);
+   if (treeIterator == NULL) return false;
+   if (set->storage == COMPRESSED_BITMAP) {
+      result = stepIterator(treeIterator, &value);
+      if (result) *((GenericType *) dst) = decodeKey(set, value);
+   } else if (set->storage == B_TREE) {
+      result = stepIterator(treeIterator, &entry);
+      if (result) *((GenericType *) dst) = entry.key;
+   } else {
+      result = stepIterator(treeIterator, &node);
+      if (result) *((GenericType *) dst) = getKey(node);
+   }
+   if (!result) {
+      freeIterator(treeIterator);
+      setIteratorData(iterator, NULL);
+   }
+   return result;
+}
+
+/*
+ * Implementation notes: freeKeyIterator
+ * -------------------------------------
+ * Frees a key iterator together with the iterator over the underlying
+ * tree, which is still allocated if the iteration stopped early.
+ */
+
+static void freeKeyIterator(Iterator iterator) {
+   Iterator treeIterator;
+
+   treeIterator = (Iterator) getIteratorData(iterator);
+   if (treeIterator != NULL) freeIterator(treeIterator);
+   freeIterator(iterator);
+}
+
 static Iterator newSetIterator(void *collection) {
    Iterator iterator;
    Set set;
@@ -265,23 +743,25 @@ static Iterator newSetIterator(void *collection) {
    set = (Set) collection;
    iterator = newStepIterator(set->baseTypeSize, stepSetIterator);
    setCollection(iterator, collection);
-   setIteratorData(iterator, newNodeIterator(set->bst, INORDER));
+   setIteratorData(iterator, newKeyIterator(set));
    return iterator;
 }
 
 static bool stepSetIterator(Iterator iterator, void *dst) {
    Set set;
-   BSTNode node;
-   Iterator nodeIterator;
+   GenericType any;
+   Iterator keyIterator;
    bool result;
 
    set = (Set) getCollection(iterator);
-   nodeIterator = (Iterator) getIteratorData(iterator);
-   result = stepIterator(nodeIterator, &node);
+   keyIterator = (Iterator) getIteratorData(iterator);
+   if (keyIterator == NULL) return false;
+   result = stepIterator(keyIterator, &any);
    if (result) {
-      set->storeFn(getKey(node), dst);
+      set->storeFn(any, dst);
    } else {
-      freeIterator(nodeIterator);
+      freeIterator(keyIterator);
+      setIteratorData(iterator, NULL);
    }
    return result;
 }
@@ -335,6 +815,13 @@ static void checkStringSet(Set set, string array[]);
 static void addStringsToSet(Set set, string array[], int n);
 static void testIntegerSet();
 static Set createDigitSet(string str);
+static void testBTreeSet(void);
+static void testLargeSets(StorageType storage);
+static void testBulkLoad(void);
+static void testOrderedSet(StorageType storage);
+static Set createMultipleSet(StorageType storage, int k, int limit);
+static void addToSum(void *vp, void *data);
+static void testBitmapSet(void);
 
 /* Unit test */
 
@@ -342,6 +829,17 @@ void testSetModule(void) {
    testCharacterSet();
    testStringSet();
    testIntegerSet();
+   testBTreeSet();
+   testLargeSets(AVL_TREE);
+   testLargeSets(B_TREE);
+   testBulkLoad();
+   testOrderedSet(AVL_TREE);
+   testOrderedSet(B_TREE);
+   testLargeSets(PERSISTENT_TREE);
+   testOrderedSet(PERSISTENT_TREE);
+   testLargeSets(COMPRESSED_BITMAP);
+   testOrderedSet(COMPRESSED_BITMAP);
+   testBitmapSet();
 }
 
 static void testCharacterSet(void) {
@@ -439,4 +937,187 @@ static Set createDigitSet(string str) {
    return set;
 }
 
+static void testBTreeSet(void) {
+   Set ospd3, ospd4, newWords, squares, evens;
+   int i, value, previous;
+
+   trace(ospd3 = newSetWithStorage(string, B_TREE));
+   trace(addStringsToSet(ospd3, OSPD3, N_OSPD3));
+   test(size(ospd3), (int) N_OSPD3);
+   trace(checkStringSet(ospd3, OSPD3));
+   trace(ospd4 = newSetWithStorage(string, B_TREE));
+   trace(addStringsToSet(ospd4, OSPD4, N_OSPD4));
+   trace(newWords = newSetWithStorage(string, B_TREE));
+   trace(addStringsToSet(newWords, NEW_WORDS, N_NEW_WORDS));
+   test(equals(union(ospd3, newWords), ospd4), true);
+   test(equals(setDifference(ospd4, ospd3), newWords), true);
+   test(equals(clone(ospd4), ospd4), true);
+   trace(squares = newSetWithStorage(int, B_TREE));
+   trace(evens = newSetWithStorage(int, B_TREE));
+   for (i = 999; i >= 0; i--) {
+      add(squares, i * i);
+      add(evens, 2 * i);
+   }
+   test(size(squares), 1000);
+   test(contains(squares, 998001), true);
+   test(contains(squares, 998000), false);
+   trace(remove(squares, 4));
+   test(contains(squares, 4), false);
+   test(size(intersection(squares, evens)), 22);
+   previous = -1;
+   foreach (value in squares) {
+      if (value <= previous) reportError("Set out of order at %d", value);
+      previous = value;
+   }
+}
+
+static void testLargeSets(StorageType storage) {
+   Set twos, threes, sixes, set;
+   int value, previous;
+
+   trace(twos = createMultipleSet(storage, 2, 6000));
+   trace(threes = createMultipleSet(storage, 3, 6000));
+   trace(sixes = createMultipleSet(storage, 6, 6000));
+   trace(set = union(twos, threes));
+   test(size(set), 4000);
+   test(contains(set, 5997), true);
+   test(contains(set, 5995), false);
+   previous = -1;
+   foreach (value in set) {
+      if (value <= previous) reportError("Set out of order at %d", value);
+      previous = value;
+   }
+   test(equals(intersection(twos, threes), sixes), true);
+   test(equals(intersection(sixes, twos), sixes), true);
+   test(equals(setDifference(twos, threes), setDifference(twos, sixes)), true);
+   test(size(setDifference(sixes, twos)), 0);
+   test(isSubset(sixes, twos), true);
+   test(isSubset(sixes, set), true);
+   test(isSubset(twos, sixes), false);
+   test(isSubset(threes, twos), false);
+   test(equals(twos, threes), false);
+   trace(add(set, 1));
+   trace(remove(set, 0));
+   test(size(set), 4000);
+   test(equals(clone(set), set), true);
+}
+
+static Set createMultipleSet(StorageType storage, int k, int limit) {
+   Set set;
+   int i;
+
+   set = newSetFromTypeWithStorage("int", storage);
+   for (i = 0; i < limit; i += k) {
+      add(set, i);
+   }
+   return set;
+}
+
+static void testBulkLoad(void) {
+   static int digits[] = { 7, 3, 9, 3, 0, 7, 1, 5, 9, 5 };
+   static char letters[] = { 'u', 'o', 'i', 'e', 'a', 'e' };
+   Set set, squares;
+   int i, *values;
+
+   trace(set = newSetFromArray("int", digits, 10));
+   test(equals(set, createDigitSet("013579")), true);
+   trace(addAllSet(set, digits, 0));
+   test(size(set), 6);
+   trace(set = newSetFromArray("string", OSPD3, N_OSPD3));
+   trace(checkStringSet(set, OSPD3));
+   trace(addAllSet(set, NEW_WORDS, N_NEW_WORDS));
+   trace(checkStringSet(set, OSPD4));
+   test(equals(newSetFromArray("char", letters, 6), createCharSet("aeiou")),
+        true);
+   values = newArray(1000, int);
+   for (i = 0; i < 1000; i++) {
+      values[i] = ((i * 377) % 1000) * ((i * 377) % 1000);
+   }
+   trace(squares = newSetWithStorage(int, B_TREE));
+   trace(addSet(squares, 1));
+   trace(addSet(squares, 2));
+   trace(addAllSet(squares, values, 1000));
+   test(size(squares), 1001);
+   test(contains(squares, 2), true);
+   test(contains(squares, 998001), true);
+   test(contains(squares, 998000), false);
+   freeBlock(values);
+}
+
+static void testOrderedSet(StorageType storage) {
+   Set multiples;
+   int value, sum;
+
+   trace(multiples = createMultipleSet(storage, 7, 7000));
+   test(rankSet(multiples, 0), 0);
+   test(rankSet(multiples, 700), 100);
+   test(rankSet(multiples, 701), 101);
+   test(rankSet(multiples, 100000), 1000);
+   sum = 0;
+   foreach (value in newSetRangeIterator(multiples, 10, 30)) {
+      sum += value;
+   }
+   test(sum, 63);
+   sum = 0;
+   foreach (value in newSetRangeIterator(multiples, 6993, 7000)) {
+      sum += value;
+   }
+   test(sum, 6993);
+   sum = 0;
+   foreach (value in newSetRangeIterator(multiples, 30, 10)) {
+      sum += value;
+   }
+   test(sum, 0);
+   sum = 0;
+   mapSet(multiples, addToSum, &sum);
+   test(sum, 3496500);
+}
+
+static void addToSum(void *vp, void *data) {
+   *((int *) data) += *((int *) vp);
+}
+
+static void testBitmapSet(void) {
+   Set set, tree, digits;
+   int value, previous, n;
+   unsigned u;
+   static int values[] = { 5, -3, 1000000, -2147483647 - 1, 0, 5, 2147483647 };
+
+   trace(set = newSetFromTypeWithStorage("int", COMPRESSED_BITMAP));
+   trace(addAllSet(set, values, 7));
+   test(size(set), 6);
+   test(contains(set, -3), true);
+   test(contains(set, 3), false);
+   test(rankSet(set, 0), 2);
+   n = 0;
+   previous = 0;
+   foreach (value in set) {
+      if (n > 0 && value <= previous) reportError("Set out of order at %d", value);
+      previous = value;
+      n++;
+   }
+   test(n, 6);
+   n = 0;
+   foreach (value in newSetRangeIterator(set, -10, 10)) {
+      n += value;
+   }
+   test(n, 2);
+   trace(tree = newSet(int));
+   trace(addAllSet(tree, values, 7));
+   test(equals(set, tree), true);
+   trace(add(tree, 17));
+   test(isSubset(set, tree), true);
+   test(size(setDifference(tree, set)), 1);
+   test(size(union(set, tree)), 7);
+   trace(digits = newSetFromTypeWithStorage("unsigned", COMPRESSED_BITMAP));
+   trace(add(digits, 4000000000U));
+   trace(add(digits, 7U));
+   n = 0;
+   foreach (u in digits) {
+      if (n == 0 && u != 7U) reportError("Wrong first element %u", u);
+      n++;
+   }
+   test(n, 2);
+}
+
 #endif
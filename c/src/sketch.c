@@ -0,0 +1,623 @@
+/*
+ * File: sketch.c
+ * --------------
+ * This file implements the sketch.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cslib.h"
+#include "sketch.h"
+#include "strlib.h"
+#include "unittest.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define SKETCH_AVX2
+#  include <immintrin.h>
+#endif
+
+/*
+ * Constants
+ * ---------
+ * BLOCK_WORDS        -- Number of 64-bit words in a filter block
+ * BLOCK_BYTES        -- Number of bytes in a filter block (a cache line)
+ * MAX_KEYS_PER_BLOCK -- Load at which a filter answers almost always yes
+ * SIZING_STEPS       -- Number of bisection steps in newBloomFilter
+ * BLOOM_MAGIC        -- Four characters that begin a saved Bloom filter
+ * CMS_MAGIC          -- Four characters that begin a saved count-min sketch
+ * SALTS              -- Odd multipliers that pick a bit in each word
+ */
+
+#define BLOCK_WORDS 8
+#define BLOCK_BYTES (BLOCK_WORDS * 8)
+#define MAX_KEYS_PER_BLOCK 1024
+#define SIZING_STEPS 60
+#define BLOOM_MAGIC "SPLB"
+#define CMS_MAGIC "SPLC"
+
+static const uint32_t SALTS[BLOCK_WORDS] = {
+   0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU,
+   0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U
+};
+
+/*
+ * Type: BloomFilterCDT
+ * --------------------
+ * This type defines the concrete structure of a Bloom filter, which is
+ * an array of blocks that each occupy one cache line.  The words field
+ * points into the storage at base, rounded up to a cache-line boundary.
+ */
+
+struct BloomFilterCDT {
+   uint64_t *words;
+   char *base;
+   int nBlocks;
+};
+
+/*
+ * Type: CountMinSketchCDT
+ * -----------------------
+ * This type defines the concrete structure of a count-min sketch, which
+ * is a table of counters with depth rows of width columns each.  Each
+ * row uses its own hash function to choose a column for a key.
+ */
+
+struct CountMinSketchCDT {
+   int *counts;
+   int width;
+   int depth;
+};
+
+/* Private function prototypes */
+
+static uint64_t hashKey(string key);
+static double blockedFalsePositiveRate(double keysPerBlock);
+static void allocateBlocks(BloomFilter bf, int nBlocks);
+static uint64_t *findBlock(BloomFilter bf, uint64_t hash);
+static void computeMasks(uint32_t hash, uint64_t masks[]);
+static bool probeBlock(uint64_t *block, uint32_t hash);
+#ifdef SKETCH_AVX2
+static bool probeBlockAVX2(uint64_t *block, uint32_t hash);
+#endif
+static int findColumn(CountMinSketch cms, uint64_t hash, int row);
+static void writeMagic(FILE *outfile, string magic);
+static void readMagic(FILE *infile, string magic, string fn);
+static void writeWord32(FILE *outfile, uint32_t value);
+static uint32_t readWord32(FILE *infile, string fn);
+static void writeWord64(FILE *outfile, uint64_t value);
+static uint64_t readWord64(FILE *infile, string fn);
+
+/* Exported entries */
+
+/*
+ * Implementation notes: newBloomFilter
+ * ------------------------------------
+ * Each key sets one bit in every word of its block, for a total of
+ * BLOCK_WORDS bits, so the formula for a classical Bloom filter, which
+ * assumes that the number of bits per key can vary, does not apply.
+ * Instead, the function searches by bisection for the largest average
+ * number of keys per block at which the false-positive rate of the
+ * blocked layout is at most rate, and then allocates enough blocks to
+ * keep the average below that number.  Since the rate rises with the
+ * load, the bisection keeps lo at a load that meets the target.
+ */
+
+BloomFilter newBloomFilter(int capacity, double rate) {
+   BloomFilter bf;
+   double lo, hi, mid, nBlocks;
+   int i;
+
+   if (capacity < 1) error("newBloomFilter: Capacity must be positive");
+   if (rate <= 0 || rate >= 1) {
+      error("newBloomFilter: Rate must be between 0 and 1");
+   }
+   lo = 0;
+   hi = MAX_KEYS_PER_BLOCK;
+   for (i = 0; i < SIZING_STEPS; i++) {
+      mid = (lo + hi) / 2;
+      if (blockedFalsePositiveRate(mid) <= rate) {
+         lo = mid;
+      } else {
+         hi = mid;
+      }
+   }
+   nBlocks = (lo == 0) ? HUGE_VAL : ceil(capacity / lo);
+   if (nBlocks > INT_MAX / BLOCK_BYTES - 1) {
+      error("newBloomFilter: Filter would be too large");
+   }
+   bf = newBlock(BloomFilter);
+   allocateBlocks(bf, (int) nBlocks);
+   clearBloomFilter(bf);
+   return bf;
+}
+
+void freeBloomFilter(BloomFilter bf) {
+   freeBlock(bf->base);
+   freeBlock(bf);
+}
+
+void clearBloomFilter(BloomFilter bf) {
+   memset(bf->words, 0, bf->nBlocks * BLOCK_BYTES);
+}
+
+void addBloomFilter(BloomFilter bf, string key) {
+   uint64_t hash, masks[BLOCK_WORDS], *block;
+   int i;
+
+   hash = hashKey(key);
+   block = findBlock(bf, hash);
+   computeMasks((uint32_t) hash, masks);
+   for (i = 0; i < BLOCK_WORDS; i++) {
+      block[i] |= masks[i];
+   }
+}
+
+bool mightContainBloomFilter(BloomFilter bf, string key) {
+   uint64_t hash;
+
+   hash = hashKey(key);
+#ifdef SKETCH_AVX2
+   if (__builtin_cpu_supports("avx2")) {
+      return probeBlockAVX2(findBlock(bf, hash), (uint32_t) hash);
+   }
+#endif
+   return probeBlock(findBlock(bf, hash), (uint32_t) hash);
+}
+
+void writeBloomFilter(FILE *outfile, BloomFilter bf) {
+   int i;
+
+   writeMagic(outfile, BLOOM_MAGIC);
+   writeWord32(outfile, bf->nBlocks);
+   for (i = 0; i < bf->nBlocks * BLOCK_WORDS; i++) {
+      writeWord64(outfile, bf->words[i]);
+   }
+}
+
+BloomFilter readBloomFilter(FILE *infile) {
+   BloomFilter bf;
+   uint32_t nBlocks;
+   int i;
+
+   readMagic(infile, BLOOM_MAGIC, "readBloomFilter");
+   nBlocks = readWord32(infile, "readBloomFilter");
+   if (nBlocks == 0 || nBlocks > INT_MAX / BLOCK_BYTES) {
+      error("readBloomFilter: Illegal filter size");
+   }
+   bf = newBlock(BloomFilter);
+   allocateBlocks(bf, nBlocks);
+   for (i = 0; i < bf->nBlocks * BLOCK_WORDS; i++) {
+      bf->words[i] = readWord64(infile, "readBloomFilter");
+   }
+   return bf;
+}
+
+CountMinSketch newCountMinSketch(double epsilon, double delta) {
+   CountMinSketch cms;
+
+   if (epsilon <= 0 || epsilon >= 1) {
+      error("newCountMinSketch: Epsilon must be between 0 and 1");
+   }
+   if (delta <= 0 || delta >= 1) {
+      error("newCountMinSketch: Delta must be between 0 and 1");
+   }
+   cms = newBlock(CountMinSketch);
+   cms->width = (int) ceil(exp(1.0) / epsilon);
+   cms->depth = (int) ceil(log(1 / delta));
+   cms->counts = newArray(cms->width * cms->depth, int);
+   clearCountMinSketch(cms);
+   return cms;
+}
+
+void freeCountMinSketch(CountMinSketch cms) {
+   freeBlock(cms->counts);
+   freeBlock(cms);
+}
+
+void clearCountMinSketch(CountMinSketch cms) {
+   memset(cms->counts, 0, cms->width * cms->depth * sizeof(int));
+}
+
+void addCountMinSketch(CountMinSketch cms, string key, int count) {
+   uint64_t hash;
+   int row, *cp;
+
+   if (count < 0) error("addCountMinSketch: Count must not be negative");
+   hash = hashKey(key);
+   for (row = 0; row < cms->depth; row++) {
+      cp = &cms->counts[row * cms->width + findColumn(cms, hash, row)];
+      *cp = (*cp > INT_MAX - count) ? INT_MAX : *cp + count;
+   }
+}
+
+int estimateCountMinSketch(CountMinSketch cms, string key) {
+   uint64_t hash;
+   int row, count, min;
+
+   hash = hashKey(key);
+   min = INT_MAX;
+   for (row = 0; row < cms->depth; row++) {
+      count = cms->counts[row * cms->width + findColumn(cms, hash, row)];
+      if (count < min) min = count;
+   }
+   return min;
+}
+
+void writeCountMinSketch(FILE *outfile, CountMinSketch cms) {
+   int i;
+
+   writeMagic(outfile, CMS_MAGIC);
+   writeWord32(outfile, cms->width);
+   writeWord32(outfile, cms->depth);
+   for (i = 0; i < cms->width * cms->depth; i++) {
+      writeWord32(outfile, cms->counts[i]);
+   }
+}
+
+CountMinSketch readCountMinSketch(FILE *infile) {
+   CountMinSketch cms;
+   uint32_t width, depth;
+   int i;
+
+   readMagic(infile, CMS_MAGIC, "readCountMinSketch");
+   width = readWord32(infile, "readCountMinSketch");
+   depth = readWord32(infile, "readCountMinSketch");
+   if (width == 0 || depth == 0 || width > INT_MAX / sizeof(int) / depth) {
+      error("readCountMinSketch: Illegal sketch size");
+   }
+   cms = newBlock(CountMinSketch);
+   cms->width = width;
+   cms->depth = depth;
+   cms->counts = newArray(cms->width * cms->depth, int);
+   for (i = 0; i < cms->width * cms->depth; i++) {
+      cms->counts[i] = readWord32(infile, "readCountMinSketch");
+   }
+   return cms;
+}
+
+/* Private functions */
+
+/*
+ * Implementation notes: hashKey
+ * -----------------------------
+ * Both structures hash the characters with the 64-bit FNV-1a function
+ * and then mix the result with the finalizer from the SplitMix64
+ * generator, so that the high and low halves can serve as independent
+ * hash values.  The 31-bit code from hashString would not do: with only
+ * 2^31 distinct codes, two of n keys collide with probability about
+ * n / 2^31, which would set a floor under the false-positive rate of
+ * half a percent at ten million keys.
+ */
+
+static uint64_t hashKey(string key) {
+   uint64_t hash;
+   int i;
+
+   hash = 0xCBF29CE484222325ULL;
+   for (i = 0; key[i] != '\0'; i++) {
+      hash = (hash ^ (unsigned char) key[i]) * 0x100000001B3ULL;
+   }
+   hash += 0x9E3779B97F4A7C15ULL;
+   hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+   return hash ^ (hash >> 31);
+}
+
+/*
+ * Implementation notes: blockedFalsePositiveRate
+ * ----------------------------------------------
+ * Returns the false-positive rate of a filter that holds keysPerBlock
+ * keys per block on average.  The number of keys j in the block that a
+ * query lands in follows a Poisson distribution with that mean.  Each of
+ * those keys sets one of the 64 bits in every word, so the bit that the
+ * query tests in a word is on with probability 1 - (63/64)^j, and the
+ * query succeeds only if its bit is on in all BLOCK_WORDS words.  The
+ * sum stops far enough into the tail that the omitted terms are
+ * negligible.
+ */
+
+static double blockedFalsePositiveRate(double keysPerBlock) {
+   double sum, limit, logTerm;
+   int j;
+
+   if (keysPerBlock <= 0) return 0;
+   sum = 0;
+   limit = keysPerBlock + 12 * sqrt(keysPerBlock) + 30;
+   for (j = 0; j <= limit; j++) {
+      logTerm = -keysPerBlock + j * log(keysPerBlock) - lgamma(j + 1.0);
+      sum += exp(logTerm) * pow(1 - pow(63.0 / 64, j), BLOCK_WORDS);
+   }
+   return sum;
+}
+
+/*
+ * Implementation notes: allocateBlocks
+ * ------------------------------------
+ * Allocates one extra block so that the words can start on a cache-line
+ * boundary.
+ */
+
+static void allocateBlocks(BloomFilter bf, int nBlocks) {
+   uintptr_t addr;
+
+   if (nBlocks < 1) nBlocks = 1;
+   bf->nBlocks = nBlocks;
+   bf->base = newArray((nBlocks + 1) * BLOCK_BYTES, char);
+   addr = (uintptr_t) bf->base + BLOCK_BYTES - 1;
+   bf->words = (uint64_t *) (addr & ~(uintptr_t) (BLOCK_BYTES - 1));
+}
+
+/*
+ * Implementation notes: findBlock, computeMasks
+ * ---------------------------------------------
+ * The high half of the hash chooses the block, scaled into the range of
+ * block indices by a multiplication rather than a division.  The low
+ * half chooses one bit in each word of the block: multiplying it by the
+ * word's salt and keeping the top six bits of the product gives a bit
+ * position from 0 to 63.
+ */
+
+static uint64_t *findBlock(BloomFilter bf, uint64_t hash) {
+   uint64_t index;
+
+   index = ((hash >> 32) * (uint64_t) bf->nBlocks) >> 32;
+   return bf->words + index * BLOCK_WORDS;
+}
+
+static void computeMasks(uint32_t hash, uint64_t masks[]) {
+   int i;
+
+   for (i = 0; i < BLOCK_WORDS; i++) {
+      masks[i] = (uint64_t) 1 << ((uint32_t) (hash * SALTS[i]) >> 26);
+   }
+}
+
+static bool probeBlock(uint64_t *block, uint32_t hash) {
+   uint64_t masks[BLOCK_WORDS];
+   int i;
+
+   computeMasks(hash, masks);
+   for (i = 0; i < BLOCK_WORDS; i++) {
+      if ((block[i] & masks[i]) != masks[i]) return false;
+   }
+   return true;
+}
+
+#ifdef SKETCH_AVX2
+
+/*
+ * Implementation notes: probeBlockAVX2
+ * ------------------------------------
+ * Computes the eight bit positions with a single vector multiplication,
+ * widens them to 64 bits to build the masks, and tests each half of the
+ * block against its masks in one instruction.
+ */
+
+__attribute__((target("avx2")))
+static bool probeBlockAVX2(uint64_t *block, uint32_t hash) {
+   __m256i positions, one, lowMasks, highMasks;
+
+   positions = _mm256_mullo_epi32(_mm256_set1_epi32(hash),
+                                  _mm256_loadu_si256((__m256i *) SALTS));
+   positions = _mm256_srli_epi32(positions, 26);
+   one = _mm256_set1_epi64x(1);
+   lowMasks = _mm256_sllv_epi64(one,
+                  _mm256_cvtepu32_epi64(_mm256_castsi256_si128(positions)));
+   highMasks = _mm256_sllv_epi64(one,
+                  _mm256_cvtepu32_epi64(_mm256_extracti128_si256(positions, 1)));
+   return _mm256_testc_si256(_mm256_load_si256((__m256i *) block), lowMasks)
+       && _mm256_testc_si256(_mm256_load_si256((__m256i *) (block + 4)),
+                             highMasks);
+}
+
+#endif
+
+/*
+ * Implementation notes: findColumn
+ * --------------------------------
+ * The hash function for each row combines the two halves of the hash,
+ * which is as effective as independent functions for this purpose.
+ */
+
+static int findColumn(CountMinSketch cms, uint64_t hash, int row) {
+   uint32_t h1, h2;
+
+   h1 = (uint32_t) hash;
+   h2 = (uint32_t) (hash >> 32) | 1;
+   return (int) ((h1 + (uint32_t) row * h2) % (uint32_t) cms->width);
+}
+
+/*
+ * Implementation notes: Serialization
+ * -----------------------------------
+ * Saved structures begin with four identifying characters followed by
+ * their dimensions and contents, with every number written in
+ * little-endian order regardless of the platform.
+ */
+
+static void writeMagic(FILE *outfile, string magic) {
+   fwrite(magic, 1, 4, outfile);
+}
+
+static void readMagic(FILE *infile, string magic, string fn) {
+   char buffer[4];
+
+   if (fread(buffer, 1, 4, infile) != 4 || memcmp(buffer, magic, 4) != 0) {
+      error("%s: File does not contain the expected structure", fn);
+   }
+}
+
+static void writeWord32(FILE *outfile, uint32_t value) {
+   int i;
+
+   for (i = 0; i < 4; i++) {
+      putc((int) ((value >> (8 * i)) & 0xFF), outfile);
+   }
+}
+
+static uint32_t readWord32(FILE *infile, string fn) {
+   uint32_t value;
+   int i, ch;
+
+   value = 0;
+   for (i = 0; i < 4; i++) {
+      ch = getc(infile);
+      if (ch == EOF) error("%s: Unexpected end of file", fn);
+      value |= (uint32_t) ch << (8 * i);
+   }
+   return value;
+}
+
+static void writeWord64(FILE *outfile, uint64_t value) {
+   writeWord32(outfile, (uint32_t) value);
+   writeWord32(outfile, (uint32_t) (value >> 32));
+}
+
+static uint64_t readWord64(FILE *infile, string fn) {
+   uint64_t low;
+
+   low = readWord32(infile, fn);
+   return low | (uint64_t) readWord32(infile, fn) << 32;
+}
+
+/**********************************************************************/
+/* Unit test for the sketch module                                    */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+/* Private function prototypes */
+
+static void testBloomFilter(void);
+static void testCountMinSketch(void);
+
+/* Unit test */
+
+void testSketchModule(void) {
+   testBloomFilter();
+   testCountMinSketch();
+}
+
+/*
+ * Implementation notes: testBloomFilter
+ * -------------------------------------
+ * Fills a filter to capacity with the even numbers below 20000 and then
+ * measures the false-positive rate on 30000 other numbers.  At the
+ * requested rate of 1 percent, about 300 of them should pass, and the
+ * limit of 360 allows for chance variation of more than three standard
+ * deviations.
+ */
+
+static void testBloomFilter(void) {
+   BloomFilter bf, copy;
+   FILE *file;
+   string key;
+   int i, misses, hits;
+
+   trace(bf = newBloomFilter(10000, 0.01));
+   test(mightContainBloomFilter(bf, "anything"), false);
+   for (i = 0; i < 20000; i += 2) {
+      key = integerToString(i);
+      addBloomFilter(bf, key);
+      freeBlock(key);
+   }
+   misses = hits = 0;
+   for (i = 0; i < 40000; i++) {
+      key = integerToString(i);
+      if (i % 2 == 0 && i < 20000) {
+         if (!mightContainBloomFilter(bf, key)) misses++;
+      } else {
+         if (mightContainBloomFilter(bf, key)) hits++;
+      }
+      freeBlock(key);
+   }
+   test(misses, 0);
+   test(hits < 360, true);
+   trace(file = tmpfile());
+   trace(writeBloomFilter(file, bf));
+   trace(rewind(file));
+   trace(copy = readBloomFilter(file));
+   trace(fclose(file));
+   test(copy->nBlocks == bf->nBlocks, true);
+   test(memcmp(copy->words, bf->words, bf->nBlocks * BLOCK_BYTES), 0);
+   test(mightContainBloomFilter(copy, "19998"), true);
+   trace(clearBloomFilter(bf));
+   test(mightContainBloomFilter(bf, "19998"), false);
+   trace(freeBloomFilter(bf));
+   trace(freeBloomFilter(copy));
+}
+
+/*
+ * Implementation notes: testCountMinSketch
+ * ----------------------------------------
+ * Adds key k a total of k times for k from 1 to 200, which gives a total
+ * count of 20100.  With epsilon set to 0.001, no estimate should exceed
+ * the true count by more than about 20.
+ */
+
+static void testCountMinSketch(void) {
+   CountMinSketch cms, copy;
+   FILE *file;
+   string key;
+   int k, estimate, under, over;
+
+   trace(cms = newCountMinSketch(0.001, 0.01));
+   test(cms->width, 2719);
+   test(cms->depth, 5);
+   test(estimateCountMinSketch(cms, "absent"), 0);
+   for (k = 1; k <= 200; k++) {
+      key = integerToString(k);
+      addCountMinSketch(cms, key, k);
+      freeBlock(key);
+   }
+   under = over = 0;
+   for (k = 1; k <= 200; k++) {
+      key = integerToString(k);
+      estimate = estimateCountMinSketch(cms, key);
+      if (estimate < k) under++;
+      if (estimate > k + 21) over++;
+      freeBlock(key);
+   }
+   test(under, 0);
+   test(over, 0);
+   trace(addCountMinSketch(cms, "big", INT_MAX - 5));
+   trace(addCountMinSketch(cms, "big", 10));
+   test(estimateCountMinSketch(cms, "big") == INT_MAX, true);
+   trace(file = tmpfile());
+   trace(writeCountMinSketch(file, cms));
+   trace(rewind(file));
+   trace(copy = readCountMinSketch(file));
+   trace(fclose(file));
+   test(estimateCountMinSketch(copy, "150")
+        == estimateCountMinSketch(cms, "150"), true);
+   trace(file = tmpfile());
+   trace(writeBloomFilter(file, newBloomFilter(10, 0.5)));
+   trace(rewind(file));
+   testError(readCountMinSketch(file));
+   trace(fclose(file));
+   trace(freeCountMinSketch(cms));
+   trace(freeCountMinSketch(copy));
+}
+
+#endif
@@ -41,13 +41,64 @@
 #include "strlib.h"
 #include "unittest.h"
 
-/* Constants */
+/*
+ * Implementation notes: Vector instructions
+ * -----------------------------------------
+ * The searches that the C library already provides, such as strchr and
+ * strstr, use vector instructions and linear-time algorithms on their
+ * own, so the functions built on them call them directly.  The case
+ * conversions, the case-insensitive comparison, and the backward string
+ * search have no library counterpart.  On x86 processors, these examine
+ * 16 characters at a time with the SSE2 instructions that every 64-bit
+ * processor supports, or 32 at a time with AVX2 when the processor
+ * running the program has it.  Other platforms use the portable code,
+ * which computes the same results.  All of these functions treat only
+ * the ASCII letters as having case, which matches the behavior of
+ * tolower and toupper in the default C locale.
+ */
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define STRLIB_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define STRLIB_AVX2
+#  include <immintrin.h>
+#endif
+
+/*
+ * Constants
+ * ---------
+ * MAX_NUMBER_DIGITS -- Size of the buffer for converting numbers
+ * CASE_BIT          -- Bit that distinguishes ASCII upper and lower case
+ * COMPARE_CHUNK     -- Characters compared between checks for the end
+ */
 
 #define MAX_NUMBER_DIGITS 30
+#define CASE_BIT 0x20
+#define COMPARE_CHUNK 256
 
 /* Private function prototypes */
 
 static string createString(int len);
+static string convertCase(string s, char first, char last);
+static bool equalIgnoringCase(const char *s1, const char *s2, int n);
+static char toLowerASCII(char ch);
+#ifdef STRLIB_SSE2
+static int convertBlocksSSE2(char *dst, const char *src, int start, int n,
+                             char first, char last);
+static int compareBlocksSSE2(const char *s1, const char *s2, int start,
+                             int n);
+static int findLastBlocksSSE2(string str, int m, string text, int count);
+#endif
+#ifdef STRLIB_AVX2
+static int convertBlocksAVX2(char *dst, const char *src, int start, int n,
+                             char first, char last);
+static int compareBlocksAVX2(const char *s1, const char *s2, int start,
+                             int n);
+static int findLastBlocksAVX2(string str, int m, string text, int count);
+#endif
 
 /* Section 1 -- Basic string operations */
 
@@ -78,19 +129,8 @@ char charAt(string s, int i) {
 }
 
 string substring(string s, int p1, int p2) {
-   int len;
-   string result;
-
    if (s == NULL) error("substring: String value is NULL");
-   len = strlen(s);
-   if (p1 < 0) p1 = 0;
-   if (p2 >= len) p2 = len - 1;
-   len = p2 - p1 + 1;
-   if (len < 0) len = 0;
-   result = createString(len);
-   strncpy(result, s + p1, len);
-   result[len] = '\0';
-   return result;
+   return viewToString(sliceString(s, p1, p2));
 }
 
 string charToString(char ch) {
@@ -125,16 +165,32 @@ bool stringEqual(string s1, string s2) {
    return strcmp(s1, s2) == 0;
 }
 
+/*
+ * Implementation notes: stringEqualIgnoreCase
+ * -------------------------------------------
+ * The strings are compared in chunks of COMPARE_CHUNK characters.
+ * Before comparing a chunk, the function looks for the end of each
+ * string within it, so that the vector code never reads past the end
+ * and the comparison of a short string with a long one stops early.
+ */
+
 bool stringEqualIgnoreCase(string s1, string s2) {
-   int i;
+   const char *end1, *end2;
+   int n1, n2;
 
    if (s1 == NULL || s2 == NULL) {
       error("stringEqualIgnoreCase: String value is NULL");
    }
-   for (i = 0; s1[i] != '\0'; i++) {
-      if (tolower(s1[i]) != tolower(s2[i])) return false;
+   while (true) {
+      end1 = memchr(s1, '\0', COMPARE_CHUNK);
+      end2 = memchr(s2, '\0', COMPARE_CHUNK);
+      n1 = (end1 == NULL) ? COMPARE_CHUNK : (int) (end1 - s1);
+      n2 = (end2 == NULL) ? COMPARE_CHUNK : (int) (end2 - s2);
+      if (n1 != n2 || !equalIgnoringCase(s1, s2, n1)) return false;
+      if (n1 < COMPARE_CHUNK) return true;
+      s1 += COMPARE_CHUNK;
+      s2 += COMPARE_CHUNK;
    }
-   return s2[i] == '\0';
 }
 
 int stringCompare(string s1, string s2) {
@@ -168,7 +224,7 @@ int findChar(char ch, string text, int start) {
 
    if (text == NULL) error("findChar: String value is NULL");
    if (start < 0) start = 0;
-   if (start > strlen(text)) return -1;
+   if (memchr(text, '\0', start) != NULL) return -1;
    cptr = strchr(text + start, ch);
    if (cptr == NULL) return -1;
    return (int) (cptr - text);
@@ -180,7 +236,7 @@ int findString(string str, string text, int start) {
    if (str == NULL) error("findString: String value is NULL");
    if (text == NULL) error("findString: String value is NULL");
    if (start < 0) start = 0;
-   if (start > strlen(text)) return -1;
+   if (memchr(text, '\0', start) != NULL) return -1;
    cptr = strstr(text + start, str);
    if (cptr == NULL) return -1;
    return (int) (cptr - text);
@@ -195,14 +251,40 @@ int findLastChar(char ch, string text) {
    return (int) (cptr - text);
 }
 
+/*
+ * Implementation notes: findLastString
+ * ------------------------------------
+ * The variable count holds the number of starting positions that remain
+ * to be checked, which are the ones below count.  The vector code checks
+ * a block of positions at a time, comparing the first and last
+ * characters of str with the characters at the corresponding offsets,
+ * so that only the positions that pass both tests need a full
+ * comparison.
+ */
+
 int findLastString(string str, string text) {
-   int i, nc;
+   int m, count;
 
    if (str == NULL) error("findLastString: String value is NULL");
    if (text == NULL) error("findLastString: String value is NULL");
-   nc = strlen(str);
-   for (i = strlen(text) - nc; i >= 0; i--) {
-      if (strncmp(str, text + i, nc) == 0) return i;
+   m = strlen(str);
+   count = (int) strlen(text) - m + 1;
+   if (count <= 0) return -1;
+   if (m == 0) return count - 1;
+#ifdef STRLIB_AVX2
+   if (count >= 32 && __builtin_cpu_supports("avx2")) {
+      count = findLastBlocksAVX2(str, m, text, count);
+      if (count < 0) return -count - 1;
+   }
+#endif
+#ifdef STRLIB_SSE2
+   count = findLastBlocksSSE2(str, m, text, count);
+   if (count < 0) return -count - 1;
+#endif
+   while (--count >= 0) {
+      if (text[count] == str[0] && memcmp(text + count, str, m) == 0) {
+         return count;
+      }
    }
    return -1;
 }
@@ -210,33 +292,17 @@ int findLastString(string str, string text) {
 /* Section 4 -- Conversion functions */
 
 string toLowerCase(string s) {
-   string result;
-   int i;
-
    if (s == NULL) {
       error("toLowerCase: String value is NULL");
    }
-   result = createString(strlen(s));
-   for (i = 0; s[i] != '\0'; i++) {
-      result[i] = tolower(s[i]);
-   }
-   result[i] = '\0';
-   return result;
+   return convertCase(s, 'A', 'Z');
 }
 
 string toUpperCase(string s) {
-   string result;
-   int i;
-
    if (s == NULL) {
       error("toUpperCase: String value is NULL");
    }
-   result = createString(strlen(s));
-   for (i = 0; s[i] != '\0'; i++) {
-      result[i] = toupper(s[i]);
-   }
-   result[i] = '\0';
-   return result;
+   return convertCase(s, 'a', 'z');
 }
 
 string integerToString(int n) {
@@ -294,17 +360,7 @@ double stringToReal(string s) {
 }
 
 string trim(string str) {
-   int start, finish;
-
-   start = 0;
-   while (str[start] != '\0' && isspace(str[start])) {
-      start++;
-   }
-   finish = strlen(str) - 1;
-   while (finish >= start && isspace(str[finish])) {
-      finish--;
-   }
-   return substring(str, start, finish);
+   return viewToString(trimView(viewString(str)));
 }
 
 string quoteString(string str) {
@@ -340,7 +396,7 @@ string quoteString(string str) {
        case '\\': *cp++ = '\\'; *cp++ = '\\'; break;
        default:
          if (ch < 32 || ch >= 127) {
-            sprintf(cp, "\\%03o", ch);
+            sprintf(cp, "\\%03o", (unsigned char) ch);
             cp += 4;
          } else {
             *cp++ = ch;
@@ -401,6 +457,93 @@ int searchStringArray(string str, string array[]) {
    return -1;
 }
 
+/* Section 6 -- String views */
+
+StringView viewString(string s) {
+   StringView view;
+
+   if (s == NULL) error("viewString: String value is NULL");
+   view.p = s;
+   view.len = strlen(s);
+   return view;
+}
+
+/*
+ * Implementation notes: sliceString
+ * ---------------------------------
+ * The loops stop at the null character, so that the function never
+ * reads past position p2 and never forms a pointer beyond the end of
+ * the string.
+ */
+
+StringView sliceString(string s, int p1, int p2) {
+   StringView view;
+   int start, len;
+
+   if (s == NULL) error("sliceString: String value is NULL");
+   start = 0;
+   while (start < p1 && s[start] != '\0') {
+      start++;
+   }
+   len = 0;
+   while (start + len <= p2 && s[start + len] != '\0') {
+      len++;
+   }
+   view.p = s + start;
+   view.len = len;
+   return view;
+}
+
+StringView sliceView(StringView view, int p1, int p2) {
+   if (p1 < 0) p1 = 0;
+   if (p1 > view.len) p1 = view.len;
+   if (p2 >= view.len) p2 = view.len - 1;
+   view.p += p1;
+   view.len = (p2 < p1) ? 0 : p2 - p1 + 1;
+   return view;
+}
+
+StringView trimView(StringView view) {
+   while (view.len > 0 && isspace((unsigned char) view.p[0])) {
+      view.p++;
+      view.len--;
+   }
+   while (view.len > 0 && isspace((unsigned char) view.p[view.len - 1])) {
+      view.len--;
+   }
+   return view;
+}
+
+int findInView(string str, StringView view, int start) {
+   const char *cptr;
+   int n, i;
+
+   if (str == NULL) error("findInView: String value is NULL");
+   if (start < 0) start = 0;
+   n = strlen(str);
+   if (n == 0) return (start > view.len) ? -1 : start;
+   for (i = start; i + n <= view.len; i = (int) (cptr - view.p) + 1) {
+      cptr = memchr(view.p + i, str[0], view.len - n + 1 - i);
+      if (cptr == NULL) return -1;
+      if (memcmp(cptr, str, n) == 0) return (int) (cptr - view.p);
+   }
+   return -1;
+}
+
+bool viewEquals(StringView view, string str) {
+   if (str == NULL) error("viewEquals: String value is NULL");
+   return strncmp(view.p, str, view.len) == 0 && str[view.len] == '\0';
+}
+
+string viewToString(StringView view) {
+   string result;
+
+   result = createString(view.len);
+   memcpy(result, view.p, view.len);
+   result[view.len] = '\0';
+   return result;
+}
+
 /*
  * Private function: createString
  * Usage: s = createString(len);
@@ -414,6 +557,243 @@ static string createString(int len) {
    return (string) getBlock(len + 1);
 }
 
+/*
+ * Private function: convertCase
+ * Usage: result = convertCase(s, first, last);
+ * --------------------------------------------
+ * Returns a copy of s in which the letters between first and last have
+ * been changed to the other case.  In ASCII, the two cases differ only
+ * in CASE_BIT, so the same code converts in either direction.
+ */
+
+static string convertCase(string s, char first, char last) {
+   string result;
+   int i, n;
+
+   n = strlen(s);
+   result = createString(n);
+   i = 0;
+#ifdef STRLIB_AVX2
+   if (n >= 32 && __builtin_cpu_supports("avx2")) {
+      i = convertBlocksAVX2(result, s, i, n, first, last);
+   }
+#endif
+#ifdef STRLIB_SSE2
+   i = convertBlocksSSE2(result, s, i, n, first, last);
+#endif
+   for (; i < n; i++) {
+      result[i] = (s[i] >= first && s[i] <= last) ? s[i] ^ CASE_BIT : s[i];
+   }
+   result[n] = '\0';
+   return result;
+}
+
+/*
+ * Private function: equalIgnoringCase
+ * Usage: if (equalIgnoringCase(s1, s2, n)) . . .
+ * ----------------------------------------------
+ * Returns true if the first n characters of s1 and s2 are the same
+ * except for the case of ASCII letters.
+ */
+
+static bool equalIgnoringCase(const char *s1, const char *s2, int n) {
+   int i;
+
+   i = 0;
+#ifdef STRLIB_AVX2
+   if (n >= 32 && __builtin_cpu_supports("avx2")) {
+      i = compareBlocksAVX2(s1, s2, i, n);
+      if (i < 0) return false;
+   }
+#endif
+#ifdef STRLIB_SSE2
+   i = compareBlocksSSE2(s1, s2, i, n);
+   if (i < 0) return false;
+#endif
+   for (; i < n; i++) {
+      if (toLowerASCII(s1[i]) != toLowerASCII(s2[i])) return false;
+   }
+   return true;
+}
+
+static char toLowerASCII(char ch) {
+   return (ch >= 'A' && ch <= 'Z') ? ch ^ CASE_BIT : ch;
+}
+
+#ifdef STRLIB_SSE2
+
+/*
+ * Implementation notes: convertBlocksSSE2, compareBlocksSSE2
+ * ----------------------------------------------------------
+ * These functions process 16 characters at a time, beginning at index
+ * start, and return the index at which the characters that remain
+ * begin, or -1 if compareBlocksSSE2 finds a difference.  A character is
+ * a letter if it is greater than the character before first and less
+ * than the one after last.  The comparisons are signed, so characters
+ * outside ASCII, which are negative, are never letters.
+ */
+
+static int convertBlocksSSE2(char *dst, const char *src, int start, int n,
+                             char first, char last) {
+   __m128i below, above, caseBit, chars, letters;
+   int i;
+
+   below = _mm_set1_epi8(first - 1);
+   above = _mm_set1_epi8(last + 1);
+   caseBit = _mm_set1_epi8(CASE_BIT);
+   for (i = start; i + 16 <= n; i += 16) {
+      chars = _mm_loadu_si128((__m128i *) (src + i));
+      letters = _mm_and_si128(_mm_cmpgt_epi8(chars, below),
+                              _mm_cmplt_epi8(chars, above));
+      chars = _mm_xor_si128(chars, _mm_and_si128(letters, caseBit));
+      _mm_storeu_si128((__m128i *) (dst + i), chars);
+   }
+   return i;
+}
+
+static int compareBlocksSSE2(const char *s1, const char *s2, int start,
+                             int n) {
+   __m128i below, above, caseBit, c1, c2;
+   int i;
+
+   below = _mm_set1_epi8('A' - 1);
+   above = _mm_set1_epi8('Z' + 1);
+   caseBit = _mm_set1_epi8(CASE_BIT);
+   for (i = start; i + 16 <= n; i += 16) {
+      c1 = _mm_loadu_si128((__m128i *) (s1 + i));
+      c2 = _mm_loadu_si128((__m128i *) (s2 + i));
+      c1 = _mm_or_si128(c1, _mm_and_si128(caseBit,
+              _mm_and_si128(_mm_cmpgt_epi8(c1, below),
+                            _mm_cmplt_epi8(c1, above))));
+      c2 = _mm_or_si128(c2, _mm_and_si128(caseBit,
+              _mm_and_si128(_mm_cmpgt_epi8(c2, below),
+                            _mm_cmplt_epi8(c2, above))));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(c1, c2)) != 0xFFFF) return -1;
+   }
+   return i;
+}
+
+/*
+ * Implementation notes: findLastBlocksSSE2
+ * ----------------------------------------
+ * Checks the starting positions below count in blocks of 16, beginning
+ * with the highest block.  The mask has a bit for each position in the
+ * block whose first and last characters match those of str, and the
+ * positions are tried from the highest bit down.  If a match turns up
+ * at index k, the function returns -k - 1; otherwise it returns the
+ * number of positions that remain.  The last load of each block ends at
+ * position count + m - 2, which is inside the text.
+ */
+
+static int findLastBlocksSSE2(string str, int m, string text, int count) {
+   __m128i first, last, head, tail;
+   unsigned mask;
+   int base, k;
+
+   first = _mm_set1_epi8(str[0]);
+   last = _mm_set1_epi8(str[m - 1]);
+   while (count >= 16) {
+      base = count - 16;
+      head = _mm_loadu_si128((__m128i *) (text + base));
+      tail = _mm_loadu_si128((__m128i *) (text + base + m - 1));
+      mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first),
+                                             _mm_cmpeq_epi8(tail, last)));
+      while (mask != 0) {
+         k = 31 - __builtin_clz(mask);
+         if (m <= 2 || memcmp(text + base + k + 1, str + 1, m - 2) == 0) {
+            return -(base + k) - 1;
+         }
+         mask &= ~(1U << k);
+      }
+      count = base;
+   }
+   return count;
+}
+
+#endif
+
+#ifdef STRLIB_AVX2
+
+/*
+ * Implementation notes: AVX2 functions
+ * ------------------------------------
+ * These functions work in the same way as their SSE2 counterparts but
+ * process 32 characters at a time.  AVX2 has no signed less-than
+ * comparison on bytes, so the tests are written with the operands of
+ * the greater-than comparison exchanged.
+ */
+
+__attribute__((target("avx2")))
+static int convertBlocksAVX2(char *dst, const char *src, int start, int n,
+                             char first, char last) {
+   __m256i below, above, caseBit, chars, letters;
+   int i;
+
+   below = _mm256_set1_epi8(first - 1);
+   above = _mm256_set1_epi8(last + 1);
+   caseBit = _mm256_set1_epi8(CASE_BIT);
+   for (i = start; i + 32 <= n; i += 32) {
+      chars = _mm256_loadu_si256((__m256i *) (src + i));
+      letters = _mm256_and_si256(_mm256_cmpgt_epi8(chars, below),
+                                 _mm256_cmpgt_epi8(above, chars));
+      chars = _mm256_xor_si256(chars, _mm256_and_si256(letters, caseBit));
+      _mm256_storeu_si256((__m256i *) (dst + i), chars);
+   }
+   return i;
+}
+
+__attribute__((target("avx2")))
+static int compareBlocksAVX2(const char *s1, const char *s2, int start,
+                             int n) {
+   __m256i below, above, caseBit, c1, c2;
+   int i;
+
+   below = _mm256_set1_epi8('A' - 1);
+   above = _mm256_set1_epi8('Z' + 1);
+   caseBit = _mm256_set1_epi8(CASE_BIT);
+   for (i = start; i + 32 <= n; i += 32) {
+      c1 = _mm256_loadu_si256((__m256i *) (s1 + i));
+      c2 = _mm256_loadu_si256((__m256i *) (s2 + i));
+      c1 = _mm256_or_si256(c1, _mm256_and_si256(caseBit,
+              _mm256_and_si256(_mm256_cmpgt_epi8(c1, below),
+                               _mm256_cmpgt_epi8(above, c1))));
+      c2 = _mm256_or_si256(c2, _mm256_and_si256(caseBit,
+              _mm256_and_si256(_mm256_cmpgt_epi8(c2, below),
+                               _mm256_cmpgt_epi8(above, c2))));
+      if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(c1, c2)) != -1) return -1;
+   }
+   return i;
+}
+
+__attribute__((target("avx2")))
+static int findLastBlocksAVX2(string str, int m, string text, int count) {
+   __m256i first, last, head, tail;
+   unsigned mask;
+   int base, k;
+
+   first = _mm256_set1_epi8(str[0]);
+   last = _mm256_set1_epi8(str[m - 1]);
+   while (count >= 32) {
+      base = count - 32;
+      head = _mm256_loadu_si256((__m256i *) (text + base));
+      tail = _mm256_loadu_si256((__m256i *) (text + base + m - 1));
+      mask = _mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(head, first),
+                                 _mm256_cmpeq_epi8(tail, last)));
+      while (mask != 0) {
+         k = 31 - __builtin_clz(mask);
+         if (m <= 2 || memcmp(text + base + k + 1, str + 1, m - 2) == 0) {
+            return -(base + k) - 1;
+         }
+         mask &= ~(1U << k);
+      }
+      count = base;
+   }
+   return count;
+}
+
+#endif
+
 /**********************************************************************/
 /* Unit test for the strlib module                                    */
 /**********************************************************************/
@@ -448,6 +828,9 @@ static void testQuoteString(void);
 static void testQuoteHTML(void);
 static void testStringArrayLength(void);
 static void testSearchStringArray(void);
+static void testStringViews(void);
+static void testLongStrings(void);
+static int findLastNaive(string str, string text);
 
 /* Unit test */
 
@@ -478,6 +861,8 @@ void testStrlibModule(void) {
    testQuoteHTML();
    testStringArrayLength();
    testSearchStringArray();
+   testStringViews();
+   testLongStrings();
 }
 
 /* Private functions */
@@ -500,6 +885,7 @@ static void testSubString(void) {
    test(substring("abcde", 0, 4), "abcde");
    test(substring("abcde", -1, 5), "abcde");
    test(substring("abcde", 3, 2), "");
+   test(substring("abcde", 7, 9), "");
 }
 
 static void testCharToString(void) {
@@ -616,6 +1002,7 @@ static void testStringToReal(void) {
 static void testQuoteString(void) {
    test(quoteString("abcde"), "\"abcde\"");
    test(quoteString("ab\t\"\5cd"), "\"ab\\t\\\"\\005cd\"");
+   test(quoteString("\377"), "\"\\377\"");
 }
 
 static void testQuoteHTML(void) {
@@ -628,6 +1015,7 @@ static void testTrim(void) {
    test(trim("abcde    "), "abcde");
    test(trim("\tabcde  "), "abcde");
    test(trim(""), "");
+   test(trim(" \t \n"), "");
 }
 
 static void testStringArrayLength(void) {
@@ -651,4 +1039,111 @@ static void testSearchStringArray(void) {
    test(searchStringArray("yellow", primaryColors), -1);
 }
 
+static void testStringViews(void) {
+   StringView view;
+   string text;
+
+   text = "  key = value  ";
+   trace(view = sliceString("abcde", 1, 3));
+   test(view.len, 3);
+   test(viewToString(view), "bcd");
+   test(viewEquals(view, "bcd"), true);
+   test(viewEquals(view, "bc"), false);
+   test(viewEquals(view, "bcde"), false);
+   test(viewToString(sliceString("abcde", -1, 9)), "abcde");
+   test(sliceString("abcde", 4, 2).len, 0);
+   test(sliceString("abcde", 7, 9).len, 0);
+   test(viewToString(sliceView(view, 1, 5)), "cd");
+   test(sliceView(view, 3, 4).len, 0);
+   trace(view = trimView(viewString(text)));
+   test(viewToString(view), "key = value");
+   test(findInView("=", view, 0), 4);
+   test(findInView("value", view, 5), 6);
+   test(findInView("value", view, 7), -1);
+   test(findInView("", view, 11), 11);
+   test(findInView("", view, 12), -1);
+   test(findInView("alue ", view, 0), -1);
+   test(viewToString(trimView(sliceView(view, 0, 3))), "key");
+   test(viewToString(trimView(sliceView(view, 5, 10))), "value");
+   test(trimView(sliceString(text, 0, 1)).len, 0);
+   test(viewEquals(viewString(""), ""), true);
+   testError(viewString(NULL));
+}
+
+/*
+ * Implementation notes: testLongStrings
+ * -------------------------------------
+ * Checks the functions that use vector instructions against simple
+ * loops on strings long enough to fill several blocks and chunks, so
+ * that every combination of vector code and leftover characters runs.
+ */
+
+static void testLongStrings(void) {
+   char text[700], upper[700];
+   string lower, raised, pattern;
+   unsigned char ch;
+   int n, i, errors;
+
+   for (i = 0; i < 699; i++) {
+      text[i] = (char) (1 + (i * 37) % 255);
+   }
+   text[699] = '\0';
+   errors = 0;
+   for (n = 0; n < 700; n += 23) {
+      lower = toLowerCase(text + 699 - n);
+      raised = toUpperCase(text + 699 - n);
+      for (i = 0; i < n; i++) {
+         ch = text[699 - n + i];
+         if ((unsigned char) lower[i] != tolower(ch)) errors++;
+         if ((unsigned char) raised[i] != toupper(ch)) errors++;
+         upper[i] = raised[i];
+      }
+      upper[n] = '\0';
+      if (lower[n] != '\0' || raised[n] != '\0') errors++;
+      if (!stringEqualIgnoreCase(lower, upper)) errors++;
+      if (n > 0) {
+         upper[n / 2] ^= 0x01;
+         if (stringEqualIgnoreCase(lower, upper)) errors++;
+         upper[n / 2] ^= 0x01;
+         upper[n - 1] = '\0';
+         if (stringEqualIgnoreCase(lower, upper)) errors++;
+         if (stringEqualIgnoreCase(upper, lower)) errors++;
+      }
+      freeBlock(lower);
+      freeBlock(raised);
+   }
+   test(errors, 0);
+   for (i = 0; i < 699; i++) {
+      text[i] = (i % 7 == 3) ? 'b' : 'a';
+   }
+   errors = 0;
+   for (n = 1; n <= 5; n++) {
+      pattern = substring("abaab", 0, n - 1);
+      for (i = 0; i < 699; i += 11) {
+         text[i] = 'x';
+         if (findLastString(pattern, text + i) != findLastNaive(pattern,
+                                                               text + i)) {
+            errors++;
+         }
+         text[i] = (i % 7 == 3) ? 'b' : 'a';
+      }
+      freeBlock(pattern);
+   }
+   test(errors, 0);
+   test(findLastString("bb", text), -1);
+   test(findLastString("", text), 699);
+   test(findChar('a', "abc", 100), -1);
+   test(findString("", "abc", 3), 3);
+}
+
+static int findLastNaive(string str, string text) {
+   int i, n;
+
+   n = strlen(str);
+   for (i = strlen(text) - n; i >= 0; i--) {
+      if (strncmp(str, text + i, n) == 0) return i;
+   }
+   return -1;
+}
+
 #endif
@@ -88,9 +88,10 @@ struct TokenScannerCDT {
 
 static void initScanner(TokenScanner scanner);
 static void skipSpaces(TokenScanner scanner);
-static string scanWord(TokenScanner scanner);
-static string scanNumber(TokenScanner scanner);
-static string scanString(TokenScanner scanner);
+static void scanToken(TokenScanner scanner);
+static void scanWord(TokenScanner scanner);
+static void scanNumber(TokenScanner scanner);
+static void scanString(TokenScanner scanner);
 static bool isOperator(TokenScanner scanner, string op);
 static bool isOperatorPrefix(TokenScanner scanner, string op);
 static void freeStringList(StringCell *cp);
@@ -116,8 +117,12 @@ void freeTokenScanner(TokenScanner scanner) {
 }
 
 void setInputString(TokenScanner scanner, string str) {
-   scanner->buffer = str;
-   scanner->len = stringLength(str);
+   setInputView(scanner, viewString(str));
+}
+
+void setInputView(TokenScanner scanner, StringView view) {
+   scanner->buffer = (string) view.p;
+   scanner->len = view.len;
    scanner->cp = 0;
    scanner->infile = NULL;
    freeStringList(scanner->savedTokens);
@@ -142,7 +147,6 @@ bool hasMoreTokens(TokenScanner scanner) {
 string nextToken(TokenScanner scanner) {
    StringCell *cp;
    string token;
-   int ch, prev;
 
    if (scanner->savedTokens != NULL) {
       cp = scanner->savedTokens;
@@ -151,56 +155,34 @@ string nextToken(TokenScanner scanner) {
       freeBlock(cp);
       return token;
    }
-   while (true) {
-      if (scanner->ignoreWhitespaceFlag) skipSpaces(scanner);
-      ch = getChar(scanner);
-      if (ch == '/' && scanner->ignoreCommentsFlag) {
-         ch = getChar(scanner);
-         if (ch == '/') {
-            while (true) {
-               ch = getChar(scanner);
-               if (ch == '\n' || ch == '\r' || ch == EOF) break;
-            }
-            continue;
-         } else if (ch == '*') {
-            prev = EOF;
-            while (true) {
-               ch = getChar(scanner);
-               if (ch == EOF || (prev == '*' && ch == '/')) break;
-               prev = ch;
-            }
-            continue;
-         }
-         ungetChar(scanner, ch);
-         ch = '/';
-      }
-      if (ch == EOF) return copyString("");
-      if ((ch == '"' || ch == '\'') && scanner->scanStringsFlag) {
-         ungetChar(scanner, ch);
-         return scanString(scanner);
-      }
-      if (isdigit(ch) && scanner->scanNumbersFlag) {
-         ungetChar(scanner, ch);
-         return scanNumber(scanner);
-      }
-      if (isWordCharacter(scanner, ch)) {
-         ungetChar(scanner, ch);
-         return scanWord(scanner);
-      }
+   scanToken(scanner);
+   return copyString(getString(scanner->sb));
+}
+
+/*
+ * Implementation notes: nextTokenView
+ * -----------------------------------
+ * Every token is assembled in the scanner's string buffer, so the view
+ * can point there instead of into a copy.  A saved token is copied into
+ * the same buffer, which lets the function free its cell.
+ */
+
+StringView nextTokenView(TokenScanner scanner) {
+   StringCell *cp;
+   StringView view;
+
+   if (scanner->savedTokens != NULL) {
+      cp = scanner->savedTokens;
       clear(scanner->sb);
-      pushChar(scanner->sb, ch);
-      while (isOperatorPrefix(scanner, getString(scanner->sb))) {
-         ch = getChar(scanner);
-         if (ch == EOF) break;
-         pushChar(scanner->sb, ch);
-      }
-      while (size(scanner->sb) > 1
-             && !isOperator(scanner, getString(scanner->sb))) {
-         ungetChar(scanner, ch);
-         popChar(scanner->sb);
-      }
-      return copyString(getString(scanner->sb));
+      appendString(scanner->sb, cp->str);
+      scanner->savedTokens = cp->link;
+      freeBlock(cp);
+   } else {
+      scanToken(scanner);
    }
+   view.p = getString(scanner->sb);
+   view.len = size(scanner->sb);
+   return view;
 }
 
 void saveToken(TokenScanner scanner, string token) {
@@ -389,6 +371,74 @@ static void initScanner(TokenScanner scanner) {
    scanner->wordChars = newStringBuffer();
 }
 
+/*
+ * Implementation notes: scanToken
+ * -------------------------------
+ * Reads the next token from the input into the string buffer, which is
+ * left empty at the end of the input.
+ */
+
+static void scanToken(TokenScanner scanner) {
+   int ch, prev;
+
+   while (true) {
+      if (scanner->ignoreWhitespaceFlag) skipSpaces(scanner);
+      ch = getChar(scanner);
+      if (ch == '/' && scanner->ignoreCommentsFlag) {
+         ch = getChar(scanner);
+         if (ch == '/') {
+            while (true) {
+               ch = getChar(scanner);
+               if (ch == '\n' || ch == '\r' || ch == EOF) break;
+            }
+            continue;
+         } else if (ch == '*') {
+            prev = EOF;
+            while (true) {
+               ch = getChar(scanner);
+               if (ch == EOF || (prev == '*' && ch == '/')) break;
+               prev = ch;
+            }
+            continue;
+         }
+         ungetChar(scanner, ch);
+         ch = '/';
+      }
+      if (ch == EOF) {
+         clear(scanner->sb);
+         return;
+      }
+      if ((ch == '"' || ch == '\'') && scanner->scanStringsFlag) {
+         ungetChar(scanner, ch);
+         scanString(scanner);
+         return;
+      }
+      if (isdigit(ch) && scanner->scanNumbersFlag) {
+         ungetChar(scanner, ch);
+         scanNumber(scanner);
+         return;
+      }
+      if (isWordCharacter(scanner, ch)) {
+         ungetChar(scanner, ch);
+         scanWord(scanner);
+         return;
+      }
+      clear(scanner->sb);
+      pushChar(scanner->sb, ch);
+      while (isOperatorPrefix(scanner, getString(scanner->sb))) {
+         ch = getChar(scanner);
+         if (ch == EOF) break;
+         pushChar(scanner->sb, ch);
+      }
+      while (size(scanner->sb) > 1
+             && !isOperator(scanner, getString(scanner->sb))) {
+         ungetChar(scanner, ch);
+         popChar(scanner->sb);
+      }
+      return;
+   }
+}
+
 /*
  * Implementation notes: skipSpaces
  * --------------------------------
@@ -420,7 +470,7 @@ static void skipSpaces(TokenScanner scanner) {
  * of word characters.
  */
 
-static string scanWord(TokenScanner scanner) {
+static void scanWord(TokenScanner scanner) {
    int ch;
 
    clear(scanner->sb);
@@ -433,7 +483,6 @@ static string scanWord(TokenScanner scanner) {
       }
       pushChar(scanner->sb, (char) ch);
    }
-   return copyString(getString(scanner->sb));
 }
 
 /*
@@ -446,7 +495,7 @@ static string scanWord(TokenScanner scanner) {
  * determine what characters would be legal at this point in time.
  */
 
-static string scanNumber(TokenScanner scanner) {
+static void scanNumber(TokenScanner scanner) {
    NumberScannerState state;
    int ch, xch;
 
@@ -517,18 +566,17 @@ static string scanNumber(TokenScanner scanner) {
          pushChar(scanner->sb, (char) ch);
       }
    }
-   return copyString(getString(scanner->sb));
 }
 
 /*
  * Implementation notes: scanString
  * --------------------------------
- * Reads and returns a quoted string from the scanner, continuing until
- * it scans the matching delimiter.  The scanner generates an error if
- * there is no closing quotation mark before the end of the input.
+ * Reads a quoted string from the scanner, continuing until it scans
+ * the matching delimiter.  The scanner generates an error if there is
+ * no closing quotation mark before the end of the input.
  */
 
-static string scanString(TokenScanner scanner) {
+static void scanString(TokenScanner scanner) {
    bool escape;
    char delim;
    int ch;
@@ -545,7 +593,6 @@ static string scanString(TokenScanner scanner) {
       pushChar(scanner->sb, (char) ch);
    }
    pushChar(scanner->sb, delim);
-   return copyString(getString(scanner->sb));
 }
 
 /*
@@ -598,11 +645,13 @@ static void testScannerNoOptions(void);
 static void testScannerLanguageOptions(void);
 static void testScanNumbers(void);
 static void testScanEscapeSequences(void);
+static void testTokenViews(void);
 
 void testTokenScannerModule(void) {
    testStringScanner();
    testStreamScanner();
    testScanEscapeSequences();
+   testTokenViews();
 }
 
 static void testStringScanner(void) {
@@ -777,4 +826,32 @@ static void testScanEscapeSequences(void) {
    test(getStringValue(token), "\377\007\a\t");
 }
 
+static void testTokenViews(void) {
+   TokenScanner scanner;
+   StringView view;
+   string line;
+
+   trace(scanner = newTokenScanner());
+   trace(ignoreWhitespace(scanner));
+   trace(scanNumbers(scanner));
+   trace(addOperator(scanner, "<="));
+   trace(line = "skip; x <= 42.5; skip");
+   trace(setInputView(scanner, sliceString(line, 6, 15)));
+   trace(view = nextTokenView(scanner));
+   test(viewEquals(view, "x"), true);
+   trace(view = nextTokenView(scanner));
+   test(viewEquals(view, "<="), true);
+   test(hasMoreTokens(scanner), true);
+   trace(view = nextTokenView(scanner));
+   test(viewToString(view), "42.5");
+   trace(view = nextTokenView(scanner));
+   test(viewEquals(view, ";"), true);
+   trace(view = nextTokenView(scanner));
+   test(view.len, 0);
+   test(nextToken(scanner), "");
+   trace(saveToken(scanner, "y"));
+   test(viewToString(nextTokenView(scanner)), "y");
+   trace(freeTokenScanner(scanner));
+}
+
 #endif
@@ -0,0 +1,913 @@
+/*
+ * File: triemap.c
+ * ---------------
+ * This file implements the triemap.h interface.
+ */
+
+/*************************************************************************/
+/* Stanford Portable Library                                             */
+/* Copyright (C) 2013 by Eric Roberts <eroberts@cs.stanford.edu>         */
+/*                                                                       */
+/* This program is free software: you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation, either version 3 of the License, or     */
+/* (at your option) any later version.                                   */
+/*                                                                       */
+/* This program is distributed in the hope that it will be useful,       */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of        */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         */
+/* GNU General Public License for more details.                          */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+/*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "cslib.h"
+#include "foreach.h"
+#include "iterator.h"
+#include "itertype.h"
+#include "strlib.h"
+#include "triemap.h"
+#include "unittest.h"
+
+/*
+ * Constants
+ * ---------
+ * SPARSE_SIZES  -- Capacities used for nodes in the sparse form
+ * N_SPARSE      -- Number of sparse capacities
+ * DENSE_FANOUT  -- Capacity of a node in the dense form
+ * MIN_DENSE     -- Number of children below which a dense node reverts
+ * INITIAL_DEPTH -- Initial capacity of an iterator's stack and buffer
+ */
+
+static const int SPARSE_SIZES[] = { 4, 16, 48 };
+#define N_SPARSE 3
+#define DENSE_FANOUT 256
+#define MIN_DENSE 24
+#define INITIAL_DEPTH 16
+
+/*
+ * Type: TrieNode
+ * --------------
+ * This type represents a node in the radix tree.  The fragment field
+ * holds the characters on the edge that leads into this node, which are
+ * never empty except at the root.  A node adapts the representation of
+ * its children to their number, in the manner of an adaptive radix tree.
+ * In the sparse form, the labels array holds the first character of each
+ * child's fragment in ascending order, and the children array holds the
+ * corresponding nodes.  When a node outgrows the largest sparse
+ * capacity, it switches to the dense form, in which labels is
+ * <code>NULL</code> and the children array is indexed directly by the
+ * next character.
+ */
+
+typedef struct TrieNodeCDT {
+   char *fragment;             /* Characters on the edge into this node */
+   int length;                 /* Number of characters in fragment      */
+   bool hasValue;              /* True if a key ends at this node       */
+   void *value;                /* Value associated with that key        */
+   int nChildren;              /* Number of children                    */
+   int capacity;               /* Number of child slots allocated       */
+   unsigned char *labels;      /* First characters in the sparse form   */
+   struct TrieNodeCDT **children; /* Child nodes                        */
+} *TrieNode;
+
+/*
+ * Type: TrieMapCDT
+ * ----------------
+ * This type is the concrete type used to represent the map.
+ */
+
+struct TrieMapCDT {
+   IteratorHeader header;      /* Header to enable iteration            */
+   TrieNode root;              /* Root of the radix tree                */
+   int count;                  /* Number of entries in the map          */
+};
+
+/*
+ * Type: TrieFrame
+ * ---------------
+ * This type represents a node on the stack of a traversal, along with
+ * the next child slot to examine and the length of the key that ends at
+ * the node.
+ */
+
+typedef struct {
+   TrieNode node;
+   int slot;
+   int keyLength;
+   bool visited;
+} TrieFrame;
+
+/*
+ * Type: PrefixState
+ * -----------------
+ * This type holds the state of a traversal of the keys with a given
+ * prefix.  The buffer holds the key for the node on top of the stack.
+ */
+
+typedef struct {
+   TrieFrame *frames;
+   int depth;
+   int maxDepth;
+   char *buffer;
+   int bufferSize;
+} PrefixState;
+
+/* Private function prototypes */
+
+static TrieNode newTrieNode(string chars, int length);
+static void freeTrieNode(TrieNode node);
+static void freeTrieTree(TrieNode node);
+static TrieNode copyTrieTree(TrieNode node);
+static TrieNode findTrieNode(TrieMap map, string key);
+static int matchLength(TrieNode node, string str);
+static TrieNode splitTrieNode(TrieNode parent, TrieNode child, int n);
+static void mergeWithChild(TrieNode parent, TrieNode node);
+static void setFragment(TrieNode node, string chars, int length);
+static int findSlot(TrieNode node, int ch);
+static TrieNode findChild(TrieNode node, int ch);
+static TrieNode nextChild(TrieNode node, int *slotPtr);
+static void insertChild(TrieNode node, TrieNode child);
+static void removeChild(TrieNode node, int ch);
+static void replaceChild(TrieNode node, TrieNode child);
+static void resizeChildren(TrieNode node, int capacity);
+static void initPrefixState(PrefixState *ps, TrieMap map, string prefix);
+static void pushFrame(PrefixState *ps, TrieNode node, int baseLength);
+static TrieNode advancePrefix(PrefixState *ps);
+static void freePrefixState(PrefixState *ps);
+static bool stepPrefixIterator(Iterator iterator, void *dst);
+static Iterator newForeachIterator(void *collection);
+
+/* Exported entries */
+
+TrieMap newTrieMap(void) {
+   TrieMap map;
+
+   map = newBlock(TrieMap);
+   enableIteration(map, newForeachIterator);
+   map->root = newTrieNode("", 0);
+   map->count = 0;
+   return map;
+}
+
+void freeTrieMap(TrieMap map) {
+   freeTrieTree(map->root);
+   freeBlock(map);
+}
+
+int sizeTrieMap(TrieMap map) {
+   return map->count;
+}
+
+bool isEmptyTrieMap(TrieMap map) {
+   return map->count == 0;
+}
+
+void clearTrieMap(TrieMap map) {
+   freeTrieTree(map->root);
+   map->root = newTrieNode("", 0);
+   map->count = 0;
+}
+
+TrieMap cloneTrieMap(TrieMap map) {
+   TrieMap newmap;
+
+   newmap = newBlock(TrieMap);
+   enableIteration(newmap, newForeachIterator);
+   newmap->root = copyTrieTree(map->root);
+   newmap->count = map->count;
+   return newmap;
+}
+
+/*
+ * Implementation notes: putTrieMap
+ * --------------------------------
+ * Walks down the tree, consuming the characters of the key along the
+ * fragments of the nodes it passes.  If the key diverges from a
+ * fragment partway through, that node is split at the point of
+ * divergence.  If the walk reaches a node with no child for the next
+ * character, the rest of the key becomes the fragment of a new leaf.
+ */
+
+void putTrieMap(TrieMap map, string key, void *value) {
+   TrieNode node, child;
+   int n;
+
+   node = map->root;
+   while (*key != '\0') {
+      child = findChild(node, *key);
+      if (child == NULL) {
+         child = newTrieNode(key, strlen(key));
+         insertChild(node, child);
+         node = child;
+         break;
+      }
+      n = matchLength(child, key);
+      if (n < child->length) child = splitTrieNode(node, child, n);
+      node = child;
+      key += n;
+   }
+   if (!node->hasValue) map->count++;
+   node->hasValue = true;
+   node->value = value;
+}
+
+void *getTrieMap(TrieMap map, string key) {
+   TrieNode node;
+
+   node = findTrieNode(map, key);
+   return (node == NULL) ? NULL : node->value;
+}
+
+bool containsKeyTrieMap(TrieMap map, string key) {
+   return findTrieNode(map, key) != NULL;
+}
+
+/*
+ * Implementation notes: removeTrieMap
+ * -----------------------------------
+ * After the value is removed, the tree is restored to its compressed
+ * form.  A node that no longer has a value or children is deleted, and
+ * a node other than the root that is left with neither a value nor more
+ * than one child is merged with that child.  Deleting a leaf can leave
+ * its parent in that state, so the parent is checked as well.
+ */
+
+void removeTrieMap(TrieMap map, string key) {
+   TrieNode grandparent, parent, node, child;
+
+   grandparent = parent = NULL;
+   node = map->root;
+   while (*key != '\0') {
+      child = findChild(node, *key);
+      if (child == NULL || matchLength(child, key) < child->length) return;
+      grandparent = parent;
+      parent = node;
+      node = child;
+      key += child->length;
+   }
+   if (!node->hasValue) return;
+   node->hasValue = false;
+   node->value = NULL;
+   map->count--;
+   if (parent == NULL) return;
+   if (node->nChildren == 0) {
+      removeChild(parent, node->fragment[0]);
+      freeTrieNode(node);
+      if (grandparent != NULL && !parent->hasValue
+                              && parent->nChildren == 1) {
+         mergeWithChild(grandparent, parent);
+      }
+   } else if (node->nChildren == 1) {
+      mergeWithChild(parent, node);
+   }
+}
+
+string longestPrefixTrieMap(TrieMap map, string str) {
+   TrieNode node, child;
+   int pos, best;
+
+   node = map->root;
+   best = (node->hasValue) ? 0 : -1;
+   pos = 0;
+   while (str[pos] != '\0') {
+      child = findChild(node, str[pos]);
+      if (child == NULL || matchLength(child, str + pos) < child->length) {
+         break;
+      }
+      pos += child->length;
+      node = child;
+      if (node->hasValue) best = pos;
+   }
+   if (best < 0) return NULL;
+   return substring(str, 0, best - 1);
+}
+
+Iterator newPrefixIterator(TrieMap map, string prefix) {
+   Iterator iterator;
+   PrefixState *ps;
+
+   ps = newBlock(PrefixState *);
+   initPrefixState(ps, map, prefix);
+   iterator = newStepIterator(sizeof(string), stepPrefixIterator);
+   setCollection(iterator, map);
+   setIteratorData(iterator, ps);
+   return iterator;
+}
+
+void mapTrieMap(TrieMap map, proc fn, void *data) {
+   PrefixState ps;
+   TrieNode node;
+
+   initPrefixState(&ps, map, "");
+   while ((node = advancePrefix(&ps)) != NULL) {
+      fn(ps.buffer, node->value, data);
+   }
+   freePrefixState(&ps);
+}
+
+/* Private functions */
+
+/*
+ * Implementation notes: newTrieNode, freeTrieNode, freeTrieTree
+ * -------------------------------------------------------------
+ * A new node starts out with no children and copies the first length
+ * characters of chars as its fragment.  The freeTrieNode function frees
+ * a single node, while freeTrieTree frees an entire subtree.
+ */
+
+static TrieNode newTrieNode(string chars, int length) {
+   TrieNode node;
+
+   node = newBlock(TrieNode);
+   node->fragment = NULL;
+   setFragment(node, chars, length);
+   node->hasValue = false;
+   node->value = NULL;
+   node->nChildren = 0;
+   node->capacity = 0;
+   node->labels = NULL;
+   node->children = NULL;
+   return node;
+}
+
+static void freeTrieNode(TrieNode node) {
+   freeBlock(node->fragment);
+   if (node->labels != NULL) freeBlock(node->labels);
+   if (node->children != NULL) freeBlock(node->children);
+   freeBlock(node);
+}
+
+static void freeTrieTree(TrieNode node) {
+   TrieNode child;
+   int slot;
+
+   slot = 0;
+   while ((child = nextChild(node, &slot)) != NULL) {
+      freeTrieTree(child);
+   }
+   freeTrieNode(node);
+}
+
+static TrieNode copyTrieTree(TrieNode node) {
+   TrieNode copy, child;
+   int slot;
+
+   copy = newTrieNode(node->fragment, node->length);
+   copy->hasValue = node->hasValue;
+   copy->value = node->value;
+   slot = 0;
+   while ((child = nextChild(node, &slot)) != NULL) {
+      insertChild(copy, copyTrieTree(child));
+   }
+   return copy;
+}
+
+static TrieNode findTrieNode(TrieMap map, string key) {
+   TrieNode node;
+
+   node = map->root;
+   while (*key != '\0') {
+      node = findChild(node, *key);
+      if (node == NULL || matchLength(node, key) < node->length) return NULL;
+      key += node->length;
+   }
+   return (node->hasValue) ? node : NULL;
+}
+
+/*
+ * Implementation notes: matchLength
+ * ---------------------------------
+ * Returns the number of leading characters of the node's fragment that
+ * match the beginning of str.
+ */
+
+static int matchLength(TrieNode node, string str) {
+   int i;
+
+   for (i = 0; i < node->length && str[i] == node->fragment[i]; i++) {
+      /* Empty */
+   }
+   return i;
+}
+
+/*
+ * Implementation notes: splitTrieNode, mergeWithChild
+ * ---------------------------------------------------
+ * The splitTrieNode function inserts a new node between parent and
+ * child that takes over the first n characters of the child's fragment.
+ * The mergeWithChild function performs the opposite transformation,
+ * replacing a node that has a single child with that child.  Neither
+ * changes the first character of the fragment that the parent uses to
+ * find the node.
+ */
+
+static TrieNode splitTrieNode(TrieNode parent, TrieNode child, int n) {
+   TrieNode mid;
+   string rest;
+
+   mid = newTrieNode(child->fragment, n);
+   rest = copyString(child->fragment + n);
+   setFragment(child, rest, child->length - n);
+   freeBlock(rest);
+   insertChild(mid, child);
+   replaceChild(parent, mid);
+   return mid;
+}
+
+static void mergeWithChild(TrieNode parent, TrieNode node) {
+   TrieNode child;
+   string joined;
+   int slot;
+
+   slot = 0;
+   child = nextChild(node, &slot);
+   joined = concat(node->fragment, child->fragment);
+   setFragment(child, joined, node->length + child->length);
+   freeBlock(joined);
+   replaceChild(parent, child);
+   freeTrieNode(node);
+}
+
+static void setFragment(TrieNode node, string chars, int length) {
+   char *fragment;
+
+   fragment = newArray(length + 1, char);
+   memcpy(fragment, chars, length);
+   fragment[length] = '\0';
+   if (node->fragment != NULL) freeBlock(node->fragment);
+   node->fragment = fragment;
+   node->length = length;
+}
+
+/*
+ * Implementation notes: Child access
+ * ----------------------------------
+ * These functions hide the difference between the sparse and dense
+ * forms of a node.  A slot is an index into the children array, and
+ * nextChild steps through the occupied slots in ascending order of
+ * their characters, which is the order in which keys are produced.
+ */
+
+static int findSlot(TrieNode node, int ch) {
+   int lh, rh, mid;
+
+   ch = (unsigned char) ch;
+   if (node->labels == NULL) {
+      return (node->children != NULL && node->children[ch] != NULL) ? ch : -1;
+   }
+   lh = 0;
+   rh = node->nChildren - 1;
+   while (lh <= rh) {
+      mid = (lh + rh) / 2;
+      if (node->labels[mid] == ch) return mid;
+      if (node->labels[mid] < ch) {
+         lh = mid + 1;
+      } else {
+         rh = mid - 1;
+      }
+   }
+   return -1;
+}
+
+static TrieNode findChild(TrieNode node, int ch) {
+   int slot;
+
+   slot = findSlot(node, ch);
+   return (slot < 0) ? NULL : node->children[slot];
+}
+
+static TrieNode nextChild(TrieNode node, int *slotPtr) {
+   int slot, limit;
+
+   limit = (node->labels == NULL && node->children != NULL)
+         ? DENSE_FANOUT : node->nChildren;
+   for (slot = *slotPtr; slot < limit; slot++) {
+      if (node->children[slot] != NULL) {
+         *slotPtr = slot + 1;
+         return node->children[slot];
+      }
+   }
+   *slotPtr = limit;
+   return NULL;
+}
+
+static void insertChild(TrieNode node, TrieNode child) {
+   int ch, i, k;
+
+   ch = (unsigned char) child->fragment[0];
+   if (node->nChildren == node->capacity) {
+      for (k = 0; k < N_SPARSE && SPARSE_SIZES[k] <= node->capacity; k++) {
+         /* Empty */
+      }
+      resizeChildren(node, (k < N_SPARSE) ? SPARSE_SIZES[k] : DENSE_FANOUT);
+   }
+   if (node->labels == NULL) {
+      node->children[ch] = child;
+   } else {
+      for (i = node->nChildren; i > 0 && node->labels[i - 1] > ch; i--) {
+         node->labels[i] = node->labels[i - 1];
+         node->children[i] = node->children[i - 1];
+      }
+      node->labels[i] = ch;
+      node->children[i] = child;
+   }
+   node->nChildren++;
+}
+
+static void removeChild(TrieNode node, int ch) {
+   int slot, i;
+
+   slot = findSlot(node, ch);
+   if (node->labels == NULL) {
+      node->children[slot] = NULL;
+      node->nChildren--;
+      if (node->nChildren < MIN_DENSE) {
+         resizeChildren(node, SPARSE_SIZES[N_SPARSE - 1]);
+      }
+   } else {
+      for (i = slot + 1; i < node->nChildren; i++) {
+         node->labels[i - 1] = node->labels[i];
+         node->children[i - 1] = node->children[i];
+      }
+      node->nChildren--;
+   }
+}
+
+static void replaceChild(TrieNode node, TrieNode child) {
+   node->children[findSlot(node, child->fragment[0])] = child;
+}
+
+/*
+ * Implementation notes: resizeChildren
+ * ------------------------------------
+ * Moves the children of a node into arrays with the new capacity, which
+ * selects the dense form if it is DENSE_FANOUT and the sparse form
+ * otherwise.
+ */
+
+static void resizeChildren(TrieNode node, int capacity) {
+   unsigned char *labels;
+   TrieNode *children, child;
+   int slot, n;
+
+   children = newArray(capacity, TrieNode);
+   memset(children, 0, capacity * sizeof(TrieNode));
+   labels = NULL;
+   if (capacity != DENSE_FANOUT) labels = newArray(capacity, unsigned char);
+   n = 0;
+   slot = 0;
+   if (node->children != NULL) {
+      while ((child = nextChild(node, &slot)) != NULL) {
+         if (labels == NULL) {
+            children[(unsigned char) child->fragment[0]] = child;
+         } else {
+            labels[n] = child->fragment[0];
+            children[n] = child;
+         }
+         n++;
+      }
+      freeBlock(node->children);
+   }
+   if (node->labels != NULL) freeBlock(node->labels);
+   node->labels = labels;
+   node->children = children;
+   node->capacity = capacity;
+}
+
+/*
+ * Implementation notes: Prefix traversal
+ * --------------------------------------
+ * The traversal begins at the highest node whose key starts with the
+ * prefix, which may be a node whose fragment extends past the end of
+ * the prefix.  From there, it conducts a preorder walk with an explicit
+ * stack, so that each key is produced before the longer keys that
+ * extend it.  The buffer grows and shrinks along with the stack.
+ */
+
+static void initPrefixState(PrefixState *ps, TrieMap map, string prefix) {
+   TrieNode node, child;
+   int pos, base, n;
+
+   ps->depth = 0;
+   ps->maxDepth = INITIAL_DEPTH;
+   ps->frames = newArray(ps->maxDepth, TrieFrame);
+   ps->bufferSize = INITIAL_DEPTH;
+   while (ps->bufferSize <= (int) strlen(prefix)) {
+      ps->bufferSize *= 2;
+   }
+   ps->buffer = newArray(ps->bufferSize, char);
+   ps->buffer[0] = '\0';
+   node = map->root;
+   pos = base = 0;
+   while (prefix[pos] != '\0') {
+      child = findChild(node, prefix[pos]);
+      if (child == NULL) return;
+      n = matchLength(child, prefix + pos);
+      if (n < child->length && prefix[pos + n] != '\0') return;
+      base = pos;
+      pos += n;
+      node = child;
+   }
+   memcpy(ps->buffer, prefix, base);
+   pushFrame(ps, node, base);
+}
+
+/*
+ * Implementation notes: pushFrame
+ * -------------------------------
+ * Pushes a frame for node, whose key consists of the first baseLength
+ * characters in the buffer followed by the node's fragment, and appends
+ * that fragment to the buffer.
+ */
+
+static void pushFrame(PrefixState *ps, TrieNode node, int baseLength) {
+   TrieFrame *frames;
+   char *buffer;
+   int keyLength;
+
+   if (ps->depth == ps->maxDepth) {
+      frames = newArray(2 * ps->maxDepth, TrieFrame);
+      memcpy(frames, ps->frames, ps->depth * sizeof(TrieFrame));
+      freeBlock(ps->frames);
+      ps->frames = frames;
+      ps->maxDepth *= 2;
+   }
+   keyLength = baseLength + node->length;
+   if (keyLength >= ps->bufferSize) {
+      while (keyLength >= ps->bufferSize) {
+         ps->bufferSize *= 2;
+      }
+      buffer = newArray(ps->bufferSize, char);
+      memcpy(buffer, ps->buffer, baseLength);
+      freeBlock(ps->buffer);
+      ps->buffer = buffer;
+   }
+   memcpy(ps->buffer + baseLength, node->fragment, node->length);
+   ps->buffer[keyLength] = '\0';
+   ps->frames[ps->depth].node = node;
+   ps->frames[ps->depth].slot = 0;
+   ps->frames[ps->depth].keyLength = keyLength;
+   ps->frames[ps->depth].visited = false;
+   ps->depth++;
+}
+
+/*
+ * Implementation notes: advancePrefix
+ * -----------------------------------
+ * Returns the next node that holds a value, with its key in the buffer,
+ * or <code>NULL</code> when the traversal is complete.
+ */
+
+static TrieNode advancePrefix(PrefixState *ps) {
+   TrieFrame *top;
+   TrieNode child;
+
+   while (ps->depth > 0) {
+      top = &ps->frames[ps->depth - 1];
+      ps->buffer[top->keyLength] = '\0';
+      if (!top->visited) {
+         top->visited = true;
+         if (top->node->hasValue) return top->node;
+      }
+      child = nextChild(top->node, &top->slot);
+      if (child == NULL) {
+         ps->depth--;
+      } else {
+         pushFrame(ps, child, top->keyLength);
+      }
+   }
+   return NULL;
+}
+
+static void freePrefixState(PrefixState *ps) {
+   freeBlock(ps->frames);
+   freeBlock(ps->buffer);
+}
+
+/*
+ * Implementation notes: stepPrefixIterator
+ * ----------------------------------------
+ * The traversal state is kept in the data field of the iterator and is
+ * freed as soon as the traversal is complete.
+ */
+
+static bool stepPrefixIterator(Iterator iterator, void *dst) {
+   PrefixState *ps;
+
+   ps = (PrefixState *) getIteratorData(iterator);
+   if (ps == NULL) return false;
+   if (advancePrefix(ps) != NULL) {
+      *((string *) dst) = ps->buffer;
+      return true;
+   }
+   freePrefixState(ps);
+   freeBlock(ps);
+   setIteratorData(iterator, NULL);
+   return false;
+}
+
+static Iterator newForeachIterator(void *collection) {
+   return newPrefixIterator((TrieMap) collection, "");
+}
+
+/**********************************************************************/
+/* Unit test for the triemap module                                   */
+/**********************************************************************/
+
+#ifndef _NOTEST_
+
+#include "map.h"
+
+/* Constants */
+
+static string LATIN[] = {
+   "romane", "romanus", "romulus", "rubens", "ruber", "rubicon",
+   "rubicundus"
+};
+static int N_LATIN = sizeof LATIN / sizeof LATIN[0];
+
+/* Private function prototypes */
+
+static void testLatinWords(void);
+static void testLongestPrefix(void);
+static void testWideNode(void);
+static void testAgainstMap(void);
+static string joinPrefixKeys(TrieMap map, string prefix);
+static void checkSameKeys(TrieMap trie, Map map);
+
+/* Unit test */
+
+void testTrieMapModule(void) {
+   testLatinWords();
+   testLongestPrefix();
+   testWideNode();
+   testAgainstMap();
+}
+
+static void testLatinWords(void) {
+   TrieMap map, copy;
+   int i;
+
+   trace(map = newTrieMap());
+   for (i = 0; i < N_LATIN; i++) {
+      putTrieMap(map, LATIN[i], LATIN[i]);
+   }
+   test(sizeTrieMap(map), 7);
+   test(getTrieMap(map, "ruber"), "ruber");
+   test(getTrieMap(map, "rube"), NULL);
+   test(containsKeyTrieMap(map, "rom"), false);
+   trace(putTrieMap(map, "rom", "Rome"));
+   test(containsKeyTrieMap(map, "rom"), true);
+   test(sizeTrieMap(map), 8);
+   test(joinPrefixKeys(map, "rub"), "rubens ruber rubicon rubicundus");
+   test(joinPrefixKeys(map, "ro"), "rom romane romanus romulus");
+   test(joinPrefixKeys(map, "romanu"), "romanus");
+   test(joinPrefixKeys(map, "roma"), "romane romanus");
+   test(joinPrefixKeys(map, "rx"), "");
+   test(joinPrefixKeys(map, "romanusque"), "");
+   trace(copy = cloneTrieMap(map));
+   trace(removeTrieMap(map, "romanus"));
+   trace(removeTrieMap(map, "rom"));
+   trace(removeTrieMap(map, "ruber"));
+   trace(removeTrieMap(map, "rubric"));
+   test(sizeTrieMap(map), 5);
+   test(joinPrefixKeys(map, ""), "romane romulus rubens rubicon rubicundus");
+   test(getTrieMap(map, "romane"), "romane");
+   test(getTrieMap(copy, "rom"), "Rome");
+   test(sizeTrieMap(copy), 8);
+   for (i = 0; i < N_LATIN; i++) {
+      removeTrieMap(map, LATIN[i]);
+   }
+   test(isEmptyTrieMap(map), true);
+   test(map->root->nChildren, 0);
+   trace(freeTrieMap(map));
+   trace(freeTrieMap(copy));
+}
+
+static void testLongestPrefix(void) {
+   TrieMap map;
+
+   trace(map = newTrieMap());
+   trace(putTrieMap(map, "/", "root"));
+   trace(putTrieMap(map, "/api", "api"));
+   trace(putTrieMap(map, "/api/users", "users"));
+   test(longestPrefixTrieMap(map, "/api/users/42"), "/api/users");
+   test(longestPrefixTrieMap(map, "/api/user"), "/api");
+   test(longestPrefixTrieMap(map, "/apix"), "/api");
+   test(longestPrefixTrieMap(map, "/index.html"), "/");
+   test(longestPrefixTrieMap(map, "api"), NULL);
+   trace(putTrieMap(map, "", "empty"));
+   test(longestPrefixTrieMap(map, "api"), "");
+   trace(freeTrieMap(map));
+}
+
+/*
+ * Implementation notes: testWideNode
+ * ----------------------------------
+ * Gives the root enough children to switch it to the dense form and then
+ * removes most of them again, checking the order of the keys each time.
+ */
+
+static void testWideNode(void) {
+   TrieMap map;
+   char key[3];
+   string str, prev;
+   int i, n;
+
+   trace(map = newTrieMap());
+   key[1] = 'x';
+   key[2] = '\0';
+   for (i = 0; i < 200; i++) {
+      key[0] = (char) (255 - i);
+      putTrieMap(map, key, NULL);
+   }
+   test(sizeTrieMap(map), 200);
+   test(map->root->capacity, 256);
+   n = 0;
+   prev = NULL;
+   foreach (str in map) {
+      if (prev != NULL && strcmp(prev, str) >= 0) {
+         reportError("Keys out of order at %d", n);
+      }
+      if (prev != NULL) freeBlock(prev);
+      prev = copyString(str);
+      n++;
+   }
+   test(n, 200);
+   for (i = 0; i < 190; i++) {
+      key[0] = (char) (255 - i);
+      removeTrieMap(map, key);
+   }
+   test(sizeTrieMap(map), 10);
+   test(map->root->capacity < DENSE_FANOUT, true);
+   key[0] = (char) 65;
+   test(containsKeyTrieMap(map, key), true);
+   trace(freeTrieMap(map));
+}
+
+/*
+ * Implementation notes: testAgainstMap
+ * ------------------------------------
+ * Inserts and removes the same keys in a TrieMap and a Map, which must
+ * then produce the same keys in the same order.
+ */
+
+static void testAgainstMap(void) {
+   TrieMap trie;
+   Map map;
+   string key;
+   int i;
+
+   trie = newTrieMap();
+   map = newMap();
+   for (i = 0; i < 3000; i++) {
+      key = integerToString((i * 7919) % 10007);
+      putTrieMap(trie, key, key);
+      putMap(map, key, key);
+   }
+   trace(checkSameKeys(trie, map));
+   for (i = 0; i < 3000; i += 2) {
+      key = integerToString((i * 7919) % 10007);
+      removeTrieMap(trie, key);
+      removeMap(map, key);
+      freeBlock(key);
+   }
+   trace(checkSameKeys(trie, map));
+   test(sizeTrieMap(trie), 1500);
+   test(getTrieMap(trie, "7919"), "7919");
+}
+
+static string joinPrefixKeys(TrieMap map, string prefix) {
+   string key, result;
+
+   result = "";
+   foreach (key in newPrefixIterator(map, prefix)) {
+      result = (*result == '\0') ? copyString(key)
+                                 : concat(concat(result, " "), key);
+   }
+   return result;
+}
+
+static void checkSameKeys(TrieMap trie, Map map) {
+   Iterator it;
+   string key, expected;
+
+   it = newIterator(map);
+   foreach (key in trie) {
+      if (!stepIterator(it, &expected)) {
+         reportError("Extra key %s", key);
+         break;
+      }
+      if (!stringEqual(key, expected)) {
+         reportError("Found %s, expected %s", key, expected);
+      }
+   }
+   if (stepIterator(it, &expected)) reportError("Missing key %s", expected);
+   freeIterator(it);
+}
+
+#endif
@@ -38,46 +38,68 @@ typedef struct {
    int flags;
 } TestEntry;
 
+extern void testBitmapModule(void);
+extern void testBitVectorModule(void);
 extern void testBSTModule(void);
+extern void testBTreeModule(void);
+extern void testCacheModule(void);
 extern void testCharSetModule(void);
+extern void testDisjointSetModule(void);
 extern void testExceptionModule(void);
 extern void testFilelibModule(void);
+extern void testFlatMapModule(void);
 extern void testGEventsModule(void);
 extern void testGraphModule(void);
+extern void testGraphAlgoModule(void);
+extern void testGraphIOModule(void);
 extern void testGTypesModule(void);
 extern void testHashMapModule(void);
+extern void testIntervalMapModule(void);
 extern void testMapModule(void);
 extern void testOptionsModule(void);
 extern void testPriorityQueueModule(void);
 extern void testQueueModule(void);
 extern void testRandomModule(void);
 extern void testSetModule(void);
+extern void testSketchModule(void);
 extern void testStackModule(void);
 extern void testStrbufModule(void);
 extern void testStrlibModule(void);
 extern void testThreadModule(void);
 extern void testTokenScannerModule(void);
+extern void testTrieMapModule(void);
 extern void testVectorModule(void);
 
 static TestEntry TEST_MODULES[] = {
+   { "bitmap", testBitmapModule },
+   { "bitvector", testBitVectorModule },
    { "bst", testBSTModule },
+   { "btree", testBTreeModule },
+   { "cache", testCacheModule },
    { "charset", testCharSetModule },
+   { "disjointset", testDisjointSetModule },
    { "exception", testExceptionModule },
    { "filelib", testFilelibModule },
+   { "flatmap", testFlatMapModule },
    { "gevents", testGEventsModule },
    { "graph", testGraphModule },
+   { "graphalgo", testGraphAlgoModule },
+   { "graphio", testGraphIOModule },
    { "gtypes", testGTypesModule },
    { "hashmap", testHashMapModule },
+   { "intervalmap", testIntervalMapModule },
    { "map", testMapModule },
    { "options", testOptionsModule },
    { "pqueue", testPriorityQueueModule },
    { "queue", testQueueModule },
    { "random", testRandomModule },
    { "set", testSetModule },
+   { "sketch", testSketchModule },
    { "stack", testStackModule },
    { "strbuf", testStrbufModule },
    { "strlib", testStrlibModule },
    { "tokenscanner", testTokenScannerModule },
+   { "triemap", testTrieMapModule },
    { "vector", testVectorModule },
 };
 
@@ -123,6 +145,7 @@ static int findTestModule(string name) {
 
    index = -1;
    for (i = 0; i < N_TEST_MODULES; i++) {
+      if (stringEqual(TEST_MODULES[i].name, name)) return i;
       if (startsWith(TEST_MODULES[i].name, name)) {
          if (index != -1) return -1;
          index = i;